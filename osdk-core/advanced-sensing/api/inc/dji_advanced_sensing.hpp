@@ -20,6 +20,7 @@
 #include "dji_perception.hpp"
 
 #include "dji_camera_stream.hpp"
+#include "dji_camera_decode_scheduler.hpp"
 
 namespace DJI {
 namespace OSDK {
@@ -185,6 +186,30 @@ public:
    *  @return true if successfully started, false otherwise
    */
   bool startMainCameraStream(CameraImageCallback cb = NULL, void * cbParam = NULL);
+  /*! @brief
+   *
+   *  Start the FPV Camera Stream with a zero-copy frame callback
+   *
+   *  @platforms M210V2, M300
+   *  @param cb callback function that is called in a callback thread with a
+   *            frame borrowed from the decoder's frame pool. The frame is
+   *            released when the callback returns.
+   *  @param cbParam a void pointer that users can manipulate inside the callback
+   *  @return true if successfully started, false otherwise
+   */
+  bool startFPVCameraFrameStream(CameraImageFrameCallback cb, void * cbParam = NULL);
+  /*! @brief
+   *
+   *  Start the Main Camera Stream with a zero-copy frame callback
+   *
+   *  @platforms M210V2, M300
+   *  @param cb callback function that is called in a callback thread with a
+   *            frame borrowed from the decoder's frame pool. The frame is
+   *            released when the callback returns.
+   *  @param cbParam a void pointer that users can manipulate inside the callback
+   *  @return true if successfully started, false otherwise
+   */
+  bool startMainCameraFrameStream(CameraImageFrameCallback cb, void * cbParam = NULL);
   /*! @brief
    *
    *  Set the ACM device path, mainly for M210V2
@@ -244,6 +269,83 @@ public:
    *  @return true if a new image frame is ready, false if timeout
    */
   bool getMainCameraImage(CameraRGBImage& copyOfImage);
+  /*! @brief Borrow the new image from the FPV camera without copying it
+   *
+   *  @platforms M210V2, M300
+   *  @param frame a read-only view into the decoder's frame pool
+   *  @note The frame must be returned with releaseCameraImage(). While it is
+   *        borrowed the decoder cannot reuse its slot.
+   *
+   *  @return true if a new image frame is ready, false if timeout
+   */
+  bool borrowFPVCameraImage(CameraImageFrame& frame);
+  /*! @brief Borrow the new image from the main camera without copying it
+   *
+   *  @platforms M210V2, M300
+   *  @param frame a read-only view into the decoder's frame pool
+   *  @note The frame must be returned with releaseCameraImage(). While it is
+   *        borrowed the decoder cannot reuse its slot.
+   *
+   *  @return true if a new image frame is ready, false if timeout
+   */
+  bool borrowMainCameraImage(CameraImageFrame& frame);
+  /*! @brief Return a frame obtained from borrowFPVCameraImage() or
+   *  borrowMainCameraImage() to its frame pool
+   *
+   *  @platforms M210V2, M300
+   */
+  void releaseCameraImage(const CameraImageFrame& frame);
+  /*! @brief Get the written/overwritten/dropped frame counters of the FPV
+   *  camera frame pool
+   *
+   *  @platforms M210V2, M300
+   */
+  void getFPVCameraImageStats(CameraImageStats& stats);
+  /*! @brief Get the written/overwritten/dropped frame counters of the main
+   *  camera frame pool
+   *
+   *  @platforms M210V2, M300
+   */
+  void getMainCameraImageStats(CameraImageStats& stats);
+  /*! @brief Set the pixel format of the decoded FPV camera frames
+   *
+   *  @platforms M210V2, M300
+   *  @param format RGB24 (default), BGR24, GRAY8 (luma only), YUV420P
+   *         (native planes, no colour conversion) or NV12 (interleaved
+   *         chroma, no colour conversion)
+   *  @param convertOnDemand for RGB24/BGR24, keep the native planes and run
+   *         the colour conversion only when a frame is actually fetched
+   *  @note The legacy CameraRGBImage APIs also return data in this format.
+   */
+  void setFPVCameraImageFormat(CameraImageFormat format, bool convertOnDemand = false);
+  /*! @brief Set the pixel format of the decoded main camera frames
+   *
+   *  @platforms M210V2, M300
+   *  @param format RGB24 (default), BGR24, GRAY8 (luma only), YUV420P
+   *         (native planes, no colour conversion) or NV12 (interleaved
+   *         chroma, no colour conversion)
+   *  @param convertOnDemand for RGB24/BGR24, keep the native planes and run
+   *         the colour conversion only when a frame is actually fetched
+   *  @note The legacy CameraRGBImage APIs also return data in this format.
+   */
+  void setMainCameraImageFormat(CameraImageFormat format, bool convertOnDemand = false);
+  /*! @brief Configure the worker pool shared by the camera decoders
+   *
+   *  @platforms M300
+   *  @param config worker thread budget, FFmpeg threads per decoder, CPU
+   *         affinity of the workers and the per-stream backlog after which
+   *         a stream drops to its next keyframe
+   *  @note The FFmpeg thread count applies to streams started afterwards.
+   *  @return true if the workers were restarted, false otherwise
+   */
+  bool configureDecodeScheduler(const DJICameraDecodeScheduler::Config& config);
+  /*! @brief Get the queueing and drop counters of one camera's decoder
+   *
+   *  @platforms M300
+   *  @return false if the position has no scheduled decoder
+   */
+  bool getDecodeStreamStats(LiveView::LiveViewCameraPosition pos,
+                            DJICameraDecodeScheduler::StreamStats& stats);
 
   /*! @brief
    *  Change the camera stream source from one payload device. (Beta API)
@@ -346,6 +448,7 @@ LiveView *liveview;
 Perception *perception;
 const char* acm_dev;
 map<LiveView::LiveViewCameraPosition, DJICameraStreamDecoder*> streamDecoder;
+DJICameraDecodeScheduler* decodeScheduler;
 
 public:
 AdvancedSensingProtocol* getAdvancedSensingProtocol();
@@ -29,6 +29,7 @@
 #ifndef ONBOARDSDK_DJI_LIVEVIEW_IMPL_H
 #define ONBOARDSDK_DJI_LIVEVIEW_IMPL_H
 
+#include <atomic>
 #include "dji_type.hpp"
 #include "dji_vehicle.hpp"
 #include "dji_liveview.hpp"
@@ -57,6 +58,21 @@ class LiveViewImpl {
     void *userData;
   } H264CallbackHandler;
 
+  /*! @brief Per-position callback slot.
+   *
+   *  The {cb, userData} pair is published under a sequence lock: the writer
+   *  makes seq odd while it stores the pair, the receive thread copies the
+   *  pair and retries if seq was odd or changed meanwhile. So it always gets
+   *  a consistent pair without locking, however quickly handlers change.
+   */
+  typedef struct H264CallbackSlot {
+    std::atomic<H264Callback> cb;
+    std::atomic<void *> userData;
+    std::atomic<uint32_t> seq;
+  } H264CallbackSlot;
+
+  static const int H264_CB_SLOT_NUM = LiveView::OSDK_CAMERA_POSITION_FPV + 1;
+
  private:
 
   typedef enum E_OSDKCameraType {
@@ -168,7 +184,10 @@ class LiveViewImpl {
   Vehicle *vehicle;
 
  private:
-  static std::map<LiveView::LiveViewCameraPosition, H264CallbackHandler> h264CbHandlerMap;
+  static H264CallbackSlot h264CbSlots[H264_CB_SLOT_NUM];
+  static std::atomic_flag h264CbWriteLock;
+  static void setH264Handler(LiveView::LiveViewCameraPosition pos,
+                             H264Callback cb, void *userData);
   static T_RecvCmdItem bulkCmdList[];
   static E_OsdkStat RecordStreamHandler(struct _CommandHandle *cmdHandle,
                                         const T_CmdInfo *cmdInfo,
@@ -81,7 +81,8 @@ AdvancedSensing::AdvancedSensing(Vehicle* vehiclePtr) :
   liveview(NULL),
   perception(NULL),
   fpvCam_ptr(NULL),
-  mainCam_ptr(NULL)
+  mainCam_ptr(NULL),
+  decodeScheduler(NULL)
 {
   stereoHandler.callback  = 0;
   stereoHandler.userData  = 0;
@@ -141,6 +142,11 @@ AdvancedSensing::AdvancedSensing(Vehicle* vehiclePtr) :
         {LiveView::OSDK_CAMERA_POSITION_NO_2, (new DJICameraStreamDecoder())},
         {LiveView::OSDK_CAMERA_POSITION_NO_3, (new DJICameraStreamDecoder())},
     };
+    /*! All positions share one bounded pool of decode workers */
+    decodeScheduler = new DJICameraDecodeScheduler();
+    for (auto pair : streamDecoder) {
+      if (pair.second) pair.second->setScheduler(decodeScheduler);
+    }
   } else {
     DSTATUS("Advanced Sensing init for the M210 drone");
     this->advancedSensingProtocol = new AdvancedSensingProtocol();
@@ -175,6 +181,11 @@ AdvancedSensing::~AdvancedSensing()
     delete perception;
   }
 
+  /*! Stop the decode workers before the decoders they feed */
+  if (decodeScheduler) {
+    delete decodeScheduler;
+  }
+
   for (auto pair : streamDecoder) {
     if (pair.second) delete pair.second;
   }
@@ -470,7 +481,7 @@ AdvancedSensing::getAdvancedSensingProtocol()
 
 void H264ToRGBCb(uint8_t* buf, int bufLen, void* userData) {
   DJICameraStreamDecoder *decoder = (DJICameraStreamDecoder *)userData;
-  decoder->decodeBuffer(buf, bufLen);
+  decoder->submitBuffer(buf, bufLen);
 }
 
 bool AdvancedSensing::startFPVCameraStream(CameraImageCallback cb,
@@ -510,6 +521,42 @@ bool AdvancedSensing::startMainCameraStream(CameraImageCallback cb, void * cbPar
   }
 }
 
+bool AdvancedSensing::startFPVCameraFrameStream(CameraImageFrameCallback cb,
+                                                void *cbParam) {
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_FPV);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      deocderPair->second->init();
+      deocderPair->second->registerFrameCallback(cb, cbParam);
+      return (LiveView::OSDK_LIVEVIEW_PASS
+          == startH264Stream(LiveView::OSDK_CAMERA_POSITION_FPV, H264ToRGBCb,
+                             deocderPair->second));
+    } else {
+      return false;
+    }
+  } else {
+    return fpvCam_ptr->startCameraFrameStream(cb, cbParam);
+  }
+}
+
+bool AdvancedSensing::startMainCameraFrameStream(CameraImageFrameCallback cb,
+                                                 void *cbParam) {
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_NO_1);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      deocderPair->second->init();
+      deocderPair->second->registerFrameCallback(cb, cbParam);
+      return (LiveView::OSDK_LIVEVIEW_PASS
+          == startH264Stream(LiveView::OSDK_CAMERA_POSITION_NO_1, H264ToRGBCb,
+                             deocderPair->second));
+    } else {
+      return false;
+    }
+  } else {
+    return mainCam_ptr->startCameraFrameStream(cb, cbParam);
+  }
+}
+
 void AdvancedSensing::stopFPVCameraStream()
 {
   if (vehicle_ptr->isM300()) {
@@ -592,6 +639,115 @@ bool AdvancedSensing::getFPVCameraImage(CameraRGBImage& copyOfImage)
   return ret;
 }
 
+bool AdvancedSensing::borrowMainCameraImage(CameraImageFrame& frame)
+{
+  bool ret = false;
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_NO_1);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      ret = deocderPair->second->decodedImageHandler.borrowNewImage(frame, 20);
+    }
+  } else {
+    ret = mainCam_ptr->borrowCurrentImage(frame);
+  }
+  return ret;
+}
+
+bool AdvancedSensing::borrowFPVCameraImage(CameraImageFrame& frame)
+{
+  bool ret = false;
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_FPV);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      ret = deocderPair->second->decodedImageHandler.borrowNewImage(frame, 20);
+    }
+  } else {
+    ret = fpvCam_ptr->borrowCurrentImage(frame);
+  }
+  return ret;
+}
+
+void AdvancedSensing::releaseCameraImage(const CameraImageFrame& frame)
+{
+  if (frame.owner) {
+    frame.owner->releaseImage(frame);
+  }
+}
+
+void AdvancedSensing::getMainCameraImageStats(CameraImageStats& stats)
+{
+  stats = CameraImageStats();
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_NO_1);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      deocderPair->second->decodedImageHandler.getStats(stats);
+    }
+  } else {
+    mainCam_ptr->getImageStats(stats);
+  }
+}
+
+void AdvancedSensing::getFPVCameraImageStats(CameraImageStats& stats)
+{
+  stats = CameraImageStats();
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_FPV);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      deocderPair->second->decodedImageHandler.getStats(stats);
+    }
+  } else {
+    fpvCam_ptr->getImageStats(stats);
+  }
+}
+
+void AdvancedSensing::setMainCameraImageFormat(CameraImageFormat format,
+                                               bool convertOnDemand)
+{
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_NO_1);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      deocderPair->second->setOutputFormat(format, convertOnDemand);
+    }
+  } else {
+    mainCam_ptr->setImageFormat(format, convertOnDemand);
+  }
+}
+
+void AdvancedSensing::setFPVCameraImageFormat(CameraImageFormat format,
+                                              bool convertOnDemand)
+{
+  if (vehicle_ptr->isM300()) {
+    auto deocderPair = streamDecoder.find(LiveView::OSDK_CAMERA_POSITION_FPV);
+    if ((deocderPair != streamDecoder.end()) && deocderPair->second) {
+      deocderPair->second->setOutputFormat(format, convertOnDemand);
+    }
+  } else {
+    fpvCam_ptr->setImageFormat(format, convertOnDemand);
+  }
+}
+
+bool AdvancedSensing::configureDecodeScheduler(
+    const DJICameraDecodeScheduler::Config& config)
+{
+  if (!decodeScheduler) {
+    DERROR("Decode scheduler is only available on M300.");
+    return false;
+  }
+  return decodeScheduler->configure(config);
+}
+
+bool AdvancedSensing::getDecodeStreamStats(
+    LiveView::LiveViewCameraPosition pos,
+    DJICameraDecodeScheduler::StreamStats& stats)
+{
+  auto deocderPair = streamDecoder.find(pos);
+  if (!decodeScheduler || (deocderPair == streamDecoder.end()) ||
+      !deocderPair->second) {
+    return false;
+  }
+  return decodeScheduler->getStreamStats(deocderPair->second, stats);
+}
+
 void AdvancedSensing::setAcmDevicePath(const char *acm_path)
 {
     this->acm_dev=acm_path;
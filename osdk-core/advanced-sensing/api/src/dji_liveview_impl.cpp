@@ -61,18 +61,46 @@ void defaultH264CB(uint8_t* buf, int bufLen, void* userData) {
   *(uint8_t *)userData = 1;
 }
 
-std::map<LiveView::LiveViewCameraPosition, LiveViewImpl::H264CallbackHandler> LiveViewImpl::h264CbHandlerMap = {
-        {LiveView::OSDK_CAMERA_POSITION_NO_1, {defaultH264CB, (void *)&(defUserData[LiveView::OSDK_CAMERA_POSITION_NO_1])}},
-        {LiveView::OSDK_CAMERA_POSITION_NO_2, {defaultH264CB, (void *)&(defUserData[LiveView::OSDK_CAMERA_POSITION_NO_2])}},
-        {LiveView::OSDK_CAMERA_POSITION_NO_3, {defaultH264CB, (void *)&(defUserData[LiveView::OSDK_CAMERA_POSITION_NO_3])}},
-        {LiveView::OSDK_CAMERA_POSITION_FPV,  {defaultH264CB, (void *)&(defUserData[LiveView::OSDK_CAMERA_POSITION_FPV])}},
-    };
+#define H264_DEF_SLOT(pos) \
+  {{defaultH264CB}, {(void *)&(defUserData[pos])}, {0}}
+#define H264_EMPTY_SLOT {{NULL}, {NULL}, {0}}
+
+/*! Indexed directly by LiveViewCameraPosition; unused positions stay empty. */
+LiveViewImpl::H264CallbackSlot LiveViewImpl::h264CbSlots[LiveViewImpl::H264_CB_SLOT_NUM] = {
+    H264_DEF_SLOT(LiveView::OSDK_CAMERA_POSITION_NO_1),
+    H264_DEF_SLOT(LiveView::OSDK_CAMERA_POSITION_NO_2),
+    H264_DEF_SLOT(LiveView::OSDK_CAMERA_POSITION_NO_3),
+    H264_EMPTY_SLOT,
+    H264_EMPTY_SLOT,
+    H264_EMPTY_SLOT,
+    H264_EMPTY_SLOT,
+    H264_DEF_SLOT(LiveView::OSDK_CAMERA_POSITION_FPV),
+};
+
+std::atomic_flag LiveViewImpl::h264CbWriteLock = ATOMIC_FLAG_INIT;
+
+void LiveViewImpl::setH264Handler(LiveView::LiveViewCameraPosition pos,
+                                  H264Callback cb, void *userData) {
+  if ((pos < 0) || (pos >= H264_CB_SLOT_NUM)) return;
+
+  /*! Writers are serialized; the reader side never takes this lock. */
+  while (h264CbWriteLock.test_and_set(std::memory_order_acquire)) {
+  }
+  H264CallbackSlot &slot = h264CbSlots[pos];
+  uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+  slot.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.cb.store(cb, std::memory_order_relaxed);
+  slot.userData.store(userData, std::memory_order_relaxed);
+  slot.seq.store(seq + 2, std::memory_order_release);
+  h264CbWriteLock.clear(std::memory_order_release);
+}
 
 T_RecvCmdItem LiveViewImpl::bulkCmdList[] = {
-    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_FPV_CAM_TEMP_CMD_ID,  MASK_HOST_DEVICE_SET_ID, (void *)&h264CbHandlerMap, RecordStreamHandler),
-    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_MAIN_CAM_TEMP_CMD_ID, MASK_HOST_DEVICE_SET_ID, (void *)&h264CbHandlerMap, RecordStreamHandler),
-    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_VICE_CAM_TEMP_CMD_ID, MASK_HOST_DEVICE_SET_ID, (void *)&h264CbHandlerMap, RecordStreamHandler),
-    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_TOP_CAM_TEMP_CMD_ID,  MASK_HOST_DEVICE_SET_ID, (void *)&h264CbHandlerMap, RecordStreamHandler),
+    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_FPV_CAM_TEMP_CMD_ID,  MASK_HOST_DEVICE_SET_ID, (void *)h264CbSlots, RecordStreamHandler),
+    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_MAIN_CAM_TEMP_CMD_ID, MASK_HOST_DEVICE_SET_ID, (void *)h264CbSlots, RecordStreamHandler),
+    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_VICE_CAM_TEMP_CMD_ID, MASK_HOST_DEVICE_SET_ID, (void *)h264CbSlots, RecordStreamHandler),
+    PROT_CMD_ITEM(0, 0, LIVEVIEW_TEMP_CMD_SET, LIVEVIEW_TOP_CAM_TEMP_CMD_ID,  MASK_HOST_DEVICE_SET_ID, (void *)h264CbSlots, RecordStreamHandler),
 };
 
 LiveViewImpl::LiveViewImpl(Vehicle* vehiclePtr) :
@@ -110,8 +138,7 @@ E_OsdkStat LiveViewImpl::RecordStreamHandler(struct _CommandHandle *cmdHandle,
     return OSDK_STAT_ERR;
   }
 
-  std::map<LiveView::LiveViewCameraPosition, H264CallbackHandler> handlerMap =
-      *(std::map<LiveView::LiveViewCameraPosition, H264CallbackHandler> *)userData;
+  H264CallbackSlot *slots = (H264CallbackSlot *)userData;
 
   LiveView::LiveViewCameraPosition pos;
   switch (cmdInfo->cmdId) {
@@ -131,10 +158,20 @@ E_OsdkStat LiveViewImpl::RecordStreamHandler(struct _CommandHandle *cmdHandle,
       return OSDK_STAT_ERR_OUT_OF_RANGE;
   }
 
-  if((handlerMap.find(pos) != handlerMap.end()) && (handlerMap[pos].cb != NULL)) {
-    handlerMap[pos].cb((uint8_t *)cmdData, cmdInfo->dataLen, handlerMap[pos].userData);
+  const H264CallbackSlot &slot = slots[pos];
+  H264CallbackHandler handler;
+  uint32_t seq;
+  do {
+    seq = slot.seq.load(std::memory_order_acquire);
+    handler.cb = slot.cb.load(std::memory_order_relaxed);
+    handler.userData = slot.userData.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || (seq != slot.seq.load(std::memory_order_relaxed)));
+
+  if (handler.cb != NULL) {
+    handler.cb((uint8_t *)cmdData, cmdInfo->dataLen, handler.userData);
   } else {
-    //DERROR("Can't find valid cb in handlerMap, pos = %d", pos);
+    //DERROR("Can't find valid cb in h264CbSlots, pos = %d", pos);
   }
 
   return OSDK_STAT_OK;
@@ -467,10 +504,7 @@ LiveView::LiveViewErrCode LiveViewImpl::startH264Stream(LiveView::LiveViewCamera
     return LiveView::OSDK_LIVEVIEW_CAM_NOT_MOUNTED;
   }
 
-  if (h264CbHandlerMap.find(pos) != h264CbHandlerMap.end()) {
-    h264CbHandlerMap[pos].cb = cb;
-    h264CbHandlerMap[pos].userData = userData;
-  }
+  setH264Handler(pos, cb, userData);
 
   if(subscribeLiveViewData(targetCamType, pos) == -1) {
     //vehicle->linker->destroyLiveViewTask();
@@ -0,0 +1,358 @@
+/*
+ * DJI Onboard SDK Advanced Sensing APIs
+ *
+ * Copyright (c) 2026 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ * @file dji_camera_decode_scheduler.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "dji_camera_decode_scheduler.hpp"
+#include "dji_camera_stream_decoder.hpp"
+#include "dji_log.hpp"
+#include <sched.h>
+
+DJICameraDecodeScheduler::DJICameraDecodeScheduler()
+  : m_running(false)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_cond_init(&m_condv, NULL);
+  startWorkers();
+}
+
+DJICameraDecodeScheduler::~DJICameraDecodeScheduler()
+{
+  stopWorkers();
+  for(size_t i = 0; i < m_streams.size(); i++)
+  {
+    delete m_streams[i];
+  }
+  pthread_mutex_destroy(&m_mutex);
+  pthread_cond_destroy(&m_condv);
+}
+
+bool DJICameraDecodeScheduler::configure(const Config& config)
+{
+  stopWorkers();
+
+  pthread_mutex_lock(&m_mutex);
+  m_config = config;
+  if(m_config.workerNum < 1)
+  {
+    m_config.workerNum = 1;
+  }
+  if(m_config.codecThreads < 1)
+  {
+    m_config.codecThreads = 1;
+  }
+  for(size_t i = 0; i < m_streams.size(); i++)
+  {
+    m_streams[i]->decoder->setCodecThreads(m_config.codecThreads);
+  }
+  pthread_mutex_unlock(&m_mutex);
+
+  return startWorkers();
+}
+
+bool DJICameraDecodeScheduler::startWorkers()
+{
+  pthread_mutex_lock(&m_mutex);
+  m_running = true;
+  int num = m_config.workerNum;
+  pthread_mutex_unlock(&m_mutex);
+
+  for(int i = 0; i < num; i++)
+  {
+    pthread_t tid;
+    if(0 != pthread_create(&tid, NULL, workerEntry, this))
+    {
+      DERROR_PRIVATE("Decode worker %d creation failed!\n", i);
+      break;
+    }
+#ifdef __linux__
+    if(!m_config.cpuAffinity.empty())
+    {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(m_config.cpuAffinity[i % m_config.cpuAffinity.size()], &cpus);
+      if(0 != pthread_setaffinity_np(tid, sizeof(cpus), &cpus))
+      {
+        DERROR_PRIVATE("Failed to pin decode worker %d\n", i);
+      }
+    }
+#endif
+    m_workers.push_back(tid);
+  }
+
+  if(m_workers.empty())
+  {
+    pthread_mutex_lock(&m_mutex);
+    m_running = false;
+    pthread_mutex_unlock(&m_mutex);
+    return false;
+  }
+
+  DSTATUS_PRIVATE("%d decode worker(s) started\n", (int)m_workers.size());
+  return true;
+}
+
+void DJICameraDecodeScheduler::stopWorkers()
+{
+  pthread_mutex_lock(&m_mutex);
+  m_running = false;
+  pthread_cond_broadcast(&m_condv);
+  pthread_mutex_unlock(&m_mutex);
+
+  for(size_t i = 0; i < m_workers.size(); i++)
+  {
+    pthread_join(m_workers[i], NULL);
+  }
+  m_workers.clear();
+}
+
+void DJICameraDecodeScheduler::addStream(DJICameraStreamDecoder* decoder)
+{
+  if(!decoder)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_mutex);
+  if(NULL == findStream(decoder))
+  {
+    Stream* s = new Stream();
+    s->decoder      = decoder;
+    s->scheduled    = false;
+    s->decoding     = false;
+    s->waitKeyframe = false;
+    s->stats        = StreamStats();
+    m_streams.push_back(s);
+    decoder->setCodecThreads(m_config.codecThreads);
+  }
+  pthread_mutex_unlock(&m_mutex);
+}
+
+DJICameraDecodeScheduler::Stream*
+DJICameraDecodeScheduler::findStream(DJICameraStreamDecoder* decoder)
+{
+  for(size_t i = 0; i < m_streams.size(); i++)
+  {
+    if(m_streams[i]->decoder == decoder)
+    {
+      return m_streams[i];
+    }
+  }
+  return NULL;
+}
+
+void DJICameraDecodeScheduler::recycleChunk(Stream* s, std::vector<uint8_t>& chunk)
+{
+  if(s->spare.size() < MAX_SPARE_CHUNKS)
+  {
+    chunk.clear();
+    s->spare.push_back(std::vector<uint8_t>());
+    s->spare.back().swap(chunk);
+  }
+}
+
+/*! Look for an SPS or IDR NAL unit (Annex B start code). A start code split
+ *  across two chunks is missed, which only delays the resync by one
+ *  keyframe.
+ */
+bool DJICameraDecodeScheduler::containsKeyframe(const uint8_t* buf, int len)
+{
+  for(int i = 0; i + 3 < len; i++)
+  {
+    if(buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1)
+    {
+      uint8_t nalType = buf[i + 3] & 0x1F;
+      if(nalType == 7 || nalType == 5)
+      {
+        return true;
+      }
+      i += 2;
+    }
+  }
+  return false;
+}
+
+void DJICameraDecodeScheduler::submit(DJICameraStreamDecoder* decoder,
+                                      const uint8_t* buf, int len)
+{
+  if(!buf || len <= 0)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_mutex);
+  Stream* s = findStream(decoder);
+  if(NULL == s || !m_running)
+  {
+    pthread_mutex_unlock(&m_mutex);
+    if(decoder)
+    {
+      decoder->decodeBuffer((uint8_t*)buf, len);
+    }
+    return;
+  }
+
+  s->stats.submittedChunks++;
+  bool isKey = containsKeyframe(buf, len);
+
+  if(s->waitKeyframe)
+  {
+    if(!isKey)
+    {
+      s->stats.droppedChunks++;
+      s->stats.droppedBytes += len;
+      pthread_mutex_unlock(&m_mutex);
+      return;
+    }
+    s->waitKeyframe = false;
+    s->stats.keyframeResyncs++;
+  }
+
+  /* Behind by more than the budget: throw the backlog away and restart
+   * from the newest keyframe so latency stays bounded.
+   */
+  if(s->stats.queuedBytes + len > m_config.maxQueuedBytes)
+  {
+    while(!s->queue.empty())
+    {
+      s->stats.droppedChunks++;
+      s->stats.droppedBytes += s->queue.front().size();
+      recycleChunk(s, s->queue.front());
+      s->queue.pop_front();
+    }
+    s->stats.queuedBytes = 0;
+
+    /* Nothing left to hand out, so take the stream off the ready list.
+     * A worker in the middle of a chunk will unschedule it when done.
+     */
+    if(s->scheduled && !s->decoding)
+    {
+      for(std::deque<Stream*>::iterator it = m_ready.begin();
+          it != m_ready.end(); ++it)
+      {
+        if(*it == s)
+        {
+          m_ready.erase(it);
+          break;
+        }
+      }
+      s->scheduled = false;
+    }
+
+    if(!isKey)
+    {
+      s->waitKeyframe = true;
+      s->stats.droppedChunks++;
+      s->stats.droppedBytes += len;
+      pthread_mutex_unlock(&m_mutex);
+      return;
+    }
+    s->stats.keyframeResyncs++;
+  }
+
+  s->queue.push_back(std::vector<uint8_t>());
+  if(!s->spare.empty())
+  {
+    s->queue.back().swap(s->spare.back());
+    s->spare.pop_back();
+  }
+  s->queue.back().assign(buf, buf + len);
+  s->stats.queuedBytes += len;
+
+  if(!s->scheduled)
+  {
+    s->scheduled = true;
+    m_ready.push_back(s);
+    pthread_cond_signal(&m_condv);
+  }
+  pthread_mutex_unlock(&m_mutex);
+}
+
+bool DJICameraDecodeScheduler::getStreamStats(DJICameraStreamDecoder* decoder,
+                                              StreamStats& stats)
+{
+  pthread_mutex_lock(&m_mutex);
+  Stream* s = findStream(decoder);
+  if(s)
+  {
+    stats = s->stats;
+  }
+  pthread_mutex_unlock(&m_mutex);
+  return (NULL != s);
+}
+
+void* DJICameraDecodeScheduler::workerEntry(void* p)
+{
+  static_cast<DJICameraDecodeScheduler*>(p)->workerFunc();
+  return NULL;
+}
+
+void DJICameraDecodeScheduler::workerFunc()
+{
+  std::vector<uint8_t> chunk;
+
+  pthread_mutex_lock(&m_mutex);
+  while(m_running)
+  {
+    if(m_ready.empty())
+    {
+      pthread_cond_wait(&m_condv, &m_mutex);
+      continue;
+    }
+
+    /* One chunk per turn, then the stream goes to the back of the line,
+     * so a busy camera cannot starve the others.
+     */
+    Stream* s = m_ready.front();
+    m_ready.pop_front();
+    if(s->queue.empty())
+    {
+      s->scheduled = false;
+      continue;
+    }
+    chunk.swap(s->queue.front());
+    s->queue.pop_front();
+    s->stats.queuedBytes -= chunk.size();
+    s->decoding = true;
+    pthread_mutex_unlock(&m_mutex);
+
+    s->decoder->decodeBuffer(chunk.data(), (int)chunk.size());
+
+    pthread_mutex_lock(&m_mutex);
+    s->decoding = false;
+    s->stats.decodedChunks++;
+    recycleChunk(s, chunk);
+    if(!s->queue.empty())
+    {
+      m_ready.push_back(s);
+    }
+    else
+    {
+      s->scheduled = false;
+    }
+  }
+  pthread_mutex_unlock(&m_mutex);
+}
@@ -0,0 +1,102 @@
+/** @file dji_camera_decode_scheduler.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Shared worker pool that decodes the H264 streams of all cameras
+ *
+ *  @copyright 2026 DJI. All rights reserved.
+ *
+ */
+
+#ifndef DJICAMERADECODESCHEDULER_HH
+#define DJICAMERADECODESCHEDULER_HH
+
+#include <deque>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "pthread.h"
+
+class DJICameraStreamDecoder;
+
+class DJICameraDecodeScheduler
+{
+public:
+  struct Config
+  {
+    //! Decode worker threads shared by all streams
+    int workerNum;
+    //! FFmpeg threads inside each decoder
+    int codecThreads;
+    //! CPUs the workers are pinned to in turn; empty means no pinning
+    std::vector<int> cpuAffinity;
+    //! Per-stream backlog before it drops to the next keyframe
+    size_t maxQueuedBytes;
+
+    Config() : workerNum(2), codecThreads(1), maxQueuedBytes(2 * 1024 * 1024) {}
+  };
+
+  struct StreamStats
+  {
+    uint64_t submittedChunks;
+    uint64_t decodedChunks;
+    uint64_t droppedChunks;
+    uint64_t droppedBytes;
+    uint64_t keyframeResyncs;
+    size_t   queuedBytes;
+  };
+
+  DJICameraDecodeScheduler();
+  ~DJICameraDecodeScheduler();
+
+  /*! @brief Apply a new configuration, restarting the workers.
+   *  Queued chunks are kept and picked up by the new workers.
+   */
+  bool configure(const Config& config);
+
+  /*! Attach a decoder; its chunks are decoded in order by one worker at a time. */
+  void addStream(DJICameraStreamDecoder* decoder);
+
+  /*! @brief Queue one chunk of raw H264 for decoding.
+   *  @note Called from the receive thread. The data is copied into a
+   *        recycled per-stream buffer, so the caller's buffer can be reused.
+   */
+  void submit(DJICameraStreamDecoder* decoder, const uint8_t* buf, int len);
+
+  bool getStreamStats(DJICameraStreamDecoder* decoder, StreamStats& stats);
+
+private:
+  typedef struct Stream
+  {
+    DJICameraStreamDecoder*           decoder;
+    std::deque<std::vector<uint8_t> > queue;
+    std::vector<std::vector<uint8_t> > spare;
+    // queued or being decoded by a worker
+    bool                              scheduled;
+    // a worker is decoding a chunk of this stream right now
+    bool                              decoding;
+    // backlog was dropped, discard chunks until a keyframe arrives
+    bool                              waitKeyframe;
+    StreamStats                       stats;
+  } Stream;
+
+  static const size_t MAX_SPARE_CHUNKS = 16;
+
+  static void* workerEntry(void* p);
+  void workerFunc();
+  bool startWorkers();
+  void stopWorkers();
+  Stream* findStream(DJICameraStreamDecoder* decoder);
+  void recycleChunk(Stream* s, std::vector<uint8_t>& chunk);
+  static bool containsKeyframe(const uint8_t* buf, int len);
+
+  pthread_mutex_t        m_mutex;
+  pthread_cond_t         m_condv;
+  Config                 m_config;
+  std::vector<pthread_t> m_workers;
+  bool                   m_running;
+  std::vector<Stream*>   m_streams;
+  std::deque<Stream*>    m_ready;
+};
+
+#endif // DJICAMERADECODESCHEDULER_HH
@@ -9,8 +9,11 @@
 #ifndef ADVANCED_SENSING_DJI_CAMERA_IMAGE_HPP
 #define ADVANCED_SENSING_DJI_CAMERA_IMAGE_HPP
 #include <cstdint>
+#include <cstddef>
 #include <vector>
 
+class DJICameraImageHandler;
+
 /*! @brief Data structure for the image frames from the
  *         FPV camera or main camera
  */
@@ -27,6 +30,63 @@ struct CameraRGBImage
  */
 typedef void (*CameraImageCallback)(CameraRGBImage pImg, void* userData);
 
+/*! @brief Pixel layout of the decoded frames
+ */
+enum CameraImageFormat
+{
+  // packed RGB, 3 bytes per pixel (default)
+  CAMERA_IMAGE_FORMAT_RGB24   = 0,
+  // packed BGR, 3 bytes per pixel, as used by OpenCV
+  CAMERA_IMAGE_FORMAT_BGR24   = 1,
+  // luma plane only, 1 byte per pixel
+  CAMERA_IMAGE_FORMAT_GRAY8   = 2,
+  // native decoder planes: Y, then U, then V at quarter size, no padding
+  CAMERA_IMAGE_FORMAT_YUV420P = 3,
+  // Y plane, then one plane of interleaved U/V pairs at quarter size
+  CAMERA_IMAGE_FORMAT_NV12    = 4
+};
+
+/*! @brief A borrowed, read-only view of a decoded frame
+ *
+ *  The pixels live in the decoder's frame pool and are not copied. The
+ *  slot stays reserved until the frame is released, so keep the borrow
+ *  short; every frame held back leaves one slot less for the decoder.
+ */
+struct CameraImageFrame
+{
+  const uint8_t* data;
+  size_t         size;
+  int            height;
+  int            width;
+  CameraImageFormat format;
+  // increases by one for every decoded frame published by the pool
+  uint64_t       seq;
+  // internal: pool and slot this frame was borrowed from
+  DJICameraImageHandler* owner;
+  int                    slot;
+};
+
+/*! @brief User callback function called by OSDK (in a dedicated thread)
+ *  when a new frame is decoded. The frame is only valid during the call;
+ *  it is released automatically when the callback returns.
+ */
+typedef void (*CameraImageFrameCallback)(const CameraImageFrame& frame,
+                                         void* userData);
+
+/*! @brief Counters of the decoded frame pool
+ */
+struct CameraImageStats
+{
+  // frames published by the decoder
+  uint64_t written;
+  // frames replaced by a newer one before anyone read them
+  uint64_t overwritten;
+  // frames discarded because every slot was still borrowed
+  uint64_t dropped;
+  // frames handed out through borrow or copy
+  uint64_t consumed;
+};
+
 /*! @brief User callback function called by OSDK (in a dedicated thread)
  *  when a H264 frame is received.
  */
@@ -23,12 +23,26 @@
  *
  */
 
+#include <cstring>
 #include "dji_camera_image_handler.hpp"
 
-DJICameraImageHandler::DJICameraImageHandler():m_newImageFlag(false)
+DJICameraImageHandler::DJICameraImageHandler()
+  : m_latest(-1), m_seq(0), m_stats(), m_newImageFlag(false),
+    m_outFormat(CAMERA_IMAGE_FORMAT_RGB24), m_convert(NULL),
+    m_convertUserData(NULL)
 {
   pthread_mutex_init(&m_mutex, NULL);
   pthread_cond_init(&m_condv, NULL);
+  for (int i = 0; i < FRAME_NUM; i++)
+  {
+    m_slots[i].height   = 0;
+    m_slots[i].width    = 0;
+    m_slots[i].format   = CAMERA_IMAGE_FORMAT_RGB24;
+    m_slots[i].convFormat = CAMERA_IMAGE_FORMAT_RGB24;
+    m_slots[i].convSeq  = 0;
+    m_slots[i].seq      = 0;
+    m_slots[i].refCount = 0;
+  }
 }
 
 DJICameraImageHandler::~DJICameraImageHandler()
@@ -37,39 +51,144 @@ DJICameraImageHandler::~DJICameraImageHandler()
   pthread_cond_destroy(&m_condv);
 }
 
-bool DJICameraImageHandler::getNewImageWithLock(CameraRGBImage & copyOfImage, int timeoutMilliSec)
+/*! @note Must be called with m_mutex held. On return m_newImageFlag is
+ *  true and m_latest points to the newest frame, unless it timed out.
+ */
+bool DJICameraImageHandler::waitNewImage(int timeoutMilliSec)
 {
-  int result = -1;
+  if(m_newImageFlag)
+  {
+    return true;
+  }
+
+  struct timespec absTimeout;
+  clock_gettime(CLOCK_REALTIME, &absTimeout);
+  absTimeout.tv_sec  += timeoutMilliSec / 1000;
+  absTimeout.tv_nsec += (timeoutMilliSec % 1000) * 1000000L;
+  if(absTimeout.tv_nsec >= 1000000000L)
+  {
+    absTimeout.tv_sec  += 1;
+    absTimeout.tv_nsec -= 1000000000L;
+  }
 
   /*! @note
    * Here result == 0 means successful.
    * Because this is the behavior of pthread_cond_timedwait.
    */
+  int result = 0;
+  while(!m_newImageFlag && result == 0)
+  {
+    result = pthread_cond_timedwait(&m_condv, &m_mutex, &absTimeout);
+  }
+  return m_newImageFlag;
+}
+
+/*! Take the newest frame and hold a reference on its slot.
+ *  @return slot index, or -1 on timeout
+ */
+int DJICameraImageHandler::takeNewImage(int timeoutMilliSec)
+{
+  int slot = -1;
+
   pthread_mutex_lock(&m_mutex);
-  if(m_newImageFlag)
+  if(waitNewImage(timeoutMilliSec))
   {
-    /* At this point, a copy of m_img is made, so it is safe to 
-     * do any modifications to copyOfImage in user code.
-     */
-    copyOfImage = m_img;
+    slot = m_latest;
+    m_slots[slot].refCount++;
     m_newImageFlag = false;
-    result = 0;
+    m_stats.consumed++;
   }
-  else
+  pthread_mutex_unlock(&m_mutex);
+  return slot;
+}
+
+/*! @note The caller holds a reference on the slot, and a published frame
+ *  is handed to exactly one reader, so the conversion runs unlocked.
+ */
+const std::vector<uint8_t>& DJICameraImageHandler::resolveImage(int slot, CameraImageFormat& format)
+{
+  FrameSlot& s = m_slots[slot];
+  format = s.format;
+
+  pthread_mutex_lock(&m_mutex);
+  CameraImageFormat target = m_outFormat;
+  ConvertFunc       convert = m_convert;
+  void*             userData = m_convertUserData;
+  pthread_mutex_unlock(&m_mutex);
+
+  if(s.format == target || NULL == convert)
   {
-    struct timespec absTimeout;
-    clock_gettime(CLOCK_REALTIME, &absTimeout);
-    absTimeout.tv_nsec += timeoutMilliSec * 1e6;
-    result = pthread_cond_timedwait(&m_condv, &m_mutex, &absTimeout);
+    return s.rawData;
+  }
 
-    if(result == 0)
+  if(s.convSeq != s.seq || s.convFormat != target)
+  {
+    if(!convert(s.rawData.data(), s.width, s.height, s.format, target,
+                s.convData, userData))
     {
-      copyOfImage = m_img;
-      m_newImageFlag = false;
+      return s.rawData;
     }
+    s.convSeq    = s.seq;
+    s.convFormat = target;
+  }
+  format = target;
+  return s.convData;
+}
+
+bool DJICameraImageHandler::getNewImageWithLock(CameraRGBImage & copyOfImage, int timeoutMilliSec)
+{
+  int slot = takeNewImage(timeoutMilliSec);
+  if(slot < 0)
+  {
+    return false;
+  }
+
+  /* At this point, a copy of the frame is made, so it is safe to
+   * do any modifications to copyOfImage in user code.
+   */
+  CameraImageFormat format;
+  copyOfImage.rawData = resolveImage(slot, format);
+  copyOfImage.height  = m_slots[slot].height;
+  copyOfImage.width   = m_slots[slot].width;
+
+  pthread_mutex_lock(&m_mutex);
+  m_slots[slot].refCount--;
+  pthread_mutex_unlock(&m_mutex);
+  return true;
+}
+
+bool DJICameraImageHandler::borrowNewImage(CameraImageFrame& frame, int timeoutMilliSec)
+{
+  int slot = takeNewImage(timeoutMilliSec);
+  if(slot < 0)
+  {
+    return false;
+  }
+
+  const std::vector<uint8_t>& data = resolveImage(slot, frame.format);
+  frame.data   = data.data();
+  frame.size   = data.size();
+  frame.height = m_slots[slot].height;
+  frame.width  = m_slots[slot].width;
+  frame.seq    = m_slots[slot].seq;
+  frame.owner  = this;
+  frame.slot   = slot;
+  return true;
+}
+
+void DJICameraImageHandler::releaseImage(const CameraImageFrame& frame)
+{
+  if(frame.owner != this || frame.slot < 0 || frame.slot >= FRAME_NUM)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_mutex);
+  if(m_slots[frame.slot].refCount > 0)
+  {
+    m_slots[frame.slot].refCount--;
   }
   pthread_mutex_unlock(&m_mutex);
-  return (result == 0) ? true : false;
 }
 
 bool DJICameraImageHandler::newImageIsReady()
@@ -77,16 +196,93 @@ bool DJICameraImageHandler::newImageIsReady()
   return m_newImageFlag;
 }
 
-void DJICameraImageHandler::writeNewImageWithLock(uint8_t* buf, int bufSize, int width, int height)
+uint8_t* DJICameraImageHandler::acquireWriteBuffer(int bufSize, int width, int height, int& slot)
 {
+  uint8_t* buf = NULL;
+
   pthread_mutex_lock(&m_mutex);
+  slot = -1;
+  /* Start after the newest frame so slots are reused in rotation and the
+   * newest frame stays readable until a newer one is committed.
+   */
+  for(int i = 1; i <= FRAME_NUM; i++)
+  {
+    int idx = (m_latest + i + FRAME_NUM) % FRAME_NUM;
+    if(idx != m_latest && m_slots[idx].refCount == 0)
+    {
+      slot = idx;
+      break;
+    }
+  }
+
+  if(slot < 0)
+  {
+    m_stats.dropped++;
+  }
+  else
+  {
+    FrameSlot& s = m_slots[slot];
+    s.refCount = 1;
+    s.height   = height;
+    s.width    = width;
+    if(s.rawData.size() != (size_t)bufSize)
+    {
+      s.rawData.resize(bufSize);
+    }
+    buf = s.rawData.data();
+  }
+  pthread_mutex_unlock(&m_mutex);
 
-  m_img.rawData.assign(buf, buf+bufSize);
-  m_img.height = height;
-  m_img.width  = width;
+  return buf;
+}
+
+void DJICameraImageHandler::commitWriteBuffer(int slot, CameraImageFormat format)
+{
+  if(slot < 0 || slot >= FRAME_NUM)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_mutex);
+  if(m_newImageFlag)
+  {
+    m_stats.overwritten++;
+  }
+  m_slots[slot].refCount--;
+  m_slots[slot].format = format;
+  m_slots[slot].seq = ++m_seq;
+  m_latest = slot;
   m_newImageFlag = true;
+  m_stats.written++;
 
-  pthread_cond_signal(&m_condv);
+  pthread_cond_broadcast(&m_condv);
   pthread_mutex_unlock(&m_mutex);
 }
 
+void DJICameraImageHandler::writeNewImageWithLock(uint8_t* buf, int bufSize, int width, int height)
+{
+  int slot = -1;
+  uint8_t* dst = acquireWriteBuffer(bufSize, width, height, slot);
+  if(dst)
+  {
+    memcpy(dst, buf, bufSize);
+    commitWriteBuffer(slot);
+  }
+}
+
+void DJICameraImageHandler::setOutputFormat(CameraImageFormat format,
+                                            ConvertFunc f, void* userData)
+{
+  pthread_mutex_lock(&m_mutex);
+  m_outFormat       = format;
+  m_convert         = f;
+  m_convertUserData = userData;
+  pthread_mutex_unlock(&m_mutex);
+}
+
+void DJICameraImageHandler::getStats(CameraImageStats& stats)
+{
+  pthread_mutex_lock(&m_mutex);
+  stats = m_stats;
+  pthread_mutex_unlock(&m_mutex);
+}
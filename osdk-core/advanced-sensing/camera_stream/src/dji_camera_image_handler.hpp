@@ -18,6 +18,9 @@
 class DJICameraImageHandler
 {
 public:
+  //! Number of preallocated frame slots reused in rotation
+  static const int FRAME_NUM = 4;
+
   DJICameraImageHandler();
   ~DJICameraImageHandler();
 
@@ -26,11 +29,65 @@ public:
   void writeNewImageWithLock(uint8_t* buf, int bufSize, int width, int height);
   bool getNewImageWithLock(CameraRGBImage & copyOfImage, int timeoutMilliSec);
 
+  /*! @brief Reserve a free slot for the decoder to write into directly.
+   *  @return the slot buffer, or NULL if every slot is borrowed (the frame
+   *          is counted as dropped)
+   */
+  uint8_t* acquireWriteBuffer(int bufSize, int width, int height, int& slot);
+  /*! Publish a slot filled through acquireWriteBuffer() as the newest frame. */
+  void commitWriteBuffer(int slot,
+                         CameraImageFormat format = CAMERA_IMAGE_FORMAT_RGB24);
+
+  /*! Converts a packed frame of another format into dstFormat. */
+  typedef bool (*ConvertFunc)(const uint8_t* src, int width, int height,
+                              CameraImageFormat srcFormat,
+                              CameraImageFormat dstFormat,
+                              std::vector<uint8_t>& dst, void* userData);
+
+  /*! @brief Set the format readers receive.
+   *  Frames committed in another format are converted by f when a reader
+   *  fetches them, so frames nobody reads are never converted.
+   */
+  void setOutputFormat(CameraImageFormat format, ConvertFunc f, void* userData);
+
+  /*! @brief Borrow the newest frame without copying it.
+   *  @note Every successful borrow must be paired with releaseImage().
+   */
+  bool borrowNewImage(CameraImageFrame& frame, int timeoutMilliSec);
+  void releaseImage(const CameraImageFrame& frame);
+
+  void getStats(CameraImageStats& stats);
+
 private:
-  pthread_mutex_t m_mutex;
-  pthread_cond_t  m_condv;
-  CameraRGBImage  m_img;
-  bool            m_newImageFlag;
+  typedef struct FrameSlot
+  {
+    std::vector<uint8_t> rawData;
+    int                  height;
+    int                  width;
+    CameraImageFormat    format;
+    // on-demand conversion result, valid while convSeq == seq
+    std::vector<uint8_t> convData;
+    CameraImageFormat    convFormat;
+    uint64_t             convSeq;
+    uint64_t             seq;
+    // borrowers plus the decoder while it is writing
+    int                  refCount;
+  } FrameSlot;
+
+  bool waitNewImage(int timeoutMilliSec);
+  int  takeNewImage(int timeoutMilliSec);
+  const std::vector<uint8_t>& resolveImage(int slot, CameraImageFormat& format);
+
+  pthread_mutex_t  m_mutex;
+  pthread_cond_t   m_condv;
+  FrameSlot        m_slots[FRAME_NUM];
+  int              m_latest;
+  uint64_t         m_seq;
+  CameraImageStats m_stats;
+  bool             m_newImageFlag;
+  CameraImageFormat m_outFormat;
+  ConvertFunc      m_convert;
+  void*            m_convertUserData;
 };
 
 #endif
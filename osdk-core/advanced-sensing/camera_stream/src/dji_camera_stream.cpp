@@ -57,6 +57,30 @@ DJICameraStream::~DJICameraStream()
 }
 
 bool DJICameraStream::startCameraStream(CameraImageCallback cb, void* cbParam)
+{
+  if(!startRawStream())
+  {
+    return false;
+  }
+
+  /*! 
+   * Callback registered by user.
+   * Run when a new image is available.
+   */
+  return decoder->registerCallback(cb, cbParam);
+}
+
+bool DJICameraStream::startCameraFrameStream(CameraImageFrameCallback cb, void* cbParam)
+{
+  if(!startRawStream())
+  {
+    return false;
+  }
+
+  return decoder->registerFrameCallback(cb, cbParam);
+}
+
+bool DJICameraStream::startRawStream()
 {
   if(!rawDataStream->init())
   {
@@ -77,21 +101,7 @@ bool DJICameraStream::startCameraStream(CameraImageCallback cb, void* cbParam)
    */
   rawDataStream->registerCallback(&decodeStream, decoder);
 
-  if(!rawDataStream->start())
-  {
-    return false;
-  }
-
-  /*! 
-   * Callback registered by user.
-   * Run when a new image is available.
-   */
-  if(!decoder->registerCallback(cb, cbParam))
-  {
-    return false;
-  }
-
-  return true;
+  return rawDataStream->start();
 }
 
 void DJICameraStream::stopCameraStream()
@@ -107,6 +117,21 @@ bool DJICameraStream::getCurrentImage(CameraRGBImage& copyOfImage)
   return decoder->decodedImageHandler.getNewImageWithLock(copyOfImage, 20);
 }
 
+bool DJICameraStream::borrowCurrentImage(CameraImageFrame& frame)
+{
+  return decoder->decodedImageHandler.borrowNewImage(frame, 20);
+}
+
+void DJICameraStream::getImageStats(CameraImageStats& stats)
+{
+  decoder->decodedImageHandler.getStats(stats);
+}
+
+void DJICameraStream::setImageFormat(CameraImageFormat format, bool convertOnDemand)
+{
+  decoder->setOutputFormat(format, convertOnDemand);
+}
+
 bool DJICameraStream::newImageIsReady()
 {
   return decoder->decodedImageHandler.newImageIsReady();
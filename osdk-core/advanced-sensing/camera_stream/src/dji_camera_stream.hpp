@@ -32,6 +32,14 @@ public:
 
   bool startCameraStream(CameraImageCallback cb = NULL, void * cbParam = NULL);
 
+  bool startCameraFrameStream(CameraImageFrameCallback cb, void * cbParam = NULL);
+
+  bool borrowCurrentImage(CameraImageFrame& frame);
+
+  void getImageStats(CameraImageStats& stats);
+
+  void setImageFormat(CameraImageFormat format, bool convertOnDemand = false);
+
   void stopCameraStream();
 
   bool startCameraH264(H264Callback cb = NULL, void * cbParam = NULL);
@@ -39,6 +47,8 @@ public:
   void stopCameraH264();
 
 private:
+  bool startRawStream();
+
   DJICameraStreamLink     *rawDataStream;
   DJICameraStreamDecoder  *decoder;
 
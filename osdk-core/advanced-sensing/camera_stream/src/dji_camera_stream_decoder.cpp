@@ -24,7 +24,9 @@
  */
 
 #include "dji_camera_stream_decoder.hpp"
+#include "dji_camera_decode_scheduler.hpp"
 #include "dji_log.hpp"
+#include <cstring>
 #include "unistd.h"
 #include "pthread.h"
 
@@ -32,29 +34,42 @@ DJICameraStreamDecoder::DJICameraStreamDecoder()
   : initSuccess(false),
     cbThreadIsRunning(false),
     cbThreadStatus(-1),
+    scheduler(NULL),
+    codecThreads(4),
     cb(NULL),
+    frameCb(NULL),
     cbUserParam(NULL),
     pCodecCtx(NULL),
     pCodec(NULL),
     pCodecParserCtx(NULL),
     pSwsCtx(NULL),
     pFrameYUV(NULL),
-    pFrameRGB(NULL),
-    rgbBuf(NULL),
-    bufSize(0)
+    bufSize(0),
+    outFormat(CAMERA_IMAGE_FORMAT_RGB24),
+    convertOnDemand(false),
+    pConvSwsCtx(NULL)
 {
   pthread_mutex_init(&decodemutex, NULL);
+  pthread_mutex_init(&convmutex, NULL);
+  decodedImageHandler.setOutputFormat(outFormat, convertImage, this);
 }
 
 DJICameraStreamDecoder::~DJICameraStreamDecoder()
 {
-  pthread_mutex_destroy(&decodemutex);
-  if(cb)
+  if(cb || frameCb)
   {
     registerCallback(NULL, NULL);
   }
 
   cleanup();
+
+  if (NULL != pConvSwsCtx)
+  {
+    sws_freeContext(pConvSwsCtx);
+    pConvSwsCtx = NULL;
+  }
+  pthread_mutex_destroy(&convmutex);
+  pthread_mutex_destroy(&decodemutex);
 }
 
 bool DJICameraStreamDecoder::init()
@@ -74,7 +89,7 @@ bool DJICameraStreamDecoder::init()
     return false;
   }
 
-  pCodecCtx->thread_count = 4;
+  pCodecCtx->thread_count = codecThreads;
   pCodec = avcodec_find_decoder(AV_CODEC_ID_H264);
   if (!pCodec || avcodec_open2(pCodecCtx, pCodec, NULL) < 0)
   {
@@ -93,12 +108,6 @@ bool DJICameraStreamDecoder::init()
     return false;
   }
 
-  pFrameRGB = av_frame_alloc();
-  if (!pFrameRGB)
-  {
-    return false;
-  }
-
   pSwsCtx = NULL;
 
   DSTATUS_PRIVATE("All components for decoding initialized ...\n");
@@ -152,18 +161,6 @@ void DJICameraStreamDecoder::cleanup()
     pCodecCtx = NULL;
   }
 
-  if (NULL != rgbBuf )
-  {
-    av_free(rgbBuf);
-    rgbBuf = NULL;
-  }
-
-  if (NULL != pFrameRGB)
-  {
-    av_free(pFrameRGB);
-    pFrameRGB = NULL;
-  }
-
   pthread_mutex_unlock(&decodemutex);
 }
 
@@ -179,17 +176,31 @@ void DJICameraStreamDecoder::callbackThreadFunc()
 {
   while(cbThreadIsRunning)
   {
-    CameraRGBImage copyOfImage;
-    if(!decodedImageHandler.getNewImageWithLock(copyOfImage, 1000))
+    CameraImageFrame frame;
+    if(!decodedImageHandler.borrowNewImage(frame, 1000))
     {
       DDEBUG_PRIVATE("Decoder Callback Thread: Get image time out\n");
       continue;
     }
 
-    if(cb)
+    if(frameCb)
     {
+      (*frameCb)(frame, cbUserParam);
+    }
+    else if(cb)
+    {
+      /* The legacy callback takes the image by value, so it still gets
+       * its own copy; the borrowed slot is returned right after.
+       */
+      CameraRGBImage copyOfImage;
+      copyOfImage.rawData.assign(frame.data, frame.data + frame.size);
+      copyOfImage.height = frame.height;
+      copyOfImage.width  = frame.width;
+      decodedImageHandler.releaseImage(frame);
       (*cb)(copyOfImage, cbUserParam);
+      continue;
     }
+    decodedImageHandler.releaseImage(frame);
   }
   DSTATUS_PRIVATE("Decoder Callback Thread Stopped...\n");
 }
@@ -232,30 +243,29 @@ void DJICameraStreamDecoder::decodeBuffer(uint8_t* buf, int bufLen)
         int h = pFrameYUV->height;
         //DSTATUS_PRIVATE("Got picture! size=%dx%d\n", w, h);
 
-        if(NULL == pSwsCtx)
+        /* With on-demand conversion the native planes are stored and the
+         * colour conversion runs only when a reader fetches the frame.
+         */
+        CameraImageFormat storeFormat = outFormat;
+        if(convertOnDemand && (outFormat == CAMERA_IMAGE_FORMAT_RGB24 ||
+                               outFormat == CAMERA_IMAGE_FORMAT_BGR24))
         {
-          pSwsCtx = sws_getContext(w, h, pCodecCtx->pix_fmt,
-                                   w, h, AV_PIX_FMT_RGB24,
-                                   4, NULL, NULL, NULL);
+          storeFormat = CAMERA_IMAGE_FORMAT_YUV420P;
         }
 
-        if(NULL == rgbBuf)
-        {
-          bufSize = avpicture_get_size(AV_PIX_FMT_RGB24, w, h);
-          rgbBuf = (uint8_t*) av_malloc(bufSize);
-          avpicture_fill((AVPicture*)pFrameRGB, rgbBuf, AV_PIX_FMT_RGB24, w, h);
-        }
-
-        if(NULL != pSwsCtx && NULL != rgbBuf)
-        {
-          sws_scale(pSwsCtx,
-                    (uint8_t const *const *) pFrameYUV->data, pFrameYUV->linesize, 0, pFrameYUV->height,
-                             pFrameRGB->data, pFrameRGB->linesize);
+        bufSize = avpicture_get_size(toPixelFormat(storeFormat), w, h);
 
-          pFrameRGB->height = h;
-          pFrameRGB->width = w;
+        /* Write straight into a pooled frame slot, so no further copy is
+         * needed before the frame reaches the reader.
+         */
+        int slot = -1;
+        uint8_t* outBuf =
+          decodedImageHandler.acquireWriteBuffer(bufSize, w, h, slot);
 
-          decodedImageHandler.writeNewImageWithLock(pFrameRGB->data[0], bufSize, w, h);
+        if(NULL != outBuf)
+        {
+          writeFrame(pFrameYUV, storeFormat, outBuf);
+          decodedImageHandler.commitWriteBuffer(slot, storeFormat);
         }
       }
     }
@@ -264,45 +274,232 @@ void DJICameraStreamDecoder::decodeBuffer(uint8_t* buf, int bufLen)
   av_free_packet(&pkt);
 }
 
+void DJICameraStreamDecoder::submitBuffer(uint8_t* buf, int bufLen)
+{
+  if(scheduler)
+  {
+    scheduler->submit(this, buf, bufLen);
+  }
+  else
+  {
+    decodeBuffer(buf, bufLen);
+  }
+}
+
+void DJICameraStreamDecoder::setScheduler(DJICameraDecodeScheduler* s)
+{
+  scheduler = s;
+  if(scheduler)
+  {
+    scheduler->addStream(this);
+  }
+}
+
+void DJICameraStreamDecoder::setCodecThreads(int num)
+{
+  codecThreads = (num > 0) ? num : 1;
+}
+
+AVPixelFormat DJICameraStreamDecoder::toPixelFormat(CameraImageFormat format)
+{
+  switch(format)
+  {
+    case CAMERA_IMAGE_FORMAT_BGR24:
+      return AV_PIX_FMT_BGR24;
+    case CAMERA_IMAGE_FORMAT_GRAY8:
+      return AV_PIX_FMT_GRAY8;
+    case CAMERA_IMAGE_FORMAT_YUV420P:
+      return AV_PIX_FMT_YUV420P;
+    case CAMERA_IMAGE_FORMAT_NV12:
+      return AV_PIX_FMT_NV12;
+    case CAMERA_IMAGE_FORMAT_RGB24:
+    default:
+      return AV_PIX_FMT_RGB24;
+  }
+}
+
+static void copyPlane(uint8_t* dst, int dstStride,
+                      const uint8_t* src, int srcStride, int rowBytes, int rows)
+{
+  for(int i = 0; i < rows; i++)
+  {
+    memcpy(dst + i * dstStride, src + i * srcStride, rowBytes);
+  }
+}
+
+static void interleavePlanes(uint8_t* dst, int dstStride,
+                             const uint8_t* srcU, int strideU,
+                             const uint8_t* srcV, int strideV,
+                             int cols, int rows)
+{
+  for(int i = 0; i < rows; i++)
+  {
+    uint8_t*       d = dst + i * dstStride;
+    const uint8_t* u = srcU + i * strideU;
+    const uint8_t* v = srcV + i * strideV;
+    for(int j = 0; j < cols; j++)
+    {
+      d[2 * j]     = u[j];
+      d[2 * j + 1] = v[j];
+    }
+  }
+}
+
+void DJICameraStreamDecoder::writeFrame(AVFrame* src, CameraImageFormat format, uint8_t* dst)
+{
+  int w = src->width;
+  int h = src->height;
+  AVPicture out;
+  avpicture_fill(&out, dst, toPixelFormat(format), w, h);
+
+  /* Y-only, YUV420P and NV12 output are plain plane copies when the
+   * decoder already produces 4:2:0 planes; anything else goes through
+   * swscale.
+   */
+  bool native420 = (pCodecCtx->pix_fmt == AV_PIX_FMT_YUV420P ||
+                    pCodecCtx->pix_fmt == AV_PIX_FMT_YUVJ420P);
+  if(native420 && format == CAMERA_IMAGE_FORMAT_GRAY8)
+  {
+    copyPlane(out.data[0], out.linesize[0], src->data[0], src->linesize[0], w, h);
+    return;
+  }
+  if(native420 && format == CAMERA_IMAGE_FORMAT_YUV420P)
+  {
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+    copyPlane(out.data[0], out.linesize[0], src->data[0], src->linesize[0], w, h);
+    copyPlane(out.data[1], out.linesize[1], src->data[1], src->linesize[1], cw, ch);
+    copyPlane(out.data[2], out.linesize[2], src->data[2], src->linesize[2], cw, ch);
+    return;
+  }
+  if(native420 && format == CAMERA_IMAGE_FORMAT_NV12)
+  {
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+    copyPlane(out.data[0], out.linesize[0], src->data[0], src->linesize[0], w, h);
+    interleavePlanes(out.data[1], out.linesize[1],
+                     src->data[1], src->linesize[1],
+                     src->data[2], src->linesize[2], cw, ch);
+    return;
+  }
+
+  pSwsCtx = sws_getCachedContext(pSwsCtx, w, h, pCodecCtx->pix_fmt,
+                                 w, h, toPixelFormat(format),
+                                 4, NULL, NULL, NULL);
+  if(NULL != pSwsCtx)
+  {
+    sws_scale(pSwsCtx,
+              (uint8_t const *const *) src->data, src->linesize, 0, h,
+              out.data, out.linesize);
+  }
+}
+
+bool DJICameraStreamDecoder::convertImage(const uint8_t* src, int width, int height,
+                                          CameraImageFormat srcFormat,
+                                          CameraImageFormat dstFormat,
+                                          std::vector<uint8_t>& dst, void* userData)
+{
+  DJICameraStreamDecoder* d = static_cast<DJICameraStreamDecoder*>(userData);
+  AVPixelFormat srcPixFmt = toPixelFormat(srcFormat);
+  AVPixelFormat dstPixFmt = toPixelFormat(dstFormat);
+
+  AVPicture in;
+  AVPicture out;
+  dst.resize(avpicture_get_size(dstPixFmt, width, height));
+  avpicture_fill(&in, src, srcPixFmt, width, height);
+  avpicture_fill(&out, dst.data(), dstPixFmt, width, height);
+
+  /* Runs on the reader's thread, so it keeps its own scaler. */
+  pthread_mutex_lock(&d->convmutex);
+  d->pConvSwsCtx = sws_getCachedContext(d->pConvSwsCtx, width, height, srcPixFmt,
+                                        width, height, dstPixFmt,
+                                        4, NULL, NULL, NULL);
+  bool ret = (NULL != d->pConvSwsCtx);
+  if(ret)
+  {
+    sws_scale(d->pConvSwsCtx,
+              (uint8_t const *const *) in.data, in.linesize, 0, height,
+              out.data, out.linesize);
+  }
+  pthread_mutex_unlock(&d->convmutex);
+  return ret;
+}
+
+void DJICameraStreamDecoder::setOutputFormat(CameraImageFormat format, bool onDemand)
+{
+  pthread_mutex_lock(&decodemutex);
+  outFormat       = format;
+  convertOnDemand = onDemand;
+  decodedImageHandler.setOutputFormat(format, convertImage, this);
+  pthread_mutex_unlock(&decodemutex);
+}
+
 bool DJICameraStreamDecoder::registerCallback(CameraImageCallback f, void *param)
 {
   cb = f;
+  frameCb = NULL;
   cbUserParam = param;
 
   /* When users register a non-NULL callback, we will start the callback thread. */
   if(NULL != cb)
   {
-    if(!cbThreadIsRunning)
+    return startCallbackThread();
+  }
+  else
+  {
+    stopCallbackThread();
+    return true;
+  }
+}
+
+bool DJICameraStreamDecoder::registerFrameCallback(CameraImageFrameCallback f, void *param)
+{
+  cb = NULL;
+  frameCb = f;
+  cbUserParam = param;
+
+  if(NULL != frameCb)
+  {
+    return startCallbackThread();
+  }
+  else
+  {
+    stopCallbackThread();
+    return true;
+  }
+}
+
+bool DJICameraStreamDecoder::startCallbackThread()
+{
+  if(!cbThreadIsRunning)
+  {
+    cbThreadIsRunning = true;
+    cbThreadStatus = pthread_create(&callbackThread, NULL, callbackThreadEntry, this);
+    if(0 == cbThreadStatus)
     {
-      cbThreadStatus = pthread_create(&callbackThread, NULL, callbackThreadEntry, this);
-      if(0 == cbThreadStatus)
-      {
-        DSTATUS_PRIVATE("User callback thread created successfully!\n");
-        cbThreadIsRunning = true;
-        return true;
-      }
-      else
-      {
-        DERROR_PRIVATE("User called thread creation failed!\n");
-        cbThreadIsRunning = false;
-        return false;
-      }
+      DSTATUS_PRIVATE("User callback thread created successfully!\n");
+      return true;
     }
     else
     {
-      DERROR_PRIVATE("Callback thread already running!\n");
-      return true;
+      DERROR_PRIVATE("User called thread creation failed!\n");
+      cbThreadIsRunning = false;
+      return false;
     }
   }
   else
   {
-    if(cbThreadStatus == 0)
-    {
-      cbThreadIsRunning = false;
-      pthread_join(callbackThread, NULL);
-      cbThreadStatus = -1;
-    }
+    DERROR_PRIVATE("Callback thread already running!\n");
     return true;
   }
 }
 
+void DJICameraStreamDecoder::stopCallbackThread()
+{
+  if(cbThreadStatus == 0)
+  {
+    cbThreadIsRunning = false;
+    pthread_join(callbackThread, NULL);
+    cbThreadStatus = -1;
+  }
+}
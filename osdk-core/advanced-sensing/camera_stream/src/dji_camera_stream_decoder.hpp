@@ -20,6 +20,8 @@ extern "C"{
 #include "dji_camera_image.hpp"
 #include "dji_camera_image_handler.hpp"
 
+class DJICameraDecodeScheduler;
+
 class DJICameraStreamDecoder
 {
 public:
@@ -34,10 +36,27 @@ public:
 
   void decodeBuffer(uint8_t* pBuf, int len);
 
+  /*! Decode through the attached scheduler, or inline if there is none. */
+  void submitBuffer(uint8_t* pBuf, int len);
+
+  void setScheduler(DJICameraDecodeScheduler* s);
+
+  /*! FFmpeg thread count, applied on the next init(). */
+  void setCodecThreads(int num);
+
   static void* callbackThreadEntry(void *p); 
 
   bool registerCallback(CameraImageCallback f, void* param);
 
+  /*! Like registerCallback(), but hands out borrowed frames without copying. */
+  bool registerFrameCallback(CameraImageFrameCallback f, void* param);
+
+  /*! @brief Select the pixel format handed to readers.
+   *  @param onDemand for RGB24/BGR24, keep the native planes and convert
+   *         only when a reader fetches the frame
+   */
+  void setOutputFormat(CameraImageFormat format, bool onDemand = false);
+
   DJICameraImageHandler decodedImageHandler;
 
 private:
@@ -47,8 +66,22 @@ private:
   bool      cbThreadIsRunning;
   int       cbThreadStatus;
 
-  CameraImageCallback cb;
-  void*               cbUserParam;
+  bool startCallbackThread();
+  void stopCallbackThread();
+
+  static AVPixelFormat toPixelFormat(CameraImageFormat format);
+  void writeFrame(AVFrame* src, CameraImageFormat format, uint8_t* dst);
+  static bool convertImage(const uint8_t* src, int width, int height,
+                           CameraImageFormat srcFormat,
+                           CameraImageFormat dstFormat,
+                           std::vector<uint8_t>& dst, void* userData);
+
+  DJICameraDecodeScheduler* scheduler;
+  int                       codecThreads;
+
+  CameraImageCallback      cb;
+  CameraImageFrameCallback frameCb;
+  void*                    cbUserParam;
 
   pthread_mutex_t       decodemutex;
   AVCodecContext*       pCodecCtx;
@@ -57,9 +90,12 @@ private:
   SwsContext*           pSwsCtx;
 
   AVFrame* pFrameYUV;
-  AVFrame* pFrameRGB;
-  uint8_t* rgbBuf;
   size_t   bufSize;
+
+  CameraImageFormat outFormat;
+  bool              convertOnDemand;
+  pthread_mutex_t   convmutex;
+  SwsContext*       pConvSwsCtx;
 };
 
 #endif // DJICAMERASTREAMDECODER_HH
@@ -39,21 +39,101 @@ namespace OSDK
 
 #define PRO_PURE_DATA_MAX_SIZE 1007 // 2^10 - header size
 
+class Mutex;
+
+/*! @brief Allocator for the protocol send/ACK buffers
+ *
+ *  @details Blocks are carved out of a fixed arena with a two-level
+ *  segregated fit (TLSF) index, so allocMemory and freeMemory do not depend
+ *  on the number of live blocks. Block descriptors are kept outside the
+ *  arena, so the whole arena stays usable. Only when no single free block
+ *  is large enough but the free bytes add up, the live blocks are moved
+ *  together (as the original allocator did) and their pmem is updated.
+ */
 class MMU
 {
+public:
+  //! Allocator counters, see getStats()
+  typedef struct Stats
+  {
+    uint32_t allocCount;
+    uint32_t freeCount;
+    uint32_t failCount;    // requests that could not be served
+    uint32_t compactCount; // allocations that needed the live blocks moved
+    uint16_t usedBytes;
+    uint16_t peakUsedBytes;
+    uint16_t freeBytes;
+    uint16_t largestFree;
+    uint8_t  usedTabs;
+    uint8_t  peakUsedTabs;
+    uint8_t  fragmentation; // % of free bytes outside the largest free block
+  } Stats;
+
 public:
   MMU();
   void setupMMU(void);
   void freeMemory(MMU_Tab* mmu_tab);
   MMU_Tab* allocMemory(uint16_t size);
 
+  /*! @brief Serialize allocMemory/freeMemory with the given mutex.
+   *  @param mutex NULL (the default) for no locking
+   */
+  void setMutex(Mutex* mutex);
+
+  void getStats(Stats& stats);
+
 public:
   static const int MMU_TABLE_NUM = 32;
   static const int MEMORY_SIZE   = 1024;
 
+private:
+  //! TLSF index: first level by power of two, SL_NUM linear steps inside
+  static const int     SL_LOG2   = 2;
+  static const int     SL_NUM    = 1 << SL_LOG2;
+  static const int     FL_NUM    = 11; // fls(MEMORY_SIZE) + 1
+  static const int     BLOCK_NUM = 2 * MMU_TABLE_NUM;
+  static const uint8_t NIL       = 0xFF;
+
+  //! Physical block of the arena, free or owned by one memoryTable entry
+  typedef struct Block
+  {
+    uint16_t offset;
+    uint16_t size;
+    uint8_t  prevPhys;
+    uint8_t  nextPhys;
+    uint8_t  prevFree;
+    uint8_t  nextFree; // also links the unused descriptors
+    uint8_t  tab;      // owning memoryTable index, 0 if free
+  } Block;
+
+  void lock();
+  void unlock();
+
+  static void mapping(uint16_t size, uint8_t& fl, uint8_t& sl);
+  uint8_t findFree(uint16_t size);
+  void insertFree(uint8_t idx);
+  void removeFree(uint8_t idx);
+  uint8_t newBlock();
+  void releaseBlock(uint8_t idx);
+  uint8_t compact();
+
 private:
   MMU_Tab memoryTable[MMU_TABLE_NUM];
   uint8_t memory[MEMORY_SIZE];
+
+  Block   block[BLOCK_NUM];
+  uint8_t tabBlock[MMU_TABLE_NUM];
+  uint8_t freeTab[MMU_TABLE_NUM];
+  uint8_t freeTabNum;
+  uint8_t spareBlock;
+  uint8_t firstBlock;
+
+  uint16_t flBitmap;
+  uint8_t  slBitmap[FL_NUM];
+  uint8_t  freeHead[FL_NUM][SL_NUM];
+
+  Mutex* mutex;
+  Stats  stats;
 };
 
 } // OSDK
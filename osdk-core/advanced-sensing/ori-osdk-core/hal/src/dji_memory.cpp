@@ -34,18 +34,57 @@
  */
 
 #include "dji_memory.hpp"
+#include "dji_thread_manager.hpp"
 #include <string.h>
 
 using namespace DJI::OSDK;
 
+//! Index of the highest set bit, x must not be 0
+static inline uint8_t
+highBit(uint32_t x)
+{
+#if defined(__GNUC__)
+  return static_cast<uint8_t>(31 - __builtin_clz(x));
+#else
+  uint8_t bit = 0;
+  while (x >>= 1)
+  {
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+//! Index of the lowest set bit, x must not be 0
+static inline uint8_t
+lowBit(uint32_t x)
+{
+#if defined(__GNUC__)
+  return static_cast<uint8_t>(__builtin_ctz(x));
+#else
+  uint8_t bit = 0;
+  while (!(x & 1))
+  {
+    x >>= 1;
+    bit++;
+  }
+  return bit;
+#endif
+}
+
 MMU::MMU()
+  : mutex(NULL)
 {
+  setupMMU();
 }
 
 void
 MMU::setupMMU()
 {
   uint32_t i;
+
+  lock();
+
   memoryTable[0].tabIndex  = 0;
   memoryTable[0].usageFlag = 1;
   memoryTable[0].pmem      = memory;
@@ -59,6 +98,61 @@ MMU::setupMMU()
   memoryTable[MMU_TABLE_NUM - 1].usageFlag = 1;
   memoryTable[MMU_TABLE_NUM - 1].pmem      = memory + MEMORY_SIZE;
   memoryTable[MMU_TABLE_NUM - 1].memSize   = 0;
+
+  //! Hand out the lowest table index first, like the linear search did
+  freeTabNum = 0;
+  for (i = MMU_TABLE_NUM - 2; i > 0; i--)
+  {
+    freeTab[freeTabNum++] = i;
+  }
+  memset(tabBlock, NIL, sizeof(tabBlock));
+
+  for (i = 0; i < BLOCK_NUM; i++)
+  {
+    block[i].nextFree = (i + 1 < BLOCK_NUM) ? i + 1 : NIL;
+  }
+  spareBlock = 0;
+
+  flBitmap = 0;
+  memset(slBitmap, 0, sizeof(slBitmap));
+  memset(freeHead, NIL, sizeof(freeHead));
+
+  firstBlock                 = newBlock();
+  block[firstBlock].offset   = 0;
+  block[firstBlock].size     = MEMORY_SIZE;
+  block[firstBlock].prevPhys = NIL;
+  block[firstBlock].nextPhys = NIL;
+  block[firstBlock].tab      = 0;
+  insertFree(firstBlock);
+
+  memset(&stats, 0, sizeof(stats));
+  stats.freeBytes = MEMORY_SIZE;
+
+  unlock();
+}
+
+void
+MMU::setMutex(Mutex* mutex)
+{
+  this->mutex = mutex;
+}
+
+void
+MMU::lock()
+{
+  if (mutex)
+  {
+    mutex->lock();
+  }
+}
+
+void
+MMU::unlock()
+{
+  if (mutex)
+  {
+    mutex->unlock();
+  }
 }
 
 void
@@ -72,131 +166,343 @@ MMU::freeMemory(MMU_Tab* mmu_tab)
   {
     return;
   }
+
+  lock();
+  if (mmu_tab->usageFlag == 0)
+  {
+    unlock();
+    return;
+  }
   mmu_tab->usageFlag = 0;
+
+  uint8_t t   = mmu_tab->tabIndex;
+  uint8_t idx = tabBlock[t];
+  tabBlock[t]           = NIL;
+  freeTab[freeTabNum++] = t;
+  stats.freeCount++;
+  stats.usedTabs--;
+
+  if (idx != NIL)
+  {
+    stats.usedBytes -= block[idx].size;
+    stats.freeBytes += block[idx].size;
+    block[idx].tab = 0;
+
+    //! Merge with the free physical neighbours
+    uint8_t next = block[idx].nextPhys;
+    if (next != NIL && block[next].tab == 0)
+    {
+      removeFree(next);
+      block[idx].size += block[next].size;
+      block[idx].nextPhys = block[next].nextPhys;
+      if (block[idx].nextPhys != NIL)
+      {
+        block[block[idx].nextPhys].prevPhys = idx;
+      }
+      releaseBlock(next);
+    }
+    uint8_t prev = block[idx].prevPhys;
+    if (prev != NIL && block[prev].tab == 0)
+    {
+      removeFree(prev);
+      block[prev].size += block[idx].size;
+      block[prev].nextPhys = block[idx].nextPhys;
+      if (block[prev].nextPhys != NIL)
+      {
+        block[block[prev].nextPhys].prevPhys = prev;
+      }
+      releaseBlock(idx);
+      idx = prev;
+    }
+    insertFree(idx);
+  }
+  unlock();
 }
 
 MMU_Tab*
 MMU::allocMemory(uint16_t size)
 {
-  uint32_t mem_used = 0;
-  uint8_t  i;
-  uint8_t  j                = 0;
-  uint8_t  mmu_tab_used_num = 0;
-  uint8_t  mmu_tab_used_index[MMU_TABLE_NUM];
+  uint8_t idx = NIL;
 
-  uint32_t temp32;
-  uint32_t temp_area[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+  lock();
 
-  uint32_t record_temp32 = 0;
-  uint8_t  magic_flag    = 0;
-
-  if (size > PRO_PURE_DATA_MAX_SIZE || size > MEMORY_SIZE)
+  if (size > PRO_PURE_DATA_MAX_SIZE || size > MEMORY_SIZE ||
+      freeTabNum == 0 || size > stats.freeBytes)
   {
-    return (MMU_Tab *) 0;
+    stats.failCount++;
+    unlock();
+    return (MMU_Tab*)0;
   }
 
-  for (i = 0; i < MMU_TABLE_NUM; i++)
+  if (size)
   {
-    if (memoryTable[i].usageFlag == 1)
+    idx = findFree(size);
+    if (idx == NIL)
     {
-      mem_used += memoryTable[i].memSize;
-      mmu_tab_used_index[mmu_tab_used_num++] = memoryTable[i].tabIndex;
+      //! Enough bytes are free, just not in one piece
+      idx = compact();
+      stats.compactCount++;
+    }
+    removeFree(idx);
+
+    //! Return the tail to the free lists. Without a spare descriptor the
+    //! whole block is handed out.
+    if (block[idx].size > size)
+    {
+      uint8_t rest = newBlock();
+      if (rest != NIL)
+      {
+        block[rest].offset   = block[idx].offset + size;
+        block[rest].size     = block[idx].size - size;
+        block[rest].prevPhys = idx;
+        block[rest].nextPhys = block[idx].nextPhys;
+        block[rest].tab      = 0;
+        if (block[rest].nextPhys != NIL)
+        {
+          block[block[rest].nextPhys].prevPhys = rest;
+        }
+        block[idx].nextPhys = rest;
+        block[idx].size     = size;
+        insertFree(rest);
+      }
+    }
+    stats.usedBytes += block[idx].size;
+    stats.freeBytes -= block[idx].size;
+    if (stats.usedBytes > stats.peakUsedBytes)
+    {
+      stats.peakUsedBytes = stats.usedBytes;
     }
   }
 
-  if (MEMORY_SIZE < (mem_used + size))
+  uint8_t t   = freeTab[--freeTabNum];
+  tabBlock[t] = idx;
+  if (idx != NIL)
   {
-    return (MMU_Tab *) 0;
+    block[idx].tab = t;
   }
+  memoryTable[t].pmem      = (idx != NIL) ? memory + block[idx].offset : memory;
+  memoryTable[t].memSize   = size;
+  memoryTable[t].usageFlag = 1;
 
-  if (mem_used == 0)
+  stats.allocCount++;
+  stats.usedTabs++;
+  if (stats.usedTabs > stats.peakUsedTabs)
   {
-    memoryTable[1].pmem      = memoryTable[0].pmem;
-    memoryTable[1].memSize   = size;
-    memoryTable[1].usageFlag = 1;
-    return &memoryTable[1];
+    stats.peakUsedTabs = stats.usedTabs;
   }
 
-  for (i = 0; i < (mmu_tab_used_num - 1); i++)
+  unlock();
+  return &memoryTable[t];
+}
+
+void
+MMU::getStats(Stats& stats)
+{
+  lock();
+  stats = this->stats;
+
+  //! The largest free block sits in the highest non-empty list
+  stats.largestFree = 0;
+  if (flBitmap)
   {
-    for (j = 0; j < (mmu_tab_used_num - i - 1); j++)
+    uint8_t fl = highBit(flBitmap);
+    uint8_t sl = highBit(slBitmap[fl]);
+    for (uint8_t i = freeHead[fl][sl]; i != NIL; i = block[i].nextFree)
     {
-      if (memoryTable[mmu_tab_used_index[j]].pmem >
-          memoryTable[mmu_tab_used_index[j + 1]].pmem)
+      if (block[i].size > stats.largestFree)
       {
-        mmu_tab_used_index[j + 1] ^= mmu_tab_used_index[j];
-        mmu_tab_used_index[j] ^= mmu_tab_used_index[j + 1];
-        mmu_tab_used_index[j + 1] ^= mmu_tab_used_index[j];
+        stats.largestFree = block[i].size;
       }
     }
   }
-  for (i = 0; i < (mmu_tab_used_num - 1); i++)
+  stats.fragmentation =
+    stats.freeBytes
+      ? (uint8_t)(100 * (stats.freeBytes - stats.largestFree) / stats.freeBytes)
+      : 0;
+  unlock();
+}
+
+void
+MMU::mapping(uint16_t size, uint8_t& fl, uint8_t& sl)
+{
+  fl = highBit(size);
+  if (fl >= SL_LOG2)
+  {
+    sl = (size >> (fl - SL_LOG2)) ^ SL_NUM;
+  }
+  else
+  {
+    sl = (size << (SL_LOG2 - fl)) ^ SL_NUM;
+  }
+}
+
+uint8_t
+MMU::findFree(uint16_t size)
+{
+  uint8_t  fl;
+  uint8_t  sl;
+  uint32_t map;
+
+  //! Round up to the next list so that any block found there fits
+  fl = highBit(size);
+  if (fl >= SL_LOG2)
+  {
+    mapping(size + (1 << (fl - SL_LOG2)) - 1, fl, sl);
+  }
+  else
   {
-    temp32 = static_cast<uint32_t>(memoryTable[mmu_tab_used_index[i + 1]].pmem -
-                                   memoryTable[mmu_tab_used_index[i]].pmem);
+    mapping(size, fl, sl);
+  }
 
-    if ((temp32 - memoryTable[mmu_tab_used_index[i]].memSize) >= size)
+  map = (fl < FL_NUM) ? (slBitmap[fl] & (~0U << sl)) : 0;
+  if (!map)
+  {
+    uint32_t flMap = (fl + 1 < FL_NUM) ? (flBitmap & (~0U << (fl + 1))) : 0;
+    if (flMap)
     {
-      if (temp_area[1] > (temp32 - memoryTable[mmu_tab_used_index[i]].memSize))
-      {
-        temp_area[0] = memoryTable[mmu_tab_used_index[i]].tabIndex;
-        temp_area[1] = temp32 - memoryTable[mmu_tab_used_index[i]].memSize;
-      }
+      fl  = lowBit(flMap);
+      map = slBitmap[fl];
     }
+  }
+  if (map)
+  {
+    return freeHead[fl][lowBit(map)];
+  }
 
-    record_temp32 += temp32 - memoryTable[mmu_tab_used_index[i]].memSize;
-    if (record_temp32 >= size && magic_flag == 0)
+  //! The list of the size itself may still hold a block that fits
+  mapping(size, fl, sl);
+  for (uint8_t i = freeHead[fl][sl]; i != NIL; i = block[i].nextFree)
+  {
+    if (block[i].size >= size)
     {
-      j          = i;
-      magic_flag = 1;
+      return i;
     }
   }
+  return NIL;
+}
 
-  if (temp_area[0] == 0xFFFFFFFF && temp_area[1] == 0xFFFFFFFF)
+void
+MMU::insertFree(uint8_t idx)
+{
+  uint8_t fl;
+  uint8_t sl;
+  mapping(block[idx].size, fl, sl);
+
+  block[idx].prevFree = NIL;
+  block[idx].nextFree = freeHead[fl][sl];
+  if (freeHead[fl][sl] != NIL)
+  {
+    block[freeHead[fl][sl]].prevFree = idx;
+  }
+  freeHead[fl][sl] = idx;
+  flBitmap |= 1 << fl;
+  slBitmap[fl] |= 1 << sl;
+}
+
+void
+MMU::removeFree(uint8_t idx)
+{
+  uint8_t fl;
+  uint8_t sl;
+  mapping(block[idx].size, fl, sl);
+
+  if (block[idx].prevFree != NIL)
+  {
+    block[block[idx].prevFree].nextFree = block[idx].nextFree;
+  }
+  else
   {
-    for (i = 0; i < j; i++)
+    freeHead[fl][sl] = block[idx].nextFree;
+  }
+  if (block[idx].nextFree != NIL)
+  {
+    block[block[idx].nextFree].prevFree = block[idx].prevFree;
+  }
+  if (freeHead[fl][sl] == NIL)
+  {
+    slBitmap[fl] &= ~(1 << sl);
+    if (!slBitmap[fl])
     {
-      if (memoryTable[mmu_tab_used_index[i + 1]].pmem >
-          (memoryTable[mmu_tab_used_index[i]].pmem +
-           memoryTable[mmu_tab_used_index[i]].memSize))
-      {
-        memmove(memoryTable[mmu_tab_used_index[i]].pmem +
-                  memoryTable[mmu_tab_used_index[i]].memSize,
-                memoryTable[mmu_tab_used_index[i + 1]].pmem,
-                memoryTable[mmu_tab_used_index[i + 1]].memSize);
-        memoryTable[mmu_tab_used_index[i + 1]].pmem =
-          memoryTable[mmu_tab_used_index[i]].pmem +
-          memoryTable[mmu_tab_used_index[i]].memSize;
-      }
+      flBitmap &= ~(1 << fl);
     }
+  }
+}
+
+uint8_t
+MMU::newBlock()
+{
+  uint8_t idx = spareBlock;
+  if (idx != NIL)
+  {
+    spareBlock = block[idx].nextFree;
+  }
+  return idx;
+}
+
+void
+MMU::releaseBlock(uint8_t idx)
+{
+  block[idx].nextFree = spareBlock;
+  spareBlock          = idx;
+}
 
-    for (i = 1; i < (MMU_TABLE_NUM - 1); i++)
+//! Move all used blocks to the start of the arena, keeping their order, and
+//! merge the free space behind them into one block, which is returned.
+uint8_t
+MMU::compact()
+{
+  uint16_t pos  = 0;
+  uint8_t  prev = NIL;
+  uint8_t  idx  = firstBlock;
+
+  firstBlock = NIL;
+  while (idx != NIL)
+  {
+    uint8_t next = block[idx].nextPhys;
+    if (block[idx].tab == 0)
+    {
+      removeFree(idx);
+      releaseBlock(idx);
+    }
+    else
     {
-      if (memoryTable[i].usageFlag == 0)
+      if (block[idx].offset != pos)
       {
-        memoryTable[i].pmem = memoryTable[mmu_tab_used_index[j]].pmem +
-                              memoryTable[mmu_tab_used_index[j]].memSize;
+        memmove(memory + pos, memory + block[idx].offset, block[idx].size);
+        block[idx].offset                = pos;
+        memoryTable[block[idx].tab].pmem = memory + pos;
+      }
+      pos += block[idx].size;
 
-        memoryTable[i].memSize   = size;
-        memoryTable[i].usageFlag = 1;
-        return &memoryTable[i];
+      block[idx].prevPhys = prev;
+      if (prev != NIL)
+      {
+        block[prev].nextPhys = idx;
+      }
+      else
+      {
+        firstBlock = idx;
       }
+      prev = idx;
     }
-    return (MMU_Tab*)0;
+    idx = next;
   }
 
-  for (i = 1; i < (MMU_TABLE_NUM - 1); i++)
+  //! At least one descriptor was released above, so this cannot fail
+  idx                 = newBlock();
+  block[idx].offset   = pos;
+  block[idx].size     = MEMORY_SIZE - pos;
+  block[idx].prevPhys = prev;
+  block[idx].nextPhys = NIL;
+  block[idx].tab      = 0;
+  if (prev != NIL)
   {
-    if (memoryTable[i].usageFlag == 0)
-    {
-      memoryTable[i].pmem =
-        memoryTable[temp_area[0]].pmem + memoryTable[temp_area[0]].memSize;
-
-      memoryTable[i].memSize   = size;
-      memoryTable[i].usageFlag = 1;
-      return &memoryTable[i];
-    }
+    block[prev].nextPhys = idx;
   }
-
-  return (MMU_Tab*)0;
+  else
+  {
+    firstBlock = idx;
+  }
+  insertFree(idx);
+  return idx;
 }
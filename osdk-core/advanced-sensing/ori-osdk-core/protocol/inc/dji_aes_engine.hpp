@@ -0,0 +1,98 @@
+/** @file dji_aes_engine.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief AES-256 ECB of the open protocol payload, table and hardware paths
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef ONBOARDSDK_DJI_AES_ENGINE_H
+#define ONBOARDSDK_DJI_AES_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DJI
+{
+namespace OSDK
+{
+
+/*! @brief AES-256 ECB over whole payloads with a key expanded once
+ *
+ *  @details Byte-identical to aes256_encrypt_ecb/aes256_decrypt_ecb applied
+ *  block by block. encrypt()/decrypt() run the fastest implementation the
+ *  CPU supports, picked on first use:
+ *  - AES-NI on x86
+ *  - the ARMv8 Crypto Extensions on aarch64
+ *  - 32-bit T-tables otherwise
+ */
+class AesEngine
+{
+public:
+  //! Expanded AES-256 key, shared by all implementations
+  typedef struct Key
+  {
+    uint8_t enc[240]; // round keys 0..14, FIPS-197 byte order
+    uint8_t dec[240]; // equivalent inverse cipher round keys, in use order
+  } Key;
+
+  //! In-place ECB over blocks 16-byte blocks
+  typedef void (*BlockFunc)(const Key& key, uint8_t* buf, size_t blocks);
+
+  static void expandKey(Key& key, const uint8_t k[32]);
+
+  static void encrypt(const Key& key, uint8_t* buf, size_t blocks);
+  static void decrypt(const Key& key, uint8_t* buf, size_t blocks);
+
+  /*! @brief Replace the implementations, NULL for the detected ones
+   *  @note Not synchronized with running ciphers, set it before the link
+   *  starts
+   */
+  static void setCipher(BlockFunc encrypt, BlockFunc decrypt);
+
+  //! Name of the implementation in use, for logs
+  static const char* name();
+
+  /*! The implementations, for checking one against the other.
+   *  The hardware ones return false when the CPU does not support them.
+   */
+  static void encryptTable(const Key& key, uint8_t* buf, size_t blocks);
+  static void decryptTable(const Key& key, uint8_t* buf, size_t blocks);
+  static bool hardware(BlockFunc& encrypt, BlockFunc& decrypt);
+
+private:
+  typedef struct Dispatch
+  {
+    BlockFunc   encrypt;
+    BlockFunc   decrypt;
+    const char* name;
+  } Dispatch;
+
+  static Dispatch  initialDispatch();
+  static Dispatch& dispatch();
+};
+
+} // namespace OSDK
+} // namespace DJI
+
+#endif // ONBOARDSDK_DJI_AES_ENGINE_H
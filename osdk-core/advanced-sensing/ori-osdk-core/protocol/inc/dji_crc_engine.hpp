@@ -0,0 +1,94 @@
+/** @file dji_crc_engine.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Block CRC16/CRC32 of the open protocol, table and hardware paths
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef ONBOARDSDK_DJI_CRC_ENGINE_H
+#define ONBOARDSDK_DJI_CRC_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DJI
+{
+namespace OSDK
+{
+
+/*! @brief CRC16 (0x8005, reflected) and CRC32 (0x04C11DB7, reflected) of the
+ *  open protocol over whole buffers
+ *
+ *  @details Bit-exact with OpenProtocol::crc16Update/crc32Update applied
+ *  byte by byte: crc is the raw register, no inversion on either side.
+ *  crc16()/crc32() run the fastest implementation the CPU supports, picked
+ *  on first use:
+ *  - CRC32: PCLMULQDQ folding on x86, the CRC32 instructions on ARMv8,
+ *    slicing-by-8 otherwise
+ *  - CRC16: slicing-by-8, there is no instruction for this polynomial
+ *  (SSE4.2 crc32 is CRC32C, a different polynomial, and is not used)
+ */
+class CrcEngine
+{
+public:
+  typedef uint16_t (*Crc16Func)(uint16_t crc, const uint8_t* data, size_t len);
+  typedef uint32_t (*Crc32Func)(uint32_t crc, const uint8_t* data, size_t len);
+
+  static uint16_t crc16(uint16_t crc, const uint8_t* data, size_t len);
+  static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+  /*! @brief Replace an implementation, NULL for the detected one
+   *  @note Not synchronized with running CRCs, set it before the link starts
+   */
+  static void setCrc16(Crc16Func func);
+  static void setCrc32(Crc32Func func);
+
+  //! Name of the CRC32 implementation in use, for logs
+  static const char* crc32Name();
+
+  /*! The implementations, for checking one against the other.
+   *  A hardware one returns NULL when the CPU does not support it.
+   */
+  static uint16_t crc16Bytewise(uint16_t crc, const uint8_t* data, size_t len);
+  static uint16_t crc16Slice8(uint16_t crc, const uint8_t* data, size_t len);
+  static uint32_t crc32Bytewise(uint32_t crc, const uint8_t* data, size_t len);
+  static uint32_t crc32Slice8(uint32_t crc, const uint8_t* data, size_t len);
+  static Crc32Func crc32Hardware();
+
+private:
+  typedef struct Dispatch
+  {
+    Crc16Func   crc16;
+    Crc32Func   crc32;
+    const char* crc32Name;
+  } Dispatch;
+
+  static Dispatch  initialDispatch();
+  static Dispatch& dispatch();
+};
+
+} // namespace OSDK
+} // namespace DJI
+
+#endif // ONBOARDSDK_DJI_CRC_ENGINE_H
@@ -32,6 +32,7 @@
 
 #include "dji_ack.hpp"
 #include "dji_aes.hpp"
+#include "dji_aes_engine.hpp"
 #include "dji_crc.hpp"
 #include "dji_hard_driver.hpp"
 #include "dji_log.hpp"
@@ -165,6 +166,11 @@ private:
 private:
   //! step 0 - 4 are in base class
 
+  //! step 2 (bulk) helpers
+  size_t findFrameStart(const uint8_t* data, size_t len);
+
+  uint32_t nextCheckIndex();
+
   //! step 5
   //! determine which part of the stream to verify
   bool checkStream();
@@ -253,6 +259,9 @@ private:
   uint8_t*  encodeSendData;
   uint8_t   encodeACK[ACK_SIZE];
 
+  //! sdkKey expanded once in setKey
+  AesEngine::Key aesKey;
+
   //! Frame-related.
   uint32_t ackFrameStatus;
   bool     broadcastFrameStatus;
@@ -121,6 +121,18 @@ protected:
 public:
   virtual bool byteHandler(const uint8_t in_data);
 
+protected:
+  //! step 2 (bulk)
+  //! Consume the read buffer a block at a time, only running checkStream()
+  //! where it can act. Falls back to byteHandler() for resync.
+  bool bulkHandler();
+
+  //! Offset of the first byte in data that may start a frame, len if none
+  virtual size_t findFrameStart(const uint8_t* data, size_t len);
+
+  //! recvIndex at which checkStream() has to run next
+  virtual uint32_t nextCheckIndex();
+
 protected:
   //! step 3
   //! Integrity checks for incoming data.
@@ -217,6 +229,9 @@ protected:
   //! A flag for large data protocol to avoid checking byte by byte
   bool is_large_data_protocol;
 
+  //! A flag to parse the read buffer in blocks instead of byte by byte
+  bool bulk_parse;
+
 }; // class ProtocolBase
 
 } // OSDK
@@ -0,0 +1,585 @@
+/** @file dji_aes_engine.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief AES-256 ECB of the open protocol payload, table and hardware paths
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "dji_aes_engine.hpp"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AES_ENGINE_X86_AESNI 1
+#include <cpuid.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#define AES_ENGINE_ARMV8_AES 1
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES (1 << 3)
+#endif
+#endif
+
+using namespace DJI::OSDK;
+
+namespace
+{
+
+inline uint32_t
+rotr32(uint32_t x, int n)
+{
+  return (x >> n) | (x << (32 - n));
+}
+
+inline uint8_t
+xtime(uint8_t x)
+{
+  return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1b : 0));
+}
+
+inline uint8_t
+gmul(uint8_t a, uint8_t b)
+{
+  uint8_t p = 0;
+  while (b)
+  {
+    if (b & 1)
+    {
+      p ^= a;
+    }
+    a = xtime(a);
+    b >>= 1;
+  }
+  return p;
+}
+
+inline uint32_t
+loadBE32(const uint8_t* p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+//! One output column of the last round: a byte from each of four columns
+inline uint32_t
+lastRound(const uint8_t* sb, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+  return ((uint32_t)sb[a >> 24] << 24) |
+         ((uint32_t)sb[(b >> 16) & 0xff] << 16) |
+         ((uint32_t)sb[(c >> 8) & 0xff] << 8) | sb[d & 0xff];
+}
+
+inline void
+storeBE32(uint8_t* p, uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+/*! S-boxes and the round tables combining SubBytes, ShiftRows and
+ *  MixColumns (te) or their inverses (td) for one byte of a column;
+ *  te[k]/td[k] are the same table rotated by 8k bits.
+ */
+typedef struct Tables
+{
+  uint8_t  sbox[256];
+  uint8_t  sboxInv[256];
+  uint32_t te[4][256];
+  uint32_t td[4][256];
+
+  Tables()
+  {
+    //! Walk the multiplicative group with generator 3, p = 3^i, q = 3^-i
+    uint8_t p = 1;
+    uint8_t q = 1;
+    do
+    {
+      p = p ^ xtime(p);
+      q ^= q << 1;
+      q ^= q << 2;
+      q ^= q << 4;
+      if (q & 0x80)
+      {
+        q ^= 0x09;
+      }
+      uint8_t x = q ^ (uint8_t)((q << 1) | (q >> 7)) ^
+                  (uint8_t)((q << 2) | (q >> 6)) ^
+                  (uint8_t)((q << 3) | (q >> 5)) ^
+                  (uint8_t)((q << 4) | (q >> 4));
+      sbox[p] = x ^ 0x63;
+    } while (p != 1);
+    sbox[0] = 0x63;
+
+    for (int i = 0; i < 256; i++)
+    {
+      sboxInv[sbox[i]] = (uint8_t)i;
+    }
+    for (int i = 0; i < 256; i++)
+    {
+      uint8_t s  = sbox[i];
+      uint8_t si = sboxInv[i];
+      te[0][i]   = ((uint32_t)gmul(s, 2) << 24) | ((uint32_t)s << 16) |
+                 ((uint32_t)s << 8) | gmul(s, 3);
+      td[0][i] = ((uint32_t)gmul(si, 14) << 24) |
+                 ((uint32_t)gmul(si, 9) << 16) |
+                 ((uint32_t)gmul(si, 13) << 8) | gmul(si, 11);
+      for (int k = 1; k < 4; k++)
+      {
+        te[k][i] = rotr32(te[0][i], 8 * k);
+        td[k][i] = rotr32(td[0][i], 8 * k);
+      }
+    }
+  }
+} Tables;
+
+const Tables&
+tables()
+{
+  static const Tables t;
+  return t;
+}
+
+#ifdef AES_ENGINE_X86_AESNI
+__attribute__((target("aes,sse2"))) void
+encryptAesni(const AesEngine::Key& key, uint8_t* buf, size_t blocks)
+{
+  __m128i rk[15];
+  for (int r = 0; r < 15; r++)
+  {
+    rk[r] = _mm_loadu_si128((const __m128i*)(key.enc + 16 * r));
+  }
+
+  //! Four independent blocks keep the AES unit busy
+  while (blocks >= 4)
+  {
+    __m128i b0 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf), rk[0]);
+    __m128i b1 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf + 1), rk[0]);
+    __m128i b2 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf + 2), rk[0]);
+    __m128i b3 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf + 3), rk[0]);
+    for (int r = 1; r < 14; r++)
+    {
+      b0 = _mm_aesenc_si128(b0, rk[r]);
+      b1 = _mm_aesenc_si128(b1, rk[r]);
+      b2 = _mm_aesenc_si128(b2, rk[r]);
+      b3 = _mm_aesenc_si128(b3, rk[r]);
+    }
+    _mm_storeu_si128((__m128i*)buf, _mm_aesenclast_si128(b0, rk[14]));
+    _mm_storeu_si128((__m128i*)buf + 1, _mm_aesenclast_si128(b1, rk[14]));
+    _mm_storeu_si128((__m128i*)buf + 2, _mm_aesenclast_si128(b2, rk[14]));
+    _mm_storeu_si128((__m128i*)buf + 3, _mm_aesenclast_si128(b3, rk[14]));
+    buf += 64;
+    blocks -= 4;
+  }
+  while (blocks--)
+  {
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf), rk[0]);
+    for (int r = 1; r < 14; r++)
+    {
+      b = _mm_aesenc_si128(b, rk[r]);
+    }
+    _mm_storeu_si128((__m128i*)buf, _mm_aesenclast_si128(b, rk[14]));
+    buf += 16;
+  }
+}
+
+__attribute__((target("aes,sse2"))) void
+decryptAesni(const AesEngine::Key& key, uint8_t* buf, size_t blocks)
+{
+  __m128i rk[15];
+  for (int r = 0; r < 15; r++)
+  {
+    rk[r] = _mm_loadu_si128((const __m128i*)(key.dec + 16 * r));
+  }
+
+  while (blocks >= 4)
+  {
+    __m128i b0 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf), rk[0]);
+    __m128i b1 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf + 1), rk[0]);
+    __m128i b2 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf + 2), rk[0]);
+    __m128i b3 = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf + 3), rk[0]);
+    for (int r = 1; r < 14; r++)
+    {
+      b0 = _mm_aesdec_si128(b0, rk[r]);
+      b1 = _mm_aesdec_si128(b1, rk[r]);
+      b2 = _mm_aesdec_si128(b2, rk[r]);
+      b3 = _mm_aesdec_si128(b3, rk[r]);
+    }
+    _mm_storeu_si128((__m128i*)buf, _mm_aesdeclast_si128(b0, rk[14]));
+    _mm_storeu_si128((__m128i*)buf + 1, _mm_aesdeclast_si128(b1, rk[14]));
+    _mm_storeu_si128((__m128i*)buf + 2, _mm_aesdeclast_si128(b2, rk[14]));
+    _mm_storeu_si128((__m128i*)buf + 3, _mm_aesdeclast_si128(b3, rk[14]));
+    buf += 64;
+    blocks -= 4;
+  }
+  while (blocks--)
+  {
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((__m128i*)buf), rk[0]);
+    for (int r = 1; r < 14; r++)
+    {
+      b = _mm_aesdec_si128(b, rk[r]);
+    }
+    _mm_storeu_si128((__m128i*)buf, _mm_aesdeclast_si128(b, rk[14]));
+    buf += 16;
+  }
+}
+
+bool
+aesniSupported()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+  {
+    return false;
+  }
+  return (ecx & bit_AES) && (edx & bit_SSE2);
+}
+#endif // AES_ENGINE_X86_AESNI
+
+#ifdef AES_ENGINE_ARMV8_AES
+/* AESE/AESD xor the round key before the byte substitution, so the last
+ * round key is applied with a plain xor. The instructions are emitted
+ * through asm so that the file builds without -march=...+crypto.
+ */
+inline uint8x16_t
+armEncRound(uint8x16_t b, uint8x16_t k)
+{
+  __asm__(".arch_extension crypto\n\t"
+          "aese %0.16b, %1.16b\n\t"
+          "aesmc %0.16b, %0.16b"
+          : "+w"(b)
+          : "w"(k));
+  return b;
+}
+
+inline uint8x16_t
+armEncLast(uint8x16_t b, uint8x16_t k)
+{
+  __asm__(".arch_extension crypto\n\taese %0.16b, %1.16b" : "+w"(b) : "w"(k));
+  return b;
+}
+
+inline uint8x16_t
+armDecRound(uint8x16_t b, uint8x16_t k)
+{
+  __asm__(".arch_extension crypto\n\t"
+          "aesd %0.16b, %1.16b\n\t"
+          "aesimc %0.16b, %0.16b"
+          : "+w"(b)
+          : "w"(k));
+  return b;
+}
+
+inline uint8x16_t
+armDecLast(uint8x16_t b, uint8x16_t k)
+{
+  __asm__(".arch_extension crypto\n\taesd %0.16b, %1.16b" : "+w"(b) : "w"(k));
+  return b;
+}
+
+void
+encryptArmv8(const AesEngine::Key& key, uint8_t* buf, size_t blocks)
+{
+  uint8x16_t rk[15];
+  for (int r = 0; r < 15; r++)
+  {
+    rk[r] = vld1q_u8(key.enc + 16 * r);
+  }
+  while (blocks--)
+  {
+    uint8x16_t b = vld1q_u8(buf);
+    for (int r = 0; r < 13; r++)
+    {
+      b = armEncRound(b, rk[r]);
+    }
+    b = veorq_u8(armEncLast(b, rk[13]), rk[14]);
+    vst1q_u8(buf, b);
+    buf += 16;
+  }
+}
+
+void
+decryptArmv8(const AesEngine::Key& key, uint8_t* buf, size_t blocks)
+{
+  uint8x16_t rk[15];
+  for (int r = 0; r < 15; r++)
+  {
+    rk[r] = vld1q_u8(key.dec + 16 * r);
+  }
+  while (blocks--)
+  {
+    uint8x16_t b = vld1q_u8(buf);
+    for (int r = 0; r < 13; r++)
+    {
+      b = armDecRound(b, rk[r]);
+    }
+    b = veorq_u8(armDecLast(b, rk[13]), rk[14]);
+    vst1q_u8(buf, b);
+    buf += 16;
+  }
+}
+#endif // AES_ENGINE_ARMV8_AES
+
+bool
+detectCipher(AesEngine::BlockFunc& encrypt, AesEngine::BlockFunc& decrypt,
+             const char*& name)
+{
+#ifdef AES_ENGINE_X86_AESNI
+  if (aesniSupported())
+  {
+    encrypt = encryptAesni;
+    decrypt = decryptAesni;
+    name    = "aes-ni";
+    return true;
+  }
+#endif
+#ifdef AES_ENGINE_ARMV8_AES
+  if (getauxval(AT_HWCAP) & HWCAP_AES)
+  {
+    encrypt = encryptArmv8;
+    decrypt = decryptArmv8;
+    name    = "armv8-aes";
+    return true;
+  }
+#endif
+  encrypt = AesEngine::encryptTable;
+  decrypt = AesEngine::decryptTable;
+  name    = "t-table";
+  return false;
+}
+
+} // namespace
+
+void
+AesEngine::expandKey(Key& key, const uint8_t k[32])
+{
+  const Tables& t = tables();
+  uint32_t      w[60];
+  uint8_t       rcon = 1;
+
+  for (int i = 0; i < 8; i++)
+  {
+    w[i] = loadBE32(k + 4 * i);
+  }
+  for (int i = 8; i < 60; i++)
+  {
+    uint32_t temp = w[i - 1];
+    if (i % 8 == 0)
+    {
+      temp = ((uint32_t)t.sbox[(temp >> 16) & 0xff] << 24) |
+             ((uint32_t)t.sbox[(temp >> 8) & 0xff] << 16) |
+             ((uint32_t)t.sbox[temp & 0xff] << 8) |
+             (uint32_t)t.sbox[temp >> 24];
+      temp ^= (uint32_t)rcon << 24;
+      rcon = xtime(rcon);
+    }
+    else if (i % 8 == 4)
+    {
+      temp = ((uint32_t)t.sbox[temp >> 24] << 24) |
+             ((uint32_t)t.sbox[(temp >> 16) & 0xff] << 16) |
+             ((uint32_t)t.sbox[(temp >> 8) & 0xff] << 8) |
+             (uint32_t)t.sbox[temp & 0xff];
+    }
+    w[i] = w[i - 8] ^ temp;
+  }
+
+  //! Decryption runs the rounds backwards with InvMixColumns applied to
+  //! the inner round keys (FIPS-197 5.3.5, equivalent inverse cipher)
+  for (int r = 0; r < 15; r++)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      uint32_t e = w[4 * r + c];
+      uint32_t d = w[4 * (14 - r) + c];
+      if (r != 0 && r != 14)
+      {
+        d = t.td[0][t.sbox[d >> 24]] ^ t.td[1][t.sbox[(d >> 16) & 0xff]] ^
+            t.td[2][t.sbox[(d >> 8) & 0xff]] ^ t.td[3][t.sbox[d & 0xff]];
+      }
+      storeBE32(key.enc + 16 * r + 4 * c, e);
+      storeBE32(key.dec + 16 * r + 4 * c, d);
+    }
+  }
+  memset(w, 0, sizeof(w));
+}
+
+void
+AesEngine::encryptTable(const Key& key, uint8_t* buf, size_t blocks)
+{
+  const Tables& t = tables();
+  const uint32_t(*te)[256] = t.te;
+
+  while (blocks--)
+  {
+    const uint8_t* rk = key.enc;
+    uint32_t       s0 = loadBE32(buf) ^ loadBE32(rk);
+    uint32_t       s1 = loadBE32(buf + 4) ^ loadBE32(rk + 4);
+    uint32_t       s2 = loadBE32(buf + 8) ^ loadBE32(rk + 8);
+    uint32_t       s3 = loadBE32(buf + 12) ^ loadBE32(rk + 12);
+    uint32_t       t0, t1, t2, t3;
+
+    for (int r = 1; r < 14; r++)
+    {
+      rk += 16;
+      t0 = te[0][s0 >> 24] ^ te[1][(s1 >> 16) & 0xff] ^
+           te[2][(s2 >> 8) & 0xff] ^ te[3][s3 & 0xff] ^ loadBE32(rk);
+      t1 = te[0][s1 >> 24] ^ te[1][(s2 >> 16) & 0xff] ^
+           te[2][(s3 >> 8) & 0xff] ^ te[3][s0 & 0xff] ^ loadBE32(rk + 4);
+      t2 = te[0][s2 >> 24] ^ te[1][(s3 >> 16) & 0xff] ^
+           te[2][(s0 >> 8) & 0xff] ^ te[3][s1 & 0xff] ^ loadBE32(rk + 8);
+      t3 = te[0][s3 >> 24] ^ te[1][(s0 >> 16) & 0xff] ^
+           te[2][(s1 >> 8) & 0xff] ^ te[3][s2 & 0xff] ^ loadBE32(rk + 12);
+      s0 = t0;
+      s1 = t1;
+      s2 = t2;
+      s3 = t3;
+    }
+
+    //! Last round has no MixColumns
+    rk += 16;
+    const uint8_t* sb = t.sbox;
+    t0                = lastRound(sb, s0, s1, s2, s3);
+    t1                = lastRound(sb, s1, s2, s3, s0);
+    t2                = lastRound(sb, s2, s3, s0, s1);
+    t3                = lastRound(sb, s3, s0, s1, s2);
+    storeBE32(buf, t0 ^ loadBE32(rk));
+    storeBE32(buf + 4, t1 ^ loadBE32(rk + 4));
+    storeBE32(buf + 8, t2 ^ loadBE32(rk + 8));
+    storeBE32(buf + 12, t3 ^ loadBE32(rk + 12));
+    buf += 16;
+  }
+}
+
+void
+AesEngine::decryptTable(const Key& key, uint8_t* buf, size_t blocks)
+{
+  const Tables& t = tables();
+  const uint32_t(*td)[256] = t.td;
+
+  while (blocks--)
+  {
+    const uint8_t* rk = key.dec;
+    uint32_t       s0 = loadBE32(buf) ^ loadBE32(rk);
+    uint32_t       s1 = loadBE32(buf + 4) ^ loadBE32(rk + 4);
+    uint32_t       s2 = loadBE32(buf + 8) ^ loadBE32(rk + 8);
+    uint32_t       s3 = loadBE32(buf + 12) ^ loadBE32(rk + 12);
+    uint32_t       t0, t1, t2, t3;
+
+    for (int r = 1; r < 14; r++)
+    {
+      rk += 16;
+      t0 = td[0][s0 >> 24] ^ td[1][(s3 >> 16) & 0xff] ^
+           td[2][(s2 >> 8) & 0xff] ^ td[3][s1 & 0xff] ^ loadBE32(rk);
+      t1 = td[0][s1 >> 24] ^ td[1][(s0 >> 16) & 0xff] ^
+           td[2][(s3 >> 8) & 0xff] ^ td[3][s2 & 0xff] ^ loadBE32(rk + 4);
+      t2 = td[0][s2 >> 24] ^ td[1][(s1 >> 16) & 0xff] ^
+           td[2][(s0 >> 8) & 0xff] ^ td[3][s3 & 0xff] ^ loadBE32(rk + 8);
+      t3 = td[0][s3 >> 24] ^ td[1][(s2 >> 16) & 0xff] ^
+           td[2][(s1 >> 8) & 0xff] ^ td[3][s0 & 0xff] ^ loadBE32(rk + 12);
+      s0 = t0;
+      s1 = t1;
+      s2 = t2;
+      s3 = t3;
+    }
+
+    rk += 16;
+    const uint8_t* sb = t.sboxInv;
+    t0                = lastRound(sb, s0, s3, s2, s1);
+    t1                = lastRound(sb, s1, s0, s3, s2);
+    t2                = lastRound(sb, s2, s1, s0, s3);
+    t3                = lastRound(sb, s3, s2, s1, s0);
+    storeBE32(buf, t0 ^ loadBE32(rk));
+    storeBE32(buf + 4, t1 ^ loadBE32(rk + 4));
+    storeBE32(buf + 8, t2 ^ loadBE32(rk + 8));
+    storeBE32(buf + 12, t3 ^ loadBE32(rk + 12));
+    buf += 16;
+  }
+}
+
+bool
+AesEngine::hardware(BlockFunc& encrypt, BlockFunc& decrypt)
+{
+  const char* name;
+  if (detectCipher(encrypt, decrypt, name))
+  {
+    return true;
+  }
+  encrypt = NULL;
+  decrypt = NULL;
+  return false;
+}
+
+AesEngine::Dispatch
+AesEngine::initialDispatch()
+{
+  Dispatch d;
+  detectCipher(d.encrypt, d.decrypt, d.name);
+  return d;
+}
+
+AesEngine::Dispatch&
+AesEngine::dispatch()
+{
+  static Dispatch d = initialDispatch();
+  return d;
+}
+
+void
+AesEngine::encrypt(const Key& key, uint8_t* buf, size_t blocks)
+{
+  dispatch().encrypt(key, buf, blocks);
+}
+
+void
+AesEngine::decrypt(const Key& key, uint8_t* buf, size_t blocks)
+{
+  dispatch().decrypt(key, buf, blocks);
+}
+
+void
+AesEngine::setCipher(BlockFunc encrypt, BlockFunc decrypt)
+{
+  Dispatch& d = dispatch();
+  if (encrypt && decrypt)
+  {
+    d.encrypt = encrypt;
+    d.decrypt = decrypt;
+    d.name    = "custom";
+  }
+  else
+  {
+    detectCipher(d.encrypt, d.decrypt, d.name);
+  }
+}
+
+const char*
+AesEngine::name()
+{
+  return dispatch().name;
+}
@@ -0,0 +1,398 @@
+/** @file dji_crc_engine.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Block CRC16/CRC32 of the open protocol, table and hardware paths
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "dji_crc_engine.hpp"
+#include "dji_crc.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC_ENGINE_X86_CLMUL 1
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#define CRC_ENGINE_ARMV8_CRC 1
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+using namespace DJI::OSDK;
+
+namespace
+{
+
+/*! table[k][b] is the CRC of byte b followed by k zero bytes, so 8 bytes
+ *  are folded with 8 independent lookups
+ */
+typedef struct SliceTables
+{
+  uint16_t t16[8][256];
+  uint32_t t32[8][256];
+
+  SliceTables()
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      t16[0][i] = crc_tab16[i];
+      t32[0][i] = crc_tab32[i];
+    }
+    for (int k = 1; k < 8; k++)
+    {
+      for (int i = 0; i < 256; i++)
+      {
+        t16[k][i] = (t16[k - 1][i] >> 8) ^ t16[0][t16[k - 1][i] & 0xff];
+        t32[k][i] = (t32[k - 1][i] >> 8) ^ t32[0][t32[k - 1][i] & 0xff];
+      }
+    }
+  }
+} SliceTables;
+
+const SliceTables&
+sliceTables()
+{
+  static const SliceTables tables;
+  return tables;
+}
+
+inline uint32_t
+load32(const uint8_t* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+#ifdef CRC_ENGINE_X86_CLMUL
+/*! Folds 64 bytes per round with carry-less multiplies, then reduces to
+ *  32 bits with a Barrett reduction (Intel, "Fast CRC Computation for
+ *  Generic Polynomials Using PCLMULQDQ"). len >= 64 and a multiple of 16.
+ */
+__attribute__((target("pclmul,sse4.1"))) uint32_t
+crc32ClmulFold(uint32_t crc, const uint8_t* buf, size_t len)
+{
+  static const uint64_t k1k2[2] __attribute__((aligned(16))) = {
+    0x0154442bd4ULL, 0x01c6e41596ULL
+  };
+  static const uint64_t k3k4[2] __attribute__((aligned(16))) = {
+    0x01751997d0ULL, 0x00ccaa009eULL
+  };
+  static const uint64_t k5k0[2] __attribute__((aligned(16))) = {
+    0x0163cd6124ULL, 0x0000000000ULL
+  };
+  static const uint64_t poly[2] __attribute__((aligned(16))) = {
+    0x01db710641ULL, 0x01f7011641ULL
+  };
+
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+  x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+  x0 = _mm_load_si128((const __m128i*)k1k2);
+  buf += 64;
+  len -= 64;
+
+  while (len >= 64)
+  {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    y5 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    y6 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    y7 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    y8 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+    buf += 64;
+    len -= 64;
+  }
+
+  /* Fold the 4 lanes into one */
+  x0 = _mm_load_si128((const __m128i*)k3k4);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  while (len >= 16)
+  {
+    x2 = _mm_loadu_si128((const __m128i*)buf);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    buf += 16;
+    len -= 16;
+  }
+
+  /* 128 to 64 bits */
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  /* Barrett reduction to 32 bits */
+  x0 = _mm_load_si128((const __m128i*)poly);
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+uint32_t
+crc32Clmul(uint32_t crc, const uint8_t* data, size_t len)
+{
+  /* Headers and small frames are not worth the setup */
+  if (len >= 64)
+  {
+    size_t n = len & ~(size_t)15;
+    crc      = crc32ClmulFold(crc, data, n);
+    data += n;
+    len -= n;
+  }
+  return CrcEngine::crc32Slice8(crc, data, len);
+}
+
+bool
+clmulSupported()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+  {
+    return false;
+  }
+  return (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1);
+}
+#endif // CRC_ENGINE_X86_CLMUL
+
+#ifdef CRC_ENGINE_ARMV8_CRC
+/* The ARMv8 crc32 instructions use this very polynomial, reflected and
+ * without inversion, so they update the register directly.
+ */
+inline uint32_t
+armCrc32x(uint32_t crc, uint64_t v)
+{
+  __asm__(".arch_extension crc\n\tcrc32x %w0, %w0, %x1" : "+r"(crc) : "r"(v));
+  return crc;
+}
+
+inline uint32_t
+armCrc32b(uint32_t crc, uint8_t v)
+{
+  __asm__(".arch_extension crc\n\tcrc32b %w0, %w0, %w1"
+          : "+r"(crc)
+          : "r"((uint32_t)v));
+  return crc;
+}
+
+uint32_t
+crc32Armv8(uint32_t crc, const uint8_t* data, size_t len)
+{
+  while (len && ((uintptr_t)data & 7))
+  {
+    crc = armCrc32b(crc, *data++);
+    len--;
+  }
+  while (len >= 8)
+  {
+    crc = armCrc32x(crc, *(const uint64_t*)data);
+    data += 8;
+    len -= 8;
+  }
+  while (len--)
+  {
+    crc = armCrc32b(crc, *data++);
+  }
+  return crc;
+}
+#endif // CRC_ENGINE_ARMV8_CRC
+
+CrcEngine::Crc32Func
+detectCrc32(const char*& name)
+{
+#ifdef CRC_ENGINE_X86_CLMUL
+  if (clmulSupported())
+  {
+    name = "pclmul";
+    return crc32Clmul;
+  }
+#endif
+#ifdef CRC_ENGINE_ARMV8_CRC
+  if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+  {
+    name = "armv8-crc";
+    return crc32Armv8;
+  }
+#endif
+  name = "slice8";
+  return CrcEngine::crc32Slice8;
+}
+
+} // namespace
+
+uint16_t
+CrcEngine::crc16Bytewise(uint16_t crc, const uint8_t* data, size_t len)
+{
+  while (len--)
+  {
+    crc = (crc >> 8) ^ crc_tab16[(crc ^ *data++) & 0xff];
+  }
+  return crc;
+}
+
+uint32_t
+CrcEngine::crc32Bytewise(uint32_t crc, const uint8_t* data, size_t len)
+{
+  while (len--)
+  {
+    crc = (crc >> 8) ^ crc_tab32[(crc ^ *data++) & 0xff];
+  }
+  return crc;
+}
+
+uint16_t
+CrcEngine::crc16Slice8(uint16_t crc, const uint8_t* data, size_t len)
+{
+  const SliceTables& t = sliceTables();
+  while (len >= 8)
+  {
+    uint32_t one = load32(data) ^ crc;
+    uint32_t two = load32(data + 4);
+    crc = t.t16[7][one & 0xff] ^ t.t16[6][(one >> 8) & 0xff] ^
+          t.t16[5][(one >> 16) & 0xff] ^ t.t16[4][one >> 24] ^
+          t.t16[3][two & 0xff] ^ t.t16[2][(two >> 8) & 0xff] ^
+          t.t16[1][(two >> 16) & 0xff] ^ t.t16[0][two >> 24];
+    data += 8;
+    len -= 8;
+  }
+  return crc16Bytewise(crc, data, len);
+}
+
+uint32_t
+CrcEngine::crc32Slice8(uint32_t crc, const uint8_t* data, size_t len)
+{
+  const SliceTables& t = sliceTables();
+  while (len >= 8)
+  {
+    uint32_t one = load32(data) ^ crc;
+    uint32_t two = load32(data + 4);
+    crc = t.t32[7][one & 0xff] ^ t.t32[6][(one >> 8) & 0xff] ^
+          t.t32[5][(one >> 16) & 0xff] ^ t.t32[4][one >> 24] ^
+          t.t32[3][two & 0xff] ^ t.t32[2][(two >> 8) & 0xff] ^
+          t.t32[1][(two >> 16) & 0xff] ^ t.t32[0][two >> 24];
+    data += 8;
+    len -= 8;
+  }
+  return crc32Bytewise(crc, data, len);
+}
+
+CrcEngine::Crc32Func
+CrcEngine::crc32Hardware()
+{
+  const char* name;
+  return detectCrc32(name);
+}
+
+CrcEngine::Dispatch
+CrcEngine::initialDispatch()
+{
+  Dispatch d;
+  d.crc16 = crc16Slice8;
+  d.crc32 = detectCrc32(d.crc32Name);
+  return d;
+}
+
+CrcEngine::Dispatch&
+CrcEngine::dispatch()
+{
+  static Dispatch d = initialDispatch();
+  return d;
+}
+
+uint16_t
+CrcEngine::crc16(uint16_t crc, const uint8_t* data, size_t len)
+{
+  return dispatch().crc16(crc, data, len);
+}
+
+uint32_t
+CrcEngine::crc32(uint32_t crc, const uint8_t* data, size_t len)
+{
+  return dispatch().crc32(crc, data, len);
+}
+
+void
+CrcEngine::setCrc16(Crc16Func func)
+{
+  dispatch().crc16 = func ? func : crc16Slice8;
+}
+
+void
+CrcEngine::setCrc32(Crc32Func func)
+{
+  Dispatch& d = dispatch();
+  if (func)
+  {
+    d.crc32     = func;
+    d.crc32Name = "custom";
+  }
+  else
+  {
+    d.crc32 = detectCrc32(d.crc32Name);
+  }
+}
+
+const char*
+CrcEngine::crc32Name()
+{
+  return dispatch().crc32Name;
+}
@@ -28,6 +28,7 @@
  */
 
 #include "dji_open_protocol.hpp"
+#include "dji_crc_engine.hpp"
 //#include <dji_vehicle.hpp>
 
 #ifdef STM32
@@ -86,6 +87,7 @@ OpenProtocol::init(HardDriver* sDevice, MMU* mmuPtr, bool userCallbackThread)
   p_filter->reuseIndex = 0;
   p_filter->encode     = 0;
   p_filter->recvBuf    = new uint8_t[MAX_RECV_LEN];
+  AesEngine::expandKey(aesKey, p_filter->sdkKey);
 
   buf             = new uint8_t[BUFFER_SIZE];
   encodeSendData  = new uint8_t[BUFFER_SIZE];
@@ -93,6 +95,7 @@ OpenProtocol::init(HardDriver* sDevice, MMU* mmuPtr, bool userCallbackThread)
   mmu          = mmuPtr;
   buf_read_pos = 0;
   read_len     = 0;
+  bulk_parse   = true;
 
   setup();
 }
@@ -513,6 +516,27 @@ OpenProtocol::clearTimeoutSession()
 /******************** Receive Pipeline **********************/
 //! step 0 - 4 are in base class
 
+//! Step 2 (bulk)
+size_t
+OpenProtocol::findFrameStart(const uint8_t* data, size_t len)
+{
+  const void* p_sof = memchr(data, OpenProtocol::SOF, len);
+  return p_sof ? (const uint8_t*)p_sof - data : len;
+}
+
+//! Step 2 (bulk)
+//! @note mirrors checkStream: the header is checked once complete, the
+//! data once recvIndex reaches the length in the header.
+uint32_t
+OpenProtocol::nextCheckIndex()
+{
+  if (p_filter->recvIndex < sizeof(OpenHeader))
+  {
+    return sizeof(OpenHeader);
+  }
+  return ((OpenHeader*)(p_filter->recvBuf))->length;
+}
+
 //! Step 5
 bool
 OpenProtocol::checkStream()
@@ -882,29 +906,13 @@ OpenProtocol::crc32Update(uint32_t crc, uint8_t ch)
 uint16_t
 OpenProtocol::crc16Calc(const uint8_t* pMsg, size_t nLen)
 {
-  size_t   i;
-  uint16_t wCRC = CRC_INIT;
-
-  for (i = 0; i < nLen; i++)
-  {
-    wCRC = crc16Update(wCRC, pMsg[i]);
-  }
-
-  return wCRC;
+  return CrcEngine::crc16(CRC_INIT, pMsg, nLen);
 }
 
 uint32_t
 OpenProtocol::crc32Calc(const uint8_t* pMsg, size_t nLen)
 {
-  size_t   i;
-  uint32_t wCRC = CRC_INIT;
-
-  for (i = 0; i < nLen; i++)
-  {
-    wCRC = crc32Update(wCRC, pMsg[i]);
-  }
-
-  return wCRC;
+  return CrcEngine::crc32(CRC_INIT, pMsg, nLen);
 }
 
 /******************* Encryption *********************/
@@ -912,12 +920,9 @@ OpenProtocol::crc32Calc(const uint8_t* pMsg, size_t nLen)
 void
 OpenProtocol::encodeData(OpenHeader* p_head, ptr_aes256_codec codec_func)
 {
-  aes256_context ctx;
-  uint32_t       buf_i;
-  uint32_t       loop_blk;
-  uint32_t       data_len;
-  uint32_t       data_idx;
-  uint8_t*       data_ptr;
+  uint32_t loop_blk;
+  uint32_t data_len;
+  uint8_t* data_ptr;
 
   if (p_head->enc == 0)
     return;
@@ -928,15 +933,12 @@ OpenProtocol::encodeData(OpenHeader* p_head, ptr_aes256_codec codec_func)
   data_len = p_head->length - OpenProtocol::PackageMin;
 
   loop_blk = data_len / 16;
-  data_idx = 0;
 
-  aes256_init(&ctx, p_filter->sdkKey);
-  for (buf_i = 0; buf_i < loop_blk; buf_i++)
-  {
-    codec_func(&ctx, data_ptr + data_idx);
-    data_idx += 16;
-  }
-  aes256_done(&ctx);
+  //! codec_func only selects the direction, the key is expanded in setKey
+  if (codec_func == aes256_decrypt_ecb)
+    AesEngine::decrypt(aesKey, data_ptr, loop_blk);
+  else
+    AesEngine::encrypt(aesKey, data_ptr, loop_blk);
 
   if (codec_func == aes256_decrypt_ecb)
     p_head->length = p_head->length - p_head->padding; // minus padding length;
@@ -1005,6 +1007,7 @@ void
 OpenProtocol::setKey(const char* key)
 {
   transformTwoByte(key, p_filter->sdkKey);
+  AesEngine::expandKey(aesKey, p_filter->sdkKey);
   p_filter->encode = 1;
 }
 
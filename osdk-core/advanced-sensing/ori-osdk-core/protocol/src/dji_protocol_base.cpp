@@ -35,6 +35,7 @@ using namespace DJI::OSDK;
 ProtocolBase::ProtocolBase()
   : reuse_buffer(true)
   , is_large_data_protocol(false)
+  , bulk_parse(false)
   , BUFFER_SIZE(1024)
 {
 }
@@ -96,6 +97,10 @@ ProtocolBase::readPoll()
     p_filter->recvIndex += BUFFER_SIZE;
     this->buf_read_pos = BUFFER_SIZE;
   }
+  else if (bulk_parse)
+  {
+    isFrame = bulkHandler();
+  }
   else
   {
     for (this->buf_read_pos; this->buf_read_pos < this->read_len;
@@ -167,6 +172,86 @@ ProtocolBase::byteHandler(const uint8_t in_data)
   return isFrame;
 }
 
+//! Step 2 (bulk)
+//! @note checkStream() only acts at a few recvIndex values (full header,
+//! full frame), so every byte in between can be copied without running the
+//! state machine. Leading bytes that cannot start a frame are dropped with a
+//! single scan. The byte that completes a checkpoint still goes through
+//! byteHandler, so header/data verification, the reuse re-scan and frame
+//! dispatch behave exactly as in the byte-wise path.
+bool
+ProtocolBase::bulkHandler()
+{
+  //! Bool to check if the protocol parser has finished a full frame
+  bool isFrame = false;
+
+  while (this->buf_read_pos < this->read_len)
+  {
+    //! Drop noise in front of the first possible frame start. This covers
+    //! both the partial data kept in the filter and the new data.
+    if (p_filter->recvIndex)
+    {
+      size_t skip = findFrameStart(p_filter->recvBuf, p_filter->recvIndex);
+      if (skip)
+      {
+        p_filter->recvIndex -= skip;
+        memmove(p_filter->recvBuf, p_filter->recvBuf + skip,
+                p_filter->recvIndex);
+      }
+    }
+    if (p_filter->recvIndex == 0)
+    {
+      this->buf_read_pos += findFrameStart(this->buf + this->buf_read_pos,
+                                           this->read_len - this->buf_read_pos);
+      if (this->buf_read_pos >= this->read_len)
+      {
+        break;
+      }
+    }
+
+    //! Copy everything up to the byte before the next checkpoint in one go.
+    //! A checkpoint that is already behind us or beyond the filter buffer is
+    //! left to the byte-wise path.
+    uint32_t target = nextCheckIndex();
+    if (target > p_filter->recvIndex + 1 && target <= (uint32_t)MAX_RECV_LEN)
+    {
+      uint32_t toCopy = target - p_filter->recvIndex - 1;
+      uint32_t avail  = this->read_len - this->buf_read_pos;
+      if (toCopy > avail)
+      {
+        toCopy = avail;
+      }
+      memcpy(p_filter->recvBuf + p_filter->recvIndex,
+             this->buf + this->buf_read_pos, toCopy);
+      p_filter->recvIndex += toCopy;
+      this->buf_read_pos += toCopy;
+      if (this->buf_read_pos >= this->read_len)
+      {
+        break;
+      }
+    }
+
+    isFrame = byteHandler(buf[this->buf_read_pos++]);
+    if (isFrame)
+    {
+      return isFrame;
+    }
+  }
+  return isFrame;
+}
+
+size_t
+ProtocolBase::findFrameStart(const uint8_t* /*data*/, size_t /*len*/)
+{
+  return 0;
+}
+
+uint32_t
+ProtocolBase::nextCheckIndex()
+{
+  return p_filter->recvIndex + 1;
+}
+
 //! Step 3
 bool
 ProtocolBase::streamHandler(uint8_t in_data)
@@ -38,6 +38,8 @@ namespace DJI
 namespace OSDK
 {
 
+class TelemetryRecorder;
+
 /*! @brief Telemetry API through asynchronous "Broadcast"-style messages
  *
  *  @details Broadcast telemetry is sent by the FC as push data - whenever an
@@ -385,11 +387,25 @@ public:
 
 public:
   void setUserBroadcastCallback(VehicleCallBack callback, UserData userData);
+
+  /*!
+   * @brief Record the raw broadcast frames, NULL to detach.
+   * @platforms Linux
+   */
+  void setRecorder(TelemetryRecorder* recorder);
   VehicleCallBackHandler unpackHandler;
+  VehicleFrameViewCallBackHandler unpackViewHandler;
 
 public:
   static void unpackCallback(Vehicle* vehicle, RecvContainer recvFrame,
                              UserData userData);
+  /*!
+   * @brief Zero-copy variant of unpackCallback, the broadcast data is
+   * extracted straight from the linker's frame buffer.
+   */
+  static void unpackViewCallback(Vehicle* vehicle,
+                                 const RecvFrameView& recvFrame,
+                                 UserData userData);
   static void setFrequencyCallback(Vehicle* vehicle, RecvContainer recvFrame,
                                    UserData userData);
 
@@ -426,25 +442,36 @@ private:
   // clang-format on
 
 private:
+  /*!
+   * @brief Dispatch the payload to the unpacker matching the FW version
+   * @param pdata: pointer to the raw data payload
+   * @param len: length of the raw data payload
+   */
+  void unpackPayload(const uint8_t* pdata, size_t len);
+
   /*!
    * @brief Extract broadcast data for A3/N3/M600
-   * @param recvFrame: pointer to the raw data payload
+   * @param pdata: pointer to the raw data payload
+   * @param len: length of the raw data payload
    */
-  void unpackData(RecvContainer* recvFrame);
+  void unpackData(const uint8_t* pdata, size_t len);
 
   /*!
    * @brief Extract broadcast data for M100
-   * @param recvFrame: pointer to the raw data payload
+   * @param pdata: pointer to the raw data payload
+   * @param len: length of the raw data payload
    */
-  void unpackM100Data(RecvContainer* pRecvFrame);
+  void unpackM100Data(const uint8_t* pdata, size_t len);
 
   /*!
    * @brief Extract broadcast data for M600 FW 3.2.41.5
-   * @param recvFrame: pointer to the raw data payload
+   * @param pdata: pointer to the raw data payload
+   * @param len: length of the raw data payload
    */
-  void unpackOldM600Data(RecvContainer* recvFrame);
+  void unpackOldM600Data(const uint8_t* pdata, size_t len);
 
-  inline void unpackOne(FLAG flag, void* data, uint8_t*& buf, size_t size);
+  inline void unpackOne(FLAG flag, void* data, const uint8_t*& buf,
+                        const uint8_t* end, size_t size);
 
 public:
   void setBroadcastLength(uint16_t length);
@@ -481,7 +508,8 @@ private:
   Telemetry::LegacyGPSInfo        legacyGPSInfo;
   // clang-format on
 private:
-  Vehicle* vehicle;
+  Vehicle*           vehicle;
+  TelemetryRecorder* recorder;
   uint16_t passFlag;
   uint16_t broadcastLength;
 
@@ -489,6 +517,10 @@ private:
   void lockMSG();
   void freeMSG();
 
+  // Firmware layout checks, false without a vehicle (offline replay)
+  bool isLegacyM600() const;
+  bool isM100() const;
+
   VehicleCallBackHandler userCbHandler;
 };
 
@@ -1738,6 +1738,30 @@ class CameraManager {
    */
   ErrorCode::ErrorCodeType startReqFileList(PayloadIndexType index, FileMgr::FileListReqCBType cb, void *userData);
 
+  /*! @brief refresh the file list of camera from the cached one, non-blocking
+   * calls
+   *
+   *  @details Only the files newer than the cached list are requested, the
+   *  cb still gets the whole list. Falls back to the full list when the card
+   *  was changed.
+   *  @platforms M300
+   *  @param index Camera module index, input limit see enum
+   * DJI::OSDK::PayloadIndexType
+   *  @param cb The download result will be called by this cb
+   *  @param userData The parameter to pass user data into the cb
+   *  @return ErrorCode::ErrorCodeType error code
+   */
+  ErrorCode::ErrorCodeType startReqFileListIncremental(PayloadIndexType index, FileMgr::FileListReqCBType cb, void *userData);
+
+  /*! @brief keep the file lists under dir, so an incremental refresh also
+   * works after a restart
+   */
+  void setFileListCacheDir(std::string dir);
+
+  /*! @brief look up a file in the last file list of camera, non-blocking */
+  bool findCachedFile(PayloadIndexType index, int fileIndex, MediaFile &file);
+  bool findCachedFile(PayloadIndexType index, std::string fileName, MediaFile &file);
+
   /*! @brief start to requeset the files of camera, non-blocking calls
    *
    *  @platforms M300
@@ -1752,6 +1776,31 @@ class CameraManager {
    *  @return ErrorCode::ErrorCodeType error code
    */
   ErrorCode::ErrorCodeType startReqFileData(PayloadIndexType index, int fileIndex, std::string localPath, FileMgr::FileDataReqCBType cb, void *userData);
+
+  /*! @brief queue files of camera for download, non-blocking calls
+   *
+   *  @details The files of one camera are downloaded back to back, the
+   * queues of different cameras run in parallel.
+   *  @platforms M300
+   *  @param index Camera module index, input limit see enum
+   * DJI::OSDK::PayloadIndexType
+   *  @param files The files to download, taken from the file list.
+   *  @param localDir The directory to save the files to, under their names
+   * in the file list.
+   *  @param priority Files with a higher priority are downloaded first.
+   *  @param cb Called once for each file. The detail of the callback ref to
+   * the DJI::OSDK::FileMgr::DownloadItemCBType
+   *  @param userData The parameter to pass user data into the cb
+   *  @param ids Filled with the queue id of each file, used to cancel it.
+   *  @return ErrorCode::ErrorCodeType error code
+   */
+  ErrorCode::ErrorCodeType enqueueFileData(PayloadIndexType index, const std::vector<MediaFile> &files, std::string localDir, int priority, FileMgr::DownloadItemCBType cb, void *userData, std::vector<uint32_t> *ids = NULL);
+
+  /*! @brief cancel a queued or running file download by its queue id */
+  bool cancelFileData(uint32_t id);
+
+  /*! @brief counters and throughput of the download queue */
+  FileMgr::DownloadQueueStats getFileDataQueueStats();
 #endif
  private:
 #if defined(__linux__)
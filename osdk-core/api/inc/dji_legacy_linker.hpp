@@ -123,44 +123,65 @@ public:
   void sendAsync(const uint8_t cmd[], void *pdata, size_t len, int timeout,
                  int retry_time, VehicleCallBack callback, UserData userData);
 
+  /*! @brief Caller owned storage for the ACK decoded by sendSync
+   *
+   *  @details Large enough for any of the ACK structs (ACK::ErrorCode,
+   *  ACK::ParamAck, ACK::WayPointIndex, ...) a synchronous command returns.
+   */
+  static const size_t MAX_SYNC_ACK_SIZE = 256;
+  typedef union SyncAck
+  {
+    uint8_t  raw[MAX_SYNC_ACK_SIZE];
+    uint64_t align;
+  } SyncAck;
+
+  /*! @brief Blocking send, the decoded ACK is written to caller owned storage
+   *
+   *  @details Safe to call from several threads in parallel.
+   *  @return the linker status, ack is filled in whatever the status is
+   */
+  E_OsdkStat sendSync(const uint8_t cmd[], void *pdata, size_t len,
+                      SyncAck &ack, int timeout, int retry_time);
+
+  /*! @brief Blocking send returning a pointer to the decoded ACK
+   *
+   *  @note The ACK lives in thread local storage, it stays valid until the
+   *  next sendSync call from the same thread. Where there is no thread local
+   *  storage (STM32) all threads share it, so use the SyncAck overload when
+   *  several threads send commands.
+   */
   void* sendSync(const uint8_t cmd[], void *pdata, size_t len,
                           int timeout, int retry_time);
 
   bool registerCMDCallback(uint8_t cmdSet, uint8_t cmdID,
                            VehicleCallBack &callback, UserData &userData);
 
+  /*! @brief Register a zero-copy callback for a push command
+   *
+   *  @details Same as registerCMDCallback, but the callback receives a view
+   *  over the linker's frame buffer instead of a RecvContainer copy.
+   *  Replaces any callback previously registered for this command.
+   */
+  bool registerCMDViewCallback(uint8_t cmdSet, uint8_t cmdID,
+                               VehicleFrameViewCallBack callback,
+                               UserData userData);
+
+  /*! @brief Build a RecvContainer out of a frame view
+   *
+   *  @details Compatibility shim for callers of the RecvContainer based
+   *  callbacks, it copies the payload of the view.
+   */
+  static RecvContainer adaptFrameView(const RecvFrameView &view);
+
  private:
   Vehicle* vehicle;
 
-  void initX5SEnableThread();
-  void *decodeAck(E_OsdkStat ret, uint8_t cmdSet, uint8_t cmdId,
-                  RecvContainer recvFrame);
+  void initX5SEnableJob();
+  static void decodeAck(E_OsdkStat ret, uint8_t cmdSet, uint8_t cmdId,
+                        const RecvContainer &recvFrame, SyncAck &ack);
  private:
-  uint8_t rawVersionACK[MAX_ACK_SIZE];
-
-  // User space ACK types
-  ACK::ErrorCode     ackErrorCode;
-  ACK::DroneVersion  droneVersionACK;
-  ACK::HotPointStart hotpointStartACK;
-  ACK::HotPointRead  hotpointReadACK;
-  /*!WayPoint download command
-   * @note Download mission setting*/
-  ACK::WayPointInit waypointInitACK;
-  /*!WayPoint index download command ACK
-   * @note Download index settings*/
-  ACK::WayPointIndex      waypointIndexACK;
-  ACK::WayPoint2CommonRsp wayPoint2CommonRspACK;
-  /*!WayPoint add point command ACK*/
-  ACK::WayPointAddPoint waypointAddPointACK;
-  ACK::MFIOGet          mfioGetACK;
-  ACK::ExtendedFunctionRsp extendedFunctionRspAck;
-  ACK::ParamAck         paramAck;
-  ACK::SetHomeLocationAck setHomeLocationAck;
-  /*! Heart Beat Ack*/
-  ACK::HeartBeatAck     heartBeatAck;
-
-  T_OsdkTaskHandle legacyX5SEnableHandle;
-  static void *legacyX5SEnableTask(void *arg);
+  uint32_t legacyX5SEnableJob;
+  static void legacyX5SEnableTask(void *arg, uint32_t self);
 }; // class LegacyLinker
 
 } // namespace OSDK
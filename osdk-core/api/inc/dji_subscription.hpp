@@ -32,9 +32,13 @@
 
 #include "dji_log.hpp"
 #include "dji_telemetry.hpp"
+#include "dji_topic_history.hpp"
 #include "dji_vehicle_callback.hpp"
+#include "osdk_osal.h"
+#include <vector>
 
 #ifdef __linux__
+#include <atomic>
 #include <cstring>
 #elif STM32
 //! handle array of characters
@@ -49,6 +53,7 @@ namespace OSDK
 
 // Forward Declarations
 class Vehicle;
+class TelemetryRecorder;
 
 /*! @brief Package class to support Subscribe-style telemetry
  *
@@ -119,6 +124,19 @@ public:
   uint32_t               getBufferSize();
   VehicleCallBackHandler getUnpackHandler();
 
+  /*!
+   * @brief Seqlock helpers guarding incomingDataBuffer when lock-free reading
+   * is enabled. The writer bumps the sequence to an odd value before copying
+   * and back to an even value afterwards; readers retry if the sequence was
+   * odd or changed while they were copying.
+   */
+  void     beginWrite();
+  void     endWrite();
+#ifdef __linux__
+  uint32_t readBegin() const;
+  bool     readRetry(uint32_t seq) const;
+#endif
+
   /*!
   * @brief Helper function to do post processing when adding package is
   * successful.
@@ -160,6 +178,24 @@ private: // Private variables
    */
   uint8_t* incomingDataBuffer;
 
+#ifdef __linux__
+  /*!
+   * @brief Storage behind incomingDataBuffer. Lock-free readers may still
+   *        copy from a removed package, so it is sized for the largest
+   *        package and only freed with the package.
+   */
+  uint8_t* dataBufferStore;
+#endif
+
+  /*!
+   * @brief Sequence counter of incomingDataBuffer, odd while being written
+   */
+#ifdef __linux__
+  std::atomic<uint32_t> writeSeq;
+#else
+  uint32_t writeSeq;
+#endif
+
   /*!
    * @brief Advanced users can optionally register a callback function
    *        (for each package) to run after every package is received.
@@ -296,6 +332,87 @@ public: // public methods
     int packageID, VehicleCallBack userFunctionAfterPackageExtraction,
     UserData userData = NULL);
 
+  /*! @brief One (topic, rate) request for the package planner */
+  typedef struct TopicRequest
+  {
+    Telemetry::TopicName topic;
+    uint16_t             freq;
+  } TopicRequest;
+
+  /*! @brief One package as laid out by the planner */
+  typedef struct PackagePlan
+  {
+    uint16_t             freq;
+    int                  numberOfTopics;
+    /*! Sum of the topic sizes, without the timestamp */
+    uint32_t             payloadSize;
+    Telemetry::TopicName topicList[Telemetry::TOTAL_TOPIC_NUMBER];
+  } PackagePlan;
+
+  /*!
+   * @brief Lay out a set of topic requests over at most maxPackages packages.
+   *
+   * @details Each requested rate is rounded up to a package frequency the FC
+   * supports, capped by the topic's maxFreq. Topics of the same frequency are
+   * packed first-fit by size into packages. Packages are then merged into
+   * faster ones, cheapest merge first. A merge is made when it lowers the
+   * link bandwidth, or when it is needed to fit into maxPackages. A topic
+   * requested twice is planned once, at its higher rate.
+   *
+   * @note No link traffic, this only fills in plans. The working set lives
+   * in the object and is shared with requestTopic/releaseTopic under the
+   * planner mutex, so concurrent calls are serialized.
+   *
+   * @platforms M210V2, M300
+   * @param requests: topics and their desired rates
+   * @param numberOfRequests
+   * @param sendTimeStamp: whether the packages will carry a timestamp
+   * @param plans: output array with room for maxPackages entries
+   * @param maxPackages
+   * @return number of packages used, -1 if the requests cannot fit
+   */
+  int planPackages(const TopicRequest* requests, int numberOfRequests,
+                   bool sendTimeStamp, PackagePlan* plans, int maxPackages);
+
+  /*!
+   * @brief Link bandwidth in bytes per second of a set of packages,
+   * including the per-frame protocol overhead.
+   */
+  static uint32_t planBandwidth(const PackagePlan* plans, int numberOfPlans,
+                                bool sendTimeStamp);
+
+  /*!
+   * @brief Blocking call to add a topic to the planner-managed packages, or
+   * change its rate. The packages are re-planned and the changed ones are
+   * restarted on the FC.
+   *
+   * @details The planner only uses packages that are free or that it
+   * started itself, so it can be mixed with initPackageFromTopicList().
+   * Packages whose content did not change keep streaming untouched.
+   *
+   * @platforms M210V2, M300
+   * @param topic
+   * @param freq: desired rate in Hz
+   * @param timeout: timeout of each add/remove package call, in seconds
+   * @return false if the topics cannot fit or the FC rejected a package
+   */
+  bool requestTopic(Telemetry::TopicName topic, uint16_t freq, int timeout);
+
+  /*!
+   * @brief Blocking call to remove a topic from the planner-managed packages
+   *
+   * @platforms M210V2, M300
+   * @param topic
+   * @param timeout: timeout of each add/remove package call, in seconds
+   */
+  bool releaseTopic(Telemetry::TopicName topic, int timeout);
+
+  /*!
+   * @brief Whether planner-managed packages carry a timestamp. Takes effect
+   * on the next re-plan. Off by default.
+   */
+  void setPlannerTimeStamp(bool sendTimeStamp);
+
   // Not implemented yet
   // bool pausePackage(int packageID);
   // bool resumePackage(int packageID);
@@ -333,14 +450,75 @@ public: // public methods
   static void decodeCallback(Vehicle* vehiclePtr, RecvContainer rcvContainer,
                              UserData subscriptionPtr);
 
+  /*!
+   * @brief Zero-copy variant of decodeCallback, the package data is copied
+   * straight from the linker's frame buffer into the package buffer.
+   * @param vehiclePtr
+   * @param rcvFrame: View over the received frame
+   * @param subscriptionPtr: The pointer to the subscription object.
+   */
+  static void decodeViewCallback(Vehicle*             vehiclePtr,
+                                 const RecvFrameView& rcvFrame,
+                                 UserData             subscriptionPtr);
+
+  /*!
+   * @brief Enable or disable lock-free reading of the subscribed topics.
+   *
+   * @details When enabled, getValue() takes a seqlock snapshot of the package
+   * buffer instead of locking the message mutex, so readers never block the
+   * decoder thread nor each other. A reader racing with the decoder simply
+   * retries its copy. Disabled by default.
+   *
+   * @note Linux only. On an RTOS a reader could spin forever on a preempted
+   * decoder task, so there getValue() always takes the mutex.
+   *
+   * @platforms M210V2, M300
+   * @param enable true to read without the message mutex
+   */
+  void setLockFreeRead(bool enable);
+
+  bool isLockFreeRead();
+
   template <Telemetry::TopicName           topic>
   typename Telemetry::TypeMap<topic>::type getValue()
   {
     typename Telemetry::TypeMap<topic>::type ans;
 
-    void* p = Telemetry::TopicDataBase[topic].latest;
+#ifdef __linux__
+    /*
+     * Adding and removing a package bumps its sequence, so a topic that moved
+     * to another package or went away while copying is read again. The
+     * buffers are kept for the life of the package, a stale p is still valid
+     * memory.
+     */
+    while (lockFreeRead.load(std::memory_order_relaxed))
+    {
+      uint8_t pkgID = Telemetry::TopicDataBase[topic].pkgID;
+      if (pkgID >= MAX_NUMBER_OF_PACKAGE)
+      {
+        break;
+      }
+      const SubscriptionPackage& pkg = package[pkgID];
+      uint32_t seq = pkg.readBegin();
+      void*    p   = Telemetry::TopicDataBase[topic].latest;
+      bool     ok  = p && (Telemetry::TopicDataBase[topic].pkgID == pkgID);
+      if (ok)
+      {
+        memcpy(&ans, p, sizeof(ans));
+      }
+      if (!pkg.readRetry(seq))
+      {
+        if (ok)
+        {
+          return ans;
+        }
+        break;
+      }
+    }
+#endif
 
     lockMSG();
+    void* p = Telemetry::TopicDataBase[topic].latest;
     if (p)
     {
       ans = *reinterpret_cast<typename Telemetry::TypeMap<topic>::type*>(p);
@@ -357,20 +535,284 @@ public: // public methods
     return ans;
   }
 
+  /*!
+   * @brief Start recording a ring of timestamped samples for a topic
+   *
+   * @details Every time a package carrying the topic is received, its value
+   * is recorded with the host receive time and, for packages subscribed
+   * with sendTimeStamp, the FC timestamp. Calling it again for the same
+   * topic starts a new, empty history.
+   *
+   * @platforms M210V2, M300
+   * @param topic
+   * @param capacity: number of samples kept, e.g. 400 for 1 s at 400 Hz
+   */
+  bool enableTopicHistory(Telemetry::TopicName topic, uint16_t capacity);
+
+  /*!
+   * @brief Stop recording a topic and free its history.
+   */
+  void disableTopicHistory(Telemetry::TopicName topic);
+
+  /*!
+   * @brief Recorded samples of a topic received in the last spanMs, oldest
+   * first. Empty if history is not enabled for the topic.
+   *
+   * @platforms M210V2, M300
+   */
+  template <Telemetry::TopicName topic>
+  std::vector<TopicSample<typename Telemetry::TypeMap<topic>::type> >
+  getHistory(uint32_t spanMs)
+  {
+    typedef TopicSample<typename Telemetry::TypeMap<topic>::type> Sample;
+    std::vector<Sample> samples;
+
+    lockHistory();
+    TopicHistory* history = topicHistory[topic];
+    if (!history)
+    {
+      freeHistory();
+      return samples;
+    }
+
+    uint64_t now = TopicHistory::getHostTimeUs();
+    Sample   sample;
+    for (uint32_t age = 0; age < history->getCapacity(); age++)
+    {
+      if (!history->read(age, sample.fcTime, sample.hostTimeUs,
+                         &sample.value) ||
+          now - sample.hostTimeUs > (uint64_t)spanMs * 1000)
+      {
+        break;
+      }
+      samples.push_back(sample);
+    }
+    freeHistory();
+    return std::vector<Sample>(samples.rbegin(), samples.rend());
+  }
+
+  /*!
+   * @brief Value of a topic at a given time, interpolated between the two
+   * recorded samples around it (see TopicInterpolator). Types without an
+   * interpolator take the nearer sample.
+   *
+   * @platforms M210V2, M300
+   * @param timeUs: in us, on the clock selected by timeBase
+   * @param value: result
+   * @param timeBase: host receive time or FC timestamp
+   * @return false if timeUs is outside the recorded samples
+   */
+  template <Telemetry::TopicName topic>
+  bool getAt(uint64_t timeUs, typename Telemetry::TypeMap<topic>::type& value,
+             TopicHistoryTimeBase timeBase = HISTORY_HOST_TIME)
+  {
+    lockHistory();
+    bool ret = getAtLocked<topic>(timeUs, value, timeBase);
+    freeHistory();
+    return ret;
+  }
+
+  /*!
+   * @brief Record the raw subscription frames and package changes.
+   * @note Set it before starting packages, NULL to detach.
+   * @platforms Linux
+   */
+  void setRecorder(TelemetryRecorder* recorder);
+
+  /*!
+   * @brief Set up and start a package without the FC, used to replay a
+   * recording (see TelemetryReplayer). A package already in use under the
+   * same ID is replaced.
+   */
+  bool addPackageOffline(int packageID, int numberOfTopics,
+                         Telemetry::TopicName* topicList, bool sendTimeStamp,
+                         uint16_t freq);
+
+  /*! @brief Counterpart of addPackageOffline() */
+  void removePackageOffline(int packageID);
+
+  /*!
+   * @brief Number of times the topic has been received since startup.
+   *
+   * @platforms M210V2, M300
+   */
+  uint32_t getUpdateSeq(Telemetry::TopicName topic);
+
+  /*!
+   * @brief Block until a package carrying the topic arrives after seq.
+   *
+   * @platforms M210V2, M300
+   * @param topic
+   * @param seq: last sequence seen, updated to the current one on return
+   * @param timeoutMs
+   * @return false on timeout
+   */
+  bool waitForUpdate(Telemetry::TopicName topic, uint32_t& seq,
+                     uint32_t timeoutMs);
+
+  /*!
+   * @brief Block until the next update of the topic, instead of sleeping
+   * and polling getValue().
+   *
+   * @platforms M210V2, M300
+   * @return false on timeout
+   */
+  template <Telemetry::TopicName topic>
+  bool waitForUpdate(uint32_t timeoutMs)
+  {
+    uint32_t seq = getUpdateSeq(topic);
+    return waitForUpdate(topic, seq, timeoutMs);
+  }
+
+  /*!
+   * @brief Block until predicate(getValue<topic>()) is true. The predicate
+   * is checked once right away, then on every update of the topic.
+   *
+   * @details The predicate may read other topics of the same package with
+   * getValue(), they are updated together.
+   *
+   * @platforms M210V2, M300
+   * @param predicate: callable taking the topic value
+   * @param timeoutMs
+   * @return false on timeout
+   */
+  template <Telemetry::TopicName topic, typename Predicate>
+  bool waitUntil(Predicate predicate, uint32_t timeoutMs)
+  {
+    uint32_t deadline = 0;
+    OsdkOsal_GetTimeMs(&deadline);
+    deadline += timeoutMs;
+
+    uint32_t seq = getUpdateSeq(topic);
+    while (!predicate(getValue<topic>()))
+    {
+      if (!waitSeqChange(topic, seq, deadline))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
 public: // public variables
   const static uint8_t   MAX_NUMBER_OF_PACKAGE = 7;
   VehicleCallBackHandler subscriptionDataDecodeHandler;
+  VehicleFrameViewCallBackHandler subscriptionDataViewDecodeHandler;
 
 private: // private variables
   Vehicle*            vehicle;
   SubscriptionPackage package[MAX_NUMBER_OF_PACKAGE];
+#ifdef __linux__
+  std::atomic<bool>   lockFreeRead;
+#else
+  bool                lockFreeRead;
+#endif
+
+  // Package planner state, requestedFreq is 0 for topics not requested
+  uint16_t requestedFreq[Telemetry::TOTAL_TOPIC_NUMBER];
+  bool     plannerOwned[MAX_NUMBER_OF_PACKAGE];
+  bool     plannerTimeStamp;
+  /*! Planner working sets, kept off the stack since they take several KB.
+   *  Guarded by plannerLock, which is held for a whole re-plan */
+  PackagePlan plannerWork[Telemetry::TOTAL_TOPIC_NUMBER];
+  PackagePlan plannerPlans[MAX_NUMBER_OF_PACKAGE];
+  T_OsdkMutexHandle plannerLock;
+
+  /*! Swapped under the message mutex for the decode thread and under
+   *  historyLock for the readers, so a ring is only freed once no reader
+   *  uses it */
+  TopicHistory* topicHistory[Telemetry::TOTAL_TOPIC_NUMBER];
+  T_OsdkMutexHandle historyLock;
+  TelemetryRecorder* recorder;
+
+  /*! A thread in waitSeqChange, linked in updateWaiters until its topic
+   *  changes or it gives up. Lives on the waiter's stack. */
+  typedef struct UpdateWaiter
+  {
+    Telemetry::TopicName topic;
+    uint32_t             seq;
+    T_OsdkSemHandle      sem;
+    bool                 linked;
+    UpdateWaiter*        next;
+  } UpdateWaiter;
+
+  // Topic update notification, guarded by updateLock; notifyUpdate posts
+  // and unlinks every waiter whose topic changed
+  uint32_t          topicSeq[Telemetry::TOTAL_TOPIC_NUMBER];
+  UpdateWaiter*     updateWaiters;
+  T_OsdkMutexHandle updateLock;
 
 private: // private methods
-  void extractOnePackage(RecvContainer*       pRcvContainer,
+  void extractOnePackage(const uint8_t* data, size_t len,
                          SubscriptionPackage* pkg);
+  void recordHistory(SubscriptionPackage* pkg, const uint8_t* data,
+                     size_t len);
+  void recordPackageAdd(SubscriptionPackage* pkg);
+  void recordPackageRemove(uint8_t packageID);
+
+  template <Telemetry::TopicName topic>
+  bool getAtLocked(uint64_t timeUs,
+                   typename Telemetry::TypeMap<topic>::type& value,
+                   TopicHistoryTimeBase timeBase)
+  {
+    typedef TopicSample<typename Telemetry::TypeMap<topic>::type> Sample;
+
+    TopicHistory* history = topicHistory[topic];
+    if (!history)
+    {
+      return false;
+    }
+
+    Sample   newer, older;
+    uint64_t newerUs = 0;
+    for (uint32_t age = 0; age < history->getCapacity(); age++)
+    {
+      if (!history->read(age, older.fcTime, older.hostTimeUs, &older.value))
+      {
+        return false;
+      }
+      uint64_t olderUs = (timeBase == HISTORY_FC_TIME)
+                           ? TopicHistory::getFcTimeUs(older.fcTime)
+                           : older.hostTimeUs;
+      if (olderUs == timeUs)
+      {
+        value = older.value;
+        return true;
+      }
+      if (olderUs < timeUs)
+      {
+        if (age == 0)
+        {
+          return false; // newer than the newest sample
+        }
+        TopicInterpolator<typename Telemetry::TypeMap<topic>::type>::lerp(
+          older.value, newer.value,
+          (float32_t)(timeUs - olderUs) / (float32_t)(newerUs - olderUs),
+          value);
+        return true;
+      }
+      newer   = older;
+      newerUs = olderUs;
+    }
+    return false;
+  }
+  //! deadlineMs is on the OsdkOsal_GetTimeMs clock
+  bool waitSeqChange(Telemetry::TopicName topic, uint32_t& seq,
+                     uint32_t deadlineMs);
+  void bumpUpdateSeq(SubscriptionPackage* pkg);
+  void notifyUpdate();
+  void unlinkWaiter(UpdateWaiter* waiter);
+  //! Called with plannerLock held
+  bool replan(int timeout);
+  static int planInto(const TopicRequest* requests, int numberOfRequests,
+                      bool sendTimeStamp, PackagePlan* work, PackagePlan* plans,
+                      int maxPackages);
+  bool isSamePackage(int packageID, const PackagePlan& plan);
   T_OsdkMutexHandle m_msgLock;
   void lockMSG();
   void freeMSG();
+  void lockHistory();
+  void freeHistory();
 };
 }
 }
@@ -0,0 +1,235 @@
+/** @file dji_telemetry_recorder.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief
+ *  Binary recorder and offline replay of subscription/broadcast telemetry
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef DJI_TELEMETRY_RECORDER_H
+#define DJI_TELEMETRY_RECORDER_H
+
+#include "dji_vehicle_callback.hpp"
+#include "dji_subscription.hpp"
+#include "dji_broadcast.hpp"
+
+#if defined(__linux__)
+
+#include <atomic>
+
+namespace DJI
+{
+namespace OSDK
+{
+
+/*! @brief On-disk layout of a telemetry recording
+ *
+ *  @details A 64-byte file header is followed by fixed-size chunks. Each
+ *  chunk starts with a TelemetryChunkHeader followed by records. A record
+ *  is a TelemetryRecordHeader plus its payload, padded to 8 bytes.
+ *
+ *  A chunk's used count is updated only after a record has been fully
+ *  written, so a recording cut short by a crash still replays up to its
+ *  last complete record.
+ */
+namespace TelemetryLog
+{
+const uint32_t VERSION            = 1;
+const uint32_t CHUNK_MAGIC        = 0x4B4E4843; // "CHNK"
+const uint32_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+const uint32_t FILE_HEADER_SIZE   = 64;
+
+typedef enum RecordType
+{
+  /*! Raw subscription or broadcast frame, payload as received */
+  RECORD_FRAME          = 1,
+  /*! A package was added, payload is PackageRecord + UID list */
+  RECORD_PACKAGE_ADD    = 2,
+  /*! A package was removed, payload is the package ID */
+  RECORD_PACKAGE_REMOVE = 3,
+} RecordType;
+
+#pragma pack(1)
+typedef struct FileHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t chunkSize;
+  uint8_t  reserved[FILE_HEADER_SIZE - 16];
+} FileHeader;
+
+typedef struct ChunkHeader
+{
+  uint32_t magic;
+  uint32_t index;
+  /*! Bytes of complete records following the header */
+  uint32_t used;
+  uint32_t records;
+} ChunkHeader;
+
+typedef struct RecordHeader
+{
+  /*! Host monotonic receive time */
+  uint64_t hostTimeUs;
+  uint8_t  type;
+  uint8_t  cmdSet;
+  uint8_t  cmdId;
+  uint8_t  reserved;
+  uint16_t len;
+  uint16_t reserved2;
+} RecordHeader;
+
+typedef struct PackageRecord
+{
+  uint8_t  packageID;
+  uint16_t freq;
+  uint8_t  config;
+  uint8_t  numberOfTopics;
+  // followed by numberOfTopics topic UIDs (uint32_t)
+} PackageRecord;
+#pragma pack()
+} // namespace TelemetryLog
+
+/*! @brief Appends the raw telemetry frame stream to a memory-mapped file
+ *
+ *  @details Attach it with DataSubscription::setRecorder() and
+ *  DataBroadcast::setRecorder(). Frames are copied into the mapped chunk
+ *  from the receive thread, no syscall is made except when a chunk fills
+ *  up and the file grows by one more chunk.
+ */
+class TelemetryRecorder
+{
+public:
+  typedef struct RecorderStats
+  {
+    uint32_t records;
+    uint32_t chunks;
+    uint64_t bytes;
+    /*! records lost because the file could not grow */
+    uint32_t dropped;
+  } RecorderStats;
+
+  TelemetryRecorder();
+  ~TelemetryRecorder();
+
+  /*!
+   * @brief Create (or truncate) a recording
+   * @param path
+   * @param chunkSize: bytes per chunk, rounded up to the page size
+   */
+  bool open(const char* path,
+            uint32_t    chunkSize = TelemetryLog::DEFAULT_CHUNK_SIZE);
+
+  /*! @brief Flush and close the recording. Detach it from the telemetry
+   *  classes first. */
+  void close();
+
+  bool isOpen();
+
+  void recordFrame(const RecvFrameView& frame);
+  void recordPackageAdd(SubscriptionPackage* pkg);
+  void recordPackageRemove(uint8_t packageID);
+
+  RecorderStats getStats();
+
+private:
+  bool append(uint8_t type, uint8_t cmdSet, uint8_t cmdId,
+              const uint8_t* part1, uint16_t len1, const uint8_t* part2,
+              uint16_t len2);
+  bool mapChunk(uint32_t index);
+  void unmapChunk();
+
+  int               fd;
+  uint32_t          chunkSize;
+  uint32_t          pageSize;
+  uint8_t*          mapBase;
+  size_t            mapLen;
+  TelemetryLog::ChunkHeader* chunk;
+  uint32_t          chunkIndex;
+  RecorderStats     stats;
+  T_OsdkMutexHandle lock;
+};
+
+/*! @brief Feeds a recording back into DataSubscription and DataBroadcast
+ *
+ *  @details No FC, linker or serial port is needed: the telemetry classes
+ *  can be constructed with a NULL vehicle. Subscription packages are
+ *  restored from the recorded add/remove events, so getValue<TOPIC>(),
+ *  history and user package callbacks all see the recorded stream.
+ *
+ *  @note Broadcast frames are decoded with the current firmware layout
+ *  when no vehicle is attached.
+ */
+class TelemetryReplayer
+{
+public:
+  typedef struct ReplayStats
+  {
+    uint32_t frames;
+    uint32_t packageEvents;
+    /*! records skipped because no target was given for them */
+    uint32_t skipped;
+    /*! recorded duration and time spent replaying */
+    uint64_t recordedUs;
+    uint64_t elapsedUs;
+  } ReplayStats;
+
+  TelemetryReplayer(DataSubscription* subscription, DataBroadcast* broadcast);
+  ~TelemetryReplayer();
+
+  bool open(const char* path);
+  void close();
+
+  /*!
+   * @brief Blocking replay of the whole recording
+   * @param speed: 1.0 for the recorded timing, 2.0 twice as fast,
+   *        0 for as fast as possible
+   * @return false if the recording is not open or corrupted
+   */
+  bool replay(float32_t speed = 1.0f);
+
+  /*! @brief Stop a running replay, may be called from another thread */
+  void stop();
+
+  ReplayStats getStats();
+
+private:
+  void dispatch(const TelemetryLog::RecordHeader* rec, const uint8_t* data);
+
+  DataSubscription* subscription;
+  DataBroadcast*    broadcast;
+  int               fd;
+  const uint8_t*    fileBase;
+  size_t            fileSize;
+  uint32_t          chunkSize;
+  std::atomic<bool> stopFlag;
+  ReplayStats       stats;
+};
+
+} // OSDK
+} // DJI
+
+#endif // __linux__
+
+#endif // DJI_TELEMETRY_RECORDER_H
@@ -0,0 +1,290 @@
+/** @file dji_topic_history.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief
+ *  Per-topic timestamped history of subscription telemetry
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef DJI_TOPIC_HISTORY_H
+#define DJI_TOPIC_HISTORY_H
+
+#include "dji_telemetry.hpp"
+#include <cmath>
+#if defined(__linux__)
+#include <atomic>
+#endif
+
+namespace DJI
+{
+namespace OSDK
+{
+
+/*! @brief Clock used to look up a sample in a TopicHistory */
+typedef enum TopicHistoryTimeBase
+{
+  /*! Host monotonic time at which the package was received */
+  HISTORY_HOST_TIME = 0,
+  /*! FC timestamp carried by the package, only set for packages subscribed
+   *  with sendTimeStamp */
+  HISTORY_FC_TIME = 1,
+} TopicHistoryTimeBase;
+
+/*! @brief One recorded sample of a topic */
+template <typename T>
+struct TopicSample
+{
+  /*! FC timestamp of the package, zero if the package has no timestamp */
+  Telemetry::TimeStamp fcTime;
+  /*! Host monotonic receive time, in us */
+  uint64_t             hostTimeUs;
+  T                    value;
+};
+
+/*! @brief Interpolation between two samples of a topic.
+ *
+ *  @details The default picks the nearer sample; numeric types blend
+ *  linearly. ratio is in [0, 1], 0 giving a and 1 giving b.
+ */
+template <typename T>
+struct TopicInterpolator
+{
+  static void lerp(const T& a, const T& b, float32_t ratio, T& out)
+  {
+    out = (ratio < 0.5f) ? a : b;
+  }
+};
+
+template <>
+struct TopicInterpolator<float32_t>
+{
+  static void lerp(const float32_t& a, const float32_t& b, float32_t ratio,
+                   float32_t& out)
+  {
+    out = a + (b - a) * ratio;
+  }
+};
+
+template <>
+struct TopicInterpolator<float64_t>
+{
+  static void lerp(const float64_t& a, const float64_t& b, float32_t ratio,
+                   float64_t& out)
+  {
+    out = a + (b - a) * ratio;
+  }
+};
+
+template <>
+struct TopicInterpolator<Telemetry::Vector3f>
+{
+  static void lerp(const Telemetry::Vector3f& a, const Telemetry::Vector3f& b,
+                   float32_t ratio, Telemetry::Vector3f& out)
+  {
+    out.x = a.x + (b.x - a.x) * ratio;
+    out.y = a.y + (b.y - a.y) * ratio;
+    out.z = a.z + (b.z - a.z) * ratio;
+  }
+};
+
+template <>
+struct TopicInterpolator<Telemetry::Velocity>
+{
+  static void lerp(const Telemetry::Velocity& a, const Telemetry::Velocity& b,
+                   float32_t ratio, Telemetry::Velocity& out)
+  {
+    out = (ratio < 0.5f) ? a : b;
+    TopicInterpolator<Telemetry::Vector3f>::lerp(a.data, b.data, ratio,
+                                                 out.data);
+  }
+};
+
+/*! Linear blend of a longitude along the shorter way, across the
+ *  antimeridian if need be. halfTurn is pi for rad, 180 for deg.
+ */
+inline float64_t
+lerpLongitude(float64_t a, float64_t b, float32_t ratio, float64_t halfTurn)
+{
+  float64_t d = b - a;
+  if (d > halfTurn)
+  {
+    d -= 2 * halfTurn;
+  }
+  else if (d < -halfTurn)
+  {
+    d += 2 * halfTurn;
+  }
+  float64_t out = a + d * ratio;
+  if (out > halfTurn)
+  {
+    out -= 2 * halfTurn;
+  }
+  else if (out < -halfTurn)
+  {
+    out += 2 * halfTurn;
+  }
+  return out;
+}
+
+/*! Rounded to the nearest integer, e.g. TOPIC_GPS_POSITION in deg*10^7 */
+template <>
+struct TopicInterpolator<Telemetry::Vector3d>
+{
+  static void lerp(const Telemetry::Vector3d& a, const Telemetry::Vector3d& b,
+                   float32_t ratio, Telemetry::Vector3d& out)
+  {
+    out.x = (int32_t)std::floor(a.x + ((float64_t)b.x - a.x) * ratio + 0.5);
+    out.y = (int32_t)std::floor(a.y + ((float64_t)b.y - a.y) * ratio + 0.5);
+    out.z = (int32_t)std::floor(a.z + ((float64_t)b.z - a.z) * ratio + 0.5);
+  }
+};
+
+/*! The position blends, the satellite count is taken from the nearer sample */
+template <>
+struct TopicInterpolator<Telemetry::GPSFused>
+{
+  static void lerp(const Telemetry::GPSFused& a, const Telemetry::GPSFused& b,
+                   float32_t ratio, Telemetry::GPSFused& out)
+  {
+    out = (ratio < 0.5f) ? a : b;
+    out.longitude = lerpLongitude(a.longitude, b.longitude, ratio,
+                                  3.14159265358979323846);
+    out.latitude  = a.latitude + (b.latitude - a.latitude) * ratio;
+    out.altitude  = a.altitude + (b.altitude - a.altitude) * ratio;
+  }
+};
+
+template <>
+struct TopicInterpolator<Telemetry::PositionData>
+{
+  static void lerp(const Telemetry::PositionData& a,
+                   const Telemetry::PositionData& b, float32_t ratio,
+                   Telemetry::PositionData& out)
+  {
+    out.longitude = lerpLongitude(a.longitude, b.longitude, ratio, 180.0);
+    out.latitude  = a.latitude + (b.latitude - a.latitude) * ratio;
+    out.HFSL      = a.HFSL + (b.HFSL - a.HFSL) * ratio;
+  }
+};
+
+/*! Normalized linear blend along the shorter arc, close enough to slerp for
+ *  samples a few ms apart.
+ */
+template <>
+struct TopicInterpolator<Telemetry::Quaternion>
+{
+  static void lerp(const Telemetry::Quaternion& a,
+                   const Telemetry::Quaternion& b, float32_t ratio,
+                   Telemetry::Quaternion& out)
+  {
+    float32_t dot  = a.q0 * b.q0 + a.q1 * b.q1 + a.q2 * b.q2 + a.q3 * b.q3;
+    float32_t sign = (dot < 0) ? -1.0f : 1.0f;
+    out.q0 = a.q0 + (sign * b.q0 - a.q0) * ratio;
+    out.q1 = a.q1 + (sign * b.q1 - a.q1) * ratio;
+    out.q2 = a.q2 + (sign * b.q2 - a.q2) * ratio;
+    out.q3 = a.q3 + (sign * b.q3 - a.q3) * ratio;
+    float32_t norm = std::sqrt(out.q0 * out.q0 + out.q1 * out.q1 +
+                               out.q2 * out.q2 + out.q3 * out.q3);
+    if (norm > 0)
+    {
+      out.q0 /= norm;
+      out.q1 /= norm;
+      out.q2 /= norm;
+      out.q3 /= norm;
+    }
+  }
+};
+
+/*! @brief Fixed-capacity ring of timestamped samples of one topic
+ *
+ *  @details Each slot starts on its own cache line and carries a sequence
+ *  number, so the decode thread never waits for readers. A reader that
+ *  races with the writer overwriting the slot it is copying sees the
+ *  sequence change and treats that sample as gone.
+ *  Without atomics (STM32) readers must hold the lock push() is called
+ *  under instead.
+ *
+ *  @note This class is internal, use DataSubscription::enableTopicHistory()
+ *  and the getHistory()/getAt() accessors.
+ */
+class TopicHistory
+{
+public:
+  TopicHistory(size_t valueSize, uint16_t capacity);
+  ~TopicHistory();
+
+  /*! @brief Record a sample. Single writer, the subscription decode thread */
+  void push(const Telemetry::TimeStamp& fcTime, uint64_t hostTimeUs,
+            const uint8_t* value);
+
+  /*!
+   * @brief Copy out a recorded sample
+   *
+   * @param age: 0 for the newest sample, 1 for the one before, ...
+   * @param value: buffer of getValueSize() bytes
+   * @return false if the sample does not exist or was just overwritten
+   */
+  bool read(uint32_t age, Telemetry::TimeStamp& fcTime, uint64_t& hostTimeUs,
+            void* value) const;
+
+  uint16_t getCapacity() const;
+  size_t   getValueSize() const;
+
+  static uint64_t getHostTimeUs();
+  static uint64_t getFcTimeUs(const Telemetry::TimeStamp& fcTime);
+
+private:
+  typedef struct SlotHeader
+  {
+    /*! 2 * (sample index + 1) once written, odd while being written */
+#if defined(__linux__)
+    std::atomic<uint32_t> seq;
+#else
+    uint32_t              seq;
+#endif
+    uint64_t              hostTimeUs;
+    Telemetry::TimeStamp  fcTime;
+  } SlotHeader;
+
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  SlotHeader* slotAt(uint32_t index) const;
+
+  uint8_t*              rawBuffer;
+  uint8_t*              slots;
+  size_t                stride;
+  size_t                valueSize;
+  uint16_t              capacity;
+  /*! Total number of samples pushed */
+#if defined(__linux__)
+  std::atomic<uint32_t> count;
+#else
+  uint32_t              count;
+#endif
+};
+
+} // OSDK
+} // DJI
+
+#endif // DJI_TOPIC_HISTORY_H
@@ -128,6 +128,31 @@ public:
 #endif
 
   DJIBattery*         djiBattery;
+
+  /*! Startup behaviour of init() */
+  typedef enum StartupMode
+  {
+    /*! Every module one after another (default) */
+    STARTUP_SEQUENTIAL = 0,
+    /*! Initialize the independent modules concurrently, overlap the waiting
+     *  phases with the rest of the startup and create MFIO, MobileDevice
+     *  and PSDKManager on first access */
+    STARTUP_FAST       = 1,
+  } StartupMode;
+
+  /*! @brief Select the startup mode, before activate() is called
+   *  @note In STARTUP_FAST mode mfio, mobileDevice and psdkManager stay
+   *  NULL until getMFIO(), getMobileDevice() or getPSDKManager() is called.
+   *  Use the getters rather than the public members in either mode, they
+   *  are also the thread safe way to reach these modules.
+   */
+  void setStartupMode(StartupMode mode);
+
+  /*! Accessors that create the module on first use */
+  MFIO*         getMFIO();
+  MobileDevice* getMobileDevice();
+  PSDKManager*  getPSDKManager();
+
   int functionalSetUp();
   ////////// Blocking calls ///////////
 
@@ -342,10 +367,43 @@ private:
 
   void sendBuriedDataPkgToFC(void);
 
+  typedef bool (Vehicle::*InitFunc)();
+  bool runStartupPhase(const char* name, InitFunc func);
+
+  static const size_t MAX_STARTUP_GROUP_SIZE = 8;
+  /*! One phase of a group initialized concurrently */
+  typedef struct StartupTask
+  {
+    Vehicle*         vehicle;
+    const char*      name;
+    InitFunc         func;
+    bool             ret;
+    T_OsdkSemHandle  done;
+  } StartupTask;
+  static void* startupTask(void* arg);
+  //! @return false if one of the phases failed
+  bool runStartupGroup(StartupTask* tasks, size_t num);
+
+  void joinSubscriberDrain();
+  static void* subscriberDrainTask(void* arg);
+  static void* buriedDataTask(void* arg);
+  void sendBuriedData();
+  void joinBuriedData();
+
+  StartupMode       startupMode;
+  T_OsdkMutexHandle lazyInitMutex;
+  T_OsdkTaskHandle  subscriberDrainHandle;
+  T_OsdkSemHandle   subscriberDrainSem;
+  T_OsdkTaskHandle  buriedDataHandle;
+  //! Posted to stop the buried data task early
+  T_OsdkSemHandle   buriedDataStopSem;
+  //! Posted by the buried data task when it returns
+  T_OsdkSemHandle   buriedDataDoneSem;
+
   static void fcLostConnectCallBack(void);
   static uint8_t sendHeartbeatToFCFunc(Linker * linker);
-  T_OsdkTaskHandle sendHeartbeatToFCHandle;
-  static void *sendHeartbeatToFCTask(void *arg);
+  uint32_t sendHeartbeatToFCJob;
+  static void sendHeartbeatToFCTask(void *arg, uint32_t self);
 };
 }
 }
@@ -63,6 +63,18 @@ typedef struct RecvContainer
   DJI::OSDK::DispatchInfo   dispatchInfo;
 } RecvContainer;
 
+/*! @brief Received frame view
+ *  @details Lightweight counterpart of RecvContainer used by the hot
+ *           telemetry commands. The payload is not copied, it points into the
+ *           linker's frame buffer and is only valid during the callback.
+ */
+typedef struct RecvFrameView
+{
+  DJI::OSDK::ACK::Entry recvInfo;
+  const uint8_t*        payload;
+  uint16_t              payloadLen;
+} RecvFrameView;
+
 
 //! @todo move definition below to class Vehicle
 //! so that we could remove this file
@@ -76,6 +88,16 @@ typedef struct RecvContainer
 typedef void (*VehicleCallBack)(Vehicle* vehicle, RecvContainer recvFrame,
                                 UserData userData);
 
+/*! @brief Function prototype for callbacks receiving a RecvFrameView
+ *
+ * @details Used for high rate data (subscription, broadcast) where copying the
+ * payload into a RecvContainer for every frame is too costly.
+ *
+ */
+typedef void (*VehicleFrameViewCallBack)(Vehicle*             vehicle,
+                                         const RecvFrameView& recvFrame,
+                                         UserData             userData);
+
 /*! @brief The CallBackHandler struct allows users to encapsulate callbacks and
  * data in one struct
  *
@@ -86,6 +108,15 @@ typedef struct VehicleCallBackHandler
   UserData        userData;
 } VehicleCallBackHandler;
 
+/*! @brief The CallBackHandler struct for VehicleFrameViewCallBack
+ *
+ */
+typedef struct VehicleFrameViewCallBackHandler
+{
+  VehicleFrameViewCallBack callback;
+  UserData                 userData;
+} VehicleFrameViewCallBackHandler;
+
 /*! @brief The CallBackHandler struct allows users to encapsulate callbacks and
  * data in one struct. This is a more common method.
  *
@@ -118,6 +118,34 @@ namespace OSDK
      */
     ErrorCode::ErrorCodeType uploadMission(int timeout);
 
+    /*! Statistics of a pipelined upload */
+    typedef struct UploadStats {
+      /*! pushes sent, not counting resends */
+      uint32_t chunks;
+      /*! pushes resent after a timeout */
+      uint32_t retries;
+      /*! payload bytes acknowledged by the flight controller */
+      uint32_t bytes;
+      uint32_t elapsedMs;
+      float32_t bytesPerSec;
+    } UploadStats;
+
+    /*! @brief Upload all the waypoint v2 mission with several pushes in flight
+     *
+     *  @platforms M300
+     *  @note Every push carries its own start/end index, so the flight
+     *  controller can accept them out of order. Only pushes that time out
+     *  are resent; any error code in an ACK aborts the upload. The push
+     *  indices are 16 bit, longer missions are rejected.
+     *  @param timeout timeout of each push in seconds
+     *  @param windowSize number of pushes in flight, 1..16
+     *  @param stats optional, filled with push count, retries and throughput
+     *  @return ErrorCode::ErrorCodeType error code
+     */
+    ErrorCode::ErrorCodeType uploadMissionPipelined(int timeout,
+                                                    uint8_t windowSize = 4,
+                                                    UploadStats *stats = NULL);
+
     /*! @brief Download all the waypoint v2 mission
      *
     *  @platforms M300
@@ -159,6 +187,21 @@ namespace OSDK
     */
     ErrorCode::ErrorCodeType uploadAction(std::vector<DJIWaypointV2Action> &actions, int timeout);
 
+    /*! @brief Upload all waypoint v2 actions, pre-encoded and with retries
+     *
+     *  @platforms M300
+     *  @note Action pushes carry no start/end index, so unlike the mission
+     *  upload they are sent strictly one at a time and in order. A push
+     *  that times out is resent before the next one.
+     *  @param actions vector of DJIWaypointV2Action
+     *  @param timeout timeout of each push in seconds
+     *  @param stats optional, filled with push count, retries and throughput
+     *  @return ErrorCode::ErrorCodeType error code
+     */
+    ErrorCode::ErrorCodeType uploadActionPipelined(std::vector<DJIWaypointV2Action> &actions,
+                                                   int timeout,
+                                                   UploadStats *stats = NULL);
+
    /*! @brief Get action's remain memory
     *
     *  @platforms M300
@@ -240,6 +283,21 @@ namespace OSDK
 
     float32_t takeoffAltitude;
 
+    typedef struct UploadChunk {
+      uint32_t offset;
+      uint16_t len;
+      uint8_t tries;
+    } UploadChunk;
+
+    /*! Encoded pushes of the last pipelined upload, reused between uploads */
+    std::vector<uint8_t> uploadBuf;
+    std::vector<UploadChunk> uploadChunks;
+    std::vector<uint32_t> retryChunks;
+
+    ErrorCode::ErrorCodeType pipelinedUpload(const uint8_t cmd[], int timeout,
+                                             uint8_t windowSize,
+                                             UploadStats *stats);
+
     void RegisterOSDInfoCallback(Vehicle *vehiclePtr);
 
   };
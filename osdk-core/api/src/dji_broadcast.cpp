@@ -29,6 +29,7 @@
 
 #include "dji_broadcast.hpp"
 #include "dji_vehicle.hpp"
+#include "dji_telemetry_recorder.hpp"
 
 using namespace DJI;
 using namespace DJI::OSDK;
@@ -39,30 +40,72 @@ DataBroadcast::unpackCallback(Vehicle* vehicle, RecvContainer recvFrame,
 {
   DataBroadcast* broadcastPtr = (DataBroadcast*)data;
 
-  if (broadcastPtr->getVehicle()->isLegacyM600())
+  broadcastPtr->unpackPayload(recvFrame.recvData.raw_ack_array,
+                              sizeof(recvFrame.recvData.raw_ack_array));
+
+  if (broadcastPtr->userCbHandler.callback)
   {
-    broadcastPtr->unpackOldM600Data(&recvFrame);
+    broadcastPtr->userCbHandler.callback(vehicle, recvFrame,
+                                         broadcastPtr->userCbHandler.userData);
   }
-  else if (broadcastPtr->getVehicle()->getFwVersion() != Version::M100_31)
+}
+
+void
+DataBroadcast::unpackViewCallback(Vehicle*             vehicle,
+                                  const RecvFrameView& recvFrame,
+                                  UserData             data)
+{
+  DataBroadcast* broadcastPtr = (DataBroadcast*)data;
+
+  if (!recvFrame.payload || recvFrame.payloadLen < sizeof(uint16_t))
   {
-    broadcastPtr->unpackData(&recvFrame);
+    DERROR("Broadcast frame too short, length %d", recvFrame.payloadLen);
+    return;
   }
-  else
+
+#if defined(__linux__)
+  if (broadcastPtr->recorder)
   {
-    broadcastPtr->unpackM100Data(&recvFrame);
+    broadcastPtr->recorder->recordFrame(recvFrame);
   }
+#endif
+
+  broadcastPtr->unpackPayload(recvFrame.payload, recvFrame.payloadLen);
 
+  // The RecvContainer copy is only paid when a user callback needs it
   if (broadcastPtr->userCbHandler.callback)
   {
-    broadcastPtr->userCbHandler.callback(vehicle, recvFrame,
-                                         broadcastPtr->userCbHandler.userData);
+    broadcastPtr->userCbHandler.callback(
+      vehicle, LegacyLinker::adaptFrameView(recvFrame),
+      broadcastPtr->userCbHandler.userData);
+  }
+}
+
+void
+DataBroadcast::unpackPayload(const uint8_t* pdata, size_t len)
+{
+  if (isLegacyM600())
+  {
+    unpackOldM600Data(pdata, len);
+  }
+  else if (!vehicle || vehicle->getFwVersion() != Version::M100_31)
+  {
+    unpackData(pdata, len);
+  }
+  else
+  {
+    unpackM100Data(pdata, len);
   }
 }
 
 DataBroadcast::DataBroadcast(Vehicle* vehiclePtr)
+  : vehicle(NULL)
+  , recorder(NULL)
 {
   unpackHandler.callback = unpackCallback;
   unpackHandler.userData = this;
+  unpackViewHandler.callback = unpackViewCallback;
+  unpackViewHandler.userData = this;
 
   userCbHandler.callback = 0;
   userCbHandler.userData = 0;
@@ -79,6 +122,8 @@ DataBroadcast::~DataBroadcast()
   this->setUserBroadcastCallback(0, NULL);
   unpackHandler.callback = 0;
   unpackHandler.userData = 0;
+  unpackViewHandler.callback = 0;
+  unpackViewHandler.userData = 0;
 }
 
 // clang-format off
@@ -87,13 +132,13 @@ DataBroadcast::getTimeStamp()
 {
   Telemetry::TimeStamp  data;
   lockMSG();
-  if (vehicle->isLegacyM600())
+  if (isLegacyM600())
   {
     // Supported Broadcast data in Matrice 600 old firmware
     data.time_ms = legacyTimeStamp.time;
     data.time_ns = legacyTimeStamp.nanoTime;
   }
-  else if(vehicle->isM100())
+  else if(isM100())
   {
     // Supported Broadcast data in Matrice 100
     data.time_ms = legacyTimeStamp.time;
@@ -112,12 +157,12 @@ DataBroadcast::getSyncStamp()
 {
   Telemetry::SyncStamp data = {0};
   lockMSG();
-  if (vehicle->isLegacyM600())
+  if (isLegacyM600())
   {
     // Supported Broadcast data in Matrice 600 old firmware
     data.flag = legacyTimeStamp.syncFlag;
   }
-  else if(vehicle->isM100())
+  else if(isM100())
   {
     // Supported Broadcast data in Matrice 100
     data.flag = legacyTimeStamp.syncFlag;
@@ -155,14 +200,14 @@ DataBroadcast::getVelocity()
 {
   Telemetry::Vector3f data;
   lockMSG();
-  if (vehicle->isLegacyM600())
+  if (isLegacyM600())
   {
     // Supported Broadcast data in Matrice 600 old firmware
     data.x = legacyVelocity.x;
     data.y = legacyVelocity.y;
     data.z = legacyVelocity.z;
   }
-  else if(vehicle->isM100())
+  else if(isM100())
   {
     // Supported Broadcast data in Matrice 100
     data.x = legacyVelocity.x;
@@ -182,13 +227,13 @@ DataBroadcast::getVelocityInfo()
 {
   Telemetry::VelocityInfo data;
   lockMSG();
-  if (vehicle->isLegacyM600())
+  if (isLegacyM600())
   {
     // Supported Broadcast data in Matrice 600 old firmware
     data.health = legacyVelocity.health;
     data.reserve = legacyVelocity.reserve;
   }
-  else if(vehicle->isM100())
+  else if(isM100())
   {
     // Supported Broadcast data in Matrice 100
     data.health = legacyVelocity.health;
@@ -240,7 +285,7 @@ DataBroadcast::getGPSInfo()
 {
   Telemetry::GPSInfo data;
   lockMSG();
-  if (vehicle->isLegacyM600())
+  if (isLegacyM600())
   {
     // Supported Broadcast data in Matrice 600 old firmware
     data.latitude = legacyGPSInfo.latitude;
@@ -304,12 +349,12 @@ DataBroadcast::getStatus()
 {
   Telemetry::Status data = {0};
   lockMSG();
-  if (vehicle->isLegacyM600())
+  if (isLegacyM600())
   {
     // Broadcast data on M600 old firmware. Only flight status is available.
     data.flight = legacyStatus;
   }
-  else if(vehicle->isM100())
+  else if(isM100())
   {
     // Supported Broadcast data in Matrice 100
     data.flight = legacyStatus;
@@ -327,12 +372,12 @@ DataBroadcast::getBatteryInfo()
 {
   Telemetry::Battery data = {0};
   lockMSG();
-  if (vehicle->isLegacyM600())
+  if (isLegacyM600())
   {
     // Only capacity is supported on old M600 FW
     data.percentage = legacyBattery;
   }
-  else if (vehicle->isM100())
+  else if (isM100())
   {
     // Supported Broadcast data in Matrice 100
     data.percentage = legacyBattery;
@@ -372,6 +417,24 @@ DataBroadcast::getVehicle() const
   return vehicle;
 }
 
+bool
+DataBroadcast::isLegacyM600() const
+{
+  return vehicle && vehicle->isLegacyM600();
+}
+
+bool
+DataBroadcast::isM100() const
+{
+  return vehicle && vehicle->isM100();
+}
+
+void
+DataBroadcast::setRecorder(TelemetryRecorder* recorder)
+{
+  this->recorder = recorder;
+}
+
 void
 DataBroadcast::setVehicle(Vehicle* vehiclePtr)
 {
@@ -422,100 +485,111 @@ DataBroadcast::setBroadcastFreq(uint8_t* dataLenIs16, int timeout)
 }
 
 void
-DataBroadcast::unpackData(RecvContainer* pRecvFrame)
+DataBroadcast::unpackData(const uint8_t* pdata, size_t len)
 {
-  uint8_t* pdata = pRecvFrame->recvData.raw_ack_array;
+  const uint8_t* end = pdata + len;
   lockMSG();
   passFlag = *(uint16_t*)pdata;
   pdata += sizeof(uint16_t);
   // clang-format off
-  unpackOne(FLAG_TIME        ,&timeStamp ,pdata,sizeof(timeStamp ));
-  unpackOne(FLAG_TIME        ,&syncStamp ,pdata,sizeof(syncStamp ));
-  unpackOne(FLAG_QUATERNION  ,&q         ,pdata,sizeof(q         ));
-  unpackOne(FLAG_ACCELERATION,&a         ,pdata,sizeof(a         ));
-  unpackOne(FLAG_VELOCITY    ,&v         ,pdata,sizeof(v         ));
-  unpackOne(FLAG_VELOCITY    ,&vi        ,pdata,sizeof(vi        ));
-  unpackOne(FLAG_ANGULAR_RATE,&w         ,pdata,sizeof(w         ));
-  unpackOne(FLAG_POSITION    ,&gp        ,pdata,sizeof(gp        ));
-  unpackOne(FLAG_POSITION    ,&rp        ,pdata,sizeof(rp        ));
-  unpackOne(FLAG_GPSINFO     ,&gps       ,pdata,sizeof(gps       ));
-  unpackOne(FLAG_RTKINFO     ,&rtk       ,pdata,sizeof(rtk       ));
-  unpackOne(FLAG_MAG         ,&mag       ,pdata,sizeof(mag       ));
-  unpackOne(FLAG_RC          ,&rc        ,pdata,sizeof(rc        ));
-  unpackOne(FLAG_GIMBAL      ,&gimbal    ,pdata,sizeof(gimbal    ));
-  unpackOne(FLAG_STATUS      ,&status    ,pdata,sizeof(status    ));
-  unpackOne(FLAG_BATTERY     ,&battery   ,pdata,sizeof(battery   ));
-  unpackOne(FLAG_DEVICE      ,&info      ,pdata,sizeof(info      ));
-  unpackOne(FLAG_COMPASS     ,&compass   ,pdata,sizeof(compass   ));
+  unpackOne(FLAG_TIME        ,&timeStamp ,pdata,end,sizeof(timeStamp ));
+  unpackOne(FLAG_TIME        ,&syncStamp ,pdata,end,sizeof(syncStamp ));
+  unpackOne(FLAG_QUATERNION  ,&q         ,pdata,end,sizeof(q         ));
+  unpackOne(FLAG_ACCELERATION,&a         ,pdata,end,sizeof(a         ));
+  unpackOne(FLAG_VELOCITY    ,&v         ,pdata,end,sizeof(v         ));
+  unpackOne(FLAG_VELOCITY    ,&vi        ,pdata,end,sizeof(vi        ));
+  unpackOne(FLAG_ANGULAR_RATE,&w         ,pdata,end,sizeof(w         ));
+  unpackOne(FLAG_POSITION    ,&gp        ,pdata,end,sizeof(gp        ));
+  unpackOne(FLAG_POSITION    ,&rp        ,pdata,end,sizeof(rp        ));
+  unpackOne(FLAG_GPSINFO     ,&gps       ,pdata,end,sizeof(gps       ));
+  unpackOne(FLAG_RTKINFO     ,&rtk       ,pdata,end,sizeof(rtk       ));
+  unpackOne(FLAG_MAG         ,&mag       ,pdata,end,sizeof(mag       ));
+  unpackOne(FLAG_RC          ,&rc        ,pdata,end,sizeof(rc        ));
+  unpackOne(FLAG_GIMBAL      ,&gimbal    ,pdata,end,sizeof(gimbal    ));
+  unpackOne(FLAG_STATUS      ,&status    ,pdata,end,sizeof(status    ));
+  unpackOne(FLAG_BATTERY     ,&battery   ,pdata,end,sizeof(battery   ));
+  unpackOne(FLAG_DEVICE      ,&info      ,pdata,end,sizeof(info      ));
+  unpackOne(FLAG_COMPASS     ,&compass   ,pdata,end,sizeof(compass   ));
   // clang-format on
   freeMSG();
 }
 
 void
-DataBroadcast::unpackM100Data(RecvContainer* pRecvFrame)
+DataBroadcast::unpackM100Data(const uint8_t* pdata, size_t len)
 {
-  uint8_t* pdata = pRecvFrame->recvData.raw_ack_array;
+  const uint8_t* end = pdata + len;
   lockMSG();
   passFlag = *(uint16_t*)pdata;
   pdata += sizeof(uint16_t);
   // clang-format off
-  unpackOne(FLAG_TIME        ,&legacyTimeStamp   ,pdata,sizeof(legacyTimeStamp ));
-  unpackOne(FLAG_QUATERNION  ,&q                 ,pdata,sizeof(q               ));
-  unpackOne(FLAG_ACCELERATION,&a                 ,pdata,sizeof(a               ));
-  unpackOne(FLAG_VELOCITY    ,&legacyVelocity    ,pdata,sizeof(legacyVelocity  ));
-  unpackOne(FLAG_ANGULAR_RATE,&w                 ,pdata,sizeof(w               ));
-  unpackOne(FLAG_POSITION    ,&gp                ,pdata,sizeof(gp              ));
-  unpackOne(FLAG_M100_MAG    ,&mag               ,pdata,sizeof(mag             ));
-  unpackOne(FLAG_M100_RC     ,&rc                ,pdata,sizeof(rc              ));
-  unpackOne(FLAG_M100_GIMBAL ,&gimbal            ,pdata,sizeof(gimbal          ));
-  unpackOne(FLAG_M100_STATUS ,&legacyStatus      ,pdata,sizeof(legacyStatus    ));
-  unpackOne(FLAG_M100_BATTERY,&legacyBattery     ,pdata,sizeof(legacyBattery   ));
-  unpackOne(FLAG_M100_DEVICE ,&info              ,pdata,sizeof(info            ));
+  unpackOne(FLAG_TIME        ,&legacyTimeStamp   ,pdata,end,sizeof(legacyTimeStamp ));
+  unpackOne(FLAG_QUATERNION  ,&q                 ,pdata,end,sizeof(q               ));
+  unpackOne(FLAG_ACCELERATION,&a                 ,pdata,end,sizeof(a               ));
+  unpackOne(FLAG_VELOCITY    ,&legacyVelocity    ,pdata,end,sizeof(legacyVelocity  ));
+  unpackOne(FLAG_ANGULAR_RATE,&w                 ,pdata,end,sizeof(w               ));
+  unpackOne(FLAG_POSITION    ,&gp                ,pdata,end,sizeof(gp              ));
+  unpackOne(FLAG_M100_MAG    ,&mag               ,pdata,end,sizeof(mag             ));
+  unpackOne(FLAG_M100_RC     ,&rc                ,pdata,end,sizeof(rc              ));
+  unpackOne(FLAG_M100_GIMBAL ,&gimbal            ,pdata,end,sizeof(gimbal          ));
+  unpackOne(FLAG_M100_STATUS ,&legacyStatus      ,pdata,end,sizeof(legacyStatus    ));
+  unpackOne(FLAG_M100_BATTERY,&legacyBattery     ,pdata,end,sizeof(legacyBattery   ));
+  unpackOne(FLAG_M100_DEVICE ,&info              ,pdata,end,sizeof(info            ));
   // clang-format on
   freeMSG();
 }
 
 void
-DataBroadcast::unpackOldM600Data(RecvContainer* pRecvFrame)
+DataBroadcast::unpackOldM600Data(const uint8_t* pdata, size_t len)
 {
-  uint8_t* pdata = pRecvFrame->recvData.raw_ack_array;
+  const uint8_t* end = pdata + len;
   lockMSG();
   passFlag = *(uint16_t*)pdata;
   pdata += sizeof(uint16_t);
   // clang-format off
-  unpackOne(FLAG_TIME        ,&legacyTimeStamp   ,pdata,sizeof(legacyTimeStamp ));
-  unpackOne(FLAG_QUATERNION  ,&q                 ,pdata,sizeof(q               ));
-  unpackOne(FLAG_ACCELERATION,&a                 ,pdata,sizeof(a               ));
-  unpackOne(FLAG_VELOCITY    ,&legacyVelocity    ,pdata,sizeof(legacyVelocity  ));
-  unpackOne(FLAG_ANGULAR_RATE,&w                 ,pdata,sizeof(w               ));
-  unpackOne(FLAG_POSITION    ,&gp                ,pdata,sizeof(gp              ));
-  unpackOne(FLAG_GPSINFO     ,&legacyGPSInfo     ,pdata,sizeof(legacyGPSInfo   ));
-  unpackOne(FLAG_RTKINFO     ,&rtk               ,pdata,sizeof(rtk             ));
-  unpackOne(FLAG_MAG         ,&mag               ,pdata,sizeof(mag             ));
-  unpackOne(FLAG_RC          ,&rc                ,pdata,sizeof(rc              ));
-  unpackOne(FLAG_GIMBAL      ,&gimbal            ,pdata,sizeof(gimbal          ));
-  unpackOne(FLAG_STATUS      ,&legacyStatus      ,pdata,sizeof(legacyStatus    ));
-  unpackOne(FLAG_BATTERY     ,&legacyBattery     ,pdata,sizeof(legacyBattery   ));
-  unpackOne(FLAG_DEVICE      ,&info              ,pdata,sizeof(info            ));
+  unpackOne(FLAG_TIME        ,&legacyTimeStamp   ,pdata,end,sizeof(legacyTimeStamp ));
+  unpackOne(FLAG_QUATERNION  ,&q                 ,pdata,end,sizeof(q               ));
+  unpackOne(FLAG_ACCELERATION,&a                 ,pdata,end,sizeof(a               ));
+  unpackOne(FLAG_VELOCITY    ,&legacyVelocity    ,pdata,end,sizeof(legacyVelocity  ));
+  unpackOne(FLAG_ANGULAR_RATE,&w                 ,pdata,end,sizeof(w               ));
+  unpackOne(FLAG_POSITION    ,&gp                ,pdata,end,sizeof(gp              ));
+  unpackOne(FLAG_GPSINFO     ,&legacyGPSInfo     ,pdata,end,sizeof(legacyGPSInfo   ));
+  unpackOne(FLAG_RTKINFO     ,&rtk               ,pdata,end,sizeof(rtk             ));
+  unpackOne(FLAG_MAG         ,&mag               ,pdata,end,sizeof(mag             ));
+  unpackOne(FLAG_RC          ,&rc                ,pdata,end,sizeof(rc              ));
+  unpackOne(FLAG_GIMBAL      ,&gimbal            ,pdata,end,sizeof(gimbal          ));
+  unpackOne(FLAG_STATUS      ,&legacyStatus      ,pdata,end,sizeof(legacyStatus    ));
+  unpackOne(FLAG_BATTERY     ,&legacyBattery     ,pdata,end,sizeof(legacyBattery   ));
+  unpackOne(FLAG_DEVICE      ,&info              ,pdata,end,sizeof(info            ));
   // clang-format on
   freeMSG();
 }
 
 void
-DataBroadcast::unpackOne(DataBroadcast::FLAG flag, void* data, uint8_t*& buf,
-                         size_t size)
+DataBroadcast::unpackOne(DataBroadcast::FLAG flag, void* data,
+                         const uint8_t*& buf, const uint8_t* end, size_t size)
 {
-  if (flag & passFlag)
+  if (!(flag & passFlag))
   {
-    memcpy((uint8_t*)data, (uint8_t*)buf, size);
+    return;
+  }
+  // passFlag comes from the frame itself, never read past its end. Once a
+  // field is cut off the offsets of the following ones are unknown, so
+  // nothing after it is unpacked either.
+  if (buf + size <= end)
+  {
+    memcpy((uint8_t*)data, buf, size);
     buf += size;
   }
+  else
+  {
+    buf = end;
+  }
 }
 
 void
 DataBroadcast::setVersionDefaults(uint8_t* frequencyBuffer)
 {
-  if (!vehicle->isM100())
+  if (!isM100())
   {
     setFreqDefaults(frequencyBuffer);
   }
@@ -1190,6 +1190,28 @@ ErrorCode::ErrorCodeType CameraManager::startReqFileList(PayloadIndexType index,
   return ret;
 }
 
+ErrorCode::ErrorCodeType CameraManager::startReqFileListIncremental(PayloadIndexType index, FileMgr::FileListReqCBType cb, void *userData) {
+  return fileMgr->startReqFileListIncremental(OSDK_COMMAND_DEVICE_TYPE_CAMERA,
+                                              PAYLOAD_INDEX_TO_DEVICE_ID(index),
+                                              cb, userData);
+}
+
+void CameraManager::setFileListCacheDir(std::string dir) {
+  fileMgr->setFileListCacheDir(dir);
+}
+
+bool CameraManager::findCachedFile(PayloadIndexType index, int fileIndex, MediaFile &file) {
+  return fileMgr->findCachedFile(OSDK_COMMAND_DEVICE_TYPE_CAMERA,
+                                 PAYLOAD_INDEX_TO_DEVICE_ID(index), fileIndex,
+                                 file);
+}
+
+bool CameraManager::findCachedFile(PayloadIndexType index, std::string fileName, MediaFile &file) {
+  return fileMgr->findCachedFile(OSDK_COMMAND_DEVICE_TYPE_CAMERA,
+                                 PAYLOAD_INDEX_TO_DEVICE_ID(index), fileName,
+                                 file);
+}
+
 ErrorCode::ErrorCodeType CameraManager::startReqFileData(PayloadIndexType index, int fileIndex, std::string localPath, FileMgr::FileDataReqCBType cb, void *userData) {
   ErrorCode::ErrorCodeType ret;
   ret = fileMgr->startReqFileData(OSDK_COMMAND_DEVICE_TYPE_CAMERA,
@@ -1197,4 +1219,26 @@ ErrorCode::ErrorCodeType CameraManager::startReqFileData(PayloadIndexType index,
                                   fileIndex, localPath, cb, userData);
   return ret;
 }
+
+ErrorCode::ErrorCodeType CameraManager::enqueueFileData(PayloadIndexType index, const std::vector<MediaFile> &files, std::string localDir, int priority, FileMgr::DownloadItemCBType cb, void *userData, std::vector<uint32_t> *ids) {
+  std::vector<FileMgr::DownloadItem> items;
+  for (auto &file : files) {
+    FileMgr::DownloadItem item;
+    item.type = OSDK_COMMAND_DEVICE_TYPE_CAMERA;
+    item.index = PAYLOAD_INDEX_TO_DEVICE_ID(index);
+    item.file = file;
+    item.localPath = localDir + "/" + file.fileName;
+    item.priority = priority;
+    items.push_back(item);
+  }
+  return fileMgr->enqueueDownloads(items, cb, userData, ids);
+}
+
+bool CameraManager::cancelFileData(uint32_t id) {
+  return fileMgr->cancelDownload(id);
+}
+
+FileMgr::DownloadQueueStats CameraManager::getFileDataQueueStats() {
+  return fileMgr->getDownloadQueueStats();
+}
 #endif
@@ -31,13 +31,23 @@
 #include "dji_linker.hpp"
 #include "osdk_device_id.h"
 #include "dji_internal_command.hpp"
+#include "dji_ctx_pool.hpp"
+#include "dji_timer_scheduler.hpp"
 
 #define MAX_PARAMETER_VALUE_LENGTH 8
 
+#include <new>
+
 #ifdef STM32
 #include <stdio.h>
 #endif
 
+#if defined(__linux__)
+#define SYNC_ACK_THREAD_LOCAL thread_local
+#else
+#define SYNC_ACK_THREAD_LOCAL
+#endif
+
 using namespace DJI;
 using namespace DJI::OSDK;
 
@@ -45,6 +55,7 @@ typedef struct legacyAdaptingData {
   VehicleCallBack cb;
   UserData udata;
   Vehicle *vehicle;
+  VehicleFrameViewCallBack viewCb;
 } legacyAdaptingData;
 
 typedef struct CmdListData {
@@ -52,8 +63,7 @@ typedef struct CmdListData {
   T_RecvCmdItem cmdItemList;
 } CmdListData;
 
-void *LegacyLinker::legacyX5SEnableTask(void *arg) {
-  DSTATUS("Legacy X5S Enable task created.");
+void LegacyLinker::legacyX5SEnableTask(void *arg, uint32_t) {
   if (arg) {
     Linker *linker = (Linker *) arg;
     T_CmdInfo cmdInfo = {0};
@@ -67,25 +77,20 @@ void *LegacyLinker::legacyX5SEnableTask(void *arg) {
     cmdInfo.addr = GEN_ADDR(0, ADDR_V1_COMMAND_INDEX);
     cmdInfo.receiver = 0x00;
     cmdInfo.sender = linker->getLocalSenderId();
-    for(;;) {
-      OsdkOsal_TaskSleepMs(500);
-      if (linker->isUSBPlugged()) linker->send(&cmdInfo, (uint8_t *) &data);
-    }
+    if (linker->isUSBPlugged()) linker->send(&cmdInfo, (uint8_t *) &data);
   } else {
     DERROR("Legacy X5S Enable task run failed because of the invalid linker "
            "ptr. Please recheck this task params, or X5S/X7 will not output "
            "vedio stream.");
   }
-  return NULL;
 }
 
-void LegacyLinker::initX5SEnableThread() {
-  /*! create task for X5S enable pinging */
-  E_OsdkStat osdkStat = OsdkOsal_TaskCreate(&legacyX5SEnableHandle,
-      (void *(*)( void *)) (DJI::OSDK::LegacyLinker::legacyX5SEnableTask),
-      OSDK_TASK_STACK_SIZE_DEFAULT / 2, vehicle->linker);
-  if (osdkStat != OSDK_STAT_OK) {
-    DERROR("legacyX5SEnableTask create error:%d", osdkStat);
+void LegacyLinker::initX5SEnableJob() {
+  /*! X5S enable pinging every 500ms */
+  legacyX5SEnableJob = TimerScheduler::instance().schedulePeriodic(
+      legacyX5SEnableTask, vehicle->linker, 500, 500, "legacyX5SEnable");
+  if (!legacyX5SEnableJob) {
+    DERROR("legacyX5SEnableTask schedule error");
   }
 }
 
@@ -128,13 +133,54 @@ RecvContainer recvFrameAdapting(const T_CmdInfo &cmdInfo, const uint8_t *cmdData
   return recvFrame;
 }
 
+RecvFrameView recvFrameViewAdapting(const T_CmdInfo &cmdInfo,
+                                   const uint8_t *cmdData)
+{
+  RecvFrameView view = {};
+
+  view.recvInfo.cmd_set = cmdInfo.cmdSet;
+  view.recvInfo.cmd_id = cmdInfo.cmdId;
+  view.recvInfo.len = OpenProtocol::PackageMin;
+  if (cmdData) {
+    view.recvInfo.len += cmdInfo.dataLen;
+    view.payloadLen = cmdInfo.dataLen;
+  }
+  view.recvInfo.buf = (uint8_t *) cmdData;
+  view.recvInfo.seqNumber = cmdInfo.seqNum;
+  view.payload = cmdData;
+
+  return view;
+}
+
+RecvContainer LegacyLinker::adaptFrameView(const RecvFrameView &view)
+{
+  RecvContainer recvFrame = {};
+  size_t len = view.payloadLen;
+
+  if (len > sizeof(recvFrame.recvData.raw_ack_array)) {
+    len = sizeof(recvFrame.recvData.raw_ack_array);
+  }
+  recvFrame.dispatchInfo.isAck = true;
+  recvFrame.dispatchInfo.isCallback = true;
+  recvFrame.dispatchInfo.callbackID = 0;
+  recvFrame.recvInfo = view.recvInfo;
+  if (view.payload) {
+    memcpy(recvFrame.recvData.raw_ack_array, view.payload, len);
+  }
+
+  return recvFrame;
+}
+
 E_OsdkStat legacyAdaptingRegisterCB(
     struct _CommandHandle *cmdHandle,
     const T_CmdInfo *cmdInfo,
     const uint8_t *cmdData, void *userData) {
   legacyAdaptingData *legacyData = (legacyAdaptingData *)userData;
   if (cmdInfo && legacyData && legacyData->vehicle) {
-    if (legacyData->cb) {
+    if (legacyData->viewCb) {
+      RecvFrameView view = recvFrameViewAdapting(*cmdInfo, cmdData);
+      legacyData->viewCb(legacyData->vehicle, view, legacyData->udata);
+    } else if (legacyData->cb) {
       RecvContainer recvFrame = recvFrameAdapting(*cmdInfo, cmdData);
       legacyData->cb(legacyData->vehicle, recvFrame, legacyData->udata);
     }
@@ -145,175 +191,254 @@ E_OsdkStat legacyAdaptingRegisterCB(
   }
 }
 
-void *LegacyLinker::decodeAck(E_OsdkStat ret, uint8_t cmdSet, uint8_t cmdId,
-                              RecvContainer recvFrame)
+/*! ACK decoders, each one fills the caller owned storage with the ACK struct
+ *  the blocking API of the command returns. */
+typedef void (*AckDecoder)(const RecvContainer &recvFrame, void *ack);
+
+template <typename AckT>
+static AckT *ackAs(void *ack)
 {
-  void* pACK;
+  static_assert(sizeof(AckT) <= LegacyLinker::MAX_SYNC_ACK_SIZE,
+                "SyncAck is too small for this ACK type");
+  return new (ack) AckT();
+}
 
-  uint8_t cmd[2] = {cmdSet, cmdId};
+static void decodeCommonAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::ErrorCode *p = ackAs<ACK::ErrorCode>(ack);
+  p->info = recvFrame.recvInfo;
+  p->data = recvFrame.recvData.ack;
+}
 
-  if (ret == OSDK_STAT_OK) {
-  }
-  else if (ret == OSDK_STAT_ERR_TIMEOUT) {
-    ackErrorCode.info = recvFrame.recvInfo;
-    ackErrorCode.data = ErrorCode::CommonACK::NO_RESPONSE_ERROR;
-    pACK = static_cast<void *>(&this->ackErrorCode);
-    return pACK;
-  } else {
-    ackErrorCode.info = recvFrame.recvInfo;
-    ackErrorCode.data = ErrorCode::CommonACK::SYSTEM_ERROR;
-    pACK = static_cast<void *>(&this->ackErrorCode);
-    return pACK;
+static void decodeMissionAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::ErrorCode *p = ackAs<ACK::ErrorCode>(ack);
+  p->info = recvFrame.recvInfo;
+  p->data = recvFrame.recvData.missionACK;
+}
+
+static void decodeSubscribeAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::ErrorCode *p = ackAs<ACK::ErrorCode>(ack);
+  p->info = recvFrame.recvInfo;
+  p->data = recvFrame.recvData.subscribeACK;
+}
+
+static void decodeCommandAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::ErrorCode *p = ackAs<ACK::ErrorCode>(ack);
+  p->info = recvFrame.recvInfo;
+  p->data = recvFrame.recvData.commandACK;
+}
+
+static void decodeMFIOInitAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::ErrorCode *p = ackAs<ACK::ErrorCode>(ack);
+  p->info = recvFrame.recvInfo;
+  p->data = recvFrame.recvData.mfioACK;
+}
+
+static void decodeMFIOGetAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::MFIOGet *p = ackAs<ACK::MFIOGet>(ack);
+  p->ack.info = recvFrame.recvInfo;
+  p->ack.data = recvFrame.recvData.mfioGetACK.result;
+  p->value    = recvFrame.recvData.mfioGetACK.value;
+}
+
+static void decodeWaypointAddPointAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::WayPointAddPoint *p = ackAs<ACK::WayPointAddPoint>(ack);
+  p->ack.info = recvFrame.recvInfo;
+  p->ack.data = recvFrame.recvData.wpAddPointACK.ack;
+  p->index    = recvFrame.recvData.wpAddPointACK.index;
+}
+
+static void decodeWaypointInitAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::WayPointInit *p = ackAs<ACK::WayPointInit>(ack);
+  p->ack.info = recvFrame.recvInfo;
+  p->ack.data = recvFrame.recvData.wpInitACK.ack;
+  p->data     = recvFrame.recvData.wpInitACK.data;
+}
+
+static void decodeWaypointIndexAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::WayPointIndex *p = ackAs<ACK::WayPointIndex>(ack);
+  p->ack.info = recvFrame.recvInfo;
+  p->ack.data = recvFrame.recvData.wpIndexACK.ack;
+  p->data     = recvFrame.recvData.wpIndexACK.data;
+}
+
+static void decodeHotpointStartAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::HotPointStart *p = ackAs<ACK::HotPointStart>(ack);
+  p->ack.info  = recvFrame.recvInfo;
+  p->ack.data  = recvFrame.recvData.hpStartACK.ack;
+  p->maxRadius = recvFrame.recvData.hpStartACK.maxRadius;
+}
+
+static void decodeHotpointReadAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::HotPointRead *p = ackAs<ACK::HotPointRead>(ack);
+  p->ack.info = recvFrame.recvInfo;
+  p->ack.data = recvFrame.recvData.hpReadACK.ack;
+  p->data     = recvFrame.recvData.hpReadACK.data;
+}
+
+static void decodeVersionAck(const RecvContainer &recvFrame, void *ack)
+{
+  //! Interim stage: version data will be parsed before returned to user
+  static_assert(sizeof(recvFrame.recvData.versionACK) <=
+                LegacyLinker::MAX_SYNC_ACK_SIZE,
+                "SyncAck is too small for the version ACK");
+  memcpy(ack, recvFrame.recvData.versionACK,
+         sizeof(recvFrame.recvData.versionACK));
+}
+
+static void decodeHeartBeatAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::HeartBeatAck *p = ackAs<ACK::HeartBeatAck>(ack);
+  p->info = recvFrame.recvInfo;
+  p->data = recvFrame.recvData.heartbeatpack;
+}
+
+static void decodeExtendedFunctionAck(const RecvContainer &recvFrame,
+                                      void *ack)
+{
+  ACK::ExtendedFunctionRsp *p = ackAs<ACK::ExtendedFunctionRsp>(ack);
+
+  /*! The payload is kept right behind the struct, so info.buf stays valid
+   *  as long as the caller's storage does */
+  uint8_t *payload = (uint8_t *) ack + sizeof(ACK::ExtendedFunctionRsp);
+  size_t len = LegacyLinker::MAX_SYNC_ACK_SIZE - sizeof(ACK::ExtendedFunctionRsp);
+  if (len > sizeof(recvFrame.recvData.raw_ack_array))
+    len = sizeof(recvFrame.recvData.raw_ack_array);
+  memcpy(payload, recvFrame.recvData.raw_ack_array, len);
+
+  p->info     = recvFrame.recvInfo;
+  p->info.buf = payload;
+  p->updated  = true;
+}
+
+static void decodeParamAck(const RecvContainer &recvFrame, void *ack)
+{
+  ACK::ParamAck *p = ackAs<ACK::ParamAck>(ack);
+  p->info           = recvFrame.recvInfo;
+  p->data.retCode   = recvFrame.recvData.paramAckData.retCode;
+  p->data.hashValue = recvFrame.recvData.paramAckData.hashValue;
+  memcpy(p->data.paramValue, recvFrame.recvData.paramAckData.paramValue,
+         MAX_PARAMETER_VALUE_LENGTH);
+  p->updated        = true;
+}
+
+static void decodeSetHomeLocationAck(const RecvContainer &recvFrame,
+                                     void *ack)
+{
+  ACK::SetHomeLocationAck *p = ackAs<ACK::SetHomeLocationAck>(ack);
+  p->info         = recvFrame.recvInfo;
+  p->data.retCode = recvFrame.recvData.setHomeLocationACK.result;
+  p->data.result  = recvFrame.recvData.setHomeLocationACK.result;
+  p->updated      = true;
+}
+
+typedef struct AckDecoderItem {
+  const uint8_t *cmd;
+  AckDecoder decoder;
+} AckDecoderItem;
+
+//@clang-format: off
+static const AckDecoderItem ackDecoderItems[] = {
+    {OpenProtocolCMD::CMDSet::Mission::waypointAddPoint,      decodeWaypointAddPointAck},
+    {OpenProtocolCMD::CMDSet::Mission::waypointDownload,      decodeWaypointInitAck},
+    {OpenProtocolCMD::CMDSet::Mission::waypointIndexDownload, decodeWaypointIndexAck},
+    {OpenProtocolCMD::CMDSet::Mission::hotpointStart,         decodeHotpointStartAck},
+    {OpenProtocolCMD::CMDSet::Mission::hotpointDownload,      decodeHotpointReadAck},
+    {OpenProtocolCMD::CMDSet::Activation::getVersion,         decodeVersionAck},
+    {OpenProtocolCMD::CMDSet::Activation::heatBeatCmd,        decodeHeartBeatAck},
+    {OpenProtocolCMD::CMDSet::Control::extendedFunction,      decodeExtendedFunctionAck},
+    {OpenProtocolCMD::CMDSet::Control::parameterRead,         decodeParamAck},
+    {OpenProtocolCMD::CMDSet::Control::parameterWrite,        decodeParamAck},
+    {OpenProtocolCMD::CMDSet::Control::setHomeLocation,       decodeSetHomeLocationAck},
+    {OpenProtocolCMD::CMDSet::MFIO::init,                     decodeMFIOInitAck},
+    {OpenProtocolCMD::CMDSet::MFIO::get,                      decodeMFIOGetAck},
+    {OpenProtocolCMD::CMDSet::Intelligent::setAvoidObstacle,  decodeCommandAck},
+};
+//@clang-format: on
+
+/*! Open addressing hash over (cmdSet, cmdId), built once from
+ *  ackDecoderItems. Commands without an entry use the default decoder of
+ *  their command set. */
+class AckDecoderTable {
+ public:
+  static const AckDecoderTable &instance() {
+    static const AckDecoderTable table;
+    return table;
   }
 
-  if (recvFrame.recvInfo.cmd_set == OpenProtocolCMD::CMDSet::mission)
-  {
-    if (memcmp(cmd, OpenProtocolCMD::CMDSet::Mission::waypointAddPoint,
-               sizeof(cmd)) == 0)
-    {
-      waypointAddPointACK.ack.info = recvFrame.recvInfo;
-      waypointAddPointACK.ack.data = recvFrame.recvData.wpAddPointACK.ack;
-      waypointAddPointACK.index    = recvFrame.recvData.wpAddPointACK.index;
-      pACK = static_cast<void*>(&this->waypointAddPointACK);
-    }
-    else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Mission::waypointDownload,
-                    sizeof(cmd)) == 0)
-    {
-      waypointInitACK.ack.info = recvFrame.recvInfo;
-      waypointInitACK.ack.data = recvFrame.recvData.wpInitACK.ack;
-      waypointInitACK.data     = recvFrame.recvData.wpInitACK.data;
-      pACK = static_cast<void*>(&this->waypointInitACK);
-    }
-    else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Mission::waypointIndexDownload,
-                    sizeof(cmd)) == 0)
-    {
-      waypointIndexACK.ack.info = recvFrame.recvInfo;
-      waypointIndexACK.ack.data = recvFrame.recvData.wpIndexACK.ack;
-      waypointIndexACK.data     = recvFrame.recvData.wpIndexACK.data;
-      pACK = static_cast<void*>(&this->waypointIndexACK);
-    }
-    else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Mission::hotpointStart,
-                    sizeof(cmd)) == 0)
-    {
-      hotpointStartACK.ack.info  = recvFrame.recvInfo;
-      hotpointStartACK.ack.data  = recvFrame.recvData.hpStartACK.ack;
-      hotpointStartACK.maxRadius = recvFrame.recvData.hpStartACK.maxRadius;
-      pACK = static_cast<void*>(&this->hotpointStartACK);
-    }
-    else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Mission::hotpointDownload,
-                    sizeof(cmd)) == 0)
-    {
-      hotpointReadACK.ack.info = recvFrame.recvInfo;
-      hotpointReadACK.ack.data = recvFrame.recvData.hpReadACK.ack;
-      hotpointReadACK.data     = recvFrame.recvData.hpReadACK.data;
-      pACK = static_cast<void*>(&this->hotpointReadACK);
-    }
-//    else if (cmd[0] == OpenProtocolCMD::CMDSet::mission
-//        && OpenProtocolCMD::CMDSet::Mission::waypointInitV2[1] <= cmd[1]
-//        &&  cmd[1] <= OpenProtocolCMD::CMDSet::Mission::waypointGetMinMaxActionIDV2[1])
-//    {
-//
-//      wayPoint2CommonRspACK.info      = recvFrame.recvInfo;
-//      wayPoint2CommonRspACK.info.buf  = recvFrame.recvData.raw_ack_array;
-//      wayPoint2CommonRspACK.updated   = true;
-//      pACK = static_cast<void*>(&this->wayPoint2CommonRspACK);
-//
-//      DERROR("TODO : to be implemented.");
-//    }
-    else
-    {
-      ackErrorCode.info = recvFrame.recvInfo;
-      ackErrorCode.data = recvFrame.recvData.missionACK;
-      pACK = static_cast<void*>(&this->ackErrorCode);
+  AckDecoder find(uint8_t cmdSet, uint8_t cmdId) const {
+    uint16_t key = (uint16_t) ((cmdSet << 8) | cmdId);
+    for (uint32_t i = hash(key);; i = (i + 1) & (SLOT_NUM - 1)) {
+      if (!decoder[i]) return setDefault(cmdSet);
+      if (keys[i] == key) return decoder[i];
     }
   }
-  else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Activation::getVersion,
-                  sizeof(cmd)) == 0)
-  {
-    size_t arrLength = sizeof(recvFrame.recvData.versionACK);
-    for (int i = 0; i < arrLength; i++)
-    {
-      //! Interim stage: version data will be parsed before returned to user
-      this->rawVersionACK[i] = recvFrame.recvData.versionACK[i];
-      pACK = static_cast<void*>(&this->rawVersionACK);
+
+ private:
+  static const uint32_t SLOT_NUM = 64;
+
+  AckDecoderTable() {
+    static_assert(sizeof(ackDecoderItems) / sizeof(AckDecoderItem) <
+                  SLOT_NUM / 2, "AckDecoderTable is too crowded");
+    memset(keys, 0, sizeof(keys));
+    memset(decoder, 0, sizeof(decoder));
+    for (size_t n = 0; n < sizeof(ackDecoderItems) / sizeof(AckDecoderItem);
+         n++) {
+      const uint8_t *cmd = ackDecoderItems[n].cmd;
+      uint16_t key = (uint16_t) ((cmd[0] << 8) | cmd[1]);
+      uint32_t i = hash(key);
+      while (decoder[i] && keys[i] != key) i = (i + 1) & (SLOT_NUM - 1);
+      keys[i] = key;
+      decoder[i] = ackDecoderItems[n].decoder;
     }
-    droneVersionACK.ack.info = recvFrame.recvInfo;
   }
-  else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Activation::heatBeatCmd,
-                  sizeof(cmd)) == 0)
-  {
-    heartBeatAck.info = recvFrame.recvInfo;
-    heartBeatAck.data = recvFrame.recvData.heartbeatpack;
-    pACK = static_cast<void*>(&this->heartBeatAck);
-  }
-  else if (recvFrame.recvInfo.cmd_set == OpenProtocolCMD::CMDSet::subscribe)
-  {
-    ackErrorCode.info = recvFrame.recvInfo;
-    ackErrorCode.data = recvFrame.recvData.subscribeACK;
-    pACK = static_cast<void*>(&this->ackErrorCode);
+
+  static uint32_t hash(uint16_t key) {
+    return ((uint32_t) key * 40503u >> 10) & (SLOT_NUM - 1);
   }
-  else if (recvFrame.recvInfo.cmd_set == OpenProtocolCMD::CMDSet::control)
-  {
-    if (memcmp(cmd, OpenProtocolCMD::CMDSet::Control::extendedFunction,
-               sizeof(cmd)) == 0) {
-      extendedFunctionRspAck.info = recvFrame.recvInfo;
-      extendedFunctionRspAck.info.buf = recvFrame.recvData.raw_ack_array;
-      extendedFunctionRspAck.updated = true;
-      pACK = static_cast<void*>(&this->extendedFunctionRspAck);
-    }
-    else if(memcmp(cmd, OpenProtocolCMD::CMDSet::Control::parameterRead, sizeof(cmd))==0 ||
-        memcmp(cmd, OpenProtocolCMD::CMDSet::Control::parameterWrite, sizeof(cmd))==0)
-    {
-      paramAck.info            = recvFrame.recvInfo;
-      paramAck.data.retCode    = recvFrame.recvData.paramAckData.retCode;
-      paramAck.data.hashValue  = recvFrame.recvData.paramAckData.hashValue;
-      memcpy(paramAck.data.paramValue, recvFrame.recvData.paramAckData.paramValue, MAX_PARAMETER_VALUE_LENGTH);
-      paramAck.updated         = true;
-      pACK = static_cast<void*>(&this->paramAck);
-    }
-    else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Control::setHomeLocation, sizeof(cmd))==0)
-    {
-      setHomeLocationAck.info = recvFrame.recvInfo;
-      setHomeLocationAck.data.retCode =recvFrame.recvData.setHomeLocationACK.result;
-      setHomeLocationAck.data.result =recvFrame.recvData.setHomeLocationACK.result;
-      setHomeLocationAck.updated         = true;
-      pACK = static_cast<void*>(&this->setHomeLocationAck);
-    }
-    else
-    {
-      ackErrorCode.info = recvFrame.recvInfo;
-      ackErrorCode.data = recvFrame.recvData.commandACK;
-      pACK = static_cast<void*>(&this->ackErrorCode);
+
+  static AckDecoder setDefault(uint8_t cmdSet) {
+    switch (cmdSet) {
+      case OpenProtocolCMD::CMDSet::mission:
+        return decodeMissionAck;
+      case OpenProtocolCMD::CMDSet::subscribe:
+        return decodeSubscribeAck;
+      case OpenProtocolCMD::CMDSet::control:
+        return decodeCommandAck;
+      default:
+        return decodeCommonAck;
     }
   }
-  else if (memcmp(cmd, OpenProtocolCMD::CMDSet::MFIO::init, sizeof(cmd)) == 0)
-  {
-    ackErrorCode.info = recvFrame.recvInfo;
-    ackErrorCode.data = recvFrame.recvData.mfioACK;
-    pACK = static_cast<void*>(&this->ackErrorCode);
-  }
-  else if (memcmp(cmd, OpenProtocolCMD::CMDSet::MFIO::get, sizeof(cmd)) == 0)
-  {
-    mfioGetACK.ack.info = recvFrame.recvInfo;
-    mfioGetACK.ack.data = recvFrame.recvData.mfioGetACK.result;
-    mfioGetACK.value    = recvFrame.recvData.mfioGetACK.value;
-    pACK = static_cast<void*>(&this->mfioGetACK);
-  }
-  else if (memcmp(cmd, OpenProtocolCMD::CMDSet::Intelligent::setAvoidObstacle, sizeof(cmd)) == 0)
-  {
-    /*! data mean's the setting's data ref in AvoidObstacleData struct*/
-    ackErrorCode.info = recvFrame.recvInfo;
-    ackErrorCode.data = recvFrame.recvData.commandACK;
-    pACK = static_cast<void*>(&this->ackErrorCode);
-  }
-  else
-  {
-    ackErrorCode.info = recvFrame.recvInfo;
-    ackErrorCode.data = recvFrame.recvData.ack;
-    pACK = static_cast<void*>(&this->ackErrorCode);
+
+  uint16_t keys[SLOT_NUM];
+  AckDecoder decoder[SLOT_NUM];
+};
+
+void LegacyLinker::decodeAck(E_OsdkStat ret, uint8_t cmdSet, uint8_t cmdId,
+                             const RecvContainer &recvFrame, SyncAck &ack)
+{
+  memset(ack.raw, 0, sizeof(ack.raw));
+
+  if (ret != OSDK_STAT_OK) {
+    ACK::ErrorCode *p = ackAs<ACK::ErrorCode>(ack.raw);
+    p->info = recvFrame.recvInfo;
+    p->data = (ret == OSDK_STAT_ERR_TIMEOUT)
+              ? ErrorCode::CommonACK::NO_RESPONSE_ERROR
+              : ErrorCode::CommonACK::SYSTEM_ERROR;
+    return;
   }
 
-  return pACK;
+  AckDecoderTable::instance().find(cmdSet, cmdId)(recvFrame, ack.raw);
 }
 
 LegacyLinker::LegacyLinker(Vehicle *vehicle)
@@ -322,11 +447,11 @@ LegacyLinker::LegacyLinker(Vehicle *vehicle)
     memset(cmdListData[i].cmdItemList.userData, 0, sizeof(legacyAdaptingData));
   }
 
-  initX5SEnableThread();
+  initX5SEnableJob();
 }
 
 LegacyLinker::~LegacyLinker() {
-  OsdkOsal_TaskDestroy(legacyX5SEnableHandle);
+  TimerScheduler::instance().cancel(legacyX5SEnableJob);
 }
 
 void LegacyLinker::send(const uint8_t cmd[], void *pdata, size_t len) {
@@ -362,7 +487,7 @@ void legacyAdaptingAsyncCB(const T_CmdInfo *cmdInfo,
     DERROR("wait for callback error.");
   }
 
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 void LegacyLinker::sendAsync(const uint8_t cmd[], void *pdata, size_t len,
@@ -379,15 +504,16 @@ void LegacyLinker::sendAsync(const uint8_t cmd[], void *pdata, size_t len,
   cmdInfo.encType = (vehicle->getEncryption() == true) ? 1 : 0;
   cmdInfo.channelId = 0;
   legacyAdaptingData
-      *udata = (legacyAdaptingData *) malloc(sizeof(legacyAdaptingData));
-  *udata = {callback, userData, vehicle};
+      *udata = (legacyAdaptingData *) DJI_CTX_ALLOC(sizeof(legacyAdaptingData));
+  *udata = {callback, userData, vehicle, NULL};
 
   vehicle->linker->sendAsync(&cmdInfo, (uint8_t *) pdata, legacyAdaptingAsyncCB,
                              udata, timeout, retry_time);
 }
 
-void* LegacyLinker::sendSync(const uint8_t cmd[], void *pdata,
-                                      size_t len, int timeout, int retry_time) {
+E_OsdkStat LegacyLinker::sendSync(const uint8_t cmd[], void *pdata,
+                                  size_t len, SyncAck &ack, int timeout,
+                                  int retry_time) {
   T_CmdInfo cmdInfo = {0};
   T_CmdInfo ackInfo = {0};
   uint8_t ackData[1024];
@@ -411,7 +537,27 @@ void* LegacyLinker::sendSync(const uint8_t cmd[], void *pdata,
                                 timeout, retry_time);
   RecvContainer recvFrame = recvFrameAdapting(ackInfo, ackData);
 
-  return decodeAck(ret, ackInfo.cmdSet, ackInfo.cmdId, recvFrame);
+  decodeAck(ret, ackInfo.cmdSet, ackInfo.cmdId, recvFrame, ack);
+  return ret;
+}
+
+void* LegacyLinker::sendSync(const uint8_t cmd[], void *pdata,
+                                      size_t len, int timeout, int retry_time) {
+  static SYNC_ACK_THREAD_LOCAL SyncAck ack;
+
+#if defined(__linux__)
+  sendSync(cmd, pdata, len, ack, timeout, retry_time);
+#else
+  /*! Without thread local storage every caller shares ack, decode on the
+   *  stack and only copy it over under the lock */
+  static Mutex ackMutex;
+  SyncAck local;
+  sendSync(cmd, pdata, len, local, timeout, retry_time);
+  ackMutex.lock();
+  memcpy(ack.raw, local.raw, sizeof(ack.raw));
+  ackMutex.unlock();
+#endif
+  return ack.raw;
 }
 
 bool LegacyLinker::registerCMDCallback(uint8_t cmdSet, uint8_t cmdID,
@@ -424,6 +570,32 @@ bool LegacyLinker::registerCMDCallback(uint8_t cmdSet, uint8_t cmdID,
       handler->cb = callback;
       handler->udata = userData;
       handler->vehicle = vehicle;
+      handler->viewCb = NULL;
+      cmdListData[i].cmdItemList.pFunc = legacyAdaptingRegisterCB;
+      cmdListData[i].cmdItemList.userData = handler;
+      cmdListData[i].recvCmdHandle.cmdList = &cmdListData[i].cmdItemList;
+      cmdListData[i].recvCmdHandle.protoType = PROTOCOL_SDK;
+      cmdListData[i].recvCmdHandle.cmdCount = 1;
+      return vehicle->linker->registerCmdHandler(&(cmdListData[i].recvCmdHandle));
+    }
+  }
+
+  DERROR("This callback is not support in the legacy linker, please use the"
+         " new linker API.");
+  return false;
+}
+
+bool LegacyLinker::registerCMDViewCallback(uint8_t cmdSet, uint8_t cmdID,
+                                           VehicleFrameViewCallBack callback,
+                                           UserData userData) {
+  for (size_t i = 0; i < sizeof(cmdListData) / sizeof(CmdListData); i++) {
+    if ((cmdListData[i].cmdItemList.cmdSet == cmdSet)
+        && (cmdListData[i].cmdItemList.cmdId == cmdID)) {
+      legacyAdaptingData *handler = (legacyAdaptingData *)(cmdListData[i].cmdItemList.userData);
+      handler->cb = NULL;
+      handler->udata = userData;
+      handler->vehicle = vehicle;
+      handler->viewCb = callback;
       cmdListData[i].cmdItemList.pFunc = legacyAdaptingRegisterCB;
       cmdListData[i].cmdItemList.userData = handler;
       cmdListData[i].recvCmdHandle.cmdList = &cmdListData[i].cmdItemList;
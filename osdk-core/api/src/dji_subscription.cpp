@@ -29,6 +29,7 @@
 
 #include "dji_subscription.hpp"
 #include "dji_vehicle.hpp"
+#include "dji_telemetry_recorder.hpp"
 
 using namespace DJI::OSDK;
 using namespace DJI::OSDK::Telemetry;
@@ -98,21 +99,48 @@ TopicInfo Telemetry::TopicDataBase[] =
  */
 DataSubscription::DataSubscription(Vehicle* vehiclePtr)
   : vehicle(vehiclePtr)
+  , lockFreeRead(false)
+  , plannerTimeStamp(false)
+  , recorder(NULL)
+  , updateWaiters(NULL)
 {
   for (int i = 0; i < MAX_NUMBER_OF_PACKAGE; i++)
   {
     package[i].setPackageID(i);
+    plannerOwned[i] = false;
   }
+  memset(requestedFreq, 0, sizeof(requestedFreq));
+  memset(topicHistory, 0, sizeof(topicHistory));
+  memset(topicSeq, 0, sizeof(topicSeq));
 
   subscriptionDataDecodeHandler.callback = decodeCallback;
   subscriptionDataDecodeHandler.userData = this;
+  subscriptionDataViewDecodeHandler.callback = decodeViewCallback;
+  subscriptionDataViewDecodeHandler.userData = this;
   Platform::instance().mutexCreate(&m_msgLock);
+  OsdkOsal_MutexCreate(&updateLock);
+  OsdkOsal_MutexCreate(&plannerLock);
+#if defined(__linux__)
+  OsdkOsal_MutexCreate(&historyLock);
+#endif
 }
 
 DataSubscription::~DataSubscription()
 {
   subscriptionDataDecodeHandler.callback = 0;
   subscriptionDataDecodeHandler.userData = 0;
+  subscriptionDataViewDecodeHandler.callback = 0;
+  OsdkOsal_MutexDestroy(updateLock);
+  OsdkOsal_MutexDestroy(plannerLock);
+#if defined(__linux__)
+  OsdkOsal_MutexDestroy(historyLock);
+#endif
+  subscriptionDataViewDecodeHandler.userData = 0;
+
+  for (int t = 0; t < TOTAL_TOPIC_NUMBER; t++)
+  {
+    delete topicHistory[t];
+  }
 }
 
 Vehicle*
@@ -121,6 +149,25 @@ DataSubscription::getVehicle()
   return vehicle;
 }
 
+void
+DataSubscription::setLockFreeRead(bool enable)
+{
+#ifdef __linux__
+  lockFreeRead.store(enable);
+#else
+  if (enable)
+  {
+    DERROR("Lock-free read is only supported on Linux");
+  }
+#endif
+}
+
+bool
+DataSubscription::isLockFreeRead()
+{
+  return lockFreeRead;
+}
+
 /*!
  * @details:  decodeCallback is a static function and cannot access object
  * member.
@@ -149,7 +196,9 @@ DataSubscription::decodeCallback(Vehicle*      vehiclePtr,
    * when the program starts,
    */
 
-  subscriptionHandle->extractOnePackage(&rcvContainer, p);
+  subscriptionHandle->extractOnePackage(
+    rcvContainer.recvData.raw_ack_array,
+    sizeof(rcvContainer.recvData.raw_ack_array), p);
 
   VehicleCallBackHandler h = p->getUnpackHandler();
   if (NULL != h.callback)
@@ -158,6 +207,48 @@ DataSubscription::decodeCallback(Vehicle*      vehiclePtr,
   }
 }
 
+void
+DataSubscription::decodeViewCallback(Vehicle*             vehiclePtr,
+                                     const RecvFrameView& rcvFrame,
+                                     UserData             subPtr)
+{
+  DataSubscription* subscriptionHandle = (DataSubscription*)subPtr;
+
+  if (!rcvFrame.payload || rcvFrame.payloadLen < 1)
+  {
+    DERROR("Empty subscription frame received.");
+    return;
+  }
+
+#if defined(__linux__)
+  if (subscriptionHandle->recorder)
+  {
+    subscriptionHandle->recorder->recordFrame(rcvFrame);
+  }
+#endif
+
+  uint8_t pkgID = rcvFrame.payload[0];
+
+  if (pkgID >= MAX_NUMBER_OF_PACKAGE)
+  {
+    DERROR("Unexpected package id %d received.", pkgID);
+    return;
+  }
+
+  SubscriptionPackage* p = &subscriptionHandle->package[pkgID];
+
+  subscriptionHandle->extractOnePackage(rcvFrame.payload,
+                                        rcvFrame.payloadLen, p);
+
+  // The RecvContainer copy is only paid when a user callback needs it
+  VehicleCallBackHandler h = p->getUnpackHandler();
+  if (NULL != h.callback)
+  {
+    (*(h.callback))(vehiclePtr, LegacyLinker::adaptFrameView(rcvFrame),
+                    h.userData);
+  }
+}
+
 /*!
  * @details Setup members of package[packageID]
  *          Do basic gate keeping. No api->send call involved
@@ -300,7 +391,21 @@ DataSubscription::addPackageCallback(Vehicle*      vehiclePtr,
           packageHandle->getInfo().numberOfTopics);
   if (!ACK::getError(ackErrorCode))
   {
+    DataSubscription* sub = vehiclePtr ? vehiclePtr->subscribe : NULL;
+    // The decoder and lock-free readers must not see a half updated package
+    if (sub)
+    {
+      sub->lockMSG();
+    }
     packageHandle->packageAddSuccessHandler();
+    if (sub)
+    {
+      sub->freeMSG();
+    }
+    if (vehiclePtr && vehiclePtr->subscribe)
+    {
+      vehiclePtr->subscribe->recordPackageAdd(packageHandle);
+    }
   }
   else
   {
@@ -351,7 +456,10 @@ DataSubscription::startPackage(int packageID, int timeout)
 
   if (!ACK::getError(ack))
   {
+    lockMSG();
     package[packageID].packageAddSuccessHandler();
+    freeMSG();
+    recordPackageAdd(&package[packageID]);
   }
   else
   {
@@ -364,7 +472,7 @@ DataSubscription::startPackage(int packageID, int timeout)
 
 // adapted from DataSubscribe::Package::unpack
 void
-DataSubscription::extractOnePackage(RecvContainer*       pRcvContainer,
+DataSubscription::extractOnePackage(const uint8_t* data, size_t len,
                                     SubscriptionPackage* pkg)
 {
   //  uint8_t *data = ((uint8_t *)header) + sizeof(OpenHeader) + 2;
@@ -374,18 +482,34 @@ DataSubscription::extractOnePackage(RecvContainer*       pRcvContainer,
   //          *((uint32_t *)data), *((uint32_t *)data + 1));
   //  data++;
 
-  uint8_t* data = pRcvContainer->recvData.raw_ack_array;
   data++; // skip the package ID
+  len--;
+
+  size_t copyLen = pkg->getBufferSize();
+  if (copyLen > len)
+  {
+    copyLen = len;
+  }
 
   /*
-   * TODO: Handle the time stamp field if it exists
+   * With config == 1 the first 8 bytes are the FC timestamp, they are copied
+   * along and offsetList already accounts for them.
    */
 
+  bool updated = false;
+
+  // Readers in lock-free mode only rely on the package sequence counter, the
+  // mutex is still taken so that mutex based readers see consistent data.
   lockMSG();
   if (pkg->getDataBuffer())
   {
     // TODO: the length needs to come from the header, not package
-    memcpy(pkg->getDataBuffer(), data, pkg->getBufferSize());
+    pkg->beginWrite();
+    memcpy(pkg->getDataBuffer(), data, copyLen);
+    pkg->endWrite();
+    recordHistory(pkg, data, copyLen);
+    bumpUpdateSeq(pkg);
+    updated = true;
     // memcpy(pkg->getDataBuffer(), data, header->length - CoreAPI::PackageMin -
     // 3);
   }
@@ -400,6 +524,11 @@ DataSubscription::extractOnePackage(RecvContainer*       pRcvContainer,
     }
   }
   freeMSG();
+
+  if (updated)
+  {
+    notifyUpdate();
+  }
 }
 
 void
@@ -430,7 +559,20 @@ DataSubscription::removePackageCallback(Vehicle*      vehiclePtr,
   if (!ACK::getError(ackErrorCode))
   {
     DSTATUS("Remove package %d successful.", packageID);
+    DataSubscription* sub = vehiclePtr ? vehiclePtr->subscribe : NULL;
+    if (sub)
+    {
+      sub->lockMSG();
+    }
     packageHandle->packageRemoveSuccessHandler();
+    if (sub)
+    {
+      sub->freeMSG();
+    }
+    if (vehiclePtr && vehiclePtr->subscribe)
+    {
+      vehiclePtr->subscribe->recordPackageRemove(packageID);
+    }
     if(packageHandle->hasLeftOverData())
     {
       packageHandle->setLeftOverDataFlag(false);
@@ -455,7 +597,10 @@ DataSubscription::removePackage(int packageID, int timeout)
   if (!ACK::getError(ack))
   {
     DSTATUS("Remove package %d successful.", packageID);
+    lockMSG();
     package[packageID].packageRemoveSuccessHandler();
+    freeMSG();
+    recordPackageRemove(packageID);
     if(package[packageID].hasLeftOverData())
     {
       package[packageID].setLeftOverDataFlag(false);
@@ -568,12 +713,718 @@ DataSubscription::freeMSG() {
   Platform::instance().mutexUnlock(m_msgLock);
 }
 
+/*! Readers of the history rings. On Linux they have a lock of their own and
+ *  never block the decode thread; without atomics they have to exclude it,
+ *  so they take the message mutex it records under.
+ */
+void
+DataSubscription::lockHistory() {
+#if defined(__linux__)
+  OsdkOsal_MutexLock(historyLock);
+#else
+  lockMSG();
+#endif
+}
+
+void
+DataSubscription::freeHistory() {
+#if defined(__linux__)
+  OsdkOsal_MutexUnlock(historyLock);
+#else
+  freeMSG();
+#endif
+}
+
+void
+DataSubscription::setRecorder(TelemetryRecorder* recorder)
+{
+  this->recorder = recorder;
+}
+
+void
+DataSubscription::recordPackageAdd(SubscriptionPackage* pkg)
+{
+#if defined(__linux__)
+  if (recorder)
+  {
+    recorder->recordPackageAdd(pkg);
+  }
+#endif
+}
+
+void
+DataSubscription::recordPackageRemove(uint8_t packageID)
+{
+#if defined(__linux__)
+  if (recorder)
+  {
+    recorder->recordPackageRemove(packageID);
+  }
+#endif
+}
+
+bool
+DataSubscription::addPackageOffline(int packageID, int numberOfTopics,
+                                    TopicName* topicList, bool sendTimeStamp,
+                                    uint16_t freq)
+{
+  if (packageID < 0 || packageID >= MAX_NUMBER_OF_PACKAGE)
+  {
+    return false;
+  }
+
+  removePackageOffline(packageID);
+  if (!initPackageFromTopicList(packageID, numberOfTopics, topicList,
+                                sendTimeStamp, freq))
+  {
+    return false;
+  }
+
+  lockMSG();
+  package[packageID].allocateDataBuffer();
+  package[packageID].packageAddSuccessHandler();
+  freeMSG();
+  return true;
+}
+
+void
+DataSubscription::removePackageOffline(int packageID)
+{
+  if (packageID < 0 || packageID >= MAX_NUMBER_OF_PACKAGE ||
+      !package[packageID].isOccupied())
+  {
+    return;
+  }
+
+  lockMSG();
+  package[packageID].packageRemoveSuccessHandler();
+  freeMSG();
+}
+
+uint32_t
+DataSubscription::getUpdateSeq(TopicName topic)
+{
+  if (topic >= TOTAL_TOPIC_NUMBER)
+  {
+    return 0;
+  }
+  OsdkOsal_MutexLock(updateLock);
+  uint32_t seq = topicSeq[topic];
+  OsdkOsal_MutexUnlock(updateLock);
+  return seq;
+}
+
+void
+DataSubscription::bumpUpdateSeq(SubscriptionPackage* pkg)
+{
+  SubscriptionPackage::PackageInfo info   = pkg->getInfo();
+  TopicName*                       topics = pkg->getTopicList();
+  OsdkOsal_MutexLock(updateLock);
+  for (int i = 0; i < info.numberOfTopics; i++)
+  {
+    topicSeq[topics[i]]++;
+  }
+  OsdkOsal_MutexUnlock(updateLock);
+}
+
+void
+DataSubscription::notifyUpdate()
+{
+  OsdkOsal_MutexLock(updateLock);
+  UpdateWaiter** link = &updateWaiters;
+  while (*link)
+  {
+    UpdateWaiter* waiter = *link;
+    if (topicSeq[waiter->topic] != waiter->seq)
+    {
+      *link          = waiter->next;
+      waiter->linked = false;
+      OsdkOsal_SemaphorePost(waiter->sem);
+    }
+    else
+    {
+      link = &waiter->next;
+    }
+  }
+  OsdkOsal_MutexUnlock(updateLock);
+}
+
+//! Called with updateLock held
+void
+DataSubscription::unlinkWaiter(UpdateWaiter* waiter)
+{
+  for (UpdateWaiter** link = &updateWaiters; *link; link = &(*link)->next)
+  {
+    if (*link == waiter)
+    {
+      *link          = waiter->next;
+      waiter->linked = false;
+      return;
+    }
+  }
+}
+
+/*!
+ * @details Each waiter has a semaphore of its own, only posted once its topic
+ *          changed, so waiters neither take each other's wakeups nor wake up
+ *          for other topics.
+ */
+bool
+DataSubscription::waitSeqChange(TopicName topic, uint32_t& seq,
+                                uint32_t deadlineMs)
+{
+  if (topic >= TOTAL_TOPIC_NUMBER)
+  {
+    return false;
+  }
+
+  OsdkOsal_MutexLock(updateLock);
+  if (topicSeq[topic] != seq)
+  {
+    seq = topicSeq[topic];
+    OsdkOsal_MutexUnlock(updateLock);
+    return true;
+  }
+  OsdkOsal_MutexUnlock(updateLock);
+
+  UpdateWaiter waiter;
+  waiter.topic  = topic;
+  waiter.seq    = seq;
+  waiter.linked = false;
+  waiter.next   = NULL;
+  if (OsdkOsal_SemaphoreCreate(&waiter.sem, 0) != OSDK_STAT_OK)
+  {
+    DERROR("Create the update semaphore failed");
+    return false;
+  }
+
+  bool changed = false;
+  for (;;)
+  {
+    OsdkOsal_MutexLock(updateLock);
+    if (topicSeq[topic] != seq)
+    {
+      seq     = topicSeq[topic];
+      changed = true;
+    }
+
+    uint32_t now = 0;
+    OsdkOsal_GetTimeMs(&now);
+    int32_t left = (int32_t)(deadlineMs - now);
+    if (changed || left <= 0)
+    {
+      if (waiter.linked)
+      {
+        unlinkWaiter(&waiter);
+      }
+      OsdkOsal_MutexUnlock(updateLock);
+      break;
+    }
+    if (!waiter.linked)
+    {
+      waiter.next   = updateWaiters;
+      updateWaiters = &waiter;
+      waiter.linked = true;
+    }
+    OsdkOsal_MutexUnlock(updateLock);
+
+    OsdkOsal_SemaphoreTimedWait(waiter.sem, (uint32_t)left);
+  }
+
+  OsdkOsal_SemaphoreDestroy(waiter.sem);
+  return changed;
+}
+
+bool
+DataSubscription::waitForUpdate(TopicName topic, uint32_t& seq,
+                                uint32_t timeoutMs)
+{
+  uint32_t now = 0;
+  OsdkOsal_GetTimeMs(&now);
+  return waitSeqChange(topic, seq, now + timeoutMs);
+}
+
+bool
+DataSubscription::enableTopicHistory(TopicName topic, uint16_t capacity)
+{
+  if (topic >= TOTAL_TOPIC_NUMBER || capacity == 0)
+  {
+    DERROR("Invalid topic 0x%X or history capacity %d", topic, capacity);
+    return false;
+  }
+
+  TopicHistory* history =
+    new TopicHistory(TopicDataBase[topic].size, capacity);
+
+  // Readers hold historyLock, the decode thread records under the message
+  // mutex; without atomics both are the message mutex
+  lockHistory();
+#if defined(__linux__)
+  lockMSG();
+#endif
+  TopicHistory* old   = topicHistory[topic];
+  topicHistory[topic] = history;
+#if defined(__linux__)
+  freeMSG();
+#endif
+  freeHistory();
+
+  delete old;
+  return true;
+}
+
+void
+DataSubscription::disableTopicHistory(TopicName topic)
+{
+  if (topic >= TOTAL_TOPIC_NUMBER)
+  {
+    return;
+  }
+
+  lockHistory();
+#if defined(__linux__)
+  lockMSG();
+#endif
+  TopicHistory* old   = topicHistory[topic];
+  topicHistory[topic] = NULL;
+#if defined(__linux__)
+  freeMSG();
+#endif
+  freeHistory();
+
+  delete old;
+}
+
+void
+DataSubscription::recordHistory(SubscriptionPackage* pkg, const uint8_t* data,
+                                size_t len)
+{
+  SubscriptionPackage::PackageInfo info       = pkg->getInfo();
+  TopicName*                       topics     = pkg->getTopicList();
+  uint32_t*                        offsets    = pkg->getOffsetList();
+  TimeStamp                        fcTime     = { 0, 0 };
+  uint64_t                         hostTimeUs = 0;
+
+  for (int i = 0; i < info.numberOfTopics; i++)
+  {
+    TopicHistory* history = topicHistory[topics[i]];
+    if (!history || offsets[i] + history->getValueSize() > len)
+    {
+      continue;
+    }
+    if (!hostTimeUs)
+    {
+      hostTimeUs = TopicHistory::getHostTimeUs();
+      if (info.config == 1 && len >= sizeof(fcTime))
+      {
+        memcpy(&fcTime, data, sizeof(fcTime));
+      }
+    }
+    history->push(fcTime, hostTimeUs, data + offsets[i]);
+  }
+}
+
+/*
+ * Package planner
+ */
+
+// Package frequencies accepted by the FC, ascending
+static const uint16_t PLANNER_FREQ_CLASS[] = { 1, 5, 10, 50, 100, 200, 400 };
+static const int      PLANNER_FREQ_CLASS_NUM =
+  sizeof(PLANNER_FREQ_CLASS) / sizeof(PLANNER_FREQ_CLASS[0]);
+// Bytes each package frame adds on the link besides its topics: open
+// protocol header (12), CRC32 (4), cmd set/id (2) and package ID (1)
+static const uint32_t PACKAGE_FRAME_OVERHEAD = 19;
+// Size of the timestamp carried when a package has config == 1
+static const uint32_t PACKAGE_TIMESTAMP_SIZE = 8;
+
+static uint16_t
+plannerFreqClass(uint16_t freq, uint16_t maxFreq)
+{
+  uint16_t cls = PLANNER_FREQ_CLASS[0];
+  for (int i = 0; i < PLANNER_FREQ_CLASS_NUM; i++)
+  {
+    if (PLANNER_FREQ_CLASS[i] > maxFreq)
+    {
+      break;
+    }
+    cls = PLANNER_FREQ_CLASS[i];
+    if (cls >= freq)
+    {
+      break;
+    }
+  }
+  return cls;
+}
+
+static uint32_t
+plannerPackageCost(uint16_t freq, uint32_t payloadSize, uint32_t tsSize)
+{
+  return (uint32_t)freq * (PACKAGE_FRAME_OVERHEAD + tsSize + payloadSize);
+}
+
+int
+DataSubscription::planPackages(const TopicRequest* requests,
+                               int numberOfRequests, bool sendTimeStamp,
+                               PackagePlan* plans, int maxPackages)
+{
+  OsdkOsal_MutexLock(plannerLock);
+  int planNum = planInto(requests, numberOfRequests, sendTimeStamp,
+                         plannerWork, plans, maxPackages);
+  OsdkOsal_MutexUnlock(plannerLock);
+  return planNum;
+}
+
+/*!
+ * @details work needs room for TOTAL_TOPIC_NUMBER entries, there are never
+ *          more packages than topics before merging.
+ */
+int
+DataSubscription::planInto(const TopicRequest* requests, int numberOfRequests,
+                           bool sendTimeStamp, PackagePlan* work,
+                           PackagePlan* plans, int maxPackages)
+{
+  const uint32_t tsSize = sendTimeStamp ? PACKAGE_TIMESTAMP_SIZE : 0;
+  const uint32_t budget = ADD_PACKAGE_DATA_LENGTH - tsSize;
+
+  // Step 1. Snap each topic to a frequency class, one entry per topic
+  uint16_t freqOf[TOTAL_TOPIC_NUMBER] = { 0 };
+  for (int i = 0; i < numberOfRequests; i++)
+  {
+    TopicName topic = requests[i].topic;
+    if (topic >= TOTAL_TOPIC_NUMBER || requests[i].freq == 0)
+    {
+      DERROR("Invalid planner request: topic 0x%X, freq %d", topic,
+             requests[i].freq);
+      return -1;
+    }
+    uint16_t cls = plannerFreqClass(requests[i].freq,
+                                    TopicDataBase[topic].maxFreq);
+    if (cls > freqOf[topic])
+    {
+      freqOf[topic] = cls;
+    }
+  }
+
+  // Step 2. Fastest and largest first, first-fit into packages of the same
+  // frequency. There are never more packages than topics.
+  TopicName order[TOTAL_TOPIC_NUMBER];
+  int       topicNum = 0;
+  for (int t = 0; t < TOTAL_TOPIC_NUMBER; t++)
+  {
+    if (freqOf[t])
+    {
+      order[topicNum++] = (TopicName)t;
+    }
+  }
+  for (int i = 1; i < topicNum; i++)
+  {
+    TopicName key = order[i];
+    int       j   = i - 1;
+    while (j >= 0 &&
+           (freqOf[order[j]] < freqOf[key] ||
+            (freqOf[order[j]] == freqOf[key] &&
+             TopicDataBase[order[j]].size < TopicDataBase[key].size)))
+    {
+      order[j + 1] = order[j];
+      j--;
+    }
+    order[j + 1] = key;
+  }
+
+  int workNum = 0;
+  for (int i = 0; i < topicNum; i++)
+  {
+    TopicName topic = order[i];
+    uint32_t  size  = TopicDataBase[topic].size;
+    int       p     = 0;
+    for (; p < workNum; p++)
+    {
+      if (work[p].freq == freqOf[topic] && work[p].payloadSize + size <= budget)
+      {
+        break;
+      }
+    }
+    if (p == workNum)
+    {
+      work[p].freq           = freqOf[topic];
+      work[p].numberOfTopics = 0;
+      work[p].payloadSize    = 0;
+      workNum++;
+    }
+    work[p].topicList[work[p].numberOfTopics++] = topic;
+    work[p].payloadSize += size;
+  }
+
+  // Step 3. Merge a package into a faster (or equally fast) one while that
+  // saves bandwidth or while there are more packages than allowed. The
+  // slower package's topics are then sent at the faster rate.
+  while (workNum > 0)
+  {
+    int     bestFrom  = -1;
+    int     bestInto  = -1;
+    int64_t bestDelta = 0;
+    for (int a = 0; a < workNum; a++)
+    {
+      for (int b = 0; b < workNum; b++)
+      {
+        if (a == b || work[a].freq > work[b].freq ||
+            work[a].payloadSize + work[b].payloadSize > budget)
+        {
+          continue;
+        }
+        bool canSpeedUp = true;
+        for (int k = 0; k < work[a].numberOfTopics; k++)
+        {
+          if (TopicDataBase[work[a].topicList[k]].maxFreq < work[b].freq)
+          {
+            canSpeedUp = false;
+            break;
+          }
+        }
+        if (!canSpeedUp)
+        {
+          continue;
+        }
+        int64_t delta =
+          (int64_t)plannerPackageCost(
+            work[b].freq, work[a].payloadSize + work[b].payloadSize, tsSize) -
+          plannerPackageCost(work[a].freq, work[a].payloadSize, tsSize) -
+          plannerPackageCost(work[b].freq, work[b].payloadSize, tsSize);
+        if (bestFrom < 0 || delta < bestDelta)
+        {
+          bestFrom  = a;
+          bestInto  = b;
+          bestDelta = delta;
+        }
+      }
+    }
+
+    if (bestFrom < 0 || (workNum <= maxPackages && bestDelta >= 0))
+    {
+      break;
+    }
+
+    PackagePlan& from = work[bestFrom];
+    PackagePlan& into = work[bestInto];
+    for (int k = 0; k < from.numberOfTopics; k++)
+    {
+      into.topicList[into.numberOfTopics++] = from.topicList[k];
+    }
+    into.payloadSize += from.payloadSize;
+    work[bestFrom] = work[--workNum];
+  }
+
+  if (workNum > maxPackages)
+  {
+    DERROR("Requested topics need %d packages, only %d available", workNum,
+           maxPackages);
+    return -1;
+  }
+
+  for (int p = 0; p < workNum; p++)
+  {
+    plans[p] = work[p];
+  }
+  return workNum;
+}
+
+uint32_t
+DataSubscription::planBandwidth(const PackagePlan* plans, int numberOfPlans,
+                                bool sendTimeStamp)
+{
+  uint32_t tsSize    = sendTimeStamp ? PACKAGE_TIMESTAMP_SIZE : 0;
+  uint32_t bandwidth = 0;
+  for (int p = 0; p < numberOfPlans; p++)
+  {
+    bandwidth += plannerPackageCost(plans[p].freq, plans[p].payloadSize,
+                                    tsSize);
+  }
+  return bandwidth;
+}
+
+void
+DataSubscription::setPlannerTimeStamp(bool sendTimeStamp)
+{
+  plannerTimeStamp = sendTimeStamp;
+}
+
+bool
+DataSubscription::requestTopic(TopicName topic, uint16_t freq, int timeout)
+{
+  if (topic >= TOTAL_TOPIC_NUMBER || freq == 0)
+  {
+    DERROR("Invalid topic 0x%X or frequency %d", topic, freq);
+    return false;
+  }
+
+  OsdkOsal_MutexLock(plannerLock);
+  uint16_t oldFreq     = requestedFreq[topic];
+  requestedFreq[topic] = freq;
+  bool result          = replan(timeout);
+  if (!result)
+  {
+    requestedFreq[topic] = oldFreq;
+  }
+  OsdkOsal_MutexUnlock(plannerLock);
+  return result;
+}
+
+bool
+DataSubscription::releaseTopic(TopicName topic, int timeout)
+{
+  if (topic >= TOTAL_TOPIC_NUMBER)
+  {
+    return true;
+  }
+
+  OsdkOsal_MutexLock(plannerLock);
+  bool result = true;
+  if (requestedFreq[topic] != 0)
+  {
+    requestedFreq[topic] = 0;
+    result               = replan(timeout);
+  }
+  OsdkOsal_MutexUnlock(plannerLock);
+  return result;
+}
+
+bool
+DataSubscription::isSamePackage(int packageID, const PackagePlan& plan)
+{
+  SubscriptionPackage::PackageInfo info = package[packageID].getInfo();
+  if (info.freq != plan.freq || info.numberOfTopics != plan.numberOfTopics ||
+      info.config != (plannerTimeStamp ? 1 : 0))
+  {
+    return false;
+  }
+
+  TopicName* topics = package[packageID].getTopicList();
+  for (int i = 0; i < plan.numberOfTopics; i++)
+  {
+    bool found = false;
+    for (int j = 0; j < info.numberOfTopics && !found; j++)
+    {
+      found = (topics[j] == plan.topicList[i]);
+    }
+    if (!found)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * @details Packages that did not change are left streaming. The stale ones
+ *          are removed before the new ones are added, since removing a
+ *          package clears its topics in TopicDataBase.
+ *          If the FC rejects a call half way, the packages already applied
+ *          stay in place and the next re-plan picks up from there.
+ */
+bool
+DataSubscription::replan(int timeout)
+{
+  TopicRequest requests[TOTAL_TOPIC_NUMBER];
+  int          requestNum = 0;
+  for (int t = 0; t < TOTAL_TOPIC_NUMBER; t++)
+  {
+    if (requestedFreq[t])
+    {
+      requests[requestNum].topic = (TopicName)t;
+      requests[requestNum].freq  = requestedFreq[t];
+      requestNum++;
+    }
+  }
+
+  int available = 0;
+  for (int id = 0; id < MAX_NUMBER_OF_PACKAGE; id++)
+  {
+    if (plannerOwned[id] || !package[id].isOccupied())
+    {
+      available++;
+    }
+  }
+
+  PackagePlan* plans   = plannerPlans;
+  int          planNum = planInto(requests, requestNum, plannerTimeStamp,
+                                  plannerWork, plans, available);
+  if (planNum < 0)
+  {
+    return false;
+  }
+
+  bool planKept[MAX_NUMBER_OF_PACKAGE]    = { false };
+  bool packageKept[MAX_NUMBER_OF_PACKAGE] = { false };
+  for (int p = 0; p < planNum; p++)
+  {
+    for (int id = 0; id < MAX_NUMBER_OF_PACKAGE; id++)
+    {
+      if (plannerOwned[id] && !packageKept[id] && isSamePackage(id, plans[p]))
+      {
+        planKept[p]     = true;
+        packageKept[id] = true;
+        break;
+      }
+    }
+  }
+
+  for (int id = 0; id < MAX_NUMBER_OF_PACKAGE; id++)
+  {
+    if (plannerOwned[id] && !packageKept[id])
+    {
+      if (ACK::getError(removePackage(id, timeout)))
+      {
+        return false;
+      }
+      plannerOwned[id] = false;
+    }
+  }
+
+  for (int p = 0; p < planNum; p++)
+  {
+    if (planKept[p])
+    {
+      continue;
+    }
+
+    int id = 0;
+    while (id < MAX_NUMBER_OF_PACKAGE &&
+           (plannerOwned[id] || package[id].isOccupied()))
+    {
+      id++;
+    }
+    if (id == MAX_NUMBER_OF_PACKAGE)
+    {
+      DERROR("No free package left for the planned layout");
+      return false;
+    }
+
+    if (!initPackageFromTopicList(id, plans[p].numberOfTopics,
+                                  plans[p].topicList, plannerTimeStamp,
+                                  plans[p].freq) ||
+        ACK::getError(startPackage(id, timeout)))
+    {
+      return false;
+    }
+    plannerOwned[id] = true;
+  }
+
+  DSTATUS("Planned %d topics into %d packages, %u bytes/s", requestNum,
+          planNum, planBandwidth(plans, planNum, plannerTimeStamp));
+  return true;
+}
+
 //////////////////////
 SubscriptionPackage::SubscriptionPackage()
   : occupied(false)
   , leftOverDataFlag(false)
   , incomingDataBuffer(NULL)
+#ifdef __linux__
+  , dataBufferStore(NULL)
+#endif
   , packageDataSize(0)
+  , writeSeq(0)
 {
   userUnpackHandler.callback = NULL;
   userUnpackHandler.userData = NULL;
@@ -582,6 +1433,9 @@ SubscriptionPackage::SubscriptionPackage()
 SubscriptionPackage::~SubscriptionPackage()
 {
   cleanUpPackage();
+#ifdef __linux__
+  delete[] dataBufferStore;
+#endif
 }
 
 void
@@ -673,6 +1527,14 @@ SubscriptionPackage::setTopicList(TopicName* topics, int numberOfTopics,
 void
 SubscriptionPackage::allocateDataBuffer()
 {
+#ifdef __linux__
+  // setTopicList() keeps every package within ADD_PACKAGE_DATA_LENGTH
+  if (!dataBufferStore)
+  {
+    dataBufferStore = new uint8_t[ADD_PACKAGE_DATA_LENGTH];
+  }
+  incomingDataBuffer = dataBufferStore;
+#else
   if (incomingDataBuffer)
   {
     delete[] incomingDataBuffer;
@@ -680,6 +1542,7 @@ SubscriptionPackage::allocateDataBuffer()
   }
 
   incomingDataBuffer = new uint8_t[packageDataSize];
+#endif
 }
 
 void
@@ -702,11 +1565,16 @@ SubscriptionPackage::cleanUpPackage()
 void
 SubscriptionPackage::clearDataBuffer()
 {
+#ifdef __linux__
+  // Lock-free readers may still copy from it, dataBufferStore stays
+  incomingDataBuffer = NULL;
+#else
   if (incomingDataBuffer)
   {
     delete[] incomingDataBuffer;
     incomingDataBuffer = NULL;
   }
+#endif
 }
 
 int
@@ -772,11 +1640,56 @@ SubscriptionPackage::getUnpackHandler()
   return userUnpackHandler;
 }
 
+#ifdef __linux__
+void
+SubscriptionPackage::beginWrite()
+{
+  writeSeq.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void
+SubscriptionPackage::endWrite()
+{
+  writeSeq.fetch_add(1, std::memory_order_release);
+}
+
+uint32_t
+SubscriptionPackage::readBegin() const
+{
+  uint32_t seq;
+  while ((seq = writeSeq.load(std::memory_order_acquire)) & 1)
+  {
+    // writer in progress, spin until the copy is done
+  }
+  return seq;
+}
+
+bool
+SubscriptionPackage::readRetry(uint32_t seq) const
+{
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return writeSeq.load(std::memory_order_relaxed) != seq;
+}
+#else
+// No lock-free readers, the message mutex already covers the copy
+void
+SubscriptionPackage::beginWrite()
+{
+}
+
+void
+SubscriptionPackage::endWrite()
+{
+}
+#endif
+
 void
 SubscriptionPackage::packageAddSuccessHandler()
 {
   // In the TopicDataBase, we set the freq, protocoland data pointer for each
-  // subscribed topic
+  // subscribed topic. Lock-free readers of this package retry around it.
+  beginWrite();
   for (size_t i = 0; i < info.numberOfTopics; ++i)
   {
     TopicDataBase[topicList[i]].pkgID = info.packageID;
@@ -785,6 +1698,7 @@ SubscriptionPackage::packageAddSuccessHandler()
     // The offset already takes time stamp into consideration
     TopicDataBase[topicList[i]].latest = incomingDataBuffer + offsetList[i];
   }
+  endWrite();
 
   setOccupied(true);
 }
@@ -793,7 +1707,9 @@ void
 SubscriptionPackage::packageRemoveSuccessHandler()
 {
   // Clean up
-  // Step 1. Clear fields in TopicDataBase
+  // Step 1. Clear fields in TopicDataBase. Lock-free readers of this
+  // package retry around it.
+  beginWrite();
   for (size_t i = 0; i < info.numberOfTopics; ++i)
   {
     TopicDataBase[topicList[i]].freq   = 0;
@@ -803,6 +1719,7 @@ SubscriptionPackage::packageRemoveSuccessHandler()
 
   // Step 2. Clean up package content, except packageID
   cleanUpPackage();
+  endWrite();
 
   setOccupied(false);
 }
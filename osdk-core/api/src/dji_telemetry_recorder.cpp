@@ -0,0 +1,562 @@
+/** @file dji_telemetry_recorder.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief
+ *  Binary recorder and offline replay of subscription/broadcast telemetry
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "dji_telemetry_recorder.hpp"
+
+#if defined(__linux__)
+
+#include "dji_legacy_linker.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace DJI::OSDK;
+using namespace DJI::OSDK::Telemetry;
+using namespace DJI::OSDK::TelemetryLog;
+
+static const char TELEMETRY_LOG_MAGIC[8] = { 'D', 'J', 'I', 'T', 'L', 'M', 0, 1 };
+
+static uint64_t
+monotonicUs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t
+recordSpan(uint32_t payloadLen)
+{
+  return (sizeof(RecordHeader) + payloadLen + 7) & ~7u;
+}
+
+/*
+ * TelemetryRecorder
+ */
+
+TelemetryRecorder::TelemetryRecorder()
+  : fd(-1)
+  , chunkSize(0)
+  , pageSize((uint32_t)sysconf(_SC_PAGESIZE))
+  , mapBase(NULL)
+  , mapLen(0)
+  , chunk(NULL)
+  , chunkIndex(0)
+{
+  memset(&stats, 0, sizeof(stats));
+  Platform::instance().mutexCreate(&lock);
+}
+
+TelemetryRecorder::~TelemetryRecorder()
+{
+  close();
+  Platform::instance().mutexDestroy(lock);
+}
+
+bool
+TelemetryRecorder::open(const char* path, uint32_t chunkSize)
+{
+  close();
+
+  if (chunkSize < pageSize)
+  {
+    chunkSize = pageSize;
+  }
+  chunkSize = (chunkSize + pageSize - 1) / pageSize * pageSize;
+
+  int newFd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (newFd < 0)
+  {
+    DERROR("Failed to create telemetry recording %s, errno %d", path, errno);
+    return false;
+  }
+
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TELEMETRY_LOG_MAGIC, sizeof(header.magic));
+  header.version   = VERSION;
+  header.chunkSize = chunkSize;
+  if (::write(newFd, &header, sizeof(header)) != sizeof(header))
+  {
+    DERROR("Failed to write telemetry recording header, errno %d", errno);
+    ::close(newFd);
+    return false;
+  }
+
+  Platform::instance().mutexLock(lock);
+  fd              = newFd;
+  this->chunkSize = chunkSize;
+  memset(&stats, 0, sizeof(stats));
+  bool ret = mapChunk(0);
+  Platform::instance().mutexUnlock(lock);
+
+  if (!ret)
+  {
+    close();
+  }
+  return ret;
+}
+
+void
+TelemetryRecorder::close()
+{
+  Platform::instance().mutexLock(lock);
+  if (chunk)
+  {
+    msync(mapBase, mapLen, MS_SYNC);
+  }
+  unmapChunk();
+  if (fd >= 0)
+  {
+    ::close(fd);
+    fd = -1;
+  }
+  Platform::instance().mutexUnlock(lock);
+}
+
+bool
+TelemetryRecorder::isOpen()
+{
+  return fd >= 0;
+}
+
+/*! Chunks live at FILE_HEADER_SIZE + index * chunkSize, which is not page
+ *  aligned, so the mapping starts at the page holding the chunk header.
+ */
+bool
+TelemetryRecorder::mapChunk(uint32_t index)
+{
+  off_t chunkOffset = FILE_HEADER_SIZE + (off_t)index * chunkSize;
+  if (ftruncate(fd, chunkOffset + chunkSize) != 0)
+  {
+    DERROR("Failed to grow telemetry recording, errno %d", errno);
+    return false;
+  }
+
+  off_t  mapOffset = chunkOffset / pageSize * pageSize;
+  size_t len       = chunkSize + (chunkOffset - mapOffset);
+  void*  base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, mapOffset);
+  if (base == MAP_FAILED)
+  {
+    DERROR("Failed to map telemetry recording chunk %u, errno %d", index,
+           errno);
+    return false;
+  }
+
+  mapBase        = (uint8_t*)base;
+  mapLen         = len;
+  chunk          = (ChunkHeader*)(mapBase + (chunkOffset - mapOffset));
+  chunk->index   = index;
+  chunk->used    = 0;
+  chunk->records = 0;
+  chunk->magic   = CHUNK_MAGIC;
+  chunkIndex     = index;
+  stats.chunks++;
+  return true;
+}
+
+void
+TelemetryRecorder::unmapChunk()
+{
+  if (mapBase)
+  {
+    munmap(mapBase, mapLen);
+  }
+  mapBase = NULL;
+  mapLen  = 0;
+  chunk   = NULL;
+}
+
+bool
+TelemetryRecorder::append(uint8_t type, uint8_t cmdSet, uint8_t cmdId,
+                          const uint8_t* part1, uint16_t len1,
+                          const uint8_t* part2, uint16_t len2)
+{
+  uint32_t len  = (uint32_t)len1 + len2;
+  uint32_t span = recordSpan(len);
+
+  Platform::instance().mutexLock(lock);
+  if (span > chunkSize - sizeof(ChunkHeader))
+  {
+    stats.dropped++;
+    Platform::instance().mutexUnlock(lock);
+    return false;
+  }
+  if (!chunk)
+  {
+    Platform::instance().mutexUnlock(lock);
+    return false;
+  }
+
+  if (sizeof(ChunkHeader) + chunk->used + span > chunkSize)
+  {
+    // Let the kernel start writing the full chunk back, then move on
+    msync(mapBase, mapLen, MS_ASYNC);
+    uint32_t next = chunkIndex + 1;
+    unmapChunk();
+    if (!mapChunk(next))
+    {
+      stats.dropped++;
+      Platform::instance().mutexUnlock(lock);
+      return false;
+    }
+  }
+
+  uint8_t*      dst = (uint8_t*)chunk + sizeof(ChunkHeader) + chunk->used;
+  RecordHeader* rec = (RecordHeader*)dst;
+  rec->hostTimeUs   = monotonicUs();
+  rec->type         = type;
+  rec->cmdSet       = cmdSet;
+  rec->cmdId        = cmdId;
+  rec->reserved     = 0;
+  rec->len          = (uint16_t)len;
+  rec->reserved2    = 0;
+  if (len1)
+  {
+    memcpy(dst + sizeof(RecordHeader), part1, len1);
+  }
+  if (len2)
+  {
+    memcpy(dst + sizeof(RecordHeader) + len1, part2, len2);
+  }
+
+  // Publish the record only once it is complete
+  std::atomic_thread_fence(std::memory_order_release);
+  chunk->records++;
+  chunk->used += span;
+
+  stats.records++;
+  stats.bytes += span;
+  Platform::instance().mutexUnlock(lock);
+  return true;
+}
+
+void
+TelemetryRecorder::recordFrame(const RecvFrameView& frame)
+{
+  append(RECORD_FRAME, frame.recvInfo.cmd_set, frame.recvInfo.cmd_id,
+         frame.payload, frame.payload ? frame.payloadLen : 0, NULL, 0);
+}
+
+void
+TelemetryRecorder::recordPackageAdd(SubscriptionPackage* pkg)
+{
+  SubscriptionPackage::PackageInfo info = pkg->getInfo();
+  PackageRecord                    rec;
+  rec.packageID      = info.packageID;
+  rec.freq           = info.freq;
+  rec.config         = info.config;
+  rec.numberOfTopics = info.numberOfTopics;
+
+  append(RECORD_PACKAGE_ADD, 0, 0, (const uint8_t*)&rec, sizeof(rec),
+         (const uint8_t*)pkg->getUidList(),
+         info.numberOfTopics * sizeof(uint32_t));
+}
+
+void
+TelemetryRecorder::recordPackageRemove(uint8_t packageID)
+{
+  append(RECORD_PACKAGE_REMOVE, 0, 0, &packageID, sizeof(packageID), NULL,
+         0);
+}
+
+TelemetryRecorder::RecorderStats
+TelemetryRecorder::getStats()
+{
+  Platform::instance().mutexLock(lock);
+  RecorderStats ret = stats;
+  Platform::instance().mutexUnlock(lock);
+  return ret;
+}
+
+/*
+ * TelemetryReplayer
+ */
+
+TelemetryReplayer::TelemetryReplayer(DataSubscription* subscription,
+                                     DataBroadcast*    broadcast)
+  : subscription(subscription)
+  , broadcast(broadcast)
+  , fd(-1)
+  , fileBase(NULL)
+  , fileSize(0)
+  , chunkSize(0)
+  , stopFlag(false)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+TelemetryReplayer::~TelemetryReplayer()
+{
+  close();
+}
+
+bool
+TelemetryReplayer::open(const char* path)
+{
+  close();
+
+  fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    DERROR("Failed to open telemetry recording %s, errno %d", path, errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < FILE_HEADER_SIZE)
+  {
+    DERROR("Telemetry recording %s is too short", path);
+    close();
+    return false;
+  }
+
+  void* base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (base == MAP_FAILED)
+  {
+    DERROR("Failed to map telemetry recording, errno %d", errno);
+    close();
+    return false;
+  }
+  fileBase = (const uint8_t*)base;
+  fileSize = st.st_size;
+  madvise(base, fileSize, MADV_SEQUENTIAL);
+
+  const FileHeader* header = (const FileHeader*)fileBase;
+  if (memcmp(header->magic, TELEMETRY_LOG_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != VERSION || header->chunkSize <= sizeof(ChunkHeader))
+  {
+    DERROR("%s is not a telemetry recording", path);
+    close();
+    return false;
+  }
+  chunkSize = header->chunkSize;
+  return true;
+}
+
+void
+TelemetryReplayer::close()
+{
+  if (fileBase)
+  {
+    munmap((void*)fileBase, fileSize);
+    fileBase = NULL;
+    fileSize = 0;
+  }
+  if (fd >= 0)
+  {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+void
+TelemetryReplayer::stop()
+{
+  stopFlag.store(true);
+}
+
+TelemetryReplayer::ReplayStats
+TelemetryReplayer::getStats()
+{
+  return stats;
+}
+
+/*! Maps the recorded UIDs back to topics, so a recording stays valid if the
+ *  TopicName enum is reordered.
+ */
+static bool
+topicFromUid(uint32_t uid, TopicName& topic)
+{
+  for (int t = 0; t < TOTAL_TOPIC_NUMBER; t++)
+  {
+    if (TopicDataBase[t].uid == uid)
+    {
+      topic = (TopicName)t;
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+TelemetryReplayer::dispatch(const RecordHeader* rec, const uint8_t* data)
+{
+  if (rec->type == RECORD_FRAME)
+  {
+    RecvFrameView view = {};
+    view.recvInfo.cmd_set = rec->cmdSet;
+    view.recvInfo.cmd_id  = rec->cmdId;
+    view.recvInfo.len     = OpenProtocol::PackageMin + rec->len;
+    view.recvInfo.buf     = (uint8_t*)data;
+    view.payload          = data;
+    view.payloadLen       = rec->len;
+
+    if (subscription &&
+        rec->cmdSet == OpenProtocolCMD::CMDSet::Broadcast::subscribe[0] &&
+        rec->cmdId == OpenProtocolCMD::CMDSet::Broadcast::subscribe[1])
+    {
+      DataSubscription::decodeViewCallback(subscription->getVehicle(), view,
+                                           subscription);
+      stats.frames++;
+    }
+    else if (broadcast &&
+             rec->cmdSet == OpenProtocolCMD::CMDSet::Broadcast::broadcast[0] &&
+             rec->cmdId == OpenProtocolCMD::CMDSet::Broadcast::broadcast[1])
+    {
+      DataBroadcast::unpackViewCallback(broadcast->getVehicle(), view,
+                                        broadcast);
+      stats.frames++;
+    }
+    else
+    {
+      stats.skipped++;
+    }
+  }
+  else if (rec->type == RECORD_PACKAGE_ADD && subscription &&
+           rec->len >= sizeof(PackageRecord))
+  {
+    PackageRecord pkg;
+    memcpy(&pkg, data, sizeof(pkg));
+
+    TopicName topics[TOTAL_TOPIC_NUMBER];
+    int       topicNum = 0;
+    for (int i = 0; i < pkg.numberOfTopics && i < TOTAL_TOPIC_NUMBER; i++)
+    {
+      uint32_t uid;
+      if (sizeof(pkg) + (i + 1) * sizeof(uid) > rec->len)
+      {
+        DERROR("Recorded package %d is cut short", pkg.packageID);
+        stats.skipped++;
+        return;
+      }
+      memcpy(&uid, data + sizeof(pkg) + i * sizeof(uid), sizeof(uid));
+      if (!topicFromUid(uid, topics[topicNum]))
+      {
+        DERROR("Unknown topic UID 0x%X in recorded package %d", uid,
+               pkg.packageID);
+        stats.skipped++;
+        return;
+      }
+      topicNum++;
+    }
+    subscription->addPackageOffline(pkg.packageID, topicNum, topics,
+                                    pkg.config == 1, pkg.freq);
+    stats.packageEvents++;
+  }
+  else if (rec->type == RECORD_PACKAGE_REMOVE && subscription && rec->len >= 1)
+  {
+    subscription->removePackageOffline(data[0]);
+    stats.packageEvents++;
+  }
+  else
+  {
+    stats.skipped++;
+  }
+}
+
+bool
+TelemetryReplayer::replay(float32_t speed)
+{
+  if (!fileBase)
+  {
+    return false;
+  }
+
+  memset(&stats, 0, sizeof(stats));
+  stopFlag.store(false);
+
+  uint64_t firstUs = 0;
+  uint64_t lastUs  = 0;
+  uint64_t startUs = monotonicUs();
+  bool     first   = true;
+
+  for (size_t off = FILE_HEADER_SIZE;
+       off + sizeof(ChunkHeader) <= fileSize && !stopFlag.load();
+       off += chunkSize)
+  {
+    const ChunkHeader* chunk = (const ChunkHeader*)(fileBase + off);
+    if (chunk->magic != CHUNK_MAGIC)
+    {
+      // Never written, the recorder stopped while growing the file
+      break;
+    }
+
+    size_t used = chunk->used;
+    if (used > chunkSize - sizeof(ChunkHeader) ||
+        off + sizeof(ChunkHeader) + used > fileSize)
+    {
+      DERROR("Telemetry recording chunk %u is corrupted", chunk->index);
+      return false;
+    }
+
+    const uint8_t* p   = (const uint8_t*)chunk + sizeof(ChunkHeader);
+    const uint8_t* end = p + used;
+    while (p + sizeof(RecordHeader) <= end && !stopFlag.load())
+    {
+      const RecordHeader* rec = (const RecordHeader*)p;
+      if (p + recordSpan(rec->len) > end)
+      {
+        DERROR("Telemetry recording chunk %u is corrupted", chunk->index);
+        return false;
+      }
+
+      if (first)
+      {
+        firstUs = rec->hostTimeUs;
+        first   = false;
+      }
+      lastUs = rec->hostTimeUs;
+
+      if (speed > 0)
+      {
+        uint64_t dueUs =
+          startUs + (uint64_t)((rec->hostTimeUs - firstUs) / speed);
+        uint64_t nowUs = monotonicUs();
+        if (dueUs > nowUs)
+        {
+          usleep(dueUs - nowUs);
+        }
+      }
+
+      dispatch(rec, p + sizeof(RecordHeader));
+      p += recordSpan(rec->len);
+    }
+  }
+
+  stats.recordedUs = lastUs - firstUs;
+  stats.elapsedUs  = monotonicUs() - startUs;
+  return true;
+}
+
+#endif // __linux__
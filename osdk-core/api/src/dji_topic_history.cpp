@@ -0,0 +1,175 @@
+/** @file dji_topic_history.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief
+ *  Per-topic timestamped history of subscription telemetry
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "dji_topic_history.hpp"
+#include "dji_platform.hpp"
+#include <string.h>
+#include <new>
+#ifdef __linux__
+#include <time.h>
+#endif
+
+using namespace DJI::OSDK;
+using namespace DJI::OSDK::Telemetry;
+
+TopicHistory::TopicHistory(size_t valueSize, uint16_t capacity)
+  : valueSize(valueSize)
+  , capacity(capacity ? capacity : 1)
+  , count(0)
+{
+  stride = (sizeof(SlotHeader) + valueSize + CACHE_LINE_SIZE - 1) &
+           ~(CACHE_LINE_SIZE - 1);
+  rawBuffer = new uint8_t[stride * this->capacity + CACHE_LINE_SIZE];
+  slots     = (uint8_t*)(((uintptr_t)rawBuffer + CACHE_LINE_SIZE - 1) &
+                     ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+
+  for (uint16_t i = 0; i < this->capacity; i++)
+  {
+    new (slotAt(i)) SlotHeader();
+    slotAt(i)->seq = 0;
+  }
+}
+
+TopicHistory::~TopicHistory()
+{
+  delete[] rawBuffer;
+}
+
+TopicHistory::SlotHeader*
+TopicHistory::slotAt(uint32_t index) const
+{
+  return (SlotHeader*)(slots + stride * index);
+}
+
+void
+TopicHistory::push(const TimeStamp& fcTime, uint64_t hostTimeUs,
+                   const uint8_t* value)
+{
+#if defined(__linux__)
+  uint32_t    n    = count.load(std::memory_order_relaxed);
+  SlotHeader* slot = slotAt(n % capacity);
+
+  slot->seq.store(2 * n + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot->hostTimeUs = hostTimeUs;
+  slot->fcTime     = fcTime;
+  memcpy((uint8_t*)slot + sizeof(SlotHeader), value, valueSize);
+  slot->seq.store(2 * (n + 1), std::memory_order_release);
+
+  count.store(n + 1, std::memory_order_release);
+#else
+  uint32_t    n    = count;
+  SlotHeader* slot = slotAt(n % capacity);
+
+  slot->hostTimeUs = hostTimeUs;
+  slot->fcTime     = fcTime;
+  memcpy((uint8_t*)slot + sizeof(SlotHeader), value, valueSize);
+  slot->seq = 2 * (n + 1);
+  count     = n + 1;
+#endif
+}
+
+bool
+TopicHistory::read(uint32_t age, TimeStamp& fcTime, uint64_t& hostTimeUs,
+                   void* value) const
+{
+#if defined(__linux__)
+  uint32_t n = count.load(std::memory_order_acquire);
+#else
+  uint32_t n = count;
+#endif
+  if (age >= n || age >= capacity)
+  {
+    return false;
+  }
+
+  uint32_t          index = n - 1 - age;
+  const SlotHeader* slot  = slotAt(index % capacity);
+
+#if defined(__linux__)
+  if (slot->seq.load(std::memory_order_acquire) != 2 * (index + 1))
+  {
+    return false;
+  }
+  hostTimeUs = slot->hostTimeUs;
+  fcTime     = slot->fcTime;
+  memcpy(value, (const uint8_t*)slot + sizeof(SlotHeader), valueSize);
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return slot->seq.load(std::memory_order_relaxed) == 2 * (index + 1);
+#else
+  // The caller holds the lock push() runs under
+  if (slot->seq != 2 * (index + 1))
+  {
+    return false;
+  }
+  hostTimeUs = slot->hostTimeUs;
+  fcTime     = slot->fcTime;
+  memcpy(value, (const uint8_t*)slot + sizeof(SlotHeader), valueSize);
+  return true;
+#endif
+}
+
+uint16_t
+TopicHistory::getCapacity() const
+{
+  return capacity;
+}
+
+size_t
+TopicHistory::getValueSize() const
+{
+  return valueSize;
+}
+
+/*! The OSAL only offers a ms clock outside of OS_DEBUG builds, which is too
+ *  coarse for 400 Hz topics, so Linux reads the monotonic clock directly.
+ */
+uint64_t
+TopicHistory::getHostTimeUs()
+{
+#ifdef __linux__
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+  uint32_t ms = 0;
+  Platform::instance().getTimeMs(&ms);
+  return (uint64_t)ms * 1000;
+#endif
+}
+
+/*! Only the ms part is used, the FC does not document time_ns as a
+ *  sub-millisecond field.
+ */
+uint64_t
+TopicHistory::getFcTimeUs(const TimeStamp& fcTime)
+{
+  return (uint64_t)fcTime.time_ms * 1000;
+}
@@ -32,6 +32,7 @@
 #include "dji_linker.hpp"
 #include "osdk_firewall.hpp"
 #include "dji_internal_command.hpp"
+#include "dji_timer_scheduler.hpp"
 #include <new>
 
 using namespace DJI;
@@ -97,147 +98,208 @@ Vehicle::Vehicle(Linker* linker)
   , advancedSensing(NULL)
   , advSensingErrorPrintOnce(false)
 #endif
+  , startupMode(STARTUP_SEQUENTIAL)
+  , lazyInitMutex(NULL)
+  , subscriberDrainHandle(NULL)
+  , subscriberDrainSem(NULL)
+  , buriedDataHandle(NULL)
+  , buriedDataStopSem(NULL)
+  , buriedDataDoneSem(NULL)
 {
   ackErrorCode.data = OpenProtocolCMD::ErrorCode::CommonACK::NO_RESPONSE_ERROR;
-  sendHeartbeatToFCHandle = NULL;
-}
-
-bool
-Vehicle::init()
-{
-  if (!initOSDKHeartBeatThread())
-  {
-    DERROR("Failed to initialize OSDKHeartBeatThread!\n");
-    return false;
-  }
-
-  if (!initLegacyLinker())
+  sendHeartbeatToFCJob = 0;
+  if (OsdkOsal_MutexCreate(&lazyInitMutex) != OSDK_STAT_OK)
   {
-    DERROR("Failed to initialize LegacyLinker!\n");
-    return false;
+    DERROR("Failed to create lazy init mutex!\n");
   }
+}
 
-  /*
-   * Initialize subscriber if supported
-   */
-  if (!initSubscriber())
+/*! Sleep what is left of periodMs since startMs, so a retry after an
+ *  attempt that already waited out its timeout goes out immediately.
+ */
+static void
+sleepRemainderMs(uint32_t startMs, uint32_t periodMs)
+{
+  uint32_t nowMs = 0;
+  OsdkOsal_GetTimeMs(&nowMs);
+  uint32_t elapsedMs = nowMs - startMs;
+  if (elapsedMs < periodMs)
   {
-    DERROR("Failed to initialize subscriber!\n");
-    return false;
+    OsdkOsal_TaskSleepMs(periodMs - elapsedMs);
   }
+}
 
-  /*
-   * Initialize broadcast if supported
-   */
-  if (!initBroadcast())
-  {
-    DERROR("Failed to initialize Broadcast!\n");
-    return false;
-  }
+void
+Vehicle::setStartupMode(StartupMode mode)
+{
+  startupMode = mode;
+}
 
-  /*
-   * @note Initialize Movement Control,
-   * @note it will be replaced by FlightActions and FlightController in the future.
-   */
-  if (!initControl())
-  {
-    DERROR("Failed to initialize Control!\n");
-    return false;
-  }
+bool
+Vehicle::runStartupPhase(const char* name, InitFunc func)
+{
+  uint32_t startMs = 0;
+  uint32_t endMs   = 0;
 
-  /*
-   * @note Initialize external components
-   * like Camera and MFIO
-   */
-  if (!initCamera())
-  {
-    DERROR("Failed to initialize Camera!\n");
-    return false;
-  }
+  OsdkOsal_GetTimeMs(&startMs);
+  bool ret = (this->*func)();
+  OsdkOsal_GetTimeMs(&endMs);
 
-  /*
-   * Initialize MFIO if supported
-   */
-  if (!initMFIO())
+  DSTATUS("Startup phase %s took %u ms", name, endMs - startMs);
+  if (!ret)
   {
-    DERROR("Failed to initialize MFIO!\n");
-    return false;
+    DERROR("Failed to initialize %s!\n", name);
   }
+  return ret;
+}
 
-  if(!initGimbal())
-  {
-    DERROR("Failed to initialize Gimbal!\n");
-    return false;
-  }
+void*
+Vehicle::startupTask(void* arg)
+{
+  StartupTask* task = (StartupTask*)arg;
+  task->ret = task->vehicle->runStartupPhase(task->name, task->func);
+  OsdkOsal_SemaphorePost(task->done);
+  return NULL;
+}
 
-  /*
-   * Initialize Mobile Device Abstraction
-   */
-  if (!initMobileDevice())
+bool
+Vehicle::runStartupGroup(StartupTask* tasks, size_t num)
+{
+  T_OsdkSemHandle   done = NULL;
+  T_OsdkTaskHandle  handles[MAX_STARTUP_GROUP_SIZE] = { NULL };
+  if (num > 1 && OsdkOsal_SemaphoreCreate(&done, 0) != OSDK_STAT_OK)
   {
-    DERROR("Failed to initialize Mobile Device!\n");
+    done = NULL;
   }
 
-  if (!initPayloadDevice())
+  /*! The first phase runs on this thread, the others in tasks of their own */
+  for (size_t i = 1; i < num && done; i++)
   {
-    DERROR("Failed to initialize Payload Device!\n");
+    tasks[i].vehicle = this;
+    tasks[i].done    = done;
+    if (OsdkOsal_TaskCreate(&handles[i], startupTask,
+                            OSDK_TASK_STACK_SIZE_DEFAULT, &tasks[i]) != OSDK_STAT_OK)
+    {
+      handles[i] = NULL;
+    }
   }
+  tasks[0].ret = runStartupPhase(tasks[0].name, tasks[0].func);
 
-  if (!initCameraManager())
+  bool ret = tasks[0].ret;
+  for (size_t i = 1; i < num; i++)
   {
-    DERROR("Failed to initialize PayloadManager!\n");
+    if (handles[i])
+    {
+      /*! Each post is one finished task, after the loop all of them are */
+      OsdkOsal_SemaphoreWait(done);
+    }
+    else
+    {
+      tasks[i].ret = runStartupPhase(tasks[i].name, tasks[i].func);
+    }
   }
-
-  if (!initPSDKManager())
+  for (size_t i = 1; i < num; i++)
   {
-    DERROR("Failed to initialize PSDKManager!\n");
+    if (handles[i])
+    {
+      OsdkOsal_TaskDestroy(handles[i]);
+    }
+    ret = ret && tasks[i].ret;
   }
-
-  if (!initGimbalManager())
+  if (done)
   {
-    DERROR("Failed to initialize GimbalManager!\n");
+    OsdkOsal_SemaphoreDestroy(done);
   }
+  return ret;
+}
 
-  if (!initMissionManager())
-  {
-    DERROR("Failed to initialize Mission Manager!\n");
-    return false;
-  }
+bool
+Vehicle::init()
+{
+  typedef struct StartupPhase
+  {
+    const char* name;
+    InitFunc    func;
+    /*! startup fails if this phase fails */
+    bool        required;
+    /*! created on first access in STARTUP_FAST mode */
+    bool        lazy;
+    /*! in STARTUP_FAST mode, runs along with the neighbouring concurrent
+     *  phases; they must not depend on each other */
+    bool        concurrent;
+  } StartupPhase;
+
+  /*! @note Order matters: LegacyLinker comes first, Control before the
+   *  external components, FlightController after the mission modules.
+   */
+  static const StartupPhase phases[] = {
+    {"OSDKHeartBeatThread", &Vehicle::initOSDKHeartBeatThread, true,  false, false},
+    {"LegacyLinker",        &Vehicle::initLegacyLinker,        true,  false, false},
+    {"Subscriber",          &Vehicle::initSubscriber,          true,  false, false},
+    {"Broadcast",           &Vehicle::initBroadcast,           true,  false, false},
+    {"Control",             &Vehicle::initControl,             true,  false, false},
+    {"Camera",              &Vehicle::initCamera,              true,  false, true},
+    {"MFIO",                &Vehicle::initMFIO,                true,  true,  false},
+    {"Gimbal",              &Vehicle::initGimbal,              true,  false, true},
+    {"MobileDevice",        &Vehicle::initMobileDevice,        false, true,  false},
+    {"PayloadDevice",       &Vehicle::initPayloadDevice,       false, false, true},
+    {"CameraManager",       &Vehicle::initCameraManager,       false, false, true},
+    {"PSDKManager",         &Vehicle::initPSDKManager,         false, true,  false},
+    {"GimbalManager",       &Vehicle::initGimbalManager,       false, false, true},
+    {"MissionManager",      &Vehicle::initMissionManager,      true,  false, false},
 #if defined(__linux__)
-  if (!initWaypointV2Mission())
-  {
-    DERROR("Failed to initialize WaypointV2Mission!\n");
-    return false;
-  }
+    {"WaypointV2Mission",   &Vehicle::initWaypointV2Mission,   true,  false, false},
 #endif
-  if (!initHardSync())
-  {
-    DERROR("Failed to initialize HardSync!\n");
-    return false;
-  }
-
-  if(!initFlightController())
-  {
-    DERROR("Failed to initialize FlightController!\n");
-    return false;
-  }
-
-  if(!initFirewall())
-  {
-    DERROR("Failed to initialize firewall!\n");
-    return false;
-  }
+    {"HardSync",            &Vehicle::initHardSync,            true,  false, false},
+    {"FlightController",    &Vehicle::initFlightController,    true,  false, false},
+    /*! The firewall may wait for the policy file for seconds */
+    {"Firewall",            &Vehicle::initFirewall,            true,  false, true},
 #if defined(__linux__)
-  if(!initDJIHms())
-  {
-    DERROR("Failed to initialize DJIHMS!\n");
-    return false;
-  }
+    {"DJIHMS",              &Vehicle::initDJIHms,              true,  false, true},
 #endif
-  if(!initDJIBattery())
-  {
-    DERROR("Failed to initialize DJIBattery!\n");
-    return false;
+    {"DJIBattery",          &Vehicle::initDJIBattery,          true,  false, true},
+  };
+  const size_t phaseNum = sizeof(phases) / sizeof(phases[0]);
+  const bool   fast     = (startupMode == STARTUP_FAST);
+
+  uint32_t startMs = 0;
+  uint32_t endMs   = 0;
+  OsdkOsal_GetTimeMs(&startMs);
+
+  for (size_t i = 0; i < phaseNum;)
+  {
+    /*! A phase on its own, or in STARTUP_FAST mode a run of concurrent
+     *  phases, lazy ones in between are skipped anyway */
+    const StartupPhase* group[MAX_STARTUP_GROUP_SIZE];
+    StartupTask         tasks[MAX_STARTUP_GROUP_SIZE];
+    bool                concurrent = fast && phases[i].concurrent;
+    size_t              num        = 0;
+    do
+    {
+      if (!(fast && phases[i].lazy))
+      {
+        group[num]      = &phases[i];
+        tasks[num].name = phases[i].name;
+        tasks[num].func = phases[i].func;
+        tasks[num].ret  = false;
+        num++;
+      }
+      i++;
+    } while (concurrent && i < phaseNum && num < MAX_STARTUP_GROUP_SIZE &&
+             (phases[i].concurrent || phases[i].lazy));
+
+    if (num == 0)
+    {
+      continue;
+    }
+    runStartupGroup(tasks, num);
+    for (size_t k = 0; k < num; k++)
+    {
+      if (!tasks[k].ret && group[k]->required)
+      {
+        return false;
+      }
+    }
   }
 
 #ifdef ADVANCED_SENSING
@@ -247,8 +309,7 @@ Vehicle::init()
     DSTATUS( "USB is not plugged or initialized successfully. "
              "Advacned-Sensing will not run.");
   } else {
-    if (!initAdvancedSensing()) {
-      DERROR("Failed to initialize AdvancedSensing!\n");
+    if (!runStartupPhase("AdvancedSensing", &Vehicle::initAdvancedSensing)) {
       return false;
     } else {
       DSTATUS("Start advanced sensing initalization");
@@ -258,15 +319,60 @@ Vehicle::init()
 
 #if defined(__linux__)
   /*! mop init should be here */
-  if (!initMopServer())
-  {
-    DERROR("Failed to initialize MopServer!\n");
-  }
+  runStartupPhase("MopServer", &Vehicle::initMopServer);
 #endif
 
+  /*! In STARTUP_FAST mode the subscription clean-up ran alongside the
+   *  phases above; make sure it is done before handing out the vehicle.
+   */
+  joinSubscriberDrain();
+
+  OsdkOsal_GetTimeMs(&endMs);
+  DSTATUS("Vehicle startup took %u ms", endMs - startMs);
   return true;
 }
 
+/*! The lazy getters always take lazyInitMutex, the pointer may be written
+ *  by another thread's first call */
+MFIO*
+Vehicle::getMFIO()
+{
+  OsdkOsal_MutexLock(lazyInitMutex);
+  if (!this->mfio)
+  {
+    initMFIO();
+  }
+  MFIO* result = this->mfio;
+  OsdkOsal_MutexUnlock(lazyInitMutex);
+  return result;
+}
+
+MobileDevice*
+Vehicle::getMobileDevice()
+{
+  OsdkOsal_MutexLock(lazyInitMutex);
+  if (!this->mobileDevice)
+  {
+    initMobileDevice();
+  }
+  MobileDevice* result = this->mobileDevice;
+  OsdkOsal_MutexUnlock(lazyInitMutex);
+  return result;
+}
+
+PSDKManager*
+Vehicle::getPSDKManager()
+{
+  OsdkOsal_MutexLock(lazyInitMutex);
+  if (!this->psdkManager)
+  {
+    initPSDKManager();
+  }
+  PSDKManager* result = this->psdkManager;
+  OsdkOsal_MutexUnlock(lazyInitMutex);
+  return result;
+}
+
 int
 Vehicle::functionalSetUp()
 {
@@ -274,6 +380,8 @@ Vehicle::functionalSetUp()
   bool shakeHandRet = false;
 
   for (uint16_t i = 0; i < tryTimes; i++) {
+    uint32_t attemptStartMs = 0;
+    OsdkOsal_GetTimeMs(&attemptStartMs);
     shakeHandRet = initVersion();
     if (shakeHandRet == true) {
       DSTATUS("Shake hand with drone successfully by getting drone version.");
@@ -283,7 +391,14 @@ Vehicle::functionalSetUp()
               i + 1, tryTimes);
       DSTATUS("Try again after 1 second ......");
     }
-    Platform::instance().taskSleepMs(1000);
+    if (startupMode == STARTUP_FAST)
+    {
+      sleepRemainderMs(attemptStartMs, 1000);
+    }
+    else
+    {
+      Platform::instance().taskSleepMs(1000);
+    }
   }
 
   if (shakeHandRet == false) {
@@ -309,11 +424,14 @@ Vehicle::functionalSetUp()
 
 Vehicle::~Vehicle()
 {
-  if(sendHeartbeatToFCHandle)
+  if(sendHeartbeatToFCJob)
   {
-    OsdkOsal_TaskDestroy(sendHeartbeatToFCHandle);
+    TimerScheduler::instance().cancel(sendHeartbeatToFCJob);
   }
 
+  joinSubscriberDrain();
+  joinBuriedData();
+
   if (this->subscribe)
   {
     subscribe->verify(1);
@@ -406,6 +524,10 @@ Vehicle::~Vehicle()
     delete this->advancedSensing;
 #endif
 
+  if(lazyInitMutex)
+  {
+    OsdkOsal_MutexDestroy(lazyInitMutex);
+  }
 }
 
 
@@ -492,19 +614,34 @@ Vehicle::initSubscriber()
       return false;
     }
 
-    bool ret = this->legacyLinker->registerCMDCallback(
+    bool ret = this->legacyLinker->registerCMDViewCallback(
         OpenProtocolCMD::CMDSet::Broadcast::subscribe[0],
         OpenProtocolCMD::CMDSet::Broadcast::subscribe[1],
-        this->subscribe->subscriptionDataDecodeHandler.callback,
-        this->subscribe->subscriptionDataDecodeHandler.userData);
+        this->subscribe->subscriptionDataViewDecodeHandler.callback,
+        this->subscribe->subscriptionDataViewDecodeHandler.userData);
     /*
      * Wait for 1.2 seconds, so we can detect all leftover
-     * packages from unclean quit, and remove them properly
+     * packages from unclean quit, and remove them properly.
+     * There is no event to wait for instead: a package that is not left
+     * over only shows by not arriving within the window.
      */
     if (!ret) {
       DERROR("Register broadcast callback fail.");
       return ret;
     }
+    if (startupMode == STARTUP_FAST &&
+        OsdkOsal_SemaphoreCreate(&subscriberDrainSem, 0) == OSDK_STAT_OK &&
+        OsdkOsal_TaskCreate(&subscriberDrainHandle, subscriberDrainTask,
+                            OSDK_TASK_STACK_SIZE_DEFAULT, this) == OSDK_STAT_OK)
+    {
+      /*! The wait runs in the background, joined at the end of init() */
+      return true;
+    }
+    if (subscriberDrainSem)
+    {
+      OsdkOsal_SemaphoreDestroy(subscriberDrainSem);
+      subscriberDrainSem = NULL;
+    }
     Platform::instance().taskSleepMs(1200);
     this->subscribe->removeLeftOverPackages();
   }
@@ -517,6 +654,33 @@ Vehicle::initSubscriber()
 }
 
 
+void*
+Vehicle::subscriberDrainTask(void* arg)
+{
+  Vehicle* vehicle = (Vehicle*)arg;
+  OsdkOsal_TaskSleepMs(1200);
+  vehicle->subscribe->removeLeftOverPackages();
+  OsdkOsal_SemaphorePost(vehicle->subscriberDrainSem);
+  return NULL;
+}
+
+void
+Vehicle::joinSubscriberDrain()
+{
+  if (!subscriberDrainHandle)
+  {
+    return;
+  }
+  /*! Wait for the task to finish on its own; destroying it early would
+   *  cancel the clean-up half way.
+   */
+  OsdkOsal_SemaphoreWait(subscriberDrainSem);
+  OsdkOsal_TaskDestroy(subscriberDrainHandle);
+  OsdkOsal_SemaphoreDestroy(subscriberDrainSem);
+  subscriberDrainHandle = NULL;
+  subscriberDrainSem = NULL;
+}
+
 bool
 Vehicle::initBroadcast()
 {
@@ -534,11 +698,11 @@ Vehicle::initBroadcast()
       DERROR("Failed to allocate memory for Broadcast!\n");
       return false;
     }
-    bool ret = this->legacyLinker->registerCMDCallback(
+    bool ret = this->legacyLinker->registerCMDViewCallback(
         OpenProtocolCMD::CMDSet::Broadcast::broadcast[0],
         OpenProtocolCMD::CMDSet::Broadcast::broadcast[1],
-        this->broadcast->unpackHandler.callback,
-        this->broadcast->unpackHandler.userData);
+        this->broadcast->unpackViewHandler.callback,
+        this->broadcast->unpackViewHandler.userData);
     if (!ret) DERROR("Register broadcast callback fail.");
     return ret;
   }
@@ -906,14 +1070,12 @@ Vehicle::initDJIHms() {
 bool
 Vehicle::initOSDKHeartBeatThread() {
     /*! create task for OSDK heart beat */
-    if(!sendHeartbeatToFCHandle) {
-      E_OsdkStat osdkStat = OsdkOsal_TaskCreate(&sendHeartbeatToFCHandle,
-                                                (void *(*)(
-                                                    void *)) (sendHeartbeatToFCTask),
-                                                OSDK_TASK_STACK_SIZE_DEFAULT,
-                                                this->linker);
-      if (osdkStat != OSDK_STAT_OK) {
-        DERROR("osdk heart beat task create error:%d", osdkStat);
+    if(!sendHeartbeatToFCJob) {
+      sendHeartbeatToFCJob = TimerScheduler::instance().schedulePeriodic(
+          sendHeartbeatToFCTask, this->linker, kHeartBeatPackSendTimeInterval,
+          1000, "heartbeat", TimerScheduler::PRIORITY_HIGH);
+      if (!sendHeartbeatToFCJob) {
+        DERROR("osdk heart beat task schedule error");
         return false;
       }
     }
@@ -1346,6 +1508,8 @@ Vehicle::activate(ActivateData* data, uint32_t timeoutMs)
   uint8_t activateRetryTimes = 0;
   while (1)
   {
+    uint32_t attemptStartMs = 0;
+    OsdkOsal_GetTimeMs(&attemptStartMs);
     /*! Try several times to avoid the NEW_DEVICE_ERROR issues */
     ack = *(ACK::ErrorCode*)legacyLinker->sendSync(
       OpenProtocolCMD::CMDSet::Activation::activate,
@@ -1356,7 +1520,14 @@ Vehicle::activate(ActivateData* data, uint32_t timeoutMs)
     if ((ack.data == OpenProtocolCMD::ErrorCode::ActivationACK::SUCCESS) ||
         (activateRetryTimes >= 3))
       break;
-    OsdkOsal_TaskSleepMs(1000);
+    if (startupMode == STARTUP_FAST)
+    {
+      sleepRemainderMs(attemptStartMs, 1000);
+    }
+    else
+    {
+      OsdkOsal_TaskSleepMs(1000);
+    }
     DSTATUS("Retry to activate again ..");
     activateRetryTimes++;
   }
@@ -1365,11 +1536,7 @@ Vehicle::activate(ActivateData* data, uint32_t timeoutMs)
       accountData.encKey)
   {
     DSTATUS("Activation successful\n");
-    for (uint8_t i = 0; i < MAX_SEND_DATA_BURY_PKG_COUNT; i++)
-    {
-        sendBuriedDataPkgToFC();
-        OsdkOsal_TaskSleepMs(200);
-    }
+    sendBuriedData();
     linker->setKey(accountData.encKey);
     setActivationStatus(true);
   }
@@ -1464,11 +1631,7 @@ Vehicle::activate(ActivateData* data, VehicleCallBack callback,
                           (uint8_t *) &accountData,
                           sizeof(accountData) - sizeof(char *), 1000, 3, cb,
                           udata);
-  for (uint8_t i = 0; i < MAX_SEND_DATA_BURY_PKG_COUNT; i++)
-  {
-      sendBuriedDataPkgToFC();
-      OsdkOsal_TaskSleepMs(200);
-  }
+  sendBuriedData();
 }
 
 
@@ -1570,33 +1733,17 @@ Vehicle::sendHeartbeatToFCFunc(Linker *linker)
     }
 }
 
-void *
-Vehicle::sendHeartbeatToFCTask(void *arg) {
-    OsdkOsal_TaskSleepMs(1000);
-    DSTATUS("OSDK send heart beat to fc task created.");
+void
+Vehicle::sendHeartbeatToFCTask(void *arg, uint32_t) {
     if(arg) {
       Linker *linker = (Linker *) arg;
-      static uint32_t preHeartBeatTimeStamp = 0;
-      static uint32_t curHeartBeatTimeStamp = 0;
-      for (;;)
-      {
-          OsdkOsal_GetTimeMs(&curHeartBeatTimeStamp);
-          if (curHeartBeatTimeStamp - preHeartBeatTimeStamp >=  kHeartBeatPackSendTimeInterval)
-          {
-            if (linker->isUartPlugged()) {
-              DJI::OSDK::Vehicle::sendHeartbeatToFCFunc(linker);
-            }
-              preHeartBeatTimeStamp = curHeartBeatTimeStamp;
-          }
-
-          /*! TODO: with out sleep 100ms, the time will get the same as last time. */
-          OsdkOsal_TaskSleepMs(100);
+      if (linker->isUartPlugged()) {
+        DJI::OSDK::Vehicle::sendHeartbeatToFCFunc(linker);
       }
     } else {
       DERROR("Osdk send heart beat to fc task run failed because of the invalid linker "
              "ptr. Please recheck this task params.");
     }
-  return NULL;
 }
 
 void
@@ -1938,6 +2085,81 @@ Vehicle::isCmdSetSupported(const uint8_t cmdSet)
   return true;
 }
 
+void*
+Vehicle::buriedDataTask(void* arg)
+{
+  Vehicle* vehicle = (Vehicle*)arg;
+  for (uint8_t i = 0; i < MAX_SEND_DATA_BURY_PKG_COUNT; i++)
+  {
+    vehicle->sendBuriedDataPkgToFC();
+    /*! Paced like the blocking path, a post on the stop semaphore ends it */
+    if (OsdkOsal_SemaphoreTimedWait(vehicle->buriedDataStopSem, 200) ==
+        OSDK_STAT_OK)
+    {
+      break;
+    }
+  }
+  OsdkOsal_SemaphorePost(vehicle->buriedDataDoneSem);
+  return NULL;
+}
+
+void
+Vehicle::joinBuriedData()
+{
+  if (!buriedDataHandle)
+  {
+    return;
+  }
+  /*! Stop the task between two packets rather than destroying it in the
+   *  middle of a send */
+  OsdkOsal_SemaphorePost(buriedDataStopSem);
+  OsdkOsal_SemaphoreWait(buriedDataDoneSem);
+  OsdkOsal_TaskDestroy(buriedDataHandle);
+  OsdkOsal_SemaphoreDestroy(buriedDataStopSem);
+  OsdkOsal_SemaphoreDestroy(buriedDataDoneSem);
+  buriedDataHandle  = NULL;
+  buriedDataStopSem = NULL;
+  buriedDataDoneSem = NULL;
+}
+
+/*! The packets are paced 200 ms apart, the FC drops them when they come
+ *  faster. That is pacing, not a wait for an event, so it stays; in
+ *  STARTUP_FAST mode it happens in a background task instead of blocking
+ *  activation.
+ */
+void
+Vehicle::sendBuriedData()
+{
+  if (startupMode == STARTUP_FAST)
+  {
+    joinBuriedData();
+    if (OsdkOsal_SemaphoreCreate(&buriedDataStopSem, 0) == OSDK_STAT_OK &&
+        OsdkOsal_SemaphoreCreate(&buriedDataDoneSem, 0) == OSDK_STAT_OK &&
+        OsdkOsal_TaskCreate(&buriedDataHandle, buriedDataTask,
+                            OSDK_TASK_STACK_SIZE_DEFAULT, this) == OSDK_STAT_OK)
+    {
+      return;
+    }
+    buriedDataHandle = NULL;
+    if (buriedDataStopSem)
+    {
+      OsdkOsal_SemaphoreDestroy(buriedDataStopSem);
+      buriedDataStopSem = NULL;
+    }
+    if (buriedDataDoneSem)
+    {
+      OsdkOsal_SemaphoreDestroy(buriedDataDoneSem);
+      buriedDataDoneSem = NULL;
+    }
+  }
+
+  for (uint8_t i = 0; i < MAX_SEND_DATA_BURY_PKG_COUNT; i++)
+  {
+    sendBuriedDataPkgToFC();
+    OsdkOsal_TaskSleepMs(200);
+  }
+}
+
 void
 Vehicle::sendBuriedDataPkgToFC(void)
 {
@@ -32,11 +32,18 @@
 #include "dji_vehicle.hpp"
 #include "memory.h"
 #include "dji_internal_command.hpp"
+#include "dji_ctx_pool.hpp"
 #include <math.h>
+#include <new>
 using namespace DJI;
 using namespace DJI::OSDK;
 
 const float32_t INVALID_TAKOFF_ALTITUDE = 999999.99;
+/*! Largest single mission/action push the encoders can produce */
+const uint16_t MAX_PUSH_LEN = 400;
+/*! Resends of one push in pipelined upload before giving up */
+const uint8_t PIPELINE_MAX_TRIES = 4;
+const uint8_t PIPELINE_MAX_WINDOW = 16;
 
 
 ErrorCode::ErrorCodeType getWP2LinkerErrorCode(E_OsdkStat cb_type) {
@@ -75,17 +82,13 @@ void elementDecode(Type &data, uint8_t *&tempPtr) {
   tempPtr += sizeof(Type);
 }
 
-bool missionEncode(const std::vector<WaypointV2Internal> &mission, uint8_t *pushPtr,
-                   uint16_t &len) {
-  if (mission.empty()) {
-    pushPtr = nullptr;
-    len = 0;
-    return true;
-  }
-
-  bool finished = false;
+/*! Encode one push of waypoints starting at startIndex.
+ *  @return index of the first waypoint not encoded
+ */
+uint16_t missionEncodeRange(const std::vector<WaypointV2Internal> &mission,
+                            uint16_t startIndex, uint8_t *pushPtr,
+                            uint16_t &len) {
   uint16_t tempTotalLen = 0;
-  static uint16_t startIndex = 0;
   uint16_t endIndex = 0;
   uint8_t *tempPtr = pushPtr;
 
@@ -130,15 +133,26 @@ bool missionEncode(const std::vector<WaypointV2Internal> &mission, uint8_t *push
   }
   len = tempTotalLen;
   endIndex = i - 1;
-  startIndex = endIndex + 1;
   memcpy(tempTempPtr, &endIndex, sizeof(endIndex));
+  return i;
+}
+
+bool missionEncode(const std::vector<WaypointV2Internal> &mission, uint8_t *pushPtr,
+                   uint16_t &len) {
+  if (mission.empty()) {
+    pushPtr = nullptr;
+    len = 0;
+    return true;
+  }
+
+  static uint16_t startIndex = 0;
+  startIndex = missionEncodeRange(mission, startIndex, pushPtr, len);
   DSTATUS("mis_upload_start_index:%d, mis_upload_end_index:%d, upload_len:%d",*pushPtr, *(pushPtr + 2), len);
-  if (endIndex >= mission.size() - 1) {
+  if (startIndex >= mission.size()) {
     startIndex = 0;
-    endIndex = 0;
-    finished = true;
+    return true;
   }
-  return finished;
+  return false;
 }
 
 bool missionDecode(std::vector<WaypointV2Internal> &mission, uint8_t *const pullPtr,
@@ -350,14 +364,17 @@ void triggerEncode(const DJIWaypointV2Trigger &trigger, uint16_t &tempTotalLen,
   }
 }
 
-bool ActionsEncode(std::vector<DJIWaypointV2Action> &actions,
-                   uint8_t *pushPtr, uint16_t &len) {
+/*! Encode one push of actions starting at startIndex.
+ *  @return index of the first action not encoded
+ */
+uint16_t actionsEncodeRange(const std::vector<DJIWaypointV2Action> &actions,
+                            uint16_t startIndex, uint8_t *pushPtr,
+                            uint16_t &len) {
   uint16_t i;
-  bool finished = false;
   uint16_t tempTotalLen = 0;
   uint8_t *tempPtr = pushPtr;
 
-  static uint16_t startIndex = 0;
+  len = 0;
   for (i = startIndex; (i < actions.size()) && (tempTotalLen < 100); ++i) {
     DJIWaypointV2Action action = actions[i];
 
@@ -371,10 +388,21 @@ bool ActionsEncode(std::vector<DJIWaypointV2Action> &actions,
     actuatorEncode(action.actuator, tempTotalLen, tempPtr);
 
     len = tempTotalLen;
-    DSTATUS("upload_action_ID:%d",action.actionId);
+  }
+  return i;
+}
+
+bool ActionsEncode(std::vector<DJIWaypointV2Action> &actions,
+                   uint8_t *pushPtr, uint16_t &len) {
+  bool finished = false;
+
+  static uint16_t startIndex = 0;
+  uint16_t nextIndex = actionsEncodeRange(actions, startIndex, pushPtr, len);
+  for (uint16_t i = startIndex; i < nextIndex; ++i) {
+    DSTATUS("upload_action_ID:%d",actions[i].actionId);
   }
   DSTATUS("total_len:%d",len);
-  startIndex = i;
+  startIndex = nextIndex;
   if (startIndex > actions.size() - 1) {
     finished = true;
     startIndex = 0;
@@ -570,8 +598,8 @@ ErrorCode::ErrorCodeType WaypointV2MissionOperator::uploadMission(
 
   uint16_t dataLengthSinglePush = 0;
   bool finished = false;
+  uint8_t waypointPushPtr[MAX_PUSH_LEN];
   while (!finished) {
-    void *waypointPushPtr = malloc(400);
     finished = missionEncode(mission, (uint8_t *) waypointPushPtr,
                              dataLengthSinglePush);
     T_CmdInfo ackInfo = {0};
@@ -585,7 +613,6 @@ ErrorCode::ErrorCodeType WaypointV2MissionOperator::uploadMission(
       vehiclePtr->linker->sendSync(&cmdInfo, (uint8_t *)waypointPushPtr, &ackInfo,
                                    ackData, timeout * 1000, 4);
     ErrorCode::ErrorCodeType ret = getWP2LinkerErrorCode(linkAck);
-    free(waypointPushPtr);
 
     if (ret != ErrorCode::SysCommonErr::Success) {
       return ret;
@@ -690,9 +717,9 @@ ErrorCode::ErrorCodeType WaypointV2MissionOperator::uploadAction(
   } else {
     bool finished = false;
     E_OsdkStat linkAck;
+    uint8_t actionsPushPtr[MAX_PUSH_LEN];
     while (!finished) {
       uint16_t dataLen = 0;
-      void *actionsPushPtr = malloc(400);
       T_CmdInfo ackInfo = {0};
       RetCodeType ackData[1024];
 
@@ -702,7 +729,6 @@ ErrorCode::ErrorCodeType WaypointV2MissionOperator::uploadAction(
 
       linkAck = vehiclePtr->linker->sendSync(&cmdInfo, (uint8_t *)actionsPushPtr, &ackInfo,
                                  ackData, timeout * 1000 / 4, 4);
-      free(actionsPushPtr);
       ErrorCode::ErrorCodeType ret = getWP2LinkerErrorCode(linkAck);
 
       if (ret != ErrorCode::SysCommonErr::Success) {
@@ -722,6 +748,272 @@ ErrorCode::ErrorCodeType WaypointV2MissionOperator::uploadAction(
   return ErrorCode::SysCommonErr::Success;
 }
 
+/*! ACK of one pipelined push, filled in by the linker callback */
+typedef struct PipelineAck {
+  uint32_t chunk;
+  E_OsdkStat stat;
+  uint32_t result;
+} PipelineAck;
+
+/*! Shared between pipelinedUpload() and the linker's ACK callbacks. It lives
+ *  on the heap and is freed by whichever side drops the last reference, so
+ *  a callback that fires after the upload gave up still finds it valid.
+ */
+typedef struct PipelineContext {
+  T_OsdkMutexHandle mutex;
+  T_OsdkSemHandle   sem;
+  /*! one for the upload loop plus one per push in flight */
+  uint32_t          refs;
+  /*! ACKs not yet consumed by the upload loop */
+  std::vector<PipelineAck> acks;
+} PipelineContext;
+
+typedef struct PipelineRequest {
+  PipelineContext *ctx;
+  uint32_t         chunk;
+} PipelineRequest;
+
+static PipelineContext *pipelineContextCreate() {
+  PipelineContext *ctx = new (std::nothrow) PipelineContext;
+  if (!ctx) return NULL;
+  if (OsdkOsal_MutexCreate(&ctx->mutex) != OSDK_STAT_OK) {
+    delete ctx;
+    return NULL;
+  }
+  if (OsdkOsal_SemaphoreCreate(&ctx->sem, 0) != OSDK_STAT_OK) {
+    OsdkOsal_MutexDestroy(ctx->mutex);
+    delete ctx;
+    return NULL;
+  }
+  ctx->refs = 1;
+  return ctx;
+}
+
+/*! Caller holds ctx->mutex, which is released here */
+static void pipelineContextUnref(PipelineContext *ctx) {
+  bool last = (--ctx->refs == 0);
+  OsdkOsal_MutexUnlock(ctx->mutex);
+  if (last) {
+    OsdkOsal_SemaphoreDestroy(ctx->sem);
+    OsdkOsal_MutexDestroy(ctx->mutex);
+    delete ctx;
+  }
+}
+
+static void pipelineAckCallback(const T_CmdInfo *cmdInfo,
+                                const uint8_t *cmdData, void *userData,
+                                E_OsdkStat cb_type) {
+  PipelineRequest *req = (PipelineRequest *)userData;
+  if (!req) return;
+
+  PipelineAck ack;
+  ack.chunk = req->chunk;
+  ack.stat = cb_type;
+  ack.result = 0;
+  if (cb_type == OSDK_STAT_OK) {
+    /*! Both mission and action upload ACKs start with a uint32 result */
+    if (cmdInfo && cmdData && cmdInfo->dataLen >= sizeof(uint32_t)) {
+      memcpy(&ack.result, cmdData, sizeof(uint32_t));
+    } else {
+      ack.stat = OSDK_STAT_ERR_OUT_OF_RANGE;
+    }
+  }
+
+  PipelineContext *ctx = req->ctx;
+  DJI_CTX_FREE(req);
+  OsdkOsal_MutexLock(ctx->mutex);
+  ctx->acks.push_back(ack);
+  OsdkOsal_SemaphorePost(ctx->sem);
+  pipelineContextUnref(ctx);
+}
+
+ErrorCode::ErrorCodeType WaypointV2MissionOperator::pipelinedUpload(
+    const uint8_t cmd[], int timeout, uint8_t windowSize, UploadStats *stats) {
+  if (windowSize < 1) windowSize = 1;
+  if (windowSize > PIPELINE_MAX_WINDOW) windowSize = PIPELINE_MAX_WINDOW;
+
+  PipelineContext *ctx = pipelineContextCreate();
+  if (!ctx) return ErrorCode::SysCommonErr::AllocMemoryFailed;
+  ctx->acks.reserve(windowSize);
+
+  uint32_t startMs = 0;
+  OsdkOsal_GetTimeMs(&startMs);
+
+  UploadStats st = {0};
+  ErrorCode::ErrorCodeType ret = ErrorCode::SysCommonErr::Success;
+  std::vector<PipelineAck> acks;
+  acks.reserve(windowSize);
+  retryChunks.clear();
+  uint32_t total = uploadChunks.size();
+  uint32_t next = 0;
+  uint32_t acked = 0;
+  uint32_t inflight = 0;
+
+  while (acked < total) {
+    /*! Keep the window full; failed pushes go out again before new ones */
+    while (ret == ErrorCode::SysCommonErr::Success && inflight < windowSize) {
+      uint32_t idx;
+      if (!retryChunks.empty()) {
+        idx = retryChunks.back();
+        retryChunks.pop_back();
+        st.retries++;
+      } else if (next < total) {
+        idx = next++;
+        st.chunks++;
+      } else {
+        break;
+      }
+
+      PipelineRequest *req =
+          (PipelineRequest *)DJI_CTX_ALLOC(sizeof(PipelineRequest));
+      if (!req) {
+        ret = ErrorCode::SysCommonErr::AllocMemoryFailed;
+        break;
+      }
+      req->ctx = ctx;
+      req->chunk = idx;
+      uploadChunks[idx].tries++;
+      OsdkOsal_MutexLock(ctx->mutex);
+      ctx->refs++;
+      OsdkOsal_MutexUnlock(ctx->mutex);
+
+      T_CmdInfo cmdInfo =
+          setCmdInfoDefault(vehiclePtr, cmd, uploadChunks[idx].len);
+      vehiclePtr->linker->sendAsync(&cmdInfo,
+                                    &uploadBuf[uploadChunks[idx].offset],
+                                    pipelineAckCallback, req,
+                                    timeout * 1000, 1);
+      inflight++;
+    }
+
+    if (inflight == 0) break;
+
+    /*! The linker reports a timeout for every push, so this only guards
+     *  against a lost callback.
+     */
+    if (OsdkOsal_SemaphoreTimedWait(ctx->sem, timeout * 1000 * 2) !=
+        OSDK_STAT_OK) {
+      DERROR("Pipelined upload lost %d ACK callbacks", inflight);
+      ret = ErrorCode::SysCommonErr::ReqTimeout;
+      break;
+    }
+
+    OsdkOsal_MutexLock(ctx->mutex);
+    acks.swap(ctx->acks);
+    OsdkOsal_MutexUnlock(ctx->mutex);
+
+    for (size_t i = 0; i < acks.size(); ++i) {
+      const PipelineAck &ack = acks[i];
+      UploadChunk &chunk = uploadChunks[ack.chunk];
+      inflight--;
+      if (ack.stat == OSDK_STAT_OK && ack.result == 0) {
+        acked++;
+        st.bytes += chunk.len;
+      } else if (ack.stat == OSDK_STAT_OK) {
+        if (ret == ErrorCode::SysCommonErr::Success)
+          ret = ErrorCode::getErrorCode(ErrorCode::MissionV2Module,
+                                        ErrorCode::MissionV2Common,
+                                        ack.result);
+      } else if (ack.stat == OSDK_STAT_ERR_OUT_OF_RANGE) {
+        if (ret == ErrorCode::SysCommonErr::Success)
+          ret = ErrorCode::SysCommonErr::UnpackDataMismatch;
+      } else if (chunk.tries < PIPELINE_MAX_TRIES) {
+        retryChunks.push_back(ack.chunk);
+      } else if (ret == ErrorCode::SysCommonErr::Success) {
+        ret = getWP2LinkerErrorCode(ack.stat);
+      }
+    }
+    acks.clear();
+
+    if (ret != ErrorCode::SysCommonErr::Success) break;
+  }
+
+  /*! Let outstanding pushes settle so a later upload does not race them;
+   *  if a callback never comes, its reference keeps ctx alive.
+   */
+  while (inflight > 0 &&
+         OsdkOsal_SemaphoreTimedWait(ctx->sem, timeout * 1000 * 2) ==
+             OSDK_STAT_OK) {
+    OsdkOsal_MutexLock(ctx->mutex);
+    inflight -= ctx->acks.size();
+    ctx->acks.clear();
+    OsdkOsal_MutexUnlock(ctx->mutex);
+  }
+
+  uint32_t endMs = 0;
+  OsdkOsal_GetTimeMs(&endMs);
+  st.elapsedMs = endMs - startMs;
+  st.bytesPerSec = st.elapsedMs ? (st.bytes * 1000.0f / st.elapsedMs) : 0;
+  DSTATUS("Pipelined upload: %d pushes, %d retries, %d bytes in %d ms (%.1f B/s)",
+          st.chunks, st.retries, st.bytes, st.elapsedMs, st.bytesPerSec);
+  if (stats) *stats = st;
+
+  OsdkOsal_MutexLock(ctx->mutex);
+  pipelineContextUnref(ctx);
+  return ret;
+}
+
+ErrorCode::ErrorCodeType WaypointV2MissionOperator::uploadMissionPipelined(
+    int timeout, uint8_t windowSize, UploadStats *stats) {
+  std::vector<WaypointV2Internal> mission = transformMission2MisssionInternal(this->missionV2);
+  if (mission.empty()) return ErrorCode::SysCommonErr::Success;
+  /*! The pushes carry 16 bit waypoint indices */
+  if (mission.size() > UINT16_MAX) {
+    DERROR("Mission of %d waypoints is too long", (int)mission.size());
+    return ErrorCode::WaypointV2MissionErr::TRAJ_INIT_WP_NUM_TOO_MANY;
+  }
+
+  /*! Encode every push up front into the reused upload buffer */
+  uploadChunks.clear();
+  uploadBuf.resize(MAX_PUSH_LEN);
+  uint16_t startIndex = 0;
+  uint32_t offset = 0;
+  while (startIndex < mission.size()) {
+    if (uploadBuf.size() < offset + MAX_PUSH_LEN)
+      uploadBuf.resize(uploadBuf.size() * 2);
+    UploadChunk chunk = {offset, 0, 0};
+    startIndex = missionEncodeRange(mission, startIndex, &uploadBuf[offset], chunk.len);
+    uploadChunks.push_back(chunk);
+    offset += chunk.len;
+  }
+
+  return pipelinedUpload(V1ProtocolCMD::waypointV2::waypointUploadV2, timeout,
+                         windowSize, stats);
+}
+
+ErrorCode::ErrorCodeType WaypointV2MissionOperator::uploadActionPipelined(
+    std::vector<DJIWaypointV2Action> &actions, int timeout, UploadStats *stats) {
+  if (actions.size() == 0) {
+    DERROR("Action number is zero, please reset actions vector");
+    return ErrorCode::SysCommonErr::Success;
+  }
+  /*! The encoder walks the actions with a 16 bit index */
+  if (actions.size() > UINT16_MAX) {
+    DERROR("%d actions are too many", (int)actions.size());
+    return ErrorCode::SysCommonErr::ReqNotSupported;
+  }
+
+  uploadChunks.clear();
+  uploadBuf.resize(MAX_PUSH_LEN);
+  uint16_t startIndex = 0;
+  uint32_t offset = 0;
+  while (startIndex < actions.size()) {
+    if (uploadBuf.size() < offset + MAX_PUSH_LEN)
+      uploadBuf.resize(uploadBuf.size() * 2);
+    UploadChunk chunk = {offset, 0, 0};
+    startIndex = actionsEncodeRange(actions, startIndex, &uploadBuf[offset], chunk.len);
+    uploadChunks.push_back(chunk);
+    offset += chunk.len;
+  }
+
+  /*! Action pushes carry no index, the FC appends them in arrival order.
+   *  A window of one keeps them in order, a timed out push is resent
+   *  before the next one goes out.
+   */
+  return pipelinedUpload(V1ProtocolCMD::waypointV2::waypointUploadActionV2,
+                         timeout, 1, stats);
+}
+
 ErrorCode::ErrorCodeType WaypointV2MissionOperator::getActionRemainMemory(
     GetRemainRamAck &remainRamAck, int timeout) {
   bool finished = false;
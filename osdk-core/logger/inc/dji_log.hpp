@@ -32,6 +32,15 @@
 
 #include "dji_singleton.hpp"
 #include "dji_platform.hpp"
+#include <stdarg.h>
+#include <stdio.h>
+#if defined(__linux__)
+#include <atomic>
+#define LOG_ATOMIC(_type_) std::atomic<_type_>
+#else
+//! No atomics on the MCU toolchains, the counters are best effort there
+#define LOG_ATOMIC(_type_) _type_
+#endif
 
 
 #ifdef WIN32
@@ -80,6 +89,56 @@ namespace OSDK
 
 //! @todo text stream and string class
 
+/*! @brief Destination of the log lines
+ *
+ * @details In async mode write() is only called from the log writer thread.
+ * In sync mode it is called under the log mutex.
+ */
+class LogSink
+{
+public:
+  virtual ~LogSink() {}
+  //! @param line one complete line, newline included, not 0-terminated
+  virtual void write(const char* line, size_t len) = 0;
+  virtual void flush() {}
+};
+
+//! @brief Default sink, prints to stdout
+class StdoutLogSink : public LogSink
+{
+public:
+  virtual void write(const char* line, size_t len);
+  virtual void flush();
+};
+
+//! @brief Appends the log lines to a file
+class FileLogSink : public LogSink
+{
+public:
+  FileLogSink(const char* path);
+  virtual ~FileLogSink();
+  bool         isOpen();
+  virtual void write(const char* line, size_t len);
+  virtual void flush();
+
+private:
+  FILE* file;
+};
+
+#if defined(__linux__)
+//! @brief Forwards the log lines to syslog
+class SyslogLogSink : public LogSink
+{
+public:
+  SyslogLogSink(const char* ident, int priority = 6 /* LOG_INFO */);
+  virtual ~SyslogLogSink();
+  virtual void write(const char* line, size_t len);
+
+private:
+  int priority;
+};
+#endif
+
 /*! @brief Logger for DJI OSDK supporting different logging channels
  *
  * @details The Log class is a singleton and contains some pre-defined logging levels.
@@ -143,6 +202,46 @@ public:
   bool getDebugLogState();
   bool getErrorLogState();
 
+  /*!
+   * @brief Hand the log lines to a background writer thread
+   *
+   * @details Each logging thread formats its lines into its own lock-free
+   * ring of recordsPerThread lines, so DSTATUS/DERROR never block on the
+   * console. A line that does not fit in a full ring is dropped and counted.
+   * Disabling flushes the queued lines before returning.
+   *
+   * @platforms Linux
+   * @param enable
+   * @param recordsPerThread ring size of each logging thread
+   * @return false if async mode is not supported on this platform
+   */
+  bool setAsyncMode(bool enable, uint32_t recordsPerThread = 256);
+  bool isAsyncMode();
+
+  /*!
+   * @brief Select where the lines go, NULL for stdout.
+   * @note The sink is not owned and must outlive its use by the logger.
+   */
+  void setSink(LogSink* sink);
+
+  /*!
+   * @brief Limit the lines each DSTATUS/DERROR/DDEBUG call site may print per
+   * second, 0 for no limit. Suppressed lines are counted and reported on the
+   * next line printed from the same call site.
+   */
+  void setRateLimit(uint32_t linesPerSecond);
+
+  typedef struct LogStats
+  {
+    uint64_t written;
+    //! lost because a thread's ring was full
+    uint64_t dropped;
+    //! suppressed by the rate limit
+    uint64_t rateLimited;
+  } LogStats;
+
+  LogStats getStats();
+
   virtual Log& print(const char* fmt, ...);
 
   Log& operator<<(bool val);
@@ -163,11 +262,25 @@ public:
   Log& operator<<(int8_t c);
   Log& operator<<(const char* str);
 
+  //! Internal state of the async backend, defined in dji_log.cpp
+  struct AsyncState;
+
 private:
+  void append(const char* fmt, ...);
+  void formatLine(const char* fmt, va_list args);
+  void writeLine(const char* line, size_t len);
+  bool rateLimited(const char* func, int line, uint32_t& suppressed);
+
   Mutex* mutex;
-  bool   vaild;
   bool   initFlag;
 
+  LogSink*              sink;
+  StdoutLogSink         stdoutSink;
+  AsyncState*           async;
+  LOG_ATOMIC(uint32_t)  rateLimit;
+  LOG_ATOMIC(uint64_t)  writtenSync;
+  LOG_ATOMIC(uint64_t)  rateLimitedCount;
+
   // @todo implement
   typedef enum NUMBER_STYLE {
     STYLE_DEC,
@@ -32,10 +32,168 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#if defined(__linux__)
+#include <syslog.h>
+#include <thread>
+#define LOG_THREAD_LOCAL thread_local
+#else
+/*! No thread_local on the MCU toolchains, the title is shared there and
+ *  title() holds the mutex until print() has written the line */
+#define LOG_THREAD_LOCAL
+#define LOG_TITLE_LOCKS
+#endif
 
 using namespace DJI::OSDK;
 
+//! Longest line, title included; longer messages are truncated
+static const size_t LOG_LINE_SIZE  = 384;
+static const size_t LOG_TITLE_SIZE = 96;
+
+/*! The title is kept per thread until print() completes the line, so a line
+ *  is always written in one go and lines of different threads no longer
+ *  interleave. Without thread_local it is guarded by the log mutex instead.
+ */
+static LOG_THREAD_LOCAL char tlsTitle[LOG_TITLE_SIZE];
+static LOG_THREAD_LOCAL bool tlsValid;
+
+/*
+ * Per call site rate limiting, approximate: two sites hashing to the same
+ * entry share their budget until one of them goes quiet.
+ */
+static const uint32_t LOG_SITE_NUM = 256;
+
+typedef struct LogSite
+{
+  LOG_ATOMIC(const char*) func;
+  LOG_ATOMIC(int)         line;
+  LOG_ATOMIC(uint32_t)    windowStartMs;
+  LOG_ATOMIC(uint32_t)    count;
+  LOG_ATOMIC(uint32_t)    suppressed;
+} LogSite;
+
+static LogSite logSites[LOG_SITE_NUM];
+
+#if defined(__linux__)
+/*
+ * Async mode: one single-producer ring per logging thread, drained by the
+ * writer thread. Rings are never freed while the logger lives; the ring of
+ * an exited thread is handed to the next new thread.
+ */
+typedef struct LogRing
+{
+  std::atomic<bool>     inUse;
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> tail;
+  std::atomic<uint32_t> dropped;
+  uint32_t              reportedDropped;
+  uint32_t              capacity;
+  char*                 records;
+  uint16_t*             lengths;
+  LogRing*              next;
+} LogRing;
+
+struct Log::AsyncState
+{
+  std::atomic<bool>     running;
+  std::atomic<LogRing*> rings;
+  std::atomic<uint32_t> ringCapacity;
+  std::atomic<uint64_t> written;
+  std::atomic<uint64_t> dropped;
+  //! Set by the writer before it blocks on wake, loggers post wake if set
+  std::atomic<bool>     sleeping;
+  T_OsdkSemHandle       wake;
+  std::thread           writer;
+};
+
+typedef struct LogRingOwner
+{
+  LogRing* ring;
+  ~LogRingOwner()
+  {
+    if (ring)
+    {
+      ring->inUse.store(false);
+    }
+  }
+} LogRingOwner;
+
+static thread_local LogRingOwner tlsRing = { NULL };
+
+static LogRing*
+claimRing(Log::AsyncState* async)
+{
+  for (LogRing* r = async->rings.load(); r; r = r->next)
+  {
+    bool expected = false;
+    if (r->inUse.compare_exchange_strong(expected, true))
+    {
+      return r;
+    }
+  }
+
+  uint32_t capacity = async->ringCapacity.load();
+  LogRing* r        = new LogRing();
+  r->inUse.store(true);
+  r->head.store(0);
+  r->tail.store(0);
+  r->dropped.store(0);
+  r->reportedDropped = 0;
+  r->capacity        = capacity;
+  r->records         = new char[capacity * LOG_LINE_SIZE];
+  r->lengths         = new uint16_t[capacity];
+
+  r->next = async->rings.load();
+  while (!async->rings.compare_exchange_weak(r->next, r))
+  {
+  }
+  return r;
+}
+
+static bool
+drainRings(Log::AsyncState* async, LogSink* sink)
+{
+  bool any = false;
+  for (LogRing* r = async->rings.load(); r; r = r->next)
+  {
+    uint32_t tail = r->tail.load(std::memory_order_relaxed);
+    // seq_cst, pairs with the loggers checking sleeping after the push
+    uint32_t head = r->head.load();
+    while (tail != head)
+    {
+      uint32_t slot = tail % r->capacity;
+      sink->write(r->records + slot * LOG_LINE_SIZE, r->lengths[slot]);
+      tail++;
+      r->tail.store(tail, std::memory_order_release);
+      async->written++;
+      any = true;
+    }
+
+    uint32_t dropped = r->dropped.load();
+    if (dropped != r->reportedDropped)
+    {
+      char line[64];
+      int  len = snprintf(line, sizeof(line), "[log] %u lines dropped\n",
+                         dropped - r->reportedDropped);
+      sink->write(line, len);
+      r->reportedDropped = dropped;
+      any = true;
+    }
+  }
+  return any;
+}
+#else
+struct Log::AsyncState
+{
+};
+#endif
+
 Log::Log(Mutex* m)
+  : mutex(NULL)
+  , sink(&stdoutSink)
+  , async(NULL)
+  , rateLimit(0)
+  , writtenSync(0)
+  , rateLimitedCount(0)
 {
   if (m)
   {
@@ -50,6 +208,7 @@ Log::Log(Mutex* m)
 
 Log::~Log()
 {
+  setAsyncMode(false);
   delete mutex;
 }
 
@@ -61,19 +220,30 @@ Log::title(int level, const char* prefix, const char* func, int line)
     mutex = new Mutex();
     initFlag = true;
   }
+#ifdef LOG_TITLE_LOCKS
+  mutex->lock();
+#endif
 
-  if (level)
+  uint32_t suppressed = 0;
+  if (level && !rateLimited(func, line, suppressed))
   {
-    vaild = true;
-    mutex->lock();
+    tlsValid = true;
     uint32_t timeMs = 0;
     OsdkOsal_GetTimeMs(&timeMs);
-    printf("[%d.%03d]%s/%d @ %s, L%d: ", timeMs / 1000, timeMs % 1000, prefix, level, func, line);
-    mutex->unlock();
+    if (suppressed)
+    {
+      snprintf(tlsTitle, sizeof(tlsTitle), "[%d.%03d]%s/%d @ %s, L%d (%u suppressed): ",
+               timeMs / 1000, timeMs % 1000, prefix, level, func, line, suppressed);
+    }
+    else
+    {
+      snprintf(tlsTitle, sizeof(tlsTitle), "[%d.%03d]%s/%d @ %s, L%d: ",
+               timeMs / 1000, timeMs % 1000, prefix, level, func, line);
+    }
   }
   else
   {
-    vaild = false;
+    tlsValid = false;
   }
   return *this;
 }
@@ -87,17 +257,18 @@ Log::title(int level, const char* prefix)
     mutex = new Mutex();
     initFlag = true;
   }
+#ifdef LOG_TITLE_LOCKS
+  mutex->lock();
+#endif
 
   if (level)
   {
-    vaild = true;
-    mutex->lock();
-    printf("%s/%d" , prefix, level);
-    mutex->unlock();
+    tlsValid = true;
+    snprintf(tlsTitle, sizeof(tlsTitle), "%s/%d" , prefix, level);
   }
   else
   {
-    vaild = false;
+    tlsValid = false;
   }
   return *this;
 }
@@ -105,49 +276,374 @@ Log::title(int level, const char* prefix)
 Log&
 Log::print()
 {
+#ifdef LOG_TITLE_LOCKS
+  mutex->unlock();
+#endif
   return *this;
 }
 
 Log&
 Log::print(const char* fmt, ...)
 {
-  char log[300] = {0};
+  va_list args;
+  va_start(args, fmt);
+  formatLine(fmt, args);
+  va_end(args);
+#ifdef LOG_TITLE_LOCKS
+  mutex->unlock();
+#endif
+  return *this;
+}
 
+//! For the stream operators, which come without a title() of their own
+void
+Log::append(const char* fmt, ...)
+{
   if(!initFlag)
   {
     mutex = new Mutex();
     initFlag = true;
   }
-  if ((!release) && vaild)
+#ifdef LOG_TITLE_LOCKS
+  mutex->lock();
+#endif
+  va_list args;
+  va_start(args, fmt);
+  formatLine(fmt, args);
+  va_end(args);
+#ifdef LOG_TITLE_LOCKS
+  mutex->unlock();
+#endif
+}
+
+void
+Log::formatLine(const char* fmt, va_list args)
+{
+  if ((!release) && tlsValid)
+  {
+    char   line[LOG_LINE_SIZE];
+    size_t len = strlen(tlsTitle);
+    memcpy(line, tlsTitle, len);
+    tlsTitle[0] = '\0';
+
+    int n = vsnprintf(line + len, sizeof(line) - len - 1, fmt, args);
+    if (n > 0)
+    {
+      len += ((size_t)n < sizeof(line) - len - 1) ? n : sizeof(line) - len - 2;
+    }
+    line[len++] = '\n';
+
+    writeLine(line, len);
+  }
+}
+
+void
+Log::writeLine(const char* line, size_t len)
+{
+#if defined(__linux__)
+  AsyncState* a = async;
+  if (a && a->running.load())
   {
-    va_list args;
-    va_start(args, fmt);
+    if (!tlsRing.ring)
+    {
+      tlsRing.ring = claimRing(a);
+    }
+    LogRing* r    = tlsRing.ring;
+    uint32_t head = r->head.load(std::memory_order_relaxed);
+    uint32_t tail = r->tail.load(std::memory_order_acquire);
+    if (head - tail >= r->capacity)
+    {
+      r->dropped++;
+      a->dropped++;
+      return;
+    }
+    uint32_t slot = head % r->capacity;
+    memcpy(r->records + slot * LOG_LINE_SIZE, line, len);
+    r->lengths[slot] = (uint16_t)len;
+    // seq_cst, pairs with the writer setting sleeping before its last pass
+    r->head.store(head + 1);
+    if (a->sleeping.load() && a->sleeping.exchange(false))
+    {
+      OsdkOsal_SemaphorePost(a->wake);
+    }
+    return;
+  }
+#endif
+
+#ifdef LOG_TITLE_LOCKS
+  // Already held since title()
+  sink->write(line, len);
+  writtenSync++;
+#else
+  mutex->lock();
+  sink->write(line, len);
+  writtenSync++;
+  mutex->unlock();
+#endif
+}
+
+bool
+Log::rateLimited(const char* func, int line, uint32_t& suppressed)
+{
+  uint32_t limit = rateLimit;
+  if (!limit)
+  {
+    return false;
+  }
+
+  uint32_t nowMs = 0;
+  OsdkOsal_GetTimeMs(&nowMs);
+
+  LogSite& site = logSites[(((uintptr_t)func >> 4) ^ (uint32_t)line) % LOG_SITE_NUM];
+  if (site.func != func || site.line != line)
+  {
+    site.func          = func;
+    site.line          = line;
+    site.windowStartMs = nowMs;
+    site.count         = 0;
+    site.suppressed    = 0;
+  }
+  else if (nowMs - site.windowStartMs >= 1000)
+  {
+    site.windowStartMs = nowMs;
+    site.count         = 0;
+  }
+
+  if (site.count++ >= limit)
+  {
+    site.suppressed++;
+    rateLimitedCount++;
+    return true;
+  }
+#if defined(__linux__)
+  suppressed = site.suppressed.exchange(0);
+#else
+  suppressed      = site.suppressed;
+  site.suppressed = 0;
+#endif
+  return false;
+}
+
+bool
+Log::setAsyncMode(bool enable, uint32_t recordsPerThread)
+{
+#if defined(__linux__)
+  if(!initFlag)
+  {
+    mutex = new Mutex();
+    initFlag = true;
+  }
+
+  if (enable)
+  {
+    if (async && async->running.load())
+    {
+      return true;
+    }
+    if (!async)
+    {
+      async = new AsyncState();
+      async->rings.store(NULL);
+      async->written.store(0);
+      async->dropped.store(0);
+      async->sleeping.store(false);
+      if (OsdkOsal_SemaphoreCreate(&async->wake, 0) != OSDK_STAT_OK)
+      {
+        delete async;
+        async = NULL;
+        return false;
+      }
+    }
+    async->ringCapacity.store(recordsPerThread ? recordsPerThread : 1);
+    async->running.store(true);
+    AsyncState* a = async;
+    async->writer = std::thread([this, a]() {
+      while (a->running.load())
+      {
+        // The mutex keeps setSink from swapping the sink under the writer
+        mutex->lock();
+        bool any = drainRings(a, sink);
+        if (!any)
+        {
+          sink->flush();
+          a->sleeping.store(true);
+          // A line pushed before sleeping was set is caught by this pass
+          any = drainRings(a, sink);
+          if (any)
+          {
+            // A logger may have seen sleeping and posted, that only costs
+            // one extra pass later
+            a->sleeping.store(false);
+          }
+        }
+        mutex->unlock();
+
+        if (!any && a->running.load())
+        {
+          OsdkOsal_SemaphoreWait(a->wake);
+        }
+      }
+    });
+    return true;
+  }
+
+  if (async && async->running.load())
+  {
+    async->running.store(false);
+    OsdkOsal_SemaphorePost(async->wake);
+    async->writer.join();
+    // Lines queued after the writer's last pass
     mutex->lock();
-    vsnprintf(log, sizeof(log) - 1, fmt, args);
-    va_end(args);
-    if(log[strlen(log)] != '\n') {
-      printf("%s\n", log);
-    } else {
-      printf("%s", log);
-    };
+    drainRings(async, sink);
+    sink->flush();
     mutex->unlock();
+  }
+  return true;
+#else
+  return !enable;
+#endif
+}
+
+bool
+Log::isAsyncMode()
+{
 #if defined(__linux__)
+  return async && async->running.load();
+#else
+  return false;
+#endif
+}
+
+void
+Log::setSink(LogSink* sink)
+{
+  if(!initFlag)
+  {
+    mutex = new Mutex();
+    initFlag = true;
+  }
+  mutex->lock();
+  this->sink = sink ? sink : &stdoutSink;
+  mutex->unlock();
+}
+
+void
+Log::setRateLimit(uint32_t linesPerSecond)
+{
+  rateLimit = linesPerSecond;
+}
+
+Log::LogStats
+Log::getStats()
+{
+  LogStats stats;
+  stats.written     = writtenSync;
+  stats.dropped     = 0;
+  stats.rateLimited = rateLimitedCount;
+#if defined(__linux__)
+  if (async)
+  {
+    stats.written += async->written.load();
+    stats.dropped = async->dropped.load();
+  }
+#endif
+  return stats;
+}
+
+/*
+ * Sinks
+ */
+
+void
+StdoutLogSink::write(const char* line, size_t len)
+{
+  fwrite(line, 1, len, stdout);
+#if defined(__linux__)
+  // In async mode the writer thread flushes once it runs out of lines
+  if (!Log::instance().isAsyncMode())
+  {
     fflush(stdout);
+  }
 #endif
+}
+
+void
+StdoutLogSink::flush()
+{
+  fflush(stdout);
+}
+
+FileLogSink::FileLogSink(const char* path)
+{
+  file = fopen(path, "a");
+}
+
+FileLogSink::~FileLogSink()
+{
+  if (file)
+  {
+    fclose(file);
   }
-  return *this;
 }
 
+bool
+FileLogSink::isOpen()
+{
+  return file != NULL;
+}
+
+void
+FileLogSink::write(const char* line, size_t len)
+{
+  if (file)
+  {
+    fwrite(line, 1, len, file);
+  }
+}
+
+void
+FileLogSink::flush()
+{
+  if (file)
+  {
+    fflush(file);
+  }
+}
+
+#if defined(__linux__)
+SyslogLogSink::SyslogLogSink(const char* ident, int priority)
+  : priority(priority)
+{
+  openlog(ident, LOG_PID, LOG_USER);
+}
+
+SyslogLogSink::~SyslogLogSink()
+{
+  closelog();
+}
+
+void
+SyslogLogSink::write(const char* line, size_t len)
+{
+  // syslog adds its own line break
+  if (len && line[len - 1] == '\n')
+  {
+    len--;
+  }
+  syslog(priority, "%.*s", (int)len, line);
+}
+#endif
+
 Log&
 Log::operator<<(bool val)
 {
   if (val)
   {
-    print("True");
+    append("True");
   }
   else
   {
-    print("False");
+    append("False");
   }
   return *this;
 }
@@ -156,7 +652,7 @@ Log&
 Log::operator<<(short val)
 {
   // @todo NUMBER_STYLE
-  print("%d", val);
+  append("%d", val);
   return *this;
 }
 
@@ -164,7 +660,7 @@ Log&
 Log::operator<<(uint16_t val)
 {
   // @todo NUMBER_STYLE
-  print("%u", val);
+  append("%u", val);
   return *this;
 }
 
@@ -172,7 +668,7 @@ Log&
 Log::operator<<(int val)
 {
   // @todo NUMBER_STYLE
-  print("%d", val);
+  append("%d", val);
   return *this;
 }
 
@@ -180,7 +676,7 @@ Log&
 Log::operator<<(uint32_t val)
 {
   // @todo NUMBER_STYLE
-  print("%u", val);
+  append("%u", val);
   return *this;
 }
 
@@ -188,7 +684,7 @@ Log&
 Log::operator<<(long val)
 {
   // @todo NUMBER_STYLE
-  print("%ld", val);
+  append("%ld", val);
   return *this;
 }
 
@@ -196,7 +692,7 @@ Log&
 Log::operator<<(unsigned long val)
 {
   // @todo NUMBER_STYLE
-  print("%lu", val);
+  append("%lu", val);
   return *this;
 }
 
@@ -204,7 +700,7 @@ Log&
 Log::operator<<(long long val)
 {
   // @todo NUMBER_STYLE
-  print("%lld", val);
+  append("%lld", val);
   return *this;
 }
 
@@ -212,7 +708,7 @@ Log&
 Log::operator<<(unsigned long long val)
 {
   // @todo NUMBER_STYLE
-  print("%llu", val);
+  append("%llu", val);
   return *this;
 }
 
@@ -220,7 +716,7 @@ Log&
 Log::operator<<(float val)
 {
   // @todo NUMBER_STYLE
-  print("%f", val);
+  append("%f", val);
   return *this;
 }
 
@@ -228,7 +724,7 @@ Log&
 Log::operator<<(double val)
 {
   // @todo NUMBER_STYLE
-  print("%lf", val);
+  append("%lf", val);
   return *this;
 }
 
@@ -236,7 +732,7 @@ Log&
 Log::operator<<(long double val)
 {
   // @todo NUMBER_STYLE
-  print("%Lf", val);
+  append("%Lf", val);
   return *this;
 }
 
@@ -244,14 +740,14 @@ Log&
 Log::operator<<(void* val)
 {
   // @todo NUMBER_STYLE
-  print("ptr:0x%X", val);
+  append("ptr:0x%X", val);
   return *this;
 }
 
 Log&
 Log::operator<<(const char* str)
 {
-  print("%s", str);
+  append("%s", str);
   return *this;
 }
 
@@ -259,7 +755,7 @@ Log&
 Log::operator<<(char c)
 {
   // @todo NUMBER_STYLE
-  print("%c", c);
+  append("%c", c);
   return *this;
 }
 
@@ -267,7 +763,7 @@ Log&
 Log::operator<<(int8_t c)
 {
   // @todo NUMBER_STYLE
-  print("%c", c);
+  append("%c", c);
   return *this;
 }
 
@@ -275,7 +771,7 @@ Log&
 Log::operator<<(uint8_t c)
 {
   // @todo NUMBER_STYLE
-  print("0x%.2X", c);
+  append("0x%.2X", c);
   return *this;
 }
 
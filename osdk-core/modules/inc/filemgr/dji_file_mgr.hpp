@@ -29,6 +29,10 @@
 #ifndef DJI_FILE_MGR_HPP
 #define DJI_FILE_MGR_HPP
 
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include "dji_error.hpp"
 #include "dji_file_mgr_define.hpp"
 #include "osdk_command.h"
@@ -50,10 +54,142 @@ class FileMgr {
   typedef void (*FileDataReqCBType)(E_OsdkStat ret_code, void* userData);
 
   ErrorCode::ErrorCodeType startReqFileList(E_OSDKCommandDeiveType type, uint8_t index, FileListReqCBType cb, void* userData);
+  /*! @brief Refresh the file list from the cached one
+   *
+   *  @details Only the files newer than the newest cached file are
+   *  requested; cb gets the whole list. When the card in the camera does not
+   *  match the cache any more, the full list is requested instead. Deleted
+   *  files stay in the cache until the next startReqFileList.
+   *  @note This relies on the camera taking the index of the file list
+   *  request as the first file to list. From a camera that ignores it the
+   *  list does not start with the newest cached file, so it is thrown away
+   *  and the full list requested: slower than startReqFileList, but right.
+   */
+  ErrorCode::ErrorCodeType startReqFileListIncremental(E_OSDKCommandDeiveType type, uint8_t index, FileListReqCBType cb, void* userData);
   ErrorCode::ErrorCodeType startReqFileData(E_OSDKCommandDeiveType type, uint8_t index, int fileIndex, std::string localPath, FileDataReqCBType cb, void* userData);
 
+  /*! One file of the download queue */
+  typedef struct DownloadItem {
+    E_OSDKCommandDeiveType type;
+    uint8_t index;
+    MediaFile file;
+    std::string localPath;
+    //! Higher priorities are downloaded first, equal ones in queue order
+    int priority;
+  } DownloadItem;
+
+  typedef enum DownloadItemState {
+    DOWNLOAD_ITEM_PENDING,
+    DOWNLOAD_ITEM_ACTIVE,
+    DOWNLOAD_ITEM_DONE,
+    DOWNLOAD_ITEM_FAILED,
+    DOWNLOAD_ITEM_CANCELED,
+  } DownloadItemState;
+
+  typedef struct DownloadItemResult {
+    uint32_t id;
+    DownloadItemState state;
+    int fileIndex;
+    std::string localPath;
+    uint64_t bytes;
+    uint32_t elapsedMs;
+    //! Throughput of this file in kB/s
+    float rate;
+  } DownloadItemResult;
+
+  /*! Counters other than pending and active restart when the queue goes
+   *  from empty to busy
+   */
+  typedef struct DownloadQueueStats {
+    uint32_t pending;
+    uint32_t active;
+    uint32_t done;
+    uint32_t failed;
+    uint32_t canceled;
+    uint64_t bytes;
+    //! Time since the queue went busy, up to when it ran empty
+    uint32_t elapsedMs;
+    //! Aggregate throughput over elapsedMs in kB/s
+    float rate;
+  } DownloadQueueStats;
+
+  typedef void (*DownloadItemCBType)(E_OsdkStat ret_code, const DownloadItemResult &result, void* userData);
+
+  /*! @brief Queue files for download, non-blocking
+   *
+   *  @details Each target device downloads one file at a time and starts the
+   *  next one as soon as the last one is finished; files on different
+   *  devices are downloaded in parallel. cb is called once per file, from
+   *  the receiving thread or the queue thread.
+   *  @param ids Filled with the id of every queued item, may be NULL
+   */
+  ErrorCode::ErrorCodeType enqueueDownloads(const std::vector<DownloadItem> &items, DownloadItemCBType cb, void* userData, std::vector<uint32_t> *ids = NULL);
+
+  bool setDownloadPriority(uint32_t id, int priority);
+
+  /*! Drop a pending item or abort it if it is being downloaded. An aborted
+   *  file keeps its progress and is resumed when queued again.
+   */
+  bool cancelDownload(uint32_t id);
+
+  void cancelAllDownloads();
+
+  DownloadQueueStats getDownloadQueueStats();
+
+  /*! @brief Keep the file lists under dir so they survive a restart
+   *  @details One file per camera, named after its position and hardware
+   *  version. Empty keeps the lists in memory only.
+   */
+  void setFileListCacheDir(const std::string &dir);
+
+  /*! Look-ups in the last file list of a camera, no link traffic */
+  bool getCachedFileList(E_OSDKCommandDeiveType type, uint8_t index, FilePackage &pack);
+  bool findCachedFile(E_OSDKCommandDeiveType type, uint8_t index, int fileIndex, MediaFile &file);
+  bool findCachedFile(E_OSDKCommandDeiveType type, uint8_t index, const std::string &fileName, MediaFile &file);
+  //! Files created in [from, to], oldest first
+  std::vector<MediaFile> findCachedFiles(E_OSDKCommandDeiveType type, uint8_t index, const DateTime &from, const DateTime &to);
+
  private:
-  FileMgrImpl *impl;
+  typedef struct QueueEntry {
+    uint32_t id;
+    uint64_t order;
+    DownloadItem item;
+    DownloadItemCBType cb;
+    void* userData;
+  } QueueEntry;
+
+  typedef struct Target {
+    FileMgr *owner;
+    FileMgrImpl *impl;
+    std::vector<QueueEntry> pending;
+    bool busy;
+    bool cancelActive;
+    QueueEntry active;
+    uint32_t startMs;
+  } Target;
+
+  FileMgrImpl *getImpl(E_OSDKCommandDeiveType type, uint8_t index);
+  Target *getTarget(E_OSDKCommandDeiveType type, uint8_t index);
+  void queueLoop();
+  //! Check period of a target whose impl runs a file list request
+  static const uint32_t WAIT_LIST_MS = 50;
+  void finishEntry(const QueueEntry &entry, DownloadItemState state, E_OsdkStat ret, uint32_t elapsedMs);
+  static void queueFileDataCB(E_OsdkStat ret_code, void* userData);
+
+  Linker *linker;
+  //! One implementation per target device, created on first use
+  std::map<uint16_t, Target *> targets;
+  std::string fileListCacheDir;
+
+  std::mutex queueMutex;
+  std::condition_variable queueCond;
+  std::thread queueThread;
+  bool queueStop;
+  uint32_t nextId;
+  uint64_t nextOrder;
+  DownloadQueueStats stats;
+  uint32_t busySinceMs;
+  bool queueBusy;
 };
 }
 }
@@ -36,6 +36,8 @@
 #include <unistd.h>
 #include <memory>
 #include <atomic>
+#include <mutex>
+#include <vector>
 #include "dji_error.hpp"
 #include "osdk_command.h"
 #include "dji_file_mgr_internal_define.hpp"
@@ -44,6 +46,7 @@
 #include "dji_file_mgr_define.hpp"
 #include "dji_file_mgr.hpp"
 #include "mmap_file_buffer.hpp"
+#include "media_file_index.hpp"
 
 #if 0
 #include "commondatarangehandler.h"
@@ -63,6 +66,17 @@ typedef enum DownloadStateEnum : int {
 // Forward Declaration
 class Linker;
 
+/*! State of the file list parsing, kept between packs */
+typedef struct FileListParser {
+  int state;
+  //! A header or descriptor split over two packs is gathered here
+  uint8_t carry[sizeof(dji_list_info_descriptor)];
+  uint32_t carryLen;
+  //! Bytes of extension data still to skip
+  uint32_t skip;
+  FilePackage pack;
+} FileListParser;
+
 class DownloadListHandler {
  public:
   DownloadListHandler();
@@ -74,6 +88,14 @@ class DownloadListHandler {
   void* reqCBUserData;
   std::atomic<int> downloadState;
   std::atomic<uint32_t> updateTimeMs;
+  //! Session of the running request, the camera answers with it
+  std::atomic<uint16_t> sessionId;
+  FileListParser parser;
+  //! Only the files from anchor on were asked for
+  bool deltaList;
+  MediaFile anchor;
+  //! The delta did not fit the cache, the monitor task asks for the full list
+  std::atomic<bool> restartFull;
 };
 
 class DownloadDataHandler {
@@ -85,10 +107,26 @@ class DownloadDataHandler {
   MmapFileBuffer *mmap_file_buffer_;
   FileMgr::FileDataReqCBType reqCB;
   void* reqCBUserData;
+  //! Callback of the finished request, run once the mutex is released
+  FileMgr::FileDataReqCBType doneCB;
+  void* doneCBUserData;
+  E_OsdkStat doneRet;
   std::atomic<uint32_t> updateTimeMs;
+  //! Session of the running request, the camera answers with it
+  std::atomic<uint16_t> sessionId;
   std::string downloadPath;
   std::atomic<int> downloadState;
   std::atomic<int> curTargetFileIndex;
+  //! Offset the current request starts at, 0 unless resuming
+  uint64_t resumeOffset;
+  //! Size the resumed file had, checked against the camera's answer
+  uint64_t resumeFileSize;
+  int resumeTimes;
+  //! Last time the missed ACKs were sent
+  uint32_t ackTimeMs;
+  std::atomic<bool> monitorRunning;
+  //! Guards the buffer and the range handler between receiving and resuming
+  std::mutex mutex;
 };
 
 class FileMgrImpl {
@@ -98,12 +136,39 @@ class FileMgrImpl {
 
   void setTargetDevice(E_OSDKCommandDeiveType type, uint8_t index);
 
-  ErrorCode::ErrorCodeType startReqFileList(FileMgr::FileListReqCBType cb, void* userData);
+  /*! @param incremental only ask for the files from the newest cached one on,
+   *  the callback still gets the whole list
+   */
+  ErrorCode::ErrorCodeType startReqFileList(FileMgr::FileListReqCBType cb, void* userData,
+                                            bool incremental = false);
   ErrorCode::ErrorCodeType startReqFileData(int fileIndex, std::string localPath, FileMgr::FileDataReqCBType cb, void* userData);
 
   void HandlePushPack(dji_general_transfer_msg_ack *rsp);
-  ErrorCode::ErrorCodeType SendReqFileListPack();
-  ErrorCode::ErrorCodeType SendReqFileDataPack(int fileIndex) ;
+
+  /*! True when no file list or file data request is running */
+  bool isIdle();
+  /*! True when startReqFileData would be accepted, the monitor of the last
+   *  file may still be winding down
+   */
+  bool canStartReqFileData();
+  /*! Abort the running file data request, its callback gets OSDK_STAT_ERR
+   *  @return false if there was none
+   */
+  bool stopReqFileData();
+  uint8_t getTargetDeviceId();
+  /*! The instance a pushed pack from sender belongs to */
+  static FileMgrImpl *findImpl(uint8_t sender);
+  /*! Sent with the session id in fileListHandler, set before arming */
+  ErrorCode::ErrorCodeType SendReqFileListPack(uint32_t startIndex = 1);
+
+  /*! Where the file list is kept between runs, empty to keep it in memory only */
+  void setFileListCacheDir(const std::string &dir);
+  bool getCachedFileList(FilePackage &pack);
+  bool findCachedFile(int fileIndex, MediaFile &file);
+  bool findCachedFile(const std::string &fileName, MediaFile &file);
+  std::vector<MediaFile> findCachedFiles(const DateTime &from, const DateTime &to);
+  /*! Sent with the session id in fileDataHandler, set before arming */
+  ErrorCode::ErrorCodeType SendReqFileDataPack(int fileIndex, uint32_t offset = 0);
 
  private:
   ErrorCode::ErrorCodeType SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE taskId);
@@ -126,6 +191,19 @@ class FileMgrImpl {
   uint8_t index;
   FileNameRule nameRule;
   FileNameRule getNameRule();
+  //! Reported with the name rule, tells the cameras of one index apart
+  std::string hardwareVersion;
+
+  //! The last file list, guarded by cacheMutex
+  MediaFileIndex fileCache;
+  std::mutex cacheMutex;
+  std::string cacheDir;
+  //! The file fileCache was loaded from, empty when not loaded yet
+  std::string cachePath;
+  std::string getCachePath();
+  void loadFileListCache();
+  bool updateFileListCache(FilePackage &pack);
+  void restartFullFileList();
 
  private:
   //typedef void (*FileDataReqCBType)(E_OsdkStat ret_code, dji_general_transfer_msg_ack* ackData);
@@ -135,8 +213,15 @@ class FileMgrImpl {
     uint16_t index;
   } ConsumeDataBuffer;
   ConsumeDataBuffer ConsumeChunk(DataPointer data_pointer, size_t &chunk_index, size_t consumSize);
-  FilePackage parseFileList(std::list<DataPointer> fullDataList);
+  //! Slots of the file list window, each holds one pack
+  static const int FILE_LIST_WINDOW = 512;
+  void feedFileList(const uint8_t *data, size_t len);
+  void resetFileListParser();
+  bool makeMediaFile(const dji_list_info_descriptor *data, MediaFile &file);
   bool parseFileData(dji_general_transfer_msg_ack *rsp);
+  bool resumeReqFileData();
+  void finishReqFileData(E_OsdkStat ret);
+  void notifyReqFileData();
 
  private:
   void OnReceiveAbortPack(dji_general_transfer_msg_ack *rsp);
@@ -153,10 +238,18 @@ class FileMgrImpl {
   uint16_t createNextReqSessionId() {return reqSessionId++;};
   uint16_t getCurReqSessionId() {return reqSessionId;};
   static std::atomic<uint16_t> reqSessionId;
-  T_OsdkTaskHandle reqFileListHandle;
-  T_OsdkTaskHandle reqFileDataHandle;
-  static void fileListMonitorTask(void *arg);
-  static void fileDataMonitorTask(void *arg);
+  //! All instances, the push packs of every camera arrive in one callback
+  static std::mutex instancesMutex;
+  static std::vector<FileMgrImpl *> instances;
+  //! Timer scheduler jobs watching the running requests
+  std::atomic<uint32_t> reqFileListJob;
+  std::atomic<uint32_t> reqFileDataJob;
+  static const uint32_t MONITOR_PERIOD_MS = 50;
+  //! The file data request carries a 32 bit offset
+  static const uint64_t MAX_REQ_OFFSET = 0xFFFFFFFF;
+  static void fileListMonitorTask(void *arg, uint32_t self);
+  static void fileDataMonitorTask(void *arg, uint32_t self);
+  void stopFileDataMonitor(uint32_t self);
   void printFileDownloadStatus();
   //只是用于测试
  private:
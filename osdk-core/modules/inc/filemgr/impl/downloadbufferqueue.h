@@ -34,18 +34,21 @@ public:
   } InsertRetType;
 
     DownloadBufferQueue() = default;
-    virtual ~DownloadBufferQueue() = default;
+    virtual ~DownloadBufferQueue() { Dealloc(); }
 
     DownloadBufferQueue(const DownloadBufferQueue& other) = delete;
     DownloadBufferQueue(DownloadBufferQueue&& other) = delete;
     DownloadBufferQueue& operator=(const DownloadBufferQueue& other) = delete;
     DownloadBufferQueue& operator=(DownloadBufferQueue&& other) = delete;
 
-    bool InitBufferQueue(int size, int start_index);
+    // 所有块预先分配在一整块slab里, InsertBlock不再malloc.
+    // block_size: 单个块的最大长度
+    bool InitBufferQueue(int size, int start_index, int block_size = 1024);
 
     bool FindBlockByIndex(int index);
     InsertRetType InsertBlock(const uint8_t *data, uint32_t data_length, int index, bool flag);
 
+    // 返回的数据指向slab, 在该块被下一轮InsertBlock覆盖前有效
     DataPointer DequeueBuffer();
     std::list<DataPointer> DequeueAllBuffer();
     int GetConfirmSeq();
@@ -61,6 +64,8 @@ private:
     mutable std::mutex m_mutex;
     std::condition_variable m_data_condition;
     DataPointer* m_queue_ptr = nullptr;
+    uint8_t* m_slab = nullptr;
+    int m_block_size = 0;
 
     // 确认收到并缓存最大index
     int m_buf_max_index;
@@ -69,7 +74,7 @@ private:
     // 期待接受的index对应的Buf数组下标
     int m_head;
     // Buffer 的大小
-    int m_size;
+    int m_size = 0;
 };
 }  // namespace OSDK
 
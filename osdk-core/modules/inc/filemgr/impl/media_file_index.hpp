@@ -0,0 +1,87 @@
+/** @file media_file_index.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Cached index of a camera's media file list
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef DJI_MEDIA_FILE_INDEX_HPP
+#define DJI_MEDIA_FILE_INDEX_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "dji_file_mgr_define.hpp"
+
+namespace DJI {
+namespace OSDK {
+
+/*! @brief The media files of one camera, looked up by index, name or time
+ *
+ *  @details Files are kept in fileIndex order. A list fetched again from
+ *  the newest known file on is merged in, and the whole index can be saved
+ *  to and loaded from disk.
+ */
+class MediaFileIndex {
+ public:
+  MediaFileIndex();
+
+  void clear();
+  bool empty() const { return files.empty(); }
+  size_t size() const { return files.size(); }
+
+  //! Replace the content with a full list
+  void assign(const std::vector<MediaFile> &media);
+  //! Add or update the files of a partial list
+  void merge(const std::vector<MediaFile> &media);
+
+  //! The file with the highest fileIndex, false when empty
+  bool newest(MediaFile &file) const;
+
+  bool findByIndex(int fileIndex, MediaFile &file) const;
+  bool findByName(const std::string &name, MediaFile &file) const;
+  //! Files created in [from, to], oldest first
+  std::vector<MediaFile> findByTime(const DateTime &from, const DateTime &to) const;
+
+  const std::vector<MediaFile> &getFiles() const { return files; }
+
+  bool save(const std::string &path) const;
+  bool load(const std::string &path);
+
+ private:
+  static uint64_t timeKey(const DateTime &date);
+  void rebuild();
+
+  //! Sorted by fileIndex
+  std::vector<MediaFile> files;
+  std::unordered_map<std::string, size_t> byName;
+  //! Creation time to position in files
+  std::multimap<uint64_t, size_t> byTime;
+};
+
+}  // namespace OSDK
+}  // namespace DJI
+
+#endif  // DJI_MEDIA_FILE_INDEX_HPP
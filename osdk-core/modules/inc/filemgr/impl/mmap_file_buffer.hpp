@@ -12,9 +12,23 @@
 #include <unistd.h>
 #include <memory>
 #include <atomic>
+#include <string>
+#include <vector>
 
 namespace DJI {
 namespace OSDK {
+
+/*! File backed download buffer.
+ *
+ *  The packets of one download request ("session") are placed by their seq:
+ *  seq 0 holds firstBlockSize bytes at baseOffset, every later seq holds
+ *  blockSize bytes right after it. A bitmap remembers the seqs already
+ *  written, so retransmitted packets are ignored and reordered ones land at
+ *  the right place. Everything before baseOffset is known to be complete.
+ *
+ *  The progress is saved next to the file (<path>.dlmap) so an interrupted
+ *  download can be resumed from firstMissingOffset(), even by a new process.
+ */
 class MmapFileBuffer {
  public:
   MmapFileBuffer();
@@ -24,14 +38,86 @@ class MmapFileBuffer {
   int fd;
   char *fdAddr;
   uint64_t fdAddrSize;
+  //! Bytes of the file received so far
   uint64_t curFilePos;
 
+  /*! Map the file, keeping the content it already has when resuming */
   bool init(std::string path, uint64_t fileSize);
 
+  /*! Unmap the file. The progress file is removed once the file is complete
+   *  and saved otherwise.
+   */
   bool deInit();
 
   bool InsertBlock(const uint8_t *pack, uint32_t data_length, uint64_t index);
 
+  /*! Start a new session at baseOffset, dropping the bitmap of the last one.
+   *  A blockSize of 0 means seq 0 is the only packet.
+   */
+  void setLayout(uint64_t baseOffset, uint32_t firstBlockSize, uint32_t blockSize);
+
+  //! Forget the layout, packets are refused until setLayout is called again
+  void resetLayout();
+
+  bool hasLayout() { return layoutValid; }
+
+  /*! Place the payload of packet seq of the current session.
+   *  @return true if the packet was written or had already been, false if it
+   *  does not fit the layout.
+   */
+  bool insertSeq(uint32_t seq, const uint8_t *data, uint32_t length);
+
+  //! Offset of the first byte not received yet, fdAddrSize when complete
+  uint64_t firstMissingOffset();
+
+  bool isComplete() { return (fd >= 0) && (firstMissingOffset() >= fdAddrSize); }
+
+  //! Flush the mapped data and save the progress file
+  bool sync();
+
+  /*! Read the progress file of path.
+   *  @return the offset to resume from and the file size it belongs to,
+   *  false if there is nothing to resume
+   */
+  static bool loadProgress(const std::string &path, uint64_t &resumeOffset,
+                           uint64_t &fileSize);
+
+  static void removeProgress(const std::string &path);
+
+ private:
+  typedef struct ProgressHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+    uint64_t baseOffset;
+    uint32_t firstBlockSize;
+    uint32_t blockSize;
+    uint32_t blockCount;
+    uint32_t reserved;
+  } ProgressHeader;
+
+  static const uint32_t PROGRESS_MAGIC = 0x504D4C44; // "DLMP"
+  static const uint32_t PROGRESS_VERSION = 1;
+  //! Written back and dropped from the mapping in steps of this size
+  static const uint64_t SYNC_STEP = 8 * 1024 * 1024;
+
+  static std::string progressPath(const std::string &path);
+  static uint64_t missingOffsetOf(const ProgressHeader &header,
+                                  const std::vector<uint8_t> &bitmap);
+  bool saveProgress();
+  uint64_t blockOffset(uint32_t seq);
+  void writeBack(bool wait);
+
+  bool layoutValid;
+  uint64_t baseOffset;
+  uint32_t firstBlockSize;
+  uint32_t blockSize;
+  uint32_t blockCount;
+  std::vector<uint8_t> bitmap;
+  //! Lowest seq whose bit is still clear
+  uint32_t firstMissingSeq;
+  //! End of the range already written back by writeBack
+  uint64_t syncedPos;
 };
 }
 }
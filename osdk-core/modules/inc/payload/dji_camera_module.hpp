@@ -2134,8 +2134,9 @@ class CameraModule : public PayloadBase {
       CaptureParamData& captureParam, int timeout);
 
   CaptureParamData CreateDefCaptureParamData(ShootPhotoMode mode = SINGLE);
-  T_OsdkTaskHandle camModuleHandle;
-  static void camHWInfoTask(void *arg);
+  uint32_t camHWInfoJob;
+  static const uint32_t CAM_HW_INFO_PERIOD_MS = 2000;
+  static void camHWInfoTask(void *arg, uint32_t self);
 }; /* CameraModule camera */
 }  // namespace OSDK
 }  // namespace DJI
@@ -35,27 +35,341 @@
 #include "osdk_command.h"
 #include "osdk_protocol.h"
 #include "dji_internal_command.hpp"
+#include "dji_log.hpp"
 
 using namespace DJI;
 using namespace DJI::OSDK;
 
-FileMgr::FileMgr(Linker *linker) {
-  impl = new FileMgrImpl(linker);
+#define TARGET_KEY(type, index) ((((uint16_t) (type)) << 8) | (index))
+
+const uint32_t FileMgr::WAIT_LIST_MS;
+
+FileMgr::FileMgr(Linker *linker)
+  : linker(linker), queueStop(false), nextId(1), nextOrder(0),
+    busySinceMs(0), queueBusy(false) {
+  stats = DownloadQueueStats();
 }
 
 FileMgr::~FileMgr(){
-  if (impl)delete impl;
+  cancelAllDownloads();
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queueStop = true;
+  }
+  queueCond.notify_all();
+  if (queueThread.joinable()) queueThread.join();
+
+  for (auto &t : targets) {
+    delete t.second->impl;
+    delete t.second;
+  }
+}
+
+FileMgr::Target *FileMgr::getTarget(E_OSDKCommandDeiveType type, uint8_t index) {
+  uint16_t key = TARGET_KEY(type, index);
+  auto it = targets.find(key);
+  if (it != targets.end()) return it->second;
+
+  Target *target = new Target();
+  target->owner = this;
+  target->impl = new FileMgrImpl(linker);
+  target->impl->setTargetDevice(type, index);
+  target->impl->setFileListCacheDir(fileListCacheDir);
+  target->busy = false;
+  target->cancelActive = false;
+  target->startMs = 0;
+  targets[key] = target;
+  return target;
+}
+
+FileMgrImpl *FileMgr::getImpl(E_OSDKCommandDeiveType type, uint8_t index) {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  return getTarget(type, index)->impl;
 }
 
 ErrorCode::ErrorCodeType FileMgr::startReqFileList(E_OSDKCommandDeiveType type,
                           uint8_t index, FileListReqCBType cb, void* userData) {
-  impl->setTargetDevice(type, index);
-  return impl->startReqFileList(cb, userData);
+  return getImpl(type, index)->startReqFileList(cb, userData);
+}
+
+ErrorCode::ErrorCodeType FileMgr::startReqFileListIncremental(E_OSDKCommandDeiveType type,
+                          uint8_t index, FileListReqCBType cb, void* userData) {
+  return getImpl(type, index)->startReqFileList(cb, userData, true);
+}
+
+void FileMgr::setFileListCacheDir(const std::string &dir) {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  fileListCacheDir = dir;
+  for (auto &t : targets) t.second->impl->setFileListCacheDir(dir);
+}
+
+bool FileMgr::getCachedFileList(E_OSDKCommandDeiveType type, uint8_t index,
+                                FilePackage &pack) {
+  return getImpl(type, index)->getCachedFileList(pack);
+}
+
+bool FileMgr::findCachedFile(E_OSDKCommandDeiveType type, uint8_t index,
+                             int fileIndex, MediaFile &file) {
+  return getImpl(type, index)->findCachedFile(fileIndex, file);
+}
+
+bool FileMgr::findCachedFile(E_OSDKCommandDeiveType type, uint8_t index,
+                             const std::string &fileName, MediaFile &file) {
+  return getImpl(type, index)->findCachedFile(fileName, file);
+}
+
+std::vector<MediaFile> FileMgr::findCachedFiles(E_OSDKCommandDeiveType type,
+                                                uint8_t index,
+                                                const DateTime &from,
+                                                const DateTime &to) {
+  return getImpl(type, index)->findCachedFiles(from, to);
 }
 
 ErrorCode::ErrorCodeType FileMgr::startReqFileData(E_OSDKCommandDeiveType type,
                           uint8_t index, int fileIndex, std::string localPath,
                           FileDataReqCBType cb, void* userData) {
-  impl->setTargetDevice(type, index);
-  return impl->startReqFileData(fileIndex, localPath, cb, userData);
+  return getImpl(type, index)->startReqFileData(fileIndex, localPath, cb, userData);
+}
+
+ErrorCode::ErrorCodeType FileMgr::enqueueDownloads(
+    const std::vector<DownloadItem> &items, DownloadItemCBType cb,
+    void* userData, std::vector<uint32_t> *ids) {
+  if (ids) ids->clear();
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (!queueBusy && !items.empty()) {
+      uint32_t curMs = 0;
+      OsdkOsal_GetTimeMs(&curMs);
+      stats = DownloadQueueStats();
+      busySinceMs = curMs;
+      queueBusy = true;
+    }
+    for (auto &item : items) {
+      QueueEntry entry;
+      entry.id = nextId++;
+      entry.order = nextOrder++;
+      entry.item = item;
+      entry.cb = cb;
+      entry.userData = userData;
+      getTarget(item.type, item.index)->pending.push_back(entry);
+      if (ids) ids->push_back(entry.id);
+    }
+    if (!queueThread.joinable()) queueThread = std::thread(&FileMgr::queueLoop, this);
+  }
+  queueCond.notify_all();
+  return ErrorCode::SysCommonErr::Success;
+}
+
+bool FileMgr::setDownloadPriority(uint32_t id, int priority) {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  for (auto &t : targets) {
+    for (auto &entry : t.second->pending) {
+      if (entry.id == id) {
+        entry.item.priority = priority;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool FileMgr::cancelDownload(uint32_t id) {
+  QueueEntry entry;
+  Target *target = NULL;
+  bool pending = false;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (auto &t : targets) {
+      auto &queue = t.second->pending;
+      for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (it->id == id) {
+          entry = *it;
+          queue.erase(it);
+          target = t.second;
+          pending = true;
+          break;
+        }
+      }
+      if (target) break;
+      if (t.second->busy && (t.second->active.id == id)) {
+        t.second->cancelActive = true;
+        target = t.second;
+        break;
+      }
+    }
+  }
+  if (!target) return false;
+
+  if (pending) {
+    finishEntry(entry, DOWNLOAD_ITEM_CANCELED, OSDK_STAT_ERR, 0);
+  } else {
+    /*! Its callback finishes the entry */
+    target->impl->stopReqFileData();
+  }
+  return true;
+}
+
+void FileMgr::cancelAllDownloads() {
+  std::vector<uint32_t> ids;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (auto &t : targets) {
+      for (auto &entry : t.second->pending) ids.push_back(entry.id);
+      if (t.second->busy) ids.push_back(t.second->active.id);
+    }
+  }
+  for (auto id : ids) cancelDownload(id);
+}
+
+FileMgr::DownloadQueueStats FileMgr::getDownloadQueueStats() {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  DownloadQueueStats ret = stats;
+  ret.pending = 0;
+  ret.active = 0;
+  for (auto &t : targets) {
+    ret.pending += t.second->pending.size();
+    if (t.second->busy) ret.active++;
+  }
+  if (queueBusy) {
+    uint32_t curMs = 0;
+    OsdkOsal_GetTimeMs(&curMs);
+    ret.elapsedMs = curMs - busySinceMs;
+  }
+  ret.rate = ret.elapsedMs ? (float) ret.bytes / ret.elapsedMs : 0;
+  return ret;
+}
+
+/*! Runs the item callback, called without queueMutex held */
+void FileMgr::finishEntry(const QueueEntry &entry, DownloadItemState state,
+                          E_OsdkStat ret, uint32_t elapsedMs) {
+  DownloadItemResult result;
+  result.id = entry.id;
+  result.state = state;
+  result.fileIndex = entry.item.file.fileIndex;
+  result.localPath = entry.item.localPath;
+  result.bytes = (state == DOWNLOAD_ITEM_DONE && entry.item.file.fileSize > 0)
+                 ? entry.item.file.fileSize : 0;
+  result.elapsedMs = elapsedMs;
+  result.rate = elapsedMs ? (float) result.bytes / elapsedMs : 0;
+
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    switch (state) {
+      case DOWNLOAD_ITEM_DONE: stats.done++; break;
+      case DOWNLOAD_ITEM_FAILED: stats.failed++; break;
+      case DOWNLOAD_ITEM_CANCELED: stats.canceled++; break;
+      default: break;
+    }
+    stats.bytes += result.bytes;
+  }
+
+  if (state == DOWNLOAD_ITEM_DONE)
+    DSTATUS("Downloaded file %d (%llu bytes) in %u ms, %0.1f kB/s",
+            result.fileIndex, (unsigned long long) result.bytes,
+            result.elapsedMs, result.rate);
+  if (entry.cb) entry.cb(ret, result, entry.userData);
+  queueCond.notify_all();
+}
+
+void FileMgr::queueFileDataCB(E_OsdkStat ret_code, void* userData) {
+  Target *target = (Target *) userData;
+  FileMgr *owner = target->owner;
+  QueueEntry entry;
+  bool canceled = false;
+  uint32_t curMs = 0;
+  OsdkOsal_GetTimeMs(&curMs);
+  {
+    std::lock_guard<std::mutex> lock(owner->queueMutex);
+    entry = target->active;
+    canceled = target->cancelActive;
+    target->busy = false;
+    target->cancelActive = false;
+  }
+
+  DownloadItemState state = canceled ? DOWNLOAD_ITEM_CANCELED
+                          : (ret_code == OSDK_STAT_OK) ? DOWNLOAD_ITEM_DONE
+                          : DOWNLOAD_ITEM_FAILED;
+  owner->finishEntry(entry, state, ret_code, curMs - target->startMs);
+}
+
+/*! Starts the next file of every idle target. Runs until the FileMgr is
+ *  destroyed, sleeping while there is nothing to start.
+ */
+void FileMgr::queueLoop() {
+  std::unique_lock<std::mutex> lock(queueMutex);
+  while (!queueStop) {
+    bool waiting = false;
+    bool working = false;
+    bool started = false;
+    for (auto &t : targets) {
+      Target *target = t.second;
+      if (target->busy) working = true;
+      if (target->busy || target->pending.empty()) continue;
+      /*! Only a file list request holds the impl here, the end of a file
+       *  comes with its callback
+       */
+      if (!target->impl->canStartReqFileData()) {
+        waiting = true;
+        continue;
+      }
+
+      auto next = target->pending.begin();
+      for (auto it = target->pending.begin(); it != target->pending.end(); ++it) {
+        if ((it->item.priority > next->item.priority) ||
+            ((it->item.priority == next->item.priority) && (it->order < next->order)))
+          next = it;
+      }
+      target->active = *next;
+      target->pending.erase(next);
+      target->busy = true;
+      target->cancelActive = false;
+      OsdkOsal_GetTimeMs(&target->startMs);
+      working = true;
+
+      QueueEntry entry = target->active;
+      lock.unlock();
+      ErrorCode::ErrorCodeType ret = target->impl->startReqFileData(
+          entry.item.file.fileIndex, entry.item.localPath,
+          &FileMgr::queueFileDataCB, target);
+      lock.lock();
+      if (ret != ErrorCode::SysCommonErr::Success) {
+        DERROR("Failed to request file %d, error 0x%llx",
+               entry.item.file.fileIndex, (unsigned long long) ret);
+        lock.unlock();
+        /*! Without a running request no callback will finish the entry */
+        if (!target->impl->stopReqFileData()) {
+          lock.lock();
+          bool own = target->busy && (target->active.id == entry.id);
+          target->busy = false;
+          lock.unlock();
+          if (own) finishEntry(entry, DOWNLOAD_ITEM_FAILED, OSDK_STAT_ERR, 0);
+        }
+        lock.lock();
+      }
+      /*! targets may have changed while unlocked */
+      started = true;
+      break;
+    }
+    if (started) continue;
+
+    bool pendingLeft = false;
+    for (auto &t : targets) {
+      if (!t.second->pending.empty()) pendingLeft = true;
+      if (t.second->busy) working = true;
+    }
+    if (!working && !pendingLeft && queueBusy) {
+      uint32_t curMs = 0;
+      OsdkOsal_GetTimeMs(&curMs);
+      stats.elapsedMs = curMs - busySinceMs;
+      queueBusy = false;
+    }
+
+    /*! Every change of the queue notifies, but the end of a file list
+     *  request does not, so a target waiting for one is checked again
+     */
+    if (waiting)
+      queueCond.wait_for(lock, std::chrono::milliseconds(WAIT_LIST_MS));
+    else
+      queueCond.wait(lock);
+  }
 }
@@ -35,12 +35,18 @@
 #include "osdk_protocol.h"
 #include "dji_internal_command.hpp"
 #include "dji_log.hpp"
+#include "dji_timer_scheduler.hpp"
+#include <ctype.h>
 
 using namespace DJI;
 using namespace DJI::OSDK;
 
 #define V1_HEADR_AND_CRC_LEN (11 + 2)
 
+std::atomic<uint16_t> FileMgrImpl::reqSessionId(0);
+std::mutex FileMgrImpl::instancesMutex;
+std::vector<FileMgrImpl *> FileMgrImpl::instances;
+
 E_OsdkStat downloadFileAckCB(struct _CommandHandle *cmdHandle,
                                       const T_CmdInfo *cmdInfo,
                                       const uint8_t *cmdData,
@@ -84,8 +90,9 @@ E_OsdkStat downloadFileAckCB(struct _CommandHandle *cmdHandle,
     /*! 4.Do V1 packet unpacking */
     if (V1_ops.Unpack(NULL, (uint8_t *) (cmdData + usedDataCnt), &V1_info, buffer)
         == OSDK_STAT_OK) {
-      FileMgrImpl *fileMgrImpl = (FileMgrImpl *) userData;
-      fileMgrImpl->HandlePushPack((dji_general_transfer_msg_ack *) buffer);
+      FileMgrImpl *fileMgrImpl = FileMgrImpl::findImpl(V1_info.sender);
+      if (fileMgrImpl)
+        fileMgrImpl->HandlePushPack((dji_general_transfer_msg_ack *) buffer);
       usedDataCnt += (V1_info.dataLen + V1_HEADR_AND_CRC_LEN);
     } else {
       DERROR("V1 unpack failed in downloading.");
@@ -133,42 +140,38 @@ void FileMgrImpl::printFileDownloadStatus() {
           finishPercent, speedMsg, recvPackCnt, lossPackCnt);
 }
 
-void FileMgrImpl::fileListMonitorTask(void *arg) {
-  DSTATUS("OSDK download monitor task created.");
+void FileMgrImpl::fileListMonitorTask(void *arg, uint32_t self) {
   if(arg) {
     uint32_t curTimeMs = 0;
-    uint32_t preTimeMs = 0;
-    uint32_t pollTimeMsInterval = 500;
     uint32_t taskTimeOutMs = 6000;
     FileMgrImpl *impl = (FileMgrImpl *)arg;
+    if (impl->fileListHandler->restartFull) impl->restartFullFileList();
+
+    uint32_t refreshTimeMs = impl->fileListHandler->updateTimeMs;
     OsdkOsal_GetTimeMs(&curTimeMs);
-    impl->fileListHandler->updateTimeMs = curTimeMs;
-    for (;;)
-    {
-      uint32_t refreshTimeMs = impl->fileListHandler->updateTimeMs;
-      OsdkOsal_GetTimeMs(&curTimeMs);
-
-      /*! Task timeout */
-      if (curTimeMs - refreshTimeMs >= taskTimeOutMs) {
-        DSTATUS("curTimeMs:%u refreshTimeMs:%u", curTimeMs, refreshTimeMs);
-        DERROR("downloadMonitorTask timeout!! device type : %d index: %d", impl->type, impl->index);
-
-          if (impl->fileListHandler->downloadState == RECVING_FILE_LIST) {
-            impl->SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_LIST);
-            auto cb = impl->fileListHandler->reqCB;
-            void *udata = impl->fileListHandler->reqCBUserData;
-              FilePackage defaultPack;
-              defaultPack.type = FileType::UNKNOWN;
-              defaultPack.media.clear();
-              if(cb) cb(OSDK_STAT_ERR, defaultPack, udata);
-            DSTATUS("Finish req filelist task cause of timeout, reset downloadState to be DOWNLOAD_IDLE");
-            impl->fileListHandler->downloadState = DOWNLOAD_IDLE;
-          }
-      }
 
-      if (impl->fileListHandler->downloadState == DOWNLOAD_IDLE) return;
+    /*! Task timeout */
+    if (curTimeMs - refreshTimeMs >= taskTimeOutMs) {
+      DSTATUS("curTimeMs:%u refreshTimeMs:%u", curTimeMs, refreshTimeMs);
+      DERROR("downloadMonitorTask timeout!! device type : %d index: %d", impl->type, impl->index);
+
+        if (impl->fileListHandler->downloadState == RECVING_FILE_LIST) {
+          impl->SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_LIST);
+          auto cb = impl->fileListHandler->reqCB;
+          void *udata = impl->fileListHandler->reqCBUserData;
+            FilePackage defaultPack;
+            defaultPack.type = FileType::UNKNOWN;
+            defaultPack.media.clear();
+            if(cb) cb(OSDK_STAT_ERR, defaultPack, udata);
+          DSTATUS("Finish req filelist task cause of timeout, reset downloadState to be DOWNLOAD_IDLE");
+          impl->fileListHandler->downloadState = DOWNLOAD_IDLE;
+        }
+    }
 
-      OsdkOsal_TaskSleepMs(10);
+    if (impl->fileListHandler->downloadState == DOWNLOAD_IDLE) {
+      TimerScheduler::instance().cancel(self, false);
+      uint32_t job = self;
+      impl->reqFileListJob.compare_exchange_strong(job, 0);
     }
   } else {
     DERROR("task run failed because of the invalid"
@@ -177,53 +180,56 @@ void FileMgrImpl::fileListMonitorTask(void *arg) {
 }
 
 
-void FileMgrImpl::fileDataMonitorTask(void *arg) {
-  DSTATUS("OSDK download filedata monitor task created.");
+void FileMgrImpl::fileDataMonitorTask(void *arg, uint32_t self) {
   if(arg) {
     uint32_t curTimeMs = 0;
-    uint32_t preTimeMs = 0;
     uint32_t pollTimeMsInterval = 500;
     uint32_t taskTimeOutMs = 3000;
     FileMgrImpl *impl = (FileMgrImpl *)arg;
+    if (impl->fileDataHandler->downloadState == DOWNLOAD_IDLE) {
+      impl->printFileDownloadStatus();
+      impl->stopFileDataMonitor(self);
+      return;
+    }
+    uint32_t refreshTimeMs = impl->fileDataHandler->updateTimeMs;
     OsdkOsal_GetTimeMs(&curTimeMs);
-    OsdkOsal_GetTimeMs(&preTimeMs);
-    impl->fileDataHandler->updateTimeMs = curTimeMs;
-    for (;;)
-    {
-      if (impl->fileDataHandler->downloadState == DOWNLOAD_IDLE) {
-        impl->printFileDownloadStatus();
-        return;
-      }
-      uint32_t refreshTimeMs = impl->fileDataHandler->updateTimeMs;
-      OsdkOsal_GetTimeMs(&curTimeMs);
-
-      /*! Task timeout */
-      if (curTimeMs - refreshTimeMs >= taskTimeOutMs) {
-        DSTATUS("curTimeMs:%d refreshTimeMs:%d", curTimeMs, refreshTimeMs);
-        DERROR("downloadMonitorTask timeout!! device type : %d index: %d", impl->type, impl->index);
-
-        if (impl->fileDataHandler->downloadState == RECVING_FILE_DATA) {
-          impl->SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_FILE);
-          auto cb = impl->fileDataHandler->reqCB;
-          void *udata = impl->fileDataHandler->reqCBUserData;
-          if (cb) cb(OSDK_STAT_ERR, udata);
-          DSTATUS("Finish req filedata task cause of timeout, reset downloadState to be DOWNLOAD_IDLE");
-          impl->fileDataHandler->downloadState = DOWNLOAD_IDLE;
-        }
-      }
 
-      if (curTimeMs - preTimeMs >=  pollTimeMsInterval)
-      {
-        /*! Here to send the miss ack packs*/
-        if (impl->fileDataHandler->downloadState == RECVING_FILE_DATA) {
-          impl->printFileDownloadStatus();
-          impl->SendMissedAckPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_FILE);
+    /*! Task timeout */
+    if (curTimeMs - refreshTimeMs >= taskTimeOutMs) {
+      DSTATUS("curTimeMs:%d refreshTimeMs:%d", curTimeMs, refreshTimeMs);
+      DERROR("downloadMonitorTask timeout!! device type : %d index: %d", impl->type, impl->index);
+
+      if (impl->fileDataHandler->downloadState == RECVING_FILE_DATA) {
+        /*! Link drop, ask again for what is still missing */
+        if (!impl->resumeReqFileData()) {
+          bool finished = false;
+          {
+            std::lock_guard<std::mutex> lock(impl->fileDataHandler->mutex);
+            if (impl->fileDataHandler->downloadState == RECVING_FILE_DATA) {
+              DSTATUS("Finish req filedata task cause of timeout");
+              /*! Before the callback, which may start the next download */
+              impl->stopFileDataMonitor(self);
+              impl->finishReqFileData(OSDK_STAT_ERR);
+              finished = true;
+            }
+          }
+          if (finished) {
+            impl->notifyReqFileData();
+            return;
+          }
         }
-        preTimeMs = curTimeMs;
       }
+    }
 
-      /*! TODO: with out sleep 100ms, the time will get the same as last time. */
-      OsdkOsal_TaskSleepMs(10);
+    if (curTimeMs - impl->fileDataHandler->ackTimeMs >= pollTimeMsInterval)
+    {
+      /*! Here to send the miss ack packs*/
+      if (impl->fileDataHandler->downloadState == RECVING_FILE_DATA) {
+        std::lock_guard<std::mutex> lock(impl->fileDataHandler->mutex);
+        impl->printFileDownloadStatus();
+        impl->SendMissedAckPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_FILE);
+      }
+      impl->fileDataHandler->ackTimeMs = curTimeMs;
     }
   } else {
     DERROR("task run failed because of the invalid"
@@ -234,9 +240,16 @@ void FileMgrImpl::fileDataMonitorTask(void *arg) {
 FileMgrImpl::FileMgrImpl(Linker *linker) : linker(linker) {
   type = OSDK_COMMAND_DEVICE_TYPE_NONE;
   index = 0;
+  nameRule = UNKNOWN_RULE;
+  reqFileListJob = 0;
+  reqFileDataJob = 0;
   fileListHandler = new DownloadListHandler();
   fileDataHandler = new DownloadDataHandler();
   localSenderId = OSDK_COMMAND_DEVICE_ID(OSDK_COMMAND_DEVICE_TYPE_APP, 0);
+  {
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    instances.push_back(this);
+  }
   static bool registerCBFlag = false;
   if (!registerCBFlag) {
     registerCBFlag = true;
@@ -256,6 +269,17 @@ FileMgrImpl::FileMgrImpl(Linker *linker) : linker(linker) {
 }
 
 FileMgrImpl::~FileMgrImpl(){
+  TimerScheduler::instance().cancel(reqFileListJob);
+  TimerScheduler::instance().cancel(reqFileDataJob);
+  {
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    for (auto it = instances.begin(); it != instances.end(); ++it) {
+      if (*it == this) {
+        instances.erase(it);
+        break;
+      }
+    }
+  }
   if (fileListHandler) {
     delete fileListHandler;
   }
@@ -265,7 +289,7 @@ FileMgrImpl::~FileMgrImpl(){
 }
 
 
-ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileListPack() {
+ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileListPack(uint32_t startIndex) {
   uint8_t reqBuf[1024] = {0};
   dji_general_transfer_msg_req
       *setting = (dji_general_transfer_msg_req *) reqBuf;
@@ -274,12 +298,12 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileListPack() {
   setting->task_id = DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_LIST;
   setting->func_id = DJI_GENERAL_DOWNLOAD_FILE_FUNC_TYPE_REQ;
   setting->msg_flag = 0;
-  setting->session_id = 999;
+  setting->session_id = fileListHandler->sessionId;
   setting->seq = 0;
 
   dji_file_list_download_req reqData = {0};
   reqData.index.drive = 0;
-  reqData.index.index = 1;
+  reqData.index.index = startIndex;
   reqData.count = 0xffff;
   reqData.type = DJI_MEDIA;
   uint32_t reqDataLen =
@@ -320,7 +344,7 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileListPack() {
                                  ErrorCode::CameraCommon, ackData[0]);
 }
 
-ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileDataPack(int fileIndex) {
+ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileDataPack(int fileIndex, uint32_t offset) {
   uint8_t reqBuf[1024] = {0};
   dji_general_transfer_msg_req
       *setting = (dji_general_transfer_msg_req *) reqBuf;
@@ -329,7 +353,7 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileDataPack(int fileIndex) {
   setting->task_id = DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_FILE;
   setting->func_id = DJI_GENERAL_DOWNLOAD_FILE_FUNC_TYPE_REQ;
   setting->msg_flag = 0;
-  setting->session_id = 999;
+  setting->session_id = fileDataHandler->sessionId;
   setting->seq = 0;
 
   dji_file_download_req reqData = {0};
@@ -338,7 +362,7 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileDataPack(int fileIndex) {
   reqData.count = 1;
   reqData.type = DJI_MEDIA;
   reqData.sub_index = 0;
-  reqData.offset = 0;
+  reqData.offset = offset;
   reqData.size = (uint32_t) (-1);
   uint32_t reqDataLen = sizeof(reqData) - sizeof(reqData.ext_sub_index)
       - sizeof(reqData.seg_sub_index);
@@ -374,6 +398,7 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendReqFileDataPack(int fileIndex) {
 void FileMgrImpl::setTargetDevice(E_OSDKCommandDeiveType type, uint8_t index) {
   this->type = type;
   this->index = index;
+  nameRule = UNKNOWN_RULE;
 }
 
 FileMgrImpl::FileNameRule FileMgrImpl::getNameRule() {
@@ -397,6 +422,8 @@ FileMgrImpl::FileNameRule FileMgrImpl::getNameRule() {
 
   if ((linkAck == OSDK_STAT_OK) && (ackInfo.dataLen >= 18)) {
     //3~18 : hardware version
+    hardwareVersion.assign((char *) (ackData + 2),
+                           strnlen((char *) (ackData + 2), 16));
     if (strstr((char *) (ackData + 2), (char *) magicNumberH20) != NULL)
       return H20_RULE;
     else return ORIGIN_RULE;
@@ -405,28 +432,58 @@ FileMgrImpl::FileNameRule FileMgrImpl::getNameRule() {
   }
 }
 
-ErrorCode::ErrorCodeType FileMgrImpl::startReqFileList(FileMgr::FileListReqCBType cb, void* userData) {
+ErrorCode::ErrorCodeType FileMgrImpl::startReqFileList(FileMgr::FileListReqCBType cb, void* userData,
+                                                       bool incremental) {
   if ((fileListHandler->downloadState == DOWNLOAD_IDLE) &&
       (fileDataHandler->downloadState == DOWNLOAD_IDLE)) {
-    nameRule = getNameRule();
+    /*! A full refresh checks the camera again, a delta trusts the last answer */
+    if (!incremental || (nameRule == UNKNOWN_RULE)) nameRule = getNameRule();
+
+    uint32_t startIndex = 1;
+    fileListHandler->deltaList = false;
+    fileListHandler->restartFull = false;
+    if (incremental) {
+      std::lock_guard<std::mutex> lock(cacheMutex);
+      loadFileListCache();
+      /*! The newest known file is asked for again, it tells whether the
+       *  cache still belongs to the card in the camera. This needs the camera
+       *  to start the list at that index; a list starting elsewhere fails
+       *  the anchor check and the full list is requested.
+       */
+      if (fileCache.newest(fileListHandler->anchor)) {
+        fileListHandler->deltaList = true;
+        startIndex = fileListHandler->anchor.fileIndex;
+      }
+    }
+
+    /*! Packs still coming for an earlier request are dropped from here on */
+    fileListHandler->sessionId = createNextReqSessionId();
     fileListHandler->downloadState = RECVING_FILE_LIST;
     if (fileListHandler->download_buffer_) {
-      fileListHandler->download_buffer_->Clear();
-      fileListHandler->download_buffer_->InitBufferQueue(5000, 0); //CSDK 5000
+      /*! The packs are parsed as soon as they are in order, so the window
+       *  only has to cover reordering
+       */
+      if (!fileListHandler->download_buffer_->InitBufferQueue(FILE_LIST_WINDOW, 0))
+        return ErrorCode::SysCommonErr::AllocMemoryFailed;
+      resetFileListParser();
     } else return ErrorCode::SysCommonErr::AllocMemoryFailed;
 
     if (fileListHandler->range_handler_) fileListHandler->range_handler_->DeInit();
     else return ErrorCode::SysCommonErr::AllocMemoryFailed;
 
-    /*! Create file list req task*/
-    OsdkOsal_TaskCreate(&reqFileListHandle,
-                        (void *(*)(void *)) (&fileListMonitorTask),
-                        OSDK_TASK_STACK_SIZE_DEFAULT, this);
+    /*! Watch the request until it is finished */
+    uint32_t curMs = 0;
+    OsdkOsal_GetTimeMs(&curMs);
+    fileListHandler->updateTimeMs = curMs;
+    TimerScheduler::instance().cancel(reqFileListJob);
+    reqFileListJob = TimerScheduler::instance().schedulePeriodic(
+        fileListMonitorTask, this, MONITOR_PERIOD_MS, MONITOR_PERIOD_MS,
+        "fileListMonitor");
 
     fileListHandler->reqCB = cb;
     fileListHandler->reqCBUserData = userData;
 
-    return SendReqFileListPack();
+    return SendReqFileListPack(startIndex);
   } else {
     DERROR("Current state cannot support to do downloading ...");
     return ErrorCode::CameraCommonErr::InvalidState;
@@ -436,12 +493,37 @@ ErrorCode::ErrorCodeType FileMgrImpl::startReqFileList(FileMgr::FileListReqCBTyp
 ErrorCode::ErrorCodeType FileMgrImpl::startReqFileData(int fileIndex, std::string localPath, FileMgr::FileDataReqCBType cb, void* userData) {
   if ((fileListHandler->downloadState == DOWNLOAD_IDLE) &&
     (fileDataHandler->downloadState == DOWNLOAD_IDLE)) {
+    /*! The monitor of the last download may not have seen its end yet */
+    TimerScheduler::instance().cancel(reqFileDataJob.exchange(0));
+    fileDataHandler->monitorRunning = false;
+    /*! Packs still coming for an earlier request are dropped from here on */
+    fileDataHandler->sessionId = createNextReqSessionId();
     fileDataHandler->downloadState = RECVING_FILE_DATA;
 
     fileDataHandler->downloadPath = localPath;
+    fileDataHandler->mmap_file_buffer_->deInit();
     fileDataHandler->mmap_file_buffer_->currentLogFilePath = localPath;
     DSTATUS("currentLogFilePath = %s", localPath.c_str());
 
+    /*! A download of this path that was interrupted goes on where it stopped */
+    uint64_t resumeOffset = 0;
+    uint64_t resumeFileSize = 0;
+    if (MmapFileBuffer::loadProgress(localPath, resumeOffset, resumeFileSize)) {
+      if (resumeOffset > MAX_REQ_OFFSET) {
+        DSTATUS("Cannot resume beyond 4 GB, download the file again");
+        MmapFileBuffer::removeProgress(localPath);
+        resumeOffset = 0;
+        resumeFileSize = 0;
+      } else {
+        DSTATUS("Resume the download at %llu of %llu bytes",
+                (unsigned long long) resumeOffset,
+                (unsigned long long) resumeFileSize);
+      }
+    }
+    fileDataHandler->resumeOffset = resumeOffset;
+    fileDataHandler->resumeFileSize = resumeFileSize;
+    fileDataHandler->resumeTimes = 0;
+
     fileDataHandler->reqCB = cb;
     fileDataHandler->reqCBUserData = userData;
     fileDataHandler->curTargetFileIndex = fileIndex;
@@ -450,12 +532,17 @@ ErrorCode::ErrorCodeType FileMgrImpl::startReqFileData(int fileIndex, std::strin
     fileDataHandler->range_handler_ = new CommonDataRangeHandler();
     if (!fileDataHandler->range_handler_) return ErrorCode::SysCommonErr::AllocMemoryFailed;
 
-    /*! Create file data req task */
-    OsdkOsal_TaskCreate(&reqFileDataHandle,
-                        (void *(*)(void *)) (&fileDataMonitorTask),
-                        OSDK_TASK_STACK_SIZE_DEFAULT, this);
-
-    return SendReqFileDataPack(fileIndex);
+    /*! Watch the download until it is finished */
+    uint32_t curMs = 0;
+    OsdkOsal_GetTimeMs(&curMs);
+    fileDataHandler->updateTimeMs = curMs;
+    fileDataHandler->ackTimeMs = curMs;
+    fileDataHandler->monitorRunning = true;
+    reqFileDataJob = TimerScheduler::instance().schedulePeriodic(
+        fileDataMonitorTask, this, MONITOR_PERIOD_MS, MONITOR_PERIOD_MS,
+        "fileDataMonitor");
+
+    return SendReqFileDataPack(fileIndex, (uint32_t) resumeOffset);
   } else {
     DERROR("Current state cannot support to do downloading ...");
     return ErrorCode::CameraCommonErr::InvalidState;
@@ -577,171 +664,176 @@ std::string FileMgrImpl::GetSuffixByFileType(MediaFileType type) {
   return unsupportFileName;
 }
 
-FilePackage FileMgrImpl::parseFileList(std::list<DataPointer> fullDataList) {
-  const uint32_t maxDataFrameLen = 1024; //link data frame max size
-  size_t chunk_index = 0;
-  FilePackage pack;
-  pack.type = FileType::UNKNOWN;
-  //pack.common.clear();
-  pack.media.clear();
-  if (fullDataList.size() == 0) return pack;
-  auto dataFront = fullDataList.front();
-  if (dataFront.length < (sizeof(dji_general_transfer_msg_ack) - 1
-      + sizeof(dji_file_list_download_resp) - sizeof(dji_list_info_descriptor)))
-    return pack;
-
-  /*! Parse file list total info */
-  auto listdata = (dji_file_list_download_resp *)((uint8_t *)dataFront.data + sizeof(dji_general_transfer_msg_ack) - 1);
-  DSTATUS("###data->amount = %d, data->len = %d", listdata->amount, listdata->len);
-  if (listdata->len > fullDataList.size() * maxDataFrameLen) {
-    DERROR("File list total data len error !");
-    return pack;
+/*! Build the MediaFile of one list descriptor.
+ *  @return false for the entries the old parser dropped as well
+ */
+bool FileMgrImpl::makeMediaFile(const dji_list_info_descriptor *data, MediaFile &file) {
+  /*! 构建file信息,装入容器 */
+  file = MediaFile();
+  file.valid = true;
+  file.date.year = data->create_time.year + 1980;
+  file.date.month = data->create_time.month;
+  file.date.day = data->create_time.day;
+  file.date.hour = data->create_time.hour;
+  file.date.minute = data->create_time.minute;
+  file.date.second = data->create_time.second * 2;
+  file.fileIndex = data->index;
+  file.fileSize = data->size;
+  file.fileType = (MediaFileType) data->type;
+  if ((data->type == (uint8_t) MediaFileType::MOV)
+      || (data->type == (uint8_t) MediaFileType::MP4)) {
+    file.duration =
+        data->attribute.video_attribute.attribute_video_duration;
+    file.orientation =
+        (CameraOrientation) data->attribute.video_attribute.attribute_video_rotation;
+    file.resolution =
+        (VideoResolution) data->attribute.video_attribute.attribute_video_resolution;
+    file.frameRate =
+        (VideoFrameRate) data->attribute.video_attribute.attribute_video_framerate;
+  } else if ((data->type == (uint8_t) MediaFileType::JPEG)
+      || (data->type == (uint8_t) MediaFileType::DNG)
+      || (data->type == (uint8_t) MediaFileType::TIFF)) {
+    file.orientation =
+        (CameraOrientation) data->attribute.photo_attribute.attribute_photo_rotation;
+    file.photoRatio =
+        (PhotoRatio) data->attribute.photo_attribute.attribute_photo_ratio;
   }
+  file.fileName = GetFileName(file);
 
-  /*! Make the total data buffer */
-  DataPointer dataPtr = {malloc(listdata->len), 0};
-  if (!dataPtr.data) {
-    DERROR("Malloc error !");
-    return pack;
-  }
-  while (fullDataList.size() != 0) {
-    auto f = fullDataList.front();
-    auto pack = (dji_general_transfer_msg_ack *)(f.data);
-    int cpSize = pack->msg_length - sizeof(dji_general_transfer_msg_ack) + 1;
-
-    memcpy((uint8_t *) dataPtr.data + dataPtr.length, pack->data, cpSize);
-    dataPtr.length += cpSize;
-    fullDataList.pop_front();
+  bool validFlagBasic = true;
+  bool validFlagNew = true;
+  if (nameRule == H20_RULE) {
+    if ((GetSuffixByFileType(file.fileType) != unsupportFileName) &&
+        (GetFileCameraType(file.fileIndex)
+            != unsupportFileCameraType))
+      validFlagNew = true;
+    else
+      validFlagNew = false;
   }
 
-  /*! Parsing dataPtr */
-  ParsingFileListStateEnum parsingState = PARSING_TOTAL_HEADER;
-    while (parsingState != PARSE_FINISH) {
-      switch (parsingState) {
-        case PARSING_TOTAL_HEADER: {
-          /*! dataPtr skip it */
-          parsingState = PARSING_DATA_HEADER;
-          break;
-        }
-        case PARSING_DATA_HEADER: {
-          uint32_t consumeBytes = sizeof(dji_file_list_download_resp)
-              - sizeof(dji_list_info_descriptor);
-          auto buffer = ConsumeChunk(dataPtr, chunk_index, consumeBytes);
-          if (buffer.index == consumeBytes) {
-            parsingState = PARSING_FILEINFO;
-          } else {
-            parsingState = PARSE_FINISH;
-          }
-          break;
-        }
-        case PARSING_FILEINFO: {
-          uint32_t consumeBytes =
-              sizeof(dji_list_info_descriptor) - sizeof(dji_file_list_ext_info);
-          auto buffer = ConsumeChunk(dataPtr, chunk_index, consumeBytes);
-          if (buffer.index == consumeBytes) {
-            if (pack.type == FileType::UNKNOWN)pack.type = FileType::MEDIA;
-            auto data = (dji_list_info_descriptor *) (buffer.data);
-            //DSTATUS("data->index = %d, data->size = %d", data->index, data->size);
-            /*! 构建file信息,装入容器 */
-            MediaFile file = {0};
-            file.valid = true;
-            file.date.year = data->create_time.year + 1980;
-            file.date.month = data->create_time.month;
-            file.date.day = data->create_time.day;
-            file.date.hour = data->create_time.hour;
-            file.date.minute = data->create_time.minute;
-            file.date.second = data->create_time.second * 2;
-            file.fileIndex = data->index;
-            file.fileSize = data->size;
-            file.fileType = (MediaFileType) data->type;
-            if ((data->type == (uint8_t) MediaFileType::MOV)
-                || (data->type == (uint8_t) MediaFileType::MP4)) {
-              file.duration =
-                  data->attribute.video_attribute.attribute_video_duration;
-              file.orientation =
-                  (CameraOrientation) data->attribute.video_attribute.attribute_video_rotation;
-              file.resolution =
-                  (VideoResolution) data->attribute.video_attribute.attribute_video_resolution;
-              file.frameRate =
-                  (VideoFrameRate) data->attribute.video_attribute.attribute_video_framerate;
-            } else if ((data->type == (uint8_t) MediaFileType::JPEG)
-                || (data->type == (uint8_t) MediaFileType::DNG)
-                || (data->type == (uint8_t) MediaFileType::TIFF)) {
-              file.orientation =
-                  (CameraOrientation) data->attribute.photo_attribute.attribute_photo_rotation;
-              file.photoRatio =
-                  (PhotoRatio) data->attribute.photo_attribute.attribute_photo_ratio;
-            }
-            file.fileName = GetFileName(file);
-
-            bool validFlagBasic = true;
-            bool validFlagNew = true;
-            if (nameRule == H20_RULE) {
-              if ((GetSuffixByFileType(file.fileType) != unsupportFileName) &&
-                  (GetFileCameraType(file.fileIndex)
-                      != unsupportFileCameraType))
-                validFlagNew = true;
-              else
-                validFlagNew = false;
-            }
+  if ((file.valid)
+      && (file.fileSize > 0))// && (file.date.year != 1980))
+    validFlagBasic = true;
+  else
+    validFlagBasic = false;
 
-            if ((file.valid)
-                && (file.fileSize > 0))// && (file.date.year != 1980))
-              validFlagBasic = true;
-            else
-              validFlagBasic = false;
-
-            if (validFlagNew && validFlagBasic)
-              pack.media.push_back(file);
-
-            /*! 这部分消耗了就算了,目前不解析 */
-            if (data->ext_size) {
-              auto extBuffer =
-                  ConsumeChunk(dataPtr, chunk_index, data->ext_size);
-              //auto extData = (dji_ext_info_descriptor *) (extBuffer.data);
-              //DSTATUS("extData->id = %d, %s", extData->id, extData->data);
-            }
-            parsingState = PARSING_FILEINFO;
-          } else {
-            //DSTATUS("---chunk_index = %d", chunk_index);
-            parsingState = PARSE_FINISH;
-          }
-          break;
-        }
-        case PARSE_FINISH:
-          break;
-        default:break;
-      }
+  return validFlagNew && validFlagBasic;
+}
+
+/*! Parse the file list as its packs come in, in order. Descriptors are
+ *  read in place; only one that straddles two packs is copied, into the
+ *  small carry buffer.
+ */
+void FileMgrImpl::feedFileList(const uint8_t *data, size_t len) {
+  FileListParser &p = fileListHandler->parser;
+  const uint32_t headerSize = sizeof(dji_file_list_download_resp) - sizeof(dji_list_info_descriptor);
+  const uint32_t infoSize = sizeof(dji_list_info_descriptor) - sizeof(dji_file_list_ext_info);
+
+  while (len) {
+    if (p.skip) {
+      size_t n = (len < p.skip) ? len : p.skip;
+      data += n;
+      len -= n;
+      p.skip -= n;
+      continue;
+    }
+
+    uint32_t need = (p.state == PARSING_DATA_HEADER) ? headerSize : infoSize;
+    const uint8_t *record = NULL;
+    if (p.carryLen == 0 && len >= need) {
+      record = data;
+      data += need;
+      len -= need;
+    } else {
+      size_t n = need - p.carryLen;
+      if (n > len) n = len;
+      memcpy(p.carry + p.carryLen, data, n);
+      p.carryLen += n;
+      data += n;
+      len -= n;
+      if (p.carryLen < need) break;
+      record = p.carry;
+      p.carryLen = 0;
     }
-  free(dataPtr.data);
-  return pack;
+
+    if (p.state == PARSING_DATA_HEADER) {
+      auto listdata = (const dji_file_list_download_resp *) record;
+      DSTATUS("###data->amount = %d, data->len = %d", listdata->amount, listdata->len);
+      p.pack.media.reserve(listdata->amount < 65536 ? listdata->amount : 65536);
+      p.state = PARSING_FILEINFO;
+    } else {
+      auto info = (const dji_list_info_descriptor *) record;
+      if (p.pack.type == FileType::UNKNOWN) p.pack.type = FileType::MEDIA;
+      MediaFile file;
+      if (makeMediaFile(info, file)) p.pack.media.push_back(file);
+      /*! 这部分消耗了就算了,目前不解析 */
+      p.skip = info->ext_size;
+    }
+  }
+}
+
+void FileMgrImpl::resetFileListParser() {
+  FileListParser &p = fileListHandler->parser;
+  p.state = PARSING_DATA_HEADER;
+  p.carryLen = 0;
+  p.skip = 0;
+  p.pack.type = FileType::UNKNOWN;
+  p.pack.media.clear();
 }
 
 #define SIZE_LIMIT 0
+/*! Place one data pack in the file by its seq.
+ *  @return false if the pack could not be used and has to be sent again
+ */
 bool FileMgrImpl::parseFileData(dji_general_transfer_msg_ack *rsp) {
   MmapFileBuffer *mfile = fileDataHandler->mmap_file_buffer_;
+  /*! 本包数据总大小计算 */
+  uint32_t data_size = rsp->msg_length;
+  data_size -= sizeof(dji_general_transfer_msg_ack) - sizeof(uint8_t);
+
   if (rsp->seq == 0) {
     /*! 1. 是第一包,parse文件大小 */
     auto resp = (dji_file_data_download_resp *) (rsp->data);
-    /*! 2. 文件总大小计算 */
-    uint32_t file_size = resp->size - (sizeof(dji_file_data_download_resp) - sizeof(uint8_t));
-    mfile->init(fileDataHandler->downloadPath, file_size);
-    /*! 3. 本包数据总大小计算 */
-    uint32_t data_size = rsp->msg_length;
-    data_size -= sizeof(dji_general_transfer_msg_ack) - sizeof(uint8_t);
-    data_size -= sizeof(dji_file_data_download_resp) - sizeof(uint8_t);
-    if (mfile->InsertBlock(resp->file_data, data_size, mfile->curFilePos))
-      mfile->curFilePos += data_size;
-  }
-  else
-  {
-    /*! 1. 本包数据总大小计算 */
-    uint32_t data_size = rsp->msg_length;
-    data_size -= sizeof(dji_general_transfer_msg_ack) - sizeof(uint8_t);
-    if (mfile->InsertBlock(rsp->data, data_size, mfile->curFilePos))
-      mfile->curFilePos += data_size;
+    uint32_t resp_size = sizeof(dji_file_data_download_resp) - sizeof(uint8_t);
+    data_size -= resp_size;
+    if (mfile->hasLayout()) {
+      return mfile->insertSeq(0, resp->file_data, data_size);
+    }
+
+    /*! 2. 文件总大小计算, the camera counts from the requested offset */
+    uint64_t offset = fileDataHandler->resumeOffset;
+    uint64_t file_size = offset + resp->size - resp_size;
+    if (mfile->fd < 0) {
+      if (offset && (file_size != fileDataHandler->resumeFileSize)) {
+        DERROR("File changed since the interrupted download, restart it from the beginning");
+        MmapFileBuffer::removeProgress(fileDataHandler->downloadPath);
+        finishReqFileData(OSDK_STAT_SYS_ERR);
+        return false;
+      }
+      if (!mfile->init(fileDataHandler->downloadPath, file_size)) {
+        finishReqFileData(OSDK_STAT_SYS_ERR);
+        return false;
+      }
+    } else if (file_size != mfile->fdAddrSize) {
+      DERROR("Resumed file size %llu differs from %llu",
+             (unsigned long long) file_size,
+             (unsigned long long) mfile->fdAddrSize);
+      finishReqFileData(OSDK_STAT_SYS_ERR);
+      return false;
+    }
+
+    /*! 3. All but the last pack are as long as this one without the
+     *  response header
+     */
+    uint32_t block_size = (rsp->msg_flag & 0x01) ? 0 : data_size + resp_size;
+    mfile->setLayout(offset, data_size, block_size);
+    return mfile->insertSeq(0, resp->file_data, data_size);
   }
 
+  /*! Packs overtaking the first one cannot be placed yet */
+  if (!mfile->hasLayout()) return false;
+  return mfile->insertSeq(rsp->seq, rsp->data, data_size);
+
 #if 0
     size_t chunk_index = 0;
   ParsingFileListStateEnum parsingState = PARSING_TOTAL_HEADER;
@@ -818,18 +910,35 @@ bool FileMgrImpl::parseFileData(dji_general_transfer_msg_ack *rsp) {
     }
   }
 #endif
-
-  return false;
 }
 
 void FileMgrImpl::fileListRawDataCB(dji_general_transfer_msg_ack *rsp) {
   int temp = fileListHandler->downloadState;
   if (fileListHandler->downloadState == DOWNLOAD_IDLE) return;
+  if (fileListHandler->restartFull) return;
+  /*! Left over from an aborted or restarted request */
+  if (rsp->session_id != fileListHandler->sessionId) return;
     auto download_buffer_ = fileListHandler->download_buffer_;
     auto range_handler_ = fileListHandler->range_handler_;
     if (download_buffer_ && range_handler_) {
-      download_buffer_->InsertBlock((const uint8_t *) rsp, rsp->msg_length, rsp->seq, true);
-      range_handler_->AddSeqIndex(rsp->seq, download_buffer_->GetConfirmSeq(), download_buffer_->GetSize());
+      /*! A pack that is not kept, e.g. larger than a block, stays missing
+       *  and is asked for again
+       */
+      DownloadBufferQueue::InsertRetType inserted =
+          download_buffer_->InsertBlock((const uint8_t *) rsp, rsp->msg_length, rsp->seq, true);
+      if ((inserted == DownloadBufferQueue::INSERT_SUCCESS) ||
+          (inserted == DownloadBufferQueue::INSERT_SUCCESS_FULL)) {
+        range_handler_->AddSeqIndex(rsp->seq, download_buffer_->GetConfirmSeq(), download_buffer_->GetSize());
+      } else if (inserted == DownloadBufferQueue::INSERT_FAIL_INVALID_PARAM) {
+        DERROR("Drop file list pack %d of %d bytes", (int) rsp->seq, (int) rsp->msg_length);
+      }
+
+      /*! 边收边解包, the packs now in order free their slots right away */
+      DataPointer block;
+      while ((block = download_buffer_->DequeueBuffer()).data != nullptr) {
+        auto pack = (dji_general_transfer_msg_ack *) block.data;
+        feedFileList(pack->data, pack->msg_length - (sizeof(dji_general_transfer_msg_ack) - 1));
+      }
     }
 
     /*! refresh the time stamp */
@@ -842,10 +951,16 @@ void FileMgrImpl::fileListRawDataCB(dji_general_transfer_msg_ack *rsp) {
     if ((rsp->msg_flag & 0x01)
     && (range_handler_->GetLastNotReceiveSeq() == rsp->seq + 1)
     && (range_handler_->GetNoAckRanges().size() == 0)) {
-      std::list<DataPointer> dataList = download_buffer_->DequeueAllBuffer();
-      FilePackage file_package = parseFileList(dataList);
+      FilePackage file_package;
+      file_package.type = fileListHandler->parser.pack.type;
+      file_package.media.swap(fileListHandler->parser.pack.media);
 
       SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_LIST);
+      if (!updateFileListCache(file_package)) {
+        /*! No sendSync from the receive thread, the monitor task asks again */
+        fileListHandler->restartFull = true;
+        return;
+      }
       if (fileListHandler->reqCB) {
         fileListHandler->reqCB(OSDK_STAT_OK, file_package, fileListHandler->reqCBUserData);
         fileListHandler->reqCB = NULL;
@@ -856,46 +971,270 @@ void FileMgrImpl::fileListRawDataCB(dji_general_transfer_msg_ack *rsp) {
     }
 }
 
+void FileMgrImpl::restartFullFileList() {
+  DSTATUS("The cached file list is out of date, requesting the full list");
+  fileListHandler->download_buffer_->InitBufferQueue(FILE_LIST_WINDOW, 0);
+  fileListHandler->range_handler_->DeInit();
+  resetFileListParser();
+  fileListHandler->deltaList = false;
+
+  uint32_t curMs = 0;
+  OsdkOsal_GetTimeMs(&curMs);
+  fileListHandler->updateTimeMs = curMs;
+  /*! Packs of the delta may still come after its abort, they must not
+   *  reach the new parser once restartFull lets packs in again
+   */
+  fileListHandler->sessionId = createNextReqSessionId();
+  fileListHandler->restartFull = false;
+
+  if (SendReqFileListPack() != ErrorCode::SysCommonErr::Success) {
+    DERROR("Request the full file list failed");
+    SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_LIST);
+    FilePackage defaultPack;
+    defaultPack.type = FileType::UNKNOWN;
+    if (fileListHandler->reqCB)
+      fileListHandler->reqCB(OSDK_STAT_ERR, defaultPack, fileListHandler->reqCBUserData);
+    fileListHandler->reqCB = NULL;
+    fileListHandler->downloadState = DOWNLOAD_IDLE;
+  }
+}
+
+std::string FileMgrImpl::getCachePath() {
+  if (cacheDir.empty()) return std::string();
+
+  /*! The list is only valid for the camera it came from */
+  std::string hw;
+  for (auto c : hardwareVersion)
+    hw.push_back(isalnum((unsigned char) c) ? c : '_');
+  if (hw.empty()) hw = "unknown";
+
+  char name[64] = {0};
+  snprintf(name, sizeof(name), "/filelist_%d_%d_", (int) type, (int) index);
+  return cacheDir + name + hw + ".idx";
+}
+
+void FileMgrImpl::loadFileListCache() {
+  std::string path = getCachePath();
+  if (path.empty() || (path == cachePath)) return;
+
+  cachePath = path;
+  if (fileCache.load(path))
+    DSTATUS("Loaded %d cached files from %s", (int) fileCache.size(), path.c_str());
+  else
+    fileCache.clear();
+}
+
+bool FileMgrImpl::updateFileListCache(FilePackage &pack) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (fileListHandler->deltaList) {
+    /*! The first file must be the anchor unchanged, otherwise the card was
+     *  swapped or formatted since the cache was made
+     */
+    const MediaFile &anchor = fileListHandler->anchor;
+    if (pack.media.empty()) return false;
+    const MediaFile &first = pack.media.front();
+    if ((first.fileIndex != anchor.fileIndex) ||
+        (first.fileSize != anchor.fileSize) ||
+        (first.date.year != anchor.date.year) ||
+        (first.date.month != anchor.date.month) ||
+        (first.date.day != anchor.date.day) ||
+        (first.date.hour != anchor.date.hour) ||
+        (first.date.minute != anchor.date.minute) ||
+        (first.date.second != anchor.date.second))
+      return false;
+
+    DSTATUS("File list delta : %d new files", (int) pack.media.size() - 1);
+    fileCache.merge(pack.media);
+    pack.media = fileCache.getFiles();
+  } else {
+    fileCache.assign(pack.media);
+  }
+
+  cachePath = getCachePath();
+  if (!cachePath.empty() && !fileCache.save(cachePath))
+    DERROR("Save the file list to %s failed", cachePath.c_str());
+  return true;
+}
+
+void FileMgrImpl::setFileListCacheDir(const std::string &dir) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  cacheDir = dir;
+  cachePath.clear();
+}
+
+bool FileMgrImpl::getCachedFileList(FilePackage &pack) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  loadFileListCache();
+  if (fileCache.empty()) return false;
+  pack.type = FileType::MEDIA;
+  pack.media = fileCache.getFiles();
+  return true;
+}
+
+bool FileMgrImpl::findCachedFile(int fileIndex, MediaFile &file) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  loadFileListCache();
+  return fileCache.findByIndex(fileIndex, file);
+}
+
+bool FileMgrImpl::findCachedFile(const std::string &fileName, MediaFile &file) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  loadFileListCache();
+  return fileCache.findByName(fileName, file);
+}
+
+std::vector<MediaFile> FileMgrImpl::findCachedFiles(const DateTime &from, const DateTime &to) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  loadFileListCache();
+  return fileCache.findByTime(from, to);
+}
+
 void FileMgrImpl::fileDataRawDataCB(dji_general_transfer_msg_ack *rsp) {
-  if (fileDataHandler->downloadState == DOWNLOAD_IDLE) return;
-  auto range_handler_ = fileDataHandler->range_handler_;
-  auto mmap_file_buffer_ = fileDataHandler->mmap_file_buffer_;
-  if (range_handler_) {
-    range_handler_->AddSeqIndex(rsp->seq, 0, (uint32_t)(-1));
+  {
+    std::lock_guard<std::mutex> lock(fileDataHandler->mutex);
+    if (fileDataHandler->downloadState == DOWNLOAD_IDLE) return;
+    /*! Left over from an aborted or resumed request */
+    if (rsp->session_id != fileDataHandler->sessionId) return;
+    auto range_handler_ = fileDataHandler->range_handler_;
+    auto mmap_file_buffer_ = fileDataHandler->mmap_file_buffer_;
+
+    /*! refresh the time stamp */
+    uint32_t curMs = 0;
+    OsdkOsal_GetTimeMs(&curMs);
+    fileDataHandler->updateTimeMs = curMs;
+
+    /*! do data parsing, 边收边解包. Packs that could not be placed stay
+     *  missing, the monitor task asks for them again.
+     */
+    if (parseFileData(rsp) && range_handler_) {
+      range_handler_->AddSeqIndex(rsp->seq, 0, (uint32_t)(-1));
+    }
+
+    /*! 看看是否收完了, whatever order the packs came in */
+    if ((fileDataHandler->downloadState != DOWNLOAD_IDLE) &&
+        mmap_file_buffer_->isComplete()) {
+      DSTATUS("Got all the packs .");
+      finishReqFileData(OSDK_STAT_OK);
+    }
   }
+  notifyReqFileData();
+}
+
+/*! Start a new request at the first byte still missing. Called with the link
+ *  quiet for a while; gives up when the last attempt brought nothing.
+ */
+bool FileMgrImpl::resumeReqFileData() {
+  static const int MAX_RESUME_TIMES = 5;
+  uint64_t offset = 0;
+  {
+    std::lock_guard<std::mutex> lock(fileDataHandler->mutex);
+    if (fileDataHandler->downloadState != RECVING_FILE_DATA) return true;
+    MmapFileBuffer *mfile = fileDataHandler->mmap_file_buffer_;
+    if (mfile->fd < 0) return false;
+
+    offset = mfile->firstMissingOffset();
+    if ((offset <= fileDataHandler->resumeOffset) ||
+        (offset > MAX_REQ_OFFSET) ||
+        (fileDataHandler->resumeTimes >= MAX_RESUME_TIMES))
+      return false;
+
+    SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_FILE);
+    /*! Late packs of the aborted request would land at the offsets of the
+     *  new one, so they are dropped before the layout is reset
+     */
+    fileDataHandler->sessionId = createNextReqSessionId();
+    mfile->sync();
+    mfile->resetLayout();
+    fileDataHandler->range_handler_->DeInit();
+    fileDataHandler->resumeOffset = offset;
+    fileDataHandler->resumeTimes++;
+  }
+
+  DSTATUS("Resume the download at %llu of %llu bytes (%d)",
+          (unsigned long long) offset,
+          (unsigned long long) fileDataHandler->mmap_file_buffer_->fdAddrSize,
+          fileDataHandler->resumeTimes);
+  SendReqFileDataPack(fileDataHandler->curTargetFileIndex, (uint32_t) offset);
 
-  /*! refresh the time stamp */
   uint32_t curMs = 0;
   OsdkOsal_GetTimeMs(&curMs);
   fileDataHandler->updateTimeMs = curMs;
+  return true;
+}
+
+bool FileMgrImpl::isIdle() {
+  return (fileListHandler->downloadState == DOWNLOAD_IDLE) &&
+         (fileDataHandler->downloadState == DOWNLOAD_IDLE) &&
+         !fileDataHandler->monitorRunning;
+}
+
+bool FileMgrImpl::canStartReqFileData() {
+  return (fileListHandler->downloadState == DOWNLOAD_IDLE) &&
+         (fileDataHandler->downloadState == DOWNLOAD_IDLE);
+}
 
-  /*! do data parsing, 边收边解包 */
-  parseFileData(rsp);
+/*! Called by the data monitor job to end itself */
+void FileMgrImpl::stopFileDataMonitor(uint32_t self) {
+  TimerScheduler::instance().cancel(self, false);
+  uint32_t job = self;
+  reqFileDataJob.compare_exchange_strong(job, 0);
+  fileDataHandler->monitorRunning = false;
+}
 
-  /*! 看看是否拿到了最后一个包 或者丢包了 */
-  bool packFinishFlag = false;
-  bool packLossFlag = false;
-  if ((rsp->msg_flag & 0x01) &&
-      (range_handler_->GetLastNotReceiveSeq() == rsp->seq + 1)) {
-    DSTATUS("Got the last one pack .");
-    packFinishFlag = true;
+bool FileMgrImpl::stopReqFileData() {
+  {
+    std::lock_guard<std::mutex> lock(fileDataHandler->mutex);
+    if (fileDataHandler->downloadState != RECVING_FILE_DATA) return false;
+    DSTATUS("Stop req filedata task");
+    finishReqFileData(OSDK_STAT_ERR);
   }
-  if (range_handler_->GetNoAckRanges().size() != 0) {
-    DERROR("pack loss !!!");
-    packLossFlag = true;
+  notifyReqFileData();
+  return true;
+}
+
+uint8_t FileMgrImpl::getTargetDeviceId() {
+  return OSDK_COMMAND_DEVICE_ID(type, index);
+}
+
+FileMgrImpl *FileMgrImpl::findImpl(uint8_t sender) {
+  std::lock_guard<std::mutex> lock(instancesMutex);
+  /*! A pack no running request of sender asked for is dropped */
+  for (auto impl : instances) {
+    if (!impl->isIdle() && (impl->getTargetDeviceId() == sender)) return impl;
   }
+  return NULL;
+}
 
-  if (packLossFlag || packFinishFlag) {
-    E_OsdkStat ret =
-      (packFinishFlag && !packLossFlag) ? OSDK_STAT_OK : OSDK_STAT_SYS_ERR;
-    SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_FILE);
-    if (fileDataHandler->reqCB) {
-      fileDataHandler->reqCB(ret, fileDataHandler->reqCBUserData);
-      fileDataHandler->reqCB = NULL;
-    }
-    DSTATUS("Finish req filedata task, reset downloadState to be DOWNLOAD_IDLE");
-    fileDataHandler->downloadState = DOWNLOAD_IDLE;
+/*! Called with fileDataHandler->mutex held, the callback is left for
+ *  notifyReqFileData to run once the mutex is released
+ */
+void FileMgrImpl::finishReqFileData(E_OsdkStat ret) {
+  SendAbortPack(DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_FILE);
+  /*! Flushes the file, keeps the progress of an unfinished one */
+  fileDataHandler->mmap_file_buffer_->deInit();
+  fileDataHandler->doneCB = fileDataHandler->reqCB;
+  fileDataHandler->doneCBUserData = fileDataHandler->reqCBUserData;
+  fileDataHandler->doneRet = ret;
+  fileDataHandler->reqCB = NULL;
+  DSTATUS("Finish req filedata task, reset downloadState to be DOWNLOAD_IDLE");
+  fileDataHandler->downloadState = DOWNLOAD_IDLE;
+}
+
+/*! Run the callback of the finished request without the mutex held, the
+ *  callback may well start the next download
+ */
+void FileMgrImpl::notifyReqFileData() {
+  FileMgr::FileDataReqCBType cb = NULL;
+  void *userData = NULL;
+  E_OsdkStat ret = OSDK_STAT_OK;
+  {
+    std::lock_guard<std::mutex> lock(fileDataHandler->mutex);
+    cb = fileDataHandler->doneCB;
+    userData = fileDataHandler->doneCBUserData;
+    ret = fileDataHandler->doneRet;
+    fileDataHandler->doneCB = NULL;
   }
+  if (cb) cb(ret, userData);
 }
 
 #define LOG_EVERY_PACK 0
@@ -963,7 +1302,8 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendAbortPack(
   setting->task_id = taskId;
   setting->func_id = DJI_GENERAL_DOWNLOAD_FILE_FUNC_TYPE_ABORT;
   setting->msg_flag = 1;
-  setting->session_id = 999;
+  setting->session_id = (taskId == DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_LIST)
+                        ? fileListHandler->sessionId : fileDataHandler->sessionId;
   setting->seq = 0;
 /*
   uint32_t abortReason = TransAbortReasonForce;
@@ -1004,7 +1344,8 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendACKPack(DJI_GENERAL_DOWNLOAD_FILE_TASK
   setting->task_id = taskId;
   setting->func_id = DJI_GENERAL_DOWNLOAD_FILE_FUNC_TYPE_ACK;
   setting->msg_flag = 0;
-  setting->session_id = 999;
+  setting->session_id = (taskId == DJI_GENERAL_DOWNLOAD_FILE_TASK_TYPE_LIST)
+                        ? fileListHandler->sessionId : fileDataHandler->sessionId;
   setting->seq = 0;
 
   uint32_t reqDataLen = sizeof(dji_download_ack) - sizeof(dji_loss_desc) + ack->loss_nr * sizeof(dji_loss_desc);
@@ -1074,7 +1415,8 @@ ErrorCode::ErrorCodeType FileMgrImpl::SendMissedAckPack(DJI_GENERAL_DOWNLOAD_FIL
   return SendACKPack(taskId, ack);
 }
 
-DownloadListHandler::DownloadListHandler() : reqCB(nullptr), reqCBUserData(nullptr) {
+DownloadListHandler::DownloadListHandler() : reqCB(nullptr), reqCBUserData(nullptr),
+                                             sessionId(0), deltaList(false), restartFull(false) {
   range_handler_ = new CommonDataRangeHandler();
   download_buffer_ = new DownloadBufferQueue();
   downloadState = DOWNLOAD_IDLE;
@@ -1085,7 +1427,10 @@ DownloadListHandler::~DownloadListHandler() {
   if (download_buffer_) delete download_buffer_;
 }
 
-DownloadDataHandler::DownloadDataHandler() : reqCB(nullptr), reqCBUserData(nullptr) {
+DownloadDataHandler::DownloadDataHandler()
+    : reqCB(nullptr), reqCBUserData(nullptr), doneCB(nullptr),
+      doneCBUserData(nullptr), doneRet(OSDK_STAT_OK), sessionId(0), resumeOffset(0),
+      resumeFileSize(0), resumeTimes(0), ackTimeMs(0), monitorRunning(false) {
   range_handler_ = new CommonDataRangeHandler();
   mmap_file_buffer_ = new MmapFileBuffer();
   downloadState = DOWNLOAD_IDLE;
@@ -20,14 +20,33 @@ using namespace std::chrono;
 
 namespace DJI {
 namespace OSDK {
-bool DownloadBufferQueue::InitBufferQueue(int size, int start_index) {
-    if (m_queue_ptr != nullptr) {
+bool DownloadBufferQueue::InitBufferQueue(int size, int start_index, int block_size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (size <= 0 || block_size <= 0) {
+        return false;
+    }
+
+    // 同样大小时复用已有的slab
+    if (m_slab == nullptr || m_size != size || m_block_size != block_size) {
         free(m_queue_ptr);
-        m_queue_ptr = nullptr;
+        free(m_slab);
+        m_queue_ptr = (DataPointer *)malloc(sizeof(DataPointer) * size);
+        m_slab = (uint8_t *)malloc((size_t)size * block_size);
+        if (!m_queue_ptr || !m_slab) {
+            free(m_queue_ptr);
+            free(m_slab);
+            m_queue_ptr = nullptr;
+            m_slab = nullptr;
+            m_size = 0;
+            return false;
+        }
     }
-    m_queue_ptr = (DataPointer *)malloc(sizeof(DataPointer) * size);
 
-    memset(m_queue_ptr, 0x00, sizeof(DataPointer) * size);
+    for (int i = 0; i < size; i++) {
+        m_queue_ptr[i].data = m_slab + (size_t)i * block_size;
+        m_queue_ptr[i].length = 0;
+    }
+    m_block_size = block_size;
 
     m_size = size;
     m_expect_index = start_index;
@@ -42,28 +61,21 @@ DownloadBufferQueue::InsertRetType DownloadBufferQueue::InsertBlock(const uint8_
   std::lock_guard<std::mutex> lock(m_mutex);
   InsertRetType ret = INSERT_FAIL_UNKOWN;
 
-  if (data_length <= 0) {
+  if (data_length <= 0 || (int)data_length > m_block_size) {
     return INSERT_FAIL_INVALID_PARAM;
   }
 
   if (m_expect_index + m_size > index && m_expect_index <= index) {
     int insert_index = m_head + (index - m_expect_index);
     insert_index = insert_index % m_size;
-    DataPointer data_ptr = m_queue_ptr[insert_index];
+    DataPointer &data_ptr = m_queue_ptr[insert_index];
 
-    if (data_ptr.data) {
-      if (false == flag) {
-        return INSERT_FAIL_MEMORY_USED;
-      }
-
-      free(data_ptr.data);
+    if (data_ptr.length && false == flag) {
+      return INSERT_FAIL_MEMORY_USED;
     }
 
-    data_ptr.data = (uint8_t *) malloc(data_length);
-    data_ptr.length = data_length;
     memcpy(data_ptr.data, pack, data_length);
-
-    m_queue_ptr[insert_index] = data_ptr;
+    data_ptr.length = data_length;
 
     if (index > m_buf_max_index) {
       m_buf_max_index = index;
@@ -88,9 +100,7 @@ bool DownloadBufferQueue::FindBlockByIndex(int index) {
     if (m_expect_index + m_size > index && index >= m_expect_index) {
         int queue_index = index - m_expect_index + m_head;
         queue_index = queue_index % m_size;
-        DataPointer data_ptr = m_queue_ptr[queue_index];
-
-        if (data_ptr.data) {
+        if (m_queue_ptr[queue_index].length) {
             ret = true;
         }
     }
@@ -108,14 +118,18 @@ int DownloadBufferQueue::GetBufMaxSeq() {
 
 DataPointer DownloadBufferQueue::DequeueBuffer() {
     std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_size == 0) {
+        DataPointer nil_ptr = {};
+        return nil_ptr;
+    }
     DataPointer data_ptr = m_queue_ptr[m_head % m_size];
 
-    if (!data_ptr.data || data_ptr.length == 0) {
+    if (data_ptr.length == 0) {
         DataPointer nil_ptr = {nullptr};
         return nil_ptr;
     }
 
-    m_queue_ptr[m_head % m_size].data = nullptr;
+    // 块留在slab里, 只标记为空闲
     m_queue_ptr[m_head % m_size].length = 0;
 
     m_expect_index++;
@@ -137,24 +151,21 @@ std::list<DataPointer> DownloadBufferQueue::DequeueAllBuffer() {
 }
 
 void DownloadBufferQueue::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
     for (int i = 0; i < m_size; i++) {
-        if (m_queue_ptr[i].data) {
-            free(m_queue_ptr[i].data);
-            m_queue_ptr[i].data = nullptr;
-            m_queue_ptr[i].length = 0;
-        }
+        m_queue_ptr[i].length = 0;
     }
 }
 
 void DownloadBufferQueue::Dealloc() {
-    Clear();
-
-    if (m_queue_ptr) {
-        free(m_queue_ptr);
-        m_queue_ptr = nullptr;
-    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    free(m_queue_ptr);
+    m_queue_ptr = nullptr;
+    free(m_slab);
+    m_slab = nullptr;
 
     m_size = 0;
+    m_block_size = 0;
 }
 }  // namespace OSDK
 
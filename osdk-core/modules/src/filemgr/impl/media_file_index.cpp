@@ -0,0 +1,224 @@
+/** @file media_file_index.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Cached index of a camera's media file list
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "media_file_index.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+using namespace DJI;
+using namespace DJI::OSDK;
+
+namespace {
+const uint32_t INDEX_MAGIC   = 0x58444946; // "FIDX"
+const uint32_t INDEX_VERSION = 1;
+
+#pragma pack(1)
+typedef struct IndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t count;
+} IndexHeader;
+
+typedef struct IndexRecord {
+  int32_t  fileIndex;
+  int32_t  fileType;
+  int64_t  fileSize;
+  int16_t  date[6];
+  int64_t  duration;
+  int32_t  orientation;
+  int32_t  frameRate;
+  int32_t  resolution;
+  int32_t  videoType;
+  int32_t  photoType;
+  int32_t  panoType;
+  int32_t  photoRatio;
+  uint16_t nameLen;
+} IndexRecord;
+#pragma pack()
+
+bool lessByIndex(const MediaFile &a, const MediaFile &b) {
+  return a.fileIndex < b.fileIndex;
+}
+}
+
+MediaFileIndex::MediaFileIndex() {}
+
+void MediaFileIndex::clear() {
+  files.clear();
+  byName.clear();
+  byTime.clear();
+}
+
+void MediaFileIndex::assign(const std::vector<MediaFile> &media) {
+  files = media;
+  std::stable_sort(files.begin(), files.end(), lessByIndex);
+  rebuild();
+}
+
+void MediaFileIndex::merge(const std::vector<MediaFile> &media) {
+  for (auto &file : media) {
+    auto it = std::lower_bound(files.begin(), files.end(), file, lessByIndex);
+    if ((it != files.end()) && (it->fileIndex == file.fileIndex))
+      *it = file;
+    else
+      files.insert(it, file);
+  }
+  rebuild();
+}
+
+void MediaFileIndex::rebuild() {
+  byName.clear();
+  byTime.clear();
+  for (size_t i = 0; i < files.size(); i++) {
+    byName[files[i].fileName] = i;
+    byTime.insert(std::make_pair(timeKey(files[i].date), i));
+  }
+}
+
+uint64_t MediaFileIndex::timeKey(const DateTime &date) {
+  return ((((((uint64_t) date.year * 13 + date.month) * 32 + date.day) * 24 +
+            date.hour) * 60 + date.minute) * 60) + date.second;
+}
+
+bool MediaFileIndex::newest(MediaFile &file) const {
+  if (files.empty()) return false;
+  file = files.back();
+  return true;
+}
+
+bool MediaFileIndex::findByIndex(int fileIndex, MediaFile &file) const {
+  MediaFile key;
+  key.fileIndex = fileIndex;
+  auto it = std::lower_bound(files.begin(), files.end(), key, lessByIndex);
+  if ((it == files.end()) || (it->fileIndex != fileIndex)) return false;
+  file = *it;
+  return true;
+}
+
+bool MediaFileIndex::findByName(const std::string &name, MediaFile &file) const {
+  auto it = byName.find(name);
+  if (it == byName.end()) return false;
+  file = files[it->second];
+  return true;
+}
+
+std::vector<MediaFile> MediaFileIndex::findByTime(const DateTime &from,
+                                                  const DateTime &to) const {
+  std::vector<MediaFile> ret;
+  auto end = byTime.upper_bound(timeKey(to));
+  for (auto it = byTime.lower_bound(timeKey(from)); it != end; ++it)
+    ret.push_back(files[it->second]);
+  return ret;
+}
+
+bool MediaFileIndex::save(const std::string &path) const {
+  /*! Write aside and rename, a crash never leaves half an index behind */
+  std::string tmpPath = path + ".tmp";
+  FILE *fp = fopen(tmpPath.c_str(), "wb");
+  if (!fp) return false;
+
+  IndexHeader header = {INDEX_MAGIC, INDEX_VERSION, (uint32_t) files.size()};
+  bool ret = (fwrite(&header, sizeof(header), 1, fp) == 1);
+  for (size_t i = 0; ret && (i < files.size()); i++) {
+    const MediaFile &f = files[i];
+    IndexRecord r;
+    r.fileIndex = f.fileIndex;
+    r.fileType = (int32_t) f.fileType;
+    r.fileSize = f.fileSize;
+    r.date[0] = f.date.year;
+    r.date[1] = f.date.month;
+    r.date[2] = f.date.day;
+    r.date[3] = f.date.hour;
+    r.date[4] = f.date.minute;
+    r.date[5] = f.date.second;
+    r.duration = f.duration;
+    r.orientation = (int32_t) f.orientation;
+    r.frameRate = (int32_t) f.frameRate;
+    r.resolution = (int32_t) f.resolution;
+    r.videoType = (int32_t) f.videoType;
+    r.photoType = (int32_t) f.photoType;
+    r.panoType = (int32_t) f.panoType;
+    r.photoRatio = (int32_t) f.photoRatio;
+    r.nameLen = (uint16_t) f.fileName.size();
+    ret = (fwrite(&r, sizeof(r), 1, fp) == 1) &&
+          (fwrite(f.fileName.data(), 1, r.nameLen, fp) == r.nameLen);
+  }
+  ret = (fclose(fp) == 0) && ret;
+
+  if (ret) ret = (rename(tmpPath.c_str(), path.c_str()) == 0);
+  if (!ret) remove(tmpPath.c_str());
+  return ret;
+}
+
+bool MediaFileIndex::load(const std::string &path) {
+  FILE *fp = fopen(path.c_str(), "rb");
+  if (!fp) return false;
+
+  IndexHeader header;
+  bool ret = (fread(&header, sizeof(header), 1, fp) == 1) &&
+             (header.magic == INDEX_MAGIC) && (header.version == INDEX_VERSION);
+  std::vector<MediaFile> loaded;
+  if (ret) loaded.reserve(header.count < 65536 ? header.count : 65536);
+  for (uint32_t i = 0; ret && (i < header.count); i++) {
+    IndexRecord r;
+    std::string name;
+    ret = (fread(&r, sizeof(r), 1, fp) == 1);
+    if (ret) {
+      name.resize(r.nameLen);
+      ret = (fread(&name[0], 1, r.nameLen, fp) == r.nameLen);
+    }
+    if (!ret) break;
+
+    MediaFile f = MediaFile();
+    f.valid = true;
+    f.fileIndex = r.fileIndex;
+    f.fileType = (MediaFileType) r.fileType;
+    f.fileName.swap(name);
+    f.fileSize = r.fileSize;
+    f.date.year = r.date[0];
+    f.date.month = r.date[1];
+    f.date.day = r.date[2];
+    f.date.hour = r.date[3];
+    f.date.minute = r.date[4];
+    f.date.second = r.date[5];
+    f.duration = r.duration;
+    f.orientation = (CameraOrientation) r.orientation;
+    f.frameRate = (VideoFrameRate) r.frameRate;
+    f.resolution = (VideoResolution) r.resolution;
+    f.videoType = (MediaVideoType) r.videoType;
+    f.photoType = (MediaPhotoType) r.photoType;
+    f.panoType = (CameraPanoType) r.panoType;
+    f.photoRatio = (PhotoRatio) r.photoRatio;
+    loaded.push_back(f);
+  }
+  fclose(fp);
+
+  if (ret) assign(loaded);
+  return ret;
+}
@@ -3,39 +3,71 @@
 //
 #include "mmap_file_buffer.hpp"
 #include "dji_log.hpp"
+#include <stdio.h>
 #include <string.h>
 
 namespace DJI {
 namespace OSDK {
 
-MmapFileBuffer::MmapFileBuffer() : fdAddr(NULL), curFilePos(0) {}
+MmapFileBuffer::MmapFileBuffer()
+    : fd(-1), fdAddr(NULL), fdAddrSize(0), curFilePos(0), layoutValid(false),
+      baseOffset(0), firstBlockSize(0), blockSize(0), blockCount(0),
+      firstMissingSeq(0), syncedPos(0) {}
 
-MmapFileBuffer::~MmapFileBuffer() {}
+MmapFileBuffer::~MmapFileBuffer() {
+  if (fd >= 0) deInit();
+}
 
 bool MmapFileBuffer::init(std::string path, uint64_t fileSize) {
   currentLogFilePath = path;
   fdAddrSize = fileSize;
   curFilePos = 0;
+  layoutValid = false;
+  baseOffset = 0;
+  syncedPos = 0;
   printf("Preparing File : %s\n", this->currentLogFilePath.c_str());
   fd = open(this->currentLogFilePath.c_str(), O_RDWR | O_CREAT, 0644);
   DSTATUS("fd = %d", fd);
   if (fd < 0) return false;
 
-  ftruncate(fd, fdAddrSize);
-  fdAddr = (char *) mmap(NULL, fdAddrSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  /*! Keeps what is already there, a resumed download relies on it */
+  if (ftruncate(fd, fdAddrSize) != 0) {
+    DERROR("Failed to resize %s to %llu bytes", path.c_str(),
+           (unsigned long long) fdAddrSize);
+    close(fd);
+    fd = -1;
+    return false;
+  }
+  if (fdAddrSize == 0) return true;
 
-  if (fdAddr)
-    return true;
-  else
+  void *addr = mmap(NULL, fdAddrSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    DERROR("Failed to map %s", path.c_str());
+    close(fd);
+    fd = -1;
     return false;
+  }
+  fdAddr = (char *) addr;
+  /*! Media files are written front to back and not read again */
+  madvise(fdAddr, fdAddrSize, MADV_SEQUENTIAL);
+  return true;
 }
 
 bool MmapFileBuffer::deInit() {
   DSTATUS("Deinit");
-  if (fd >= 0) close(fd);
-  fd = -1;
+  if (fd >= 0) {
+    if (isComplete()) {
+      if (fdAddr) msync(fdAddr, fdAddrSize, MS_SYNC);
+      removeProgress(currentLogFilePath);
+    } else {
+      sync();
+    }
+  }
   if (fdAddr) munmap(fdAddr, fdAddrSize);
   fdAddr = NULL;
+  if (fd >= 0) close(fd);
+  fd = -1;
+  layoutValid = false;
   return true;
 }
 
@@ -57,5 +89,171 @@ bool MmapFileBuffer::InsertBlock(const uint8_t *pack, uint32_t data_length, uint
 
   return true;
 }
+
+void MmapFileBuffer::setLayout(uint64_t baseOffset, uint32_t firstBlockSize,
+                               uint32_t blockSize) {
+  if (baseOffset > fdAddrSize) baseOffset = fdAddrSize;
+  this->baseOffset = baseOffset;
+  this->firstBlockSize = firstBlockSize;
+  this->blockSize = blockSize;
+
+  uint64_t rest = fdAddrSize - baseOffset;
+  rest = (rest > firstBlockSize) ? rest - firstBlockSize : 0;
+  blockCount = 1;
+  if (blockSize) blockCount += (uint32_t) ((rest + blockSize - 1) / blockSize);
+  bitmap.assign((blockCount + 7) / 8, 0);
+  firstMissingSeq = 0;
+  curFilePos = baseOffset;
+  if (syncedPos > baseOffset) syncedPos = baseOffset;
+  layoutValid = true;
+}
+
+void MmapFileBuffer::resetLayout() {
+  baseOffset = firstMissingOffset();
+  curFilePos = baseOffset;
+  layoutValid = false;
+}
+
+uint64_t MmapFileBuffer::blockOffset(uint32_t seq) {
+  if (seq == 0) return baseOffset;
+  return baseOffset + firstBlockSize + (uint64_t) (seq - 1) * blockSize;
+}
+
+bool MmapFileBuffer::insertSeq(uint32_t seq, const uint8_t *data, uint32_t length) {
+  if (!layoutValid || seq >= blockCount) return false;
+
+  uint64_t offset = blockOffset(seq);
+  uint64_t expected = (seq == 0) ? firstBlockSize : blockSize;
+  if (offset + expected > fdAddrSize) expected = fdAddrSize - offset;
+  if (length != expected) {
+    DERROR("Pack %u carries %u bytes, %llu expected", seq, length,
+           (unsigned long long) expected);
+    return false;
+  }
+
+  if (bitmap[seq / 8] & (1 << (seq % 8))) return true;
+
+  if (length) {
+    if (!fdAddr) return false;
+    memcpy(fdAddr + offset, data, length);
+  }
+  bitmap[seq / 8] |= (1 << (seq % 8));
+  curFilePos += length;
+
+  while ((firstMissingSeq < blockCount) &&
+         (bitmap[firstMissingSeq / 8] & (1 << (firstMissingSeq % 8))))
+    firstMissingSeq++;
+
+  if (firstMissingOffset() - syncedPos >= SYNC_STEP) writeBack(false);
+  return true;
+}
+
+uint64_t MmapFileBuffer::firstMissingOffset() {
+  if (!layoutValid) return baseOffset;
+  if (firstMissingSeq >= blockCount) return fdAddrSize;
+  return blockOffset(firstMissingSeq);
+}
+
+/*! Start writing back the complete front of the file and drop it from the
+ *  mapping, so a large download does not pin its whole size in memory.
+ */
+void MmapFileBuffer::writeBack(bool wait) {
+  if (!fdAddr) return;
+  uint64_t pageSize = sysconf(_SC_PAGESIZE);
+  uint64_t end = firstMissingOffset();
+  if (end < fdAddrSize) end -= end % pageSize;
+  if (end <= syncedPos) return;
+
+  msync(fdAddr + syncedPos, end - syncedPos, wait ? MS_SYNC : MS_ASYNC);
+  madvise(fdAddr + syncedPos, end - syncedPos, MADV_DONTNEED);
+  syncedPos = end;
+}
+
+bool MmapFileBuffer::sync() {
+  if (fd < 0) return false;
+  /*! The data has to be on disk before the progress file claims it is */
+  if (fdAddr) msync(fdAddr, fdAddrSize, MS_SYNC);
+  return saveProgress();
+}
+
+std::string MmapFileBuffer::progressPath(const std::string &path) {
+  return path + ".dlmap";
+}
+
+void MmapFileBuffer::removeProgress(const std::string &path) {
+  unlink(progressPath(path).c_str());
+}
+
+bool MmapFileBuffer::saveProgress() {
+  ProgressHeader header = {0};
+  header.magic = PROGRESS_MAGIC;
+  header.version = PROGRESS_VERSION;
+  header.fileSize = fdAddrSize;
+  header.baseOffset = baseOffset;
+  if (layoutValid) {
+    header.firstBlockSize = firstBlockSize;
+    header.blockSize = blockSize;
+    header.blockCount = blockCount;
+  }
+
+  FILE *fp = fopen(progressPath(currentLogFilePath).c_str(), "wb");
+  if (!fp) {
+    DERROR("Failed to save the download progress of %s", currentLogFilePath.c_str());
+    return false;
+  }
+  bool ret = (fwrite(&header, sizeof(header), 1, fp) == 1);
+  if (ret && header.blockCount)
+    ret = (fwrite(bitmap.data(), 1, bitmap.size(), fp) == bitmap.size());
+  fclose(fp);
+  return ret;
+}
+
+uint64_t MmapFileBuffer::missingOffsetOf(const ProgressHeader &header,
+                                         const std::vector<uint8_t> &bitmap) {
+  if (header.blockCount == 0) return header.baseOffset;
+  for (uint32_t seq = 0; seq < header.blockCount; seq++) {
+    if (!(bitmap[seq / 8] & (1 << (seq % 8)))) {
+      if (seq == 0) return header.baseOffset;
+      return header.baseOffset + header.firstBlockSize +
+             (uint64_t) (seq - 1) * header.blockSize;
+    }
+  }
+  return header.fileSize;
+}
+
+bool MmapFileBuffer::loadProgress(const std::string &path,
+                                  uint64_t &resumeOffset, uint64_t &fileSize) {
+  resumeOffset = 0;
+  fileSize = 0;
+  FILE *fp = fopen(progressPath(path).c_str(), "rb");
+  if (!fp) return false;
+
+  ProgressHeader header;
+  std::vector<uint8_t> bits;
+  bool valid = (fread(&header, sizeof(header), 1, fp) == 1) &&
+               (header.magic == PROGRESS_MAGIC) &&
+               (header.version == PROGRESS_VERSION);
+  if (valid) {
+    bits.resize((header.blockCount + 7) / 8);
+    valid = bits.empty() || (fread(bits.data(), 1, bits.size(), fp) == bits.size());
+  }
+  fclose(fp);
+
+  /*! Without the partial file the progress is worthless */
+  struct stat st;
+  if (valid)
+    valid = (stat(path.c_str(), &st) == 0) && ((uint64_t) st.st_size == header.fileSize);
+
+  if (valid) {
+    resumeOffset = missingOffsetOf(header, bits);
+    fileSize = header.fileSize;
+    valid = (resumeOffset > 0) && (resumeOffset < fileSize);
+  }
+  if (!valid) {
+    resumeOffset = 0;
+    removeProgress(path);
+  }
+  return valid;
+}
+}
 }
-}
\ No newline at end of file
@@ -29,6 +29,7 @@
 #include "dji_flight_joystick_module.hpp"
 #include <dji_vehicle.hpp>
 #include "dji_flight_link.hpp"
+#include "dji_ctx_pool.hpp"
 
 using namespace DJI;
 using namespace DJI::OSDK;
@@ -55,7 +56,7 @@ void joystickCtrlAuthorityCbWrapperFunc(const T_CmdInfo *cmdInfo,
     handler->cb(ErrorCode::getLinkerErrorCode(cb_type), handler->udata);
   }
 
-  OsdkOsal_Free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 FlightJoystick::FlightJoystick(Vehicle *vehicle) {
@@ -29,6 +29,7 @@
 #include "dji_flight_link.hpp"
 #include <dji_vehicle.hpp>
 #include "dji_linker.hpp"
+#include "dji_ctx_pool.hpp"
 
 using namespace DJI;
 using namespace DJI::OSDK;
@@ -67,7 +68,7 @@ void FlightLink::linkSendFCAsync(const uint8_t cmd[], const uint8_t *cmdData, si
    cmdInfo.receiver   = OSDK_COMMAND_FC_2_DEVICE_ID;
    cmdInfo.addr       = GEN_ADDR(0, ADDR_SDK_COMMAND_INDEX);
 
-   callbackWarpperHandler *handler = (callbackWarpperHandler *)OsdkOsal_Malloc(sizeof(callbackWarpperHandler));
+   callbackWarpperHandler *handler = (callbackWarpperHandler *)DJI_CTX_ALLOC(sizeof(callbackWarpperHandler));
    handler->cb    = UserCallBack;
    handler->udata = userData;
 
@@ -33,6 +33,8 @@
 #include "dji_legacy_linker.hpp"
 #include "dji_camera_module.hpp"
 #include "dji_internal_command.hpp"
+#include "dji_ctx_pool.hpp"
+#include "dji_timer_scheduler.hpp"
 
 using namespace DJI;
 using namespace DJI::OSDK;
@@ -55,9 +57,13 @@ CameraModule::CameraModule(Linker* linker,
     : PayloadBase(linker, payloadIndex, name, enable) {
   cameraVersion = "UNKNOWN";
   firmwareVersion = "UNKNOWN";
-  OsdkOsal_TaskCreate(&camModuleHandle,
-                      (void *(*)(void *)) (&camHWInfoTask),
-                      OSDK_TASK_STACK_SIZE_DEFAULT / 2, this);
+  /*! Each request blocks a scheduler worker for up to 600 ms, so the
+   *  cameras take turns instead of all asking at once
+   */
+  camHWInfoJob = TimerScheduler::instance().schedulePeriodic(
+      camHWInfoTask, this, CAM_HW_INFO_PERIOD_MS,
+      (uint32_t)payloadIndex * CAM_HW_INFO_PERIOD_MS / PAYLOAD_INDEX_CNT,
+      "camHWInfo");
   memset(&lensInfo, 0, sizeof(lensInfo));
   OsdkOsal_MutexCreate(&lensUpdatedMutex);
 }
@@ -77,17 +83,15 @@ CameraModule::LensInfoPacketType CameraModule::getLensInfo() {
   return ret;
 }
 
-void CameraModule::camHWInfoTask(void *arg) {
-  while (arg != NULL) {
+void CameraModule::camHWInfoTask(void *arg, uint32_t) {
+  if (arg != NULL) {
     CameraModule *module = (CameraModule *)arg;
 
     module->requestCameraVersion();
-    OsdkOsal_TaskSleepMs(2000);
   }
 }
 CameraModule::~CameraModule() {
-  OsdkOsal_TaskDestroy(camModuleHandle);
-  OsdkOsal_TaskSleepMs(100);
+  TimerScheduler::instance().cancel(camHWInfoJob);
   OsdkOsal_MutexDestroy(lensUpdatedMutex);
 }
 
@@ -118,7 +122,7 @@ void retAckCB(const T_CmdInfo *cmdInfo,
     cb(ret, handler->udata);
   }
 
-  if (handler)free(handler);
+  if (handler) DJI_CTX_FREE(handler);
 }
 
 
@@ -257,7 +261,7 @@ void paramAckCB(const T_CmdInfo *cmdInfo,
              cmdInfo->cmdId);
     }
 //clang-format on
-    if (handler)free(handler);
+    if (handler) DJI_CTX_FREE(handler);
   }
 }
 
@@ -284,7 +288,7 @@ void CameraModule::getInterfaceAsync(
                                             getIndex() * 2);
   cmdInfo.sender = getLinker()->getLocalSenderId();
 
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) userCB;
   handler->udata = userData;
   uint8_t temp = 0; // @TODO:fix the linker send data len = 0 issue
@@ -350,7 +354,7 @@ void CameraModule::setInterfaceAsync(const uint8_t cmd[2], const uint8_t *pdata,
                                             getIndex() * 2);
   cmdInfo.sender = getLinker()->getLocalSenderId();
 
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) userCB;
   handler->udata = userData;
 
@@ -430,7 +434,7 @@ void CameraModule::setExposureModeAsync(
                                             getIndex() * 2);
   cmdInfo.sender = getLinker()->getLocalSenderId();
 
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *)UserCallBack;
   handler->udata = userData;
 
@@ -908,7 +912,7 @@ void CameraModule::setTapZoomEnabledAsync(
     bool param,
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode, UserData userData),
     UserData userData) {
-  auto handler = (TapZoomEnabledHandler *)malloc(sizeof(TapZoomEnabledHandler));
+  auto handler = (TapZoomEnabledHandler *) DJI_CTX_ALLOC(sizeof(TapZoomEnabledHandler));
   handler->cameraModule = this;
   handler->enable = param;
   handler->UserCallBack = UserCallBack;
@@ -946,7 +950,7 @@ void CameraModule::callbackToSetTapZoomEnabled(ErrorCode::ErrorCodeType retCode,
         V1ProtocolCMD::Camera::setPointZoomMode, (uint8_t *) &req,
         sizeof(req), handler.UserCallBack, handler.userData, 1000 / 3, 3);
   }
-  if (userData) free(userData);
+  if (userData) DJI_CTX_FREE(userData);
 }
 
 void CameraModule::getTapZoomDataAckAsync(
@@ -961,7 +965,7 @@ void CameraModule::getTapZoomEnabledAsync(
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode, bool param,
                          UserData userData),
     UserData userData) {
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) UserCallBack;
   handler->udata = userData;
   getTapZoomDataAckAsync(getTapZoomEnabledDecoder, handler);
@@ -984,7 +988,7 @@ void CameraModule::setTapZoomMultiplierAsync(
     TapZoomMultiplierData param,
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode, UserData userData),
     UserData userData) {
-  auto handler = (TapZoomEnabledHandler *)malloc(sizeof(TapZoomEnabledHandler));
+  auto handler = (TapZoomEnabledHandler *) DJI_CTX_ALLOC(sizeof(TapZoomEnabledHandler));
   handler->cameraModule = this;
   handler->enable = false;
   handler->multiplier = param;
@@ -1022,14 +1026,14 @@ void CameraModule::callbackToSetTapZoomMultiplier(
         V1ProtocolCMD::Camera::setPointZoomMode, (uint8_t *) &req,
         sizeof(req), handler.UserCallBack, handler.userData, 1000 / 3, 3);
   }
-  if (userData) free(userData);
+  if (userData) DJI_CTX_FREE(userData);
 }
 
 void CameraModule::getTapZoomMultiplierAsync(
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode,
                          TapZoomMultiplierData param, UserData userData),
     UserData userData) {
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) UserCallBack;
   handler->udata = userData;
   getTapZoomDataAckAsync(getTapZoomMultiplierDecoder, handler);
@@ -1055,7 +1059,7 @@ void CameraModule::getShootPhotoModeDataDecoder(ErrorCode::ErrorCodeType retCode
   auto *handler = (handlerType *) userData;
   auto cb = (void (*)(ErrorCode::ErrorCodeType, CameraModule::ShootPhotoMode, UserData)) handler->cb;
   if(cb) cb(retCode, (CameraModule::ShootPhotoMode)captureParam.captureMode, handler->udata);
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 void CameraModule::getPhotoAEBCountDecoder(ErrorCode::ErrorCodeType retCode,
@@ -1065,7 +1069,7 @@ void CameraModule::getPhotoAEBCountDecoder(ErrorCode::ErrorCodeType retCode,
   auto *handler = (handlerType *) userData;
   auto cb = (void (*)(ErrorCode::ErrorCodeType, CameraModule::PhotoAEBCount, UserData)) handler->cb;
   if(cb) cb(retCode, (CameraModule::PhotoAEBCount)captureParam.photoNumBurst, handler->udata);
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 void CameraModule::getPhotoBurstCountDecoder(ErrorCode::ErrorCodeType retCode,
@@ -1075,7 +1079,7 @@ void CameraModule::getPhotoBurstCountDecoder(ErrorCode::ErrorCodeType retCode,
   auto *handler = (handlerType *) userData;
   auto cb = (void (*)(ErrorCode::ErrorCodeType, CameraModule::PhotoBurstCount, UserData)) handler->cb;
   if(cb) cb(retCode, (CameraModule::PhotoBurstCount)captureParam.photoNumBurst, handler->udata);
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 void CameraModule::getPhotoIntervalDatasDecoder(ErrorCode::ErrorCodeType retCode,
@@ -1085,7 +1089,7 @@ void CameraModule::getPhotoIntervalDatasDecoder(ErrorCode::ErrorCodeType retCode
   auto *handler = (handlerType *) userData;
   auto cb = (void (*)(ErrorCode::ErrorCodeType, PhotoIntervalData, UserData)) handler->cb;
   if(cb) cb(retCode, captureParam.intervalSetting, handler->udata);
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 void CameraModule::getTapZoomEnabledDecoder(ErrorCode::ErrorCodeType retCode,
@@ -1095,7 +1099,7 @@ void CameraModule::getTapZoomEnabledDecoder(ErrorCode::ErrorCodeType retCode,
   auto *handler = (handlerType *) userData;
   auto cb = (void (*)(ErrorCode::ErrorCodeType, bool, UserData)) handler->cb;
   if(cb) cb(retCode, data.tapZoomEnable, handler->udata);
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 void CameraModule::getTapZoomMultiplierDecoder(ErrorCode::ErrorCodeType retCode,
@@ -1105,7 +1109,7 @@ void CameraModule::getTapZoomMultiplierDecoder(ErrorCode::ErrorCodeType retCode,
   auto *handler = (handlerType *) userData;
   auto cb = (void (*)(ErrorCode::ErrorCodeType, TapZoomMultiplierData, UserData)) handler->cb;
   if(cb) cb(retCode, data.multiplier, handler->udata);
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 CameraModule::ShutterSpeedType createShutterSpeedStruct(
@@ -1542,7 +1546,7 @@ void CameraModule::setShootPhotoModeAsync(
                       sizeof(req), UserCallBack, userData, 1000 / 3, 3);
   } else {
     auto handler =
-      (shootPhotoParamHandler*)malloc(sizeof(shootPhotoParamHandler));
+      (shootPhotoParamHandler *) DJI_CTX_ALLOC(sizeof(shootPhotoParamHandler));
     handler->cameraModule          = this;
     handler->paramData.captureMode = takePhotoMode;
     handler->UserCallBack          = UserCallBack;
@@ -1606,7 +1610,7 @@ void CameraModule::getShootPhotoModeAsync(
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode,
                          ShootPhotoMode takePhotoMode, UserData userData),
     UserData userData) {
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) UserCallBack;
   handler->udata = userData;
   getCaptureParamDataAsync(getShootPhotoModeDataDecoder, handler);
@@ -1644,7 +1648,7 @@ void CameraModule::setPhotoBurstCountAsync(
     PhotoBurstCount count,
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode, UserData userData),
     UserData userData) {
-  auto handler = (shootPhotoParamHandler*)malloc(sizeof(shootPhotoParamHandler));
+  auto handler = (shootPhotoParamHandler *) DJI_CTX_ALLOC(sizeof(shootPhotoParamHandler));
   handler->cameraModule = this;
   handler->paramData.photoNumBurst = count;
   handler->UserCallBack = UserCallBack;
@@ -1671,7 +1675,7 @@ void CameraModule::getPhotoBurstCountAsync(
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode,
                          PhotoBurstCount count, UserData userData),
     UserData userData) {
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) UserCallBack;
   handler->udata = userData;
   getCaptureParamDataAsync(getPhotoBurstCountDecoder, handler);
@@ -1698,7 +1702,7 @@ void CameraModule::getPhotoAEBCountAsync(
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode, PhotoAEBCount count,
                          UserData userData),
     UserData userData) {
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) UserCallBack;
   handler->udata = userData;
   getCaptureParamDataAsync(getPhotoAEBCountDecoder, handler);
@@ -1750,7 +1754,7 @@ void CameraModule::setPhotoTimeIntervalSettingsAsync(
       sizeof(req), UserCallBack, userData, 1000 / 3, 3);
   } else {
     auto handler =
-      (shootPhotoParamHandler*)malloc(sizeof(shootPhotoParamHandler));
+      (shootPhotoParamHandler *) DJI_CTX_ALLOC(sizeof(shootPhotoParamHandler));
     handler->cameraModule              = this;
     handler->paramData.intervalSetting = intervalSetting;
     handler->UserCallBack              = UserCallBack;
@@ -1793,7 +1797,7 @@ void CameraModule::getPhotoIntervalDatasAsync(
     void (*UserCallBack)(ErrorCode::ErrorCodeType retCode,
                          PhotoIntervalData intervalSetting, UserData userData),
     UserData userData) {
-  auto *handler = (handlerType *) malloc(sizeof(handlerType));
+  auto *handler = (handlerType *) DJI_CTX_ALLOC(sizeof(handlerType));
   handler->cb = (void *) UserCallBack;
   handler->udata = userData;
   getCaptureParamDataAsync(getPhotoIntervalDatasDecoder, handler);
@@ -30,6 +30,7 @@
 #include "dji_linker.hpp"
 #include "dji_legacy_linker.hpp"
 #include "dji_internal_command.hpp"
+#include "dji_ctx_pool.hpp"
 
 #include <vector>
 #include "osdk_device_id.h"
@@ -66,7 +67,7 @@ void callbackWrapperFunc(const T_CmdInfo *cmdInfo,
     handler->cb(ErrorCode::getLinkerErrorCode(cb_type), handler->udata);
   }
 
-  free(userData);
+  DJI_CTX_FREE(userData);
 }
 
 void GimbalModule::resetAsync(
@@ -91,7 +92,7 @@ void GimbalModule::resetAsync(
                                                 V1GimbalIndex);
       cmdInfo.sender = getLinker()->getLocalSenderId();
 
-      callbackWarpperHandler *handler = (callbackWarpperHandler *)malloc(sizeof(callbackWarpperHandler));
+      callbackWarpperHandler *handler = (callbackWarpperHandler *) DJI_CTX_ALLOC(sizeof(callbackWarpperHandler));
       handler->cb = userCB;
       handler->udata = userData;
 
@@ -165,7 +166,7 @@ void GimbalModule::rotateAsync(Rotation rotation,
         OSDK_COMMAND_DEVICE_ID(OSDK_COMMAND_DEVICE_TYPE_GIMBAL, V1GimbalIndex);
     cmdInfo.sender = getLinker()->getLocalSenderId();
 
-    callbackWarpperHandler *handler = (callbackWarpperHandler *)malloc(sizeof(callbackWarpperHandler));
+    callbackWarpperHandler *handler = (callbackWarpperHandler *) DJI_CTX_ALLOC(sizeof(callbackWarpperHandler));
     handler->cb = userCB;
     handler->udata = userData;
 
@@ -0,0 +1,130 @@
+/** @file dji_ctx_pool.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Fixed capacity pool for asynchronous request contexts
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef DJI_CTX_POOL_H
+#define DJI_CTX_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#if defined(__linux__)
+#include <atomic>
+#else
+#include "osdk_osal.h"
+#endif
+
+/*! Blocks in the static arena, 0 leaves the arena out and every context
+ *  comes from malloc. Override with -DDJIOSDK_CTX_POOL_BLOCKS=<n>; the MCU
+ *  builds default to 0 to keep their RAM.
+ */
+#ifndef DJIOSDK_CTX_POOL_BLOCKS
+#if defined(__linux__)
+#define DJIOSDK_CTX_POOL_BLOCKS 256
+#else
+#define DJIOSDK_CTX_POOL_BLOCKS 0
+#endif
+#endif
+
+#define DJI_CTX_ALLOC(size)                                         \
+  DJI::OSDK::AsyncContextPool::instance()                           \
+  .alloc(size)
+
+#define DJI_CTX_FREE(ptr)                                           \
+  DJI::OSDK::AsyncContextPool::instance()                           \
+  .free(ptr)
+
+namespace DJI
+{
+namespace OSDK
+{
+
+/*! @brief Free-list allocator for the small contexts (callback + user data)
+ *  that travel with every asynchronous command until its ACK arrives.
+ *
+ *  @details The blocks live in a static arena, so issuing commands at a high
+ *  rate does not churn the shared heap. Requests larger than a block, or
+ *  issued while the pool is exhausted, fall back to malloc; free() tells the
+ *  two apart, so callers never need to know where a context came from.
+ *  All methods are thread safe.
+ */
+class AsyncContextPool
+{
+public:
+  static const uint32_t BLOCK_SIZE = 64;
+  static const uint32_t BLOCK_NUM  = DJIOSDK_CTX_POOL_BLOCKS;
+
+  typedef struct Stats
+  {
+    uint32_t capacity;      /*!< Number of blocks in the pool */
+    uint32_t inUse;         /*!< Blocks currently handed out */
+    uint32_t highWaterMark; /*!< Maximum of inUse since start */
+    uint32_t allocCount;    /*!< Contexts served from the pool */
+    uint32_t exhaustCount;  /*!< Requests served by malloc, pool empty */
+    uint32_t oversizeCount; /*!< Requests served by malloc, too large */
+  } Stats;
+
+  static AsyncContextPool& instance();
+
+  void* alloc(size_t size);
+  void  free(void* ptr);
+
+  Stats getStats();
+
+private:
+  AsyncContextPool();
+  AsyncContextPool(const AsyncContextPool&);
+  AsyncContextPool& operator=(const AsyncContextPool&);
+
+  bool isPoolBlock(const void* ptr) const;
+  void lock();
+  void unlock();
+
+  typedef union Block
+  {
+    Block*  next;
+    uint8_t data[BLOCK_SIZE];
+    /* keep the blocks aligned for any context struct */
+    long double align;
+  } Block;
+
+#if DJIOSDK_CTX_POOL_BLOCKS > 0
+  Block            arena[BLOCK_NUM];
+#endif
+  Block*           freeList;
+#if defined(__linux__)
+  std::atomic_flag spin;
+#else
+  //! No atomics on the MCU toolchains
+  T_OsdkMutexHandle mutex;
+#endif
+  Stats            stats;
+};
+
+} // namespace OSDK
+} // namespace DJI
+
+#endif // DJI_CTX_POOL_H
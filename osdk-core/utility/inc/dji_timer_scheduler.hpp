@@ -0,0 +1,220 @@
+/** @file dji_timer_scheduler.hpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Shared timer wheel for the periodic and one-shot jobs of the OSDK
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef DJI_TIMER_SCHEDULER_H
+#define DJI_TIMER_SCHEDULER_H
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <stdint.h>
+#include "osdk_osal.h"
+
+namespace DJI
+{
+namespace OSDK
+{
+
+/*! @brief One small pool of threads that runs every periodic and one-shot
+ *  job of the OSDK, instead of one polling task per module.
+ *
+ *  @details Jobs are kept in a hierarchical timer wheel: 4 levels of 64
+ *  slots, TICK_MS per slot on the first level, so adding, cancelling and
+ *  expiring a job is O(1) and an idle scheduler does not wake up. Whichever
+ *  worker is free advances the wheel and runs the jobs that are due.
+ *
+ *  Jobs may block, e.g. in Linker::sendSync, but then hold one of the
+ *  WORKER_NUM workers. PRIORITY_HIGH jobs, like the heartbeat, also have a
+ *  worker of their own that never runs normal jobs, so they stay on time
+ *  while blocking jobs hold the others; they only wait for each other.
+ *  A periodic job never runs twice at the same time: a period that comes
+ *  while the job is still running is skipped and counted as an overrun.
+ *  All methods are thread safe and may be called from jobs.
+ */
+class TimerScheduler
+{
+public:
+  //! 0 is never a valid id
+  typedef uint32_t JobId;
+  //! self is the id of the running job, e.g. for it to cancel itself
+  typedef void (*JobFunc)(void* arg, JobId self);
+
+  typedef enum Priority
+  {
+    PRIORITY_NORMAL = 0,
+    //! Few, short jobs that must run on time
+    PRIORITY_HIGH   = 1,
+  } Priority;
+
+  static const uint32_t TICK_MS    = 10;
+  //! Workers for every job, the PRIORITY_HIGH worker comes on top
+  static const uint32_t WORKER_NUM = 2;
+
+  //! Upper bounds of the lateness histogram buckets in ms, the last is open
+  static const uint32_t LATE_BUCKET_NUM = 6;
+
+  typedef struct JobStats
+  {
+    uint32_t runs;
+    //! Periods skipped because the job was still running
+    uint32_t overruns;
+    //! Time from the due time to the start of the run
+    uint32_t maxLateMs;
+    uint64_t totalLateMs;
+    uint32_t maxRunMs;
+  } JobStats;
+
+  typedef struct Stats
+  {
+    uint32_t jobs;
+    uint64_t runs;
+    uint64_t overruns;
+    uint32_t maxLateMs;
+    //! Runs by lateness: <TICK_MS, <20, <50, <100, <500, more ms
+    uint64_t lateHistogram[LATE_BUCKET_NUM];
+  } Stats;
+
+  static TimerScheduler& instance();
+
+  /*! @brief Run func(arg) every periodMs, the first time after delayMs
+   *  @details The period is kept from the due time, not from the end of the
+   *  last run, so a late run does not shift the following ones.
+   *  @return 0 if the scheduler could not be started
+   */
+  JobId schedulePeriodic(JobFunc func, void* arg, uint32_t periodMs,
+                         uint32_t delayMs = 0, const char* name = NULL,
+                         Priority priority = PRIORITY_NORMAL);
+
+  //! Run func(arg) once after delayMs
+  JobId scheduleOnce(JobFunc func, void* arg, uint32_t delayMs,
+                     const char* name = NULL,
+                     Priority priority = PRIORITY_NORMAL);
+
+  /*! @brief Stop a job, it does not run again once cancel returns
+   *  @param wait also wait for a run in progress to return; a job that
+   *  cancels itself must pass false
+   *  @return false if the id is unknown or the job already finished
+   */
+  bool cancel(JobId id, bool wait = true);
+
+  bool getJobStats(JobId id, JobStats& stats);
+  Stats getStats();
+
+private:
+  TimerScheduler();
+  ~TimerScheduler();
+  TimerScheduler(const TimerScheduler&);
+  TimerScheduler& operator=(const TimerScheduler&);
+
+  static const int      LEVEL_NUM  = 4;
+  static const int      SLOT_BITS  = 6;
+  static const int      SLOT_NUM   = 1 << SLOT_BITS;
+  static const uint32_t SLOT_MASK  = SLOT_NUM - 1;
+  //! Longest sleep of a worker while jobs are pending
+  static const uint32_t MAX_WAIT_MS = 60000;
+
+  typedef struct Job
+  {
+    JobId       id;
+    JobFunc     func;
+    void*       arg;
+    const char* name;
+    Priority    priority;
+    //! 0 for a one-shot job
+    uint32_t    periodMs;
+    //! Next run, in ms since the scheduler started
+    uint64_t    dueMs;
+    //! dueMs rounded up to a tick, the slot it sits in
+    uint64_t    expires;
+    //! Due time of the queued run, for the lateness
+    uint64_t    queuedDueMs;
+    //! The wheel slot the job is linked in, NULL when not in the wheel
+    Job**       slot;
+    Job*        prev;
+    Job*        next;
+    bool        queued;
+    bool        running;
+    bool        canceled;
+    JobStats    stats;
+    //! Posted when the run in progress returns, one per cancel(id, true)
+    std::vector<T_OsdkSemHandle> waiters;
+  } Job;
+
+  JobId add(JobFunc func, void* arg, uint32_t periodMs, uint32_t delayMs,
+            const char* name, Priority priority);
+  bool start();
+  void stop();
+  static void* workerEntry(void* arg);
+  static void* urgentWorkerEntry(void* arg);
+  void workerLoop(bool urgentOnly);
+  void handOff();
+
+  uint64_t nowTick();
+  void insert(Job* job);
+  void unlink(Job* job);
+  void expire(Job* job);
+  void cascade(int level);
+  void advance(uint64_t toTick);
+  uint64_t nextExpiry();
+  void finish(Job* job, uint32_t lateMs, uint32_t runMs);
+  void release(Job* job);
+
+  T_OsdkMutexHandle mutex;
+  T_OsdkSemHandle   wake;
+  T_OsdkSemHandle   urgentWake;
+  T_OsdkSemHandle   exited;
+  //! The PRIORITY_HIGH worker first, then the WORKER_NUM others
+  T_OsdkTaskHandle  workers[WORKER_NUM + 1];
+  uint32_t          workerNum;
+  bool              started;
+  bool              stopping;
+
+  Job*              wheel[LEVEL_NUM][SLOT_NUM];
+  //! Jobs in the wheel
+  uint32_t          pending;
+  uint64_t          curTick;
+  //! Tick the sleeping workers wake up at, to know whether to wake them
+  uint64_t          wakeTick;
+  uint32_t          sleeping;
+  uint64_t          urgentWakeTick;
+  bool              urgentSleeping;
+  uint32_t          lastMs;
+  uint64_t          elapsedMs;
+
+  std::deque<Job*>      ready;
+  //! Due PRIORITY_HIGH jobs, taken before the ready ones by every worker
+  std::deque<Job*>      urgent;
+  std::map<JobId, Job*> jobs;
+  JobId                 nextId;
+  Stats                 stats;
+};
+
+} // namespace OSDK
+} // namespace DJI
+
+#endif // DJI_TIMER_SCHEDULER_H
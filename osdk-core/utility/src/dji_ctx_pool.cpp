@@ -0,0 +1,172 @@
+/** @file dji_ctx_pool.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Fixed capacity pool for asynchronous request contexts
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "dji_ctx_pool.hpp"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__linux__)
+#include <thread>
+#endif
+
+using namespace DJI::OSDK;
+
+AsyncContextPool&
+AsyncContextPool::instance()
+{
+  static AsyncContextPool pool;
+  return pool;
+}
+
+AsyncContextPool::AsyncContextPool()
+  : freeList(NULL)
+{
+#if defined(__linux__)
+  spin.clear();
+#else
+  OsdkOsal_MutexCreate(&mutex);
+#endif
+  memset(&stats, 0, sizeof(stats));
+  stats.capacity = BLOCK_NUM;
+
+#if DJIOSDK_CTX_POOL_BLOCKS > 0
+  for (int i = BLOCK_NUM - 1; i >= 0; i--)
+  {
+    arena[i].next = freeList;
+    freeList      = &arena[i];
+  }
+#endif
+}
+
+void*
+AsyncContextPool::alloc(size_t size)
+{
+#if DJIOSDK_CTX_POOL_BLOCKS == 0
+  return ::malloc(size);
+#endif
+  if (size > BLOCK_SIZE)
+  {
+    lock();
+    stats.oversizeCount++;
+    unlock();
+    return ::malloc(size);
+  }
+
+  lock();
+  Block* block = freeList;
+  if (block)
+  {
+    freeList = block->next;
+    stats.allocCount++;
+    stats.inUse++;
+    if (stats.inUse > stats.highWaterMark)
+    {
+      stats.highWaterMark = stats.inUse;
+    }
+  }
+  else
+  {
+    stats.exhaustCount++;
+  }
+  unlock();
+
+  return block ? (void*)block : ::malloc(size);
+}
+
+void
+AsyncContextPool::free(void* ptr)
+{
+  if (!ptr)
+  {
+    return;
+  }
+
+  if (!isPoolBlock(ptr))
+  {
+    ::free(ptr);
+    return;
+  }
+
+  Block* block = (Block*)ptr;
+  lock();
+  block->next = freeList;
+  freeList    = block;
+  stats.inUse--;
+  unlock();
+}
+
+AsyncContextPool::Stats
+AsyncContextPool::getStats()
+{
+  lock();
+  Stats ret = stats;
+  unlock();
+  return ret;
+}
+
+bool
+AsyncContextPool::isPoolBlock(const void* ptr) const
+{
+#if DJIOSDK_CTX_POOL_BLOCKS > 0
+  const uint8_t* p = (const uint8_t*)ptr;
+  return (p >= (const uint8_t*)&arena[0]) &&
+         (p < (const uint8_t*)&arena[BLOCK_NUM]);
+#else
+  (void)ptr;
+  return false;
+#endif
+}
+
+void
+AsyncContextPool::lock()
+{
+#if defined(__linux__)
+  // The holder only swaps a pointer, but it may have been preempted; give
+  // up the CPU instead of spinning through its time slice
+  uint32_t spins = 0;
+  while (spin.test_and_set(std::memory_order_acquire))
+  {
+    if (++spins >= 64)
+    {
+      std::this_thread::yield();
+      spins = 0;
+    }
+  }
+#else
+  OsdkOsal_MutexLock(mutex);
+#endif
+}
+
+void
+AsyncContextPool::unlock()
+{
+#if defined(__linux__)
+  spin.clear(std::memory_order_release);
+#else
+  OsdkOsal_MutexUnlock(mutex);
+#endif
+}
@@ -0,0 +1,674 @@
+/** @file dji_timer_scheduler.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief Shared timer wheel for the periodic and one-shot jobs of the OSDK
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "dji_timer_scheduler.hpp"
+#include "dji_log.hpp"
+#include <string.h>
+
+using namespace DJI::OSDK;
+
+static const uint64_t NEVER = ~(uint64_t)0;
+
+static const uint32_t lateBucketMs[TimerScheduler::LATE_BUCKET_NUM - 1] = {
+  TimerScheduler::TICK_MS, 20, 50, 100, 500
+};
+
+TimerScheduler&
+TimerScheduler::instance()
+{
+  static TimerScheduler scheduler;
+  return scheduler;
+}
+
+TimerScheduler::TimerScheduler()
+  : mutex(NULL)
+  , wake(NULL)
+  , urgentWake(NULL)
+  , exited(NULL)
+  , workerNum(0)
+  , started(false)
+  , stopping(false)
+  , pending(0)
+  , curTick(0)
+  , wakeTick(NEVER)
+  , sleeping(0)
+  , urgentWakeTick(NEVER)
+  , urgentSleeping(false)
+  , lastMs(0)
+  , elapsedMs(0)
+  , nextId(1)
+{
+  memset(wheel, 0, sizeof(wheel));
+  memset(workers, 0, sizeof(workers));
+  memset(&stats, 0, sizeof(stats));
+
+  if ((OsdkOsal_MutexCreate(&mutex) != OSDK_STAT_OK) ||
+      (OsdkOsal_SemaphoreCreate(&wake, 0) != OSDK_STAT_OK) ||
+      (OsdkOsal_SemaphoreCreate(&urgentWake, 0) != OSDK_STAT_OK) ||
+      (OsdkOsal_SemaphoreCreate(&exited, 0) != OSDK_STAT_OK))
+  {
+    DERROR("Timer scheduler init failed");
+    mutex = NULL;
+  }
+}
+
+TimerScheduler::~TimerScheduler()
+{
+  if (!mutex)
+  {
+    return;
+  }
+  stop();
+
+  for (std::map<JobId, Job*>::iterator it = jobs.begin(); it != jobs.end();
+       ++it)
+  {
+    delete it->second;
+  }
+  jobs.clear();
+
+  OsdkOsal_SemaphoreDestroy(exited);
+  OsdkOsal_SemaphoreDestroy(urgentWake);
+  OsdkOsal_SemaphoreDestroy(wake);
+  OsdkOsal_MutexDestroy(mutex);
+}
+
+bool
+TimerScheduler::start()
+{
+  elapsedMs = 0;
+  curTick   = 0;
+  OsdkOsal_GetTimeMs(&lastMs);
+
+  /*! Without it the PRIORITY_HIGH jobs still run first on the others */
+  if (OsdkOsal_TaskCreate(&workers[workerNum], urgentWorkerEntry,
+                          OSDK_TASK_STACK_SIZE_DEFAULT, this) != OSDK_STAT_OK)
+  {
+    DERROR("Timer scheduler priority worker creation failed");
+  }
+  else
+  {
+    workerNum++;
+  }
+
+  uint32_t normalNum = 0;
+  for (uint32_t i = 0; i < WORKER_NUM; i++)
+  {
+    if (OsdkOsal_TaskCreate(&workers[workerNum], workerEntry,
+                            OSDK_TASK_STACK_SIZE_DEFAULT, this) != OSDK_STAT_OK)
+    {
+      DERROR("Timer scheduler worker %d creation failed", i);
+      continue;
+    }
+    workerNum++;
+    normalNum++;
+  }
+
+  started = (normalNum > 0);
+  return started;
+}
+
+void
+TimerScheduler::stop()
+{
+  OsdkOsal_MutexLock(mutex);
+  stopping = true;
+  OsdkOsal_MutexUnlock(mutex);
+
+  for (uint32_t i = 0; i < workerNum; i++)
+  {
+    OsdkOsal_SemaphorePost(wake);
+  }
+  OsdkOsal_SemaphorePost(urgentWake);
+  /*! A worker stuck in a job is cancelled by TaskDestroy */
+  for (uint32_t i = 0; i < workerNum; i++)
+  {
+    OsdkOsal_SemaphoreTimedWait(exited, 3000);
+  }
+  for (uint32_t i = 0; i < workerNum; i++)
+  {
+    OsdkOsal_TaskDestroy(workers[i]);
+  }
+  workerNum = 0;
+}
+
+TimerScheduler::JobId
+TimerScheduler::schedulePeriodic(JobFunc func, void* arg, uint32_t periodMs,
+                                 uint32_t delayMs, const char* name,
+                                 Priority priority)
+{
+  if (periodMs == 0)
+  {
+    return 0;
+  }
+  return add(func, arg, periodMs, delayMs, name, priority);
+}
+
+TimerScheduler::JobId
+TimerScheduler::scheduleOnce(JobFunc func, void* arg, uint32_t delayMs,
+                             const char* name, Priority priority)
+{
+  return add(func, arg, 0, delayMs, name, priority);
+}
+
+TimerScheduler::JobId
+TimerScheduler::add(JobFunc func, void* arg, uint32_t periodMs,
+                    uint32_t delayMs, const char* name, Priority priority)
+{
+  if (!func || !mutex)
+  {
+    return 0;
+  }
+
+  OsdkOsal_MutexLock(mutex);
+  if (stopping || (!started && !start()))
+  {
+    OsdkOsal_MutexUnlock(mutex);
+    return 0;
+  }
+  advance(nowTick());
+
+  Job* job = new Job();
+  memset(&job->stats, 0, sizeof(job->stats));
+  while ((nextId == 0) || (jobs.find(nextId) != jobs.end()))
+  {
+    nextId++;
+  }
+  job->id       = nextId++;
+  job->func     = func;
+  job->arg      = arg;
+  job->name     = name;
+  job->priority = priority;
+  job->periodMs = periodMs;
+  job->dueMs    = elapsedMs + delayMs;
+  /*! Rounded up, a job never runs early */
+  job->expires  = (job->dueMs + TICK_MS - 1) / TICK_MS;
+  job->slot     = NULL;
+  job->prev     = NULL;
+  job->next     = NULL;
+  job->queued   = false;
+  job->running  = false;
+  job->canceled = false;
+  jobs[job->id] = job;
+  stats.jobs++;
+
+  JobId id = job->id;
+  insert(job);
+
+  /*! Whoever wakes up advances the wheel and hands the jobs on */
+  if (urgentSleeping && (!urgent.empty() || (job->expires < urgentWakeTick)))
+  {
+    OsdkOsal_SemaphorePost(urgentWake);
+  }
+  else if (sleeping && (!ready.empty() || !urgent.empty() ||
+                        (job->expires < wakeTick)))
+  {
+    OsdkOsal_SemaphorePost(wake);
+  }
+  OsdkOsal_MutexUnlock(mutex);
+  return id;
+}
+
+bool
+TimerScheduler::cancel(JobId id, bool wait)
+{
+  if (!mutex)
+  {
+    return false;
+  }
+
+  OsdkOsal_MutexLock(mutex);
+  std::map<JobId, Job*>::iterator it = jobs.find(id);
+  if (it == jobs.end())
+  {
+    OsdkOsal_MutexUnlock(mutex);
+    return false;
+  }
+
+  Job* job = it->second;
+  bool ret = !job->canceled;
+  job->canceled = true;
+  unlink(job);
+
+  T_OsdkSemHandle done = NULL;
+  if (job->running)
+  {
+    /*! The worker releases it and posts the waiters when the run returns */
+    if (wait && (OsdkOsal_SemaphoreCreate(&done, 0) == OSDK_STAT_OK))
+    {
+      job->waiters.push_back(done);
+    }
+  }
+  else if (!job->queued)
+  {
+    /*! A queued job is instead dropped by the worker that takes it */
+    release(job);
+  }
+  OsdkOsal_MutexUnlock(mutex);
+
+  if (done)
+  {
+    OsdkOsal_SemaphoreWait(done);
+    OsdkOsal_SemaphoreDestroy(done);
+  }
+  return ret;
+}
+
+bool
+TimerScheduler::getJobStats(JobId id, JobStats& jobStats)
+{
+  if (!mutex)
+  {
+    return false;
+  }
+
+  OsdkOsal_MutexLock(mutex);
+  std::map<JobId, Job*>::iterator it = jobs.find(id);
+  bool found = (it != jobs.end());
+  if (found)
+  {
+    jobStats = it->second->stats;
+  }
+  OsdkOsal_MutexUnlock(mutex);
+  return found;
+}
+
+TimerScheduler::Stats
+TimerScheduler::getStats()
+{
+  if (!mutex)
+  {
+    return stats;
+  }
+
+  OsdkOsal_MutexLock(mutex);
+  Stats ret = stats;
+  OsdkOsal_MutexUnlock(mutex);
+  return ret;
+}
+
+uint64_t
+TimerScheduler::nowTick()
+{
+  uint32_t ms = 0;
+  OsdkOsal_GetTimeMs(&ms);
+  /*! Unsigned difference, survives the wrap of the 32 bit ms clock */
+  elapsedMs += (uint32_t)(ms - lastMs);
+  lastMs = ms;
+  return elapsedMs / TICK_MS;
+}
+
+/*! Level n holds the jobs due in less than 64^(n+1) ticks, in the slot of
+ *  their expiry, so a slot of level n is moved down exactly when the ticks
+ *  of level n-1 wrap around to it.
+ */
+void
+TimerScheduler::insert(Job* job)
+{
+  if (job->expires <= curTick)
+  {
+    expire(job);
+    return;
+  }
+
+  uint64_t delta = job->expires - curTick;
+  uint64_t at    = job->expires;
+  int      level = 0;
+  while ((level < LEVEL_NUM - 1) &&
+         (delta >= ((uint64_t)1 << (SLOT_BITS * (level + 1)))))
+  {
+    level++;
+  }
+  /*! Beyond the wheel: parked in the farthest slot, placed again later */
+  if (delta >= ((uint64_t)1 << (SLOT_BITS * LEVEL_NUM)))
+  {
+    at = curTick + ((uint64_t)1 << (SLOT_BITS * LEVEL_NUM)) - 1;
+  }
+
+  Job** slot = &wheel[level][(at >> (SLOT_BITS * level)) & SLOT_MASK];
+  job->slot  = slot;
+  job->prev  = NULL;
+  job->next  = *slot;
+  if (*slot)
+  {
+    (*slot)->prev = job;
+  }
+  *slot = job;
+  pending++;
+}
+
+void
+TimerScheduler::unlink(Job* job)
+{
+  if (!job->slot)
+  {
+    return;
+  }
+  if (job->prev)
+  {
+    job->prev->next = job->next;
+  }
+  else
+  {
+    *job->slot = job->next;
+  }
+  if (job->next)
+  {
+    job->next->prev = job->prev;
+  }
+  job->slot = NULL;
+  job->prev = NULL;
+  job->next = NULL;
+  pending--;
+}
+
+void
+TimerScheduler::expire(Job* job)
+{
+  uint64_t due = job->dueMs;
+
+  if (job->periodMs)
+  {
+    /*! The period counts from the due time, so runs do not drift */
+    uint64_t nowMs = curTick * TICK_MS;
+    job->dueMs += job->periodMs;
+    if (job->dueMs <= nowMs)
+    {
+      /*! Every worker was busy for whole periods, those runs are lost */
+      uint64_t missed = (nowMs - job->dueMs) / job->periodMs + 1;
+      job->dueMs += missed * job->periodMs;
+      job->stats.overruns += (uint32_t)missed;
+      stats.overruns += missed;
+    }
+    job->expires = (job->dueMs + TICK_MS - 1) / TICK_MS;
+    insert(job);
+  }
+
+  if (job->running || job->queued)
+  {
+    job->stats.overruns++;
+    stats.overruns++;
+    return;
+  }
+
+  job->queued      = true;
+  job->queuedDueMs = due;
+  if (job->priority == PRIORITY_HIGH)
+  {
+    urgent.push_back(job);
+  }
+  else
+  {
+    ready.push_back(job);
+  }
+}
+
+void
+TimerScheduler::cascade(int level)
+{
+  Job** slot = &wheel[level][(curTick >> (SLOT_BITS * level)) & SLOT_MASK];
+  Job*  job  = *slot;
+  *slot      = NULL;
+
+  while (job)
+  {
+    Job* next = job->next;
+    job->slot = NULL;
+    job->prev = NULL;
+    job->next = NULL;
+    pending--;
+    insert(job);
+    job = next;
+  }
+}
+
+void
+TimerScheduler::advance(uint64_t toTick)
+{
+  while (curTick < toTick)
+  {
+    if (pending == 0)
+    {
+      curTick = toTick;
+      break;
+    }
+
+    curTick++;
+    for (int level = LEVEL_NUM - 1; level > 0; level--)
+    {
+      if ((curTick & (((uint64_t)1 << (SLOT_BITS * level)) - 1)) == 0)
+      {
+        cascade(level);
+      }
+    }
+    cascade(0);
+  }
+}
+
+/*! Only asked by a worker that has nothing to run */
+uint64_t
+TimerScheduler::nextExpiry()
+{
+  if (pending == 0)
+  {
+    return NEVER;
+  }
+
+  /*! The next non-empty slot of each level; for the upper levels that is
+   *  when the slot is moved down, not yet the expiry itself
+   */
+  uint64_t next = NEVER;
+  for (int level = 0; level < LEVEL_NUM; level++)
+  {
+    uint64_t block = curTick >> (SLOT_BITS * level);
+    for (uint32_t k = 1; k <= (uint32_t)SLOT_NUM; k++)
+    {
+      if (wheel[level][(block + k) & SLOT_MASK])
+      {
+        uint64_t at = (block + k) << (SLOT_BITS * level);
+        if (at < next)
+        {
+          next = at;
+        }
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+void
+TimerScheduler::finish(Job* job, uint32_t lateMs, uint32_t runMs)
+{
+  job->stats.runs++;
+  job->stats.totalLateMs += lateMs;
+  if (lateMs > job->stats.maxLateMs)
+  {
+    job->stats.maxLateMs = lateMs;
+  }
+  if (runMs > job->stats.maxRunMs)
+  {
+    job->stats.maxRunMs = runMs;
+  }
+
+  stats.runs++;
+  if (lateMs > stats.maxLateMs)
+  {
+    stats.maxLateMs = lateMs;
+  }
+  uint32_t bucket = 0;
+  while ((bucket < LATE_BUCKET_NUM - 1) && (lateMs >= lateBucketMs[bucket]))
+  {
+    bucket++;
+  }
+  stats.lateHistogram[bucket]++;
+
+  if (job->canceled || (job->periodMs == 0))
+  {
+    release(job);
+  }
+}
+
+void
+TimerScheduler::release(Job* job)
+{
+  unlink(job);
+  jobs.erase(job->id);
+  stats.jobs--;
+  delete job;
+}
+
+void*
+TimerScheduler::workerEntry(void* arg)
+{
+  static_cast<TimerScheduler*>(arg)->workerLoop(false);
+  return NULL;
+}
+
+void*
+TimerScheduler::urgentWorkerEntry(void* arg)
+{
+  static_cast<TimerScheduler*>(arg)->workerLoop(true);
+  return NULL;
+}
+
+/*! Wake a sleeping worker for the due jobs the caller does not take */
+void
+TimerScheduler::handOff()
+{
+  if (urgentSleeping && !urgent.empty())
+  {
+    OsdkOsal_SemaphorePost(urgentWake);
+  }
+  if (sleeping && (!ready.empty() || !urgent.empty()))
+  {
+    OsdkOsal_SemaphorePost(wake);
+  }
+}
+
+/*! The PRIORITY_HIGH worker runs only urgent jobs, but still advances the
+ *  wheel for everyone, so normal jobs get queued even while all the other
+ *  workers are stuck in a job.
+ */
+void
+TimerScheduler::workerLoop(bool urgentOnly)
+{
+  OsdkOsal_MutexLock(mutex);
+  while (!stopping)
+  {
+    advance(nowTick());
+
+    std::deque<Job*>* queue = NULL;
+    if (!urgent.empty())
+    {
+      queue = &urgent;
+    }
+    else if (!urgentOnly && !ready.empty())
+    {
+      queue = &ready;
+    }
+
+    if (!queue)
+    {
+      handOff();
+
+      uint64_t next   = nextExpiry();
+      uint64_t dueMs  = (next == NEVER) ? NEVER : next * TICK_MS;
+      uint32_t waitMs = MAX_WAIT_MS;
+      if ((dueMs != NEVER) && (dueMs - elapsedMs < MAX_WAIT_MS))
+      {
+        waitMs = (uint32_t)(dueMs - elapsedMs);
+      }
+
+      T_OsdkSemHandle sem = urgentOnly ? urgentWake : wake;
+      if (urgentOnly)
+      {
+        urgentWakeTick = next;
+        urgentSleeping = true;
+      }
+      else
+      {
+        wakeTick = next;
+        sleeping++;
+      }
+      OsdkOsal_MutexUnlock(mutex);
+      if (next == NEVER)
+      {
+        OsdkOsal_SemaphoreWait(sem);
+      }
+      else
+      {
+        OsdkOsal_SemaphoreTimedWait(sem, waitMs);
+      }
+      OsdkOsal_MutexLock(mutex);
+      if (urgentOnly)
+      {
+        urgentSleeping = false;
+      }
+      else
+      {
+        sleeping--;
+      }
+      continue;
+    }
+
+    Job* job = queue->front();
+    queue->pop_front();
+    job->queued = false;
+    if (job->canceled)
+    {
+      release(job);
+      continue;
+    }
+
+    /*! More due than this worker can take, hand some to a sleeping one */
+    handOff();
+
+    uint64_t dueMs  = job->queuedDueMs;
+    uint32_t lateMs = (elapsedMs > dueMs) ? (uint32_t)(elapsedMs - dueMs) : 0;
+    uint32_t startMs = 0;
+    uint32_t endMs   = 0;
+    job->running = true;
+    OsdkOsal_MutexUnlock(mutex);
+
+    OsdkOsal_GetTimeMs(&startMs);
+    job->func(job->arg, job->id);
+    OsdkOsal_GetTimeMs(&endMs);
+
+    OsdkOsal_MutexLock(mutex);
+    job->running = false;
+    for (size_t i = 0; i < job->waiters.size(); i++)
+    {
+      OsdkOsal_SemaphorePost(job->waiters[i]);
+    }
+    job->waiters.clear();
+    finish(job, lateMs, endMs - startMs);
+  }
+  OsdkOsal_MutexUnlock(mutex);
+  OsdkOsal_SemaphorePost(exited);
+}
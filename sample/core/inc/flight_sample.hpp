@@ -175,5 +175,6 @@ class FlightSample {
   bool takeOffInAirCheck();
   bool takeoffFinishedCheck();
   bool landFinishedCheck();
+  bool landingStoppedCheck(int timeoutInMs);
 };
 #endif  // DJIOSDK_FLIGHT_SAMPLE_HPP
@@ -260,7 +260,8 @@ bool FlightSample::moveByPositionOffset(const Vector3f& offsetDesired,
     if (withinBoundsCounter >= withinControlBoundsTimeReqmt) {
       break;
     }
-    usleep(cycleTimeInMs * 1000);
+    //! Run the next cycle as soon as new position data arrives
+    vehicle->subscribe->waitForUpdate<TOPIC_GPS_FUSED>(2 * cycleTimeInMs);
     elapsedTimeInMs += cycleTimeInMs;
   }
 
@@ -300,12 +301,14 @@ bool FlightSample::goHomeAndConfirmLanding(int timeout) {
   if (!checkActionStarted(VehicleStatus::DisplayMode::MODE_NAVI_GO_HOME)) {
     return false;
   } else {
-    while (vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
-               VehicleStatus::DisplayMode::MODE_NAVI_GO_HOME &&
-           vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() ==
-               VehicleStatus::FlightStatus::IN_AIR) {
-      Platform::instance().taskSleepMs(
-          1000);  // waiting for this action finished
+    //! waiting for this action finished
+    while (!vehicle->subscribe->waitUntil<TOPIC_STATUS_DISPLAYMODE>(
+        [this](uint8_t mode) {
+          return mode != VehicleStatus::DisplayMode::MODE_NAVI_GO_HOME ||
+                 vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() !=
+                     VehicleStatus::FlightStatus::IN_AIR;
+        },
+        1000)) {
     }
   }
   DSTATUS("Finished go home action");
@@ -316,17 +319,17 @@ bool FlightSample::goHomeAndConfirmLanding(int timeout) {
     DERROR("Fail to execute Landing action!");
     return false;
   } else {
-    while (vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
-               VehicleStatus::DisplayMode::MODE_AUTO_LANDING &&
-           vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() ==
-               VehicleStatus::FlightStatus::IN_AIR) {
-      Telemetry::TypeMap<TOPIC_AVOID_DATA>::type avoidData =
-          vehicle->subscribe->getValue<TOPIC_AVOID_DATA>();
-      Platform::instance().taskSleepMs(1000);
-      if ((0.65 < avoidData.down && avoidData.down < 0.75) &&
-          (avoidData.downHealth == 1)) {
-        break;
-      }
+    //! Landing goes on until the aircraft is about 0.7 m above the ground
+    while (!vehicle->subscribe->waitUntil<TOPIC_AVOID_DATA>(
+        [this](const Telemetry::TypeMap<TOPIC_AVOID_DATA>::type& avoidData) {
+          return vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() !=
+                     VehicleStatus::DisplayMode::MODE_AUTO_LANDING ||
+                 vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() !=
+                     VehicleStatus::FlightStatus::IN_AIR ||
+                 ((0.65 < avoidData.down && avoidData.down < 0.75) &&
+                  (avoidData.downHealth == 1));
+        },
+        1000)) {
     }
   }
   DSTATUS("Finished landing action");
@@ -345,11 +348,7 @@ bool FlightSample::goHomeAndConfirmLanding(int timeout) {
   if (!checkActionStarted(VehicleStatus::DisplayMode::MODE_AUTO_LANDING)) {
     return false;
   } else {
-    while (vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
-               VehicleStatus::DisplayMode::MODE_AUTO_LANDING &&
-           vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() ==
-               VehicleStatus::FlightStatus::IN_AIR) {
-      Platform::instance().taskSleepMs(1000);
+    while (!landingStoppedCheck(1000)) {
     }
   }
   DSTATUS("Finished force Landing and avoid ground action");
@@ -473,14 +472,10 @@ bool FlightSample::startGlobalPositionBroadcast(void)
 }
 
 bool FlightSample::checkActionStarted(uint8_t mode) {
-  int actionNotStarted = 0;
-  int timeoutCycles = 20;
-  while (vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() != mode &&
-         actionNotStarted < timeoutCycles) {
-    actionNotStarted++;
-    Platform::instance().taskSleepMs(100);
-  }
-  if (actionNotStarted == timeoutCycles) {
+  int timeoutInMs = 2000;
+  if (!vehicle->subscribe->waitUntil<TOPIC_STATUS_DISPLAYMODE>(
+          [mode](uint8_t displayMode) { return displayMode == mode; },
+          timeoutInMs)) {
     DERROR("Start actions mode %d failed, current DISPLAYMODE is: %d ...", mode,
            vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>());
     return false;
@@ -621,42 +616,32 @@ Vector3f FlightSample::localOffsetFromGpsAndFusedHeightOffset(
 }
 
 bool FlightSample::motorStartedCheck() {
-  int motorsNotStarted = 0;
-  int timeoutCycles = 20;
-  while (vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() !=
-             VehicleStatus::FlightStatus::ON_GROUND &&
-         vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() !=
-             VehicleStatus::DisplayMode::MODE_ENGINE_START &&
-         motorsNotStarted < timeoutCycles) {
-    motorsNotStarted++;
-    usleep(100000);
-  }
-  return motorsNotStarted != timeoutCycles ? true : false;
+  int timeoutInMs = 2000;
+  return vehicle->subscribe->waitUntil<TOPIC_STATUS_FLIGHT>(
+      [this](uint8_t flightStatus) {
+        return flightStatus == VehicleStatus::FlightStatus::ON_GROUND ||
+               vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
+                   VehicleStatus::DisplayMode::MODE_ENGINE_START;
+      },
+      timeoutInMs);
 }
 
 bool FlightSample::takeOffInAirCheck() {
-  int stillOnGround = 0;
-  int timeoutCycles = 110;
-  while (vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() !=
-             VehicleStatus::FlightStatus::IN_AIR &&
-         (vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() !=
-              VehicleStatus::DisplayMode::MODE_ASSISTED_TAKEOFF ||
-          vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() !=
-              VehicleStatus::DisplayMode::MODE_AUTO_TAKEOFF) &&
-         stillOnGround < timeoutCycles) {
-    stillOnGround++;
-    usleep(100000);
-  }
-
-  return stillOnGround != timeoutCycles ? true : false;
+  int timeoutInMs = 11000;
+  return vehicle->subscribe->waitUntil<TOPIC_STATUS_FLIGHT>(
+      [](uint8_t flightStatus) {
+        return flightStatus == VehicleStatus::FlightStatus::IN_AIR;
+      },
+      timeoutInMs);
 }
 
 bool FlightSample::takeoffFinishedCheck() {
-  while (vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
-             VehicleStatus::DisplayMode::MODE_ASSISTED_TAKEOFF ||
-         vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
-             VehicleStatus::DisplayMode::MODE_AUTO_TAKEOFF) {
-    sleep(1);
+  while (!vehicle->subscribe->waitUntil<TOPIC_STATUS_DISPLAYMODE>(
+      [](uint8_t mode) {
+        return mode != VehicleStatus::DisplayMode::MODE_ASSISTED_TAKEOFF &&
+               mode != VehicleStatus::DisplayMode::MODE_AUTO_TAKEOFF;
+      },
+      1000)) {
   }
   return ((vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
            VehicleStatus::DisplayMode::MODE_P_GPS) ||
@@ -666,14 +651,21 @@ bool FlightSample::takeoffFinishedCheck() {
              : false;
 }
 
+ bool FlightSample::landingStoppedCheck(int timeoutInMs)
+ {
+   return vehicle->subscribe->waitUntil<TOPIC_STATUS_DISPLAYMODE>(
+       [this](uint8_t mode) {
+         return mode != VehicleStatus::DisplayMode::MODE_AUTO_LANDING ||
+                vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() !=
+                    VehicleStatus::FlightStatus::IN_AIR;
+       },
+       timeoutInMs);
+ }
+
  bool FlightSample::landFinishedCheck(void)
  {
-    while(vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() ==
-               VehicleStatus::DisplayMode::MODE_AUTO_LANDING &&
-           vehicle->subscribe->getValue<TOPIC_STATUS_FLIGHT>() ==
-               VehicleStatus::FlightStatus::IN_AIR)
+   while (!landingStoppedCheck(1000))
    {
-      Platform::instance().taskSleepMs(1000);
    }
 
    return ((vehicle->subscribe->getValue<TOPIC_STATUS_DISPLAYMODE>() !=
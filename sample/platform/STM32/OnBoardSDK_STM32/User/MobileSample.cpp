@@ -129,7 +129,7 @@ controlAuthorityMobileCallback(Vehicle* vehiclePtr, RecvContainer recvFrame,
       mobileAck.cmdID = 0x03;
     }
     mobileAck.ack = static_cast<uint16_t>(ack.data);
-    vehiclePtr->mobileDevice->sendDataToMSDK(reinterpret_cast<uint8_t*>(&mobileAck),
+    vehiclePtr->getMobileDevice()->sendDataToMSDK(reinterpret_cast<uint8_t*>(&mobileAck),
                                     sizeof(mobileAck));
   }
 }
@@ -165,7 +165,7 @@ actionMobileCallback(Vehicle* vehiclePtr, RecvContainer recvFrame,
     {
       mobileAck.cmdID = 0x05;
       mobileAck.ack   = static_cast<uint16_t>(ack.data);
-      vehiclePtr->mobileDevice->sendDataToMSDK(reinterpret_cast<uint8_t*>(&mobileAck),
+      vehiclePtr->getMobileDevice()->sendDataToMSDK(reinterpret_cast<uint8_t*>(&mobileAck),
                                       sizeof(mobileAck));
     }
     else if (recvFrame.recvInfo.buf[2] == Control::FlightCommand::stopMotor ||
@@ -174,7 +174,7 @@ actionMobileCallback(Vehicle* vehiclePtr, RecvContainer recvFrame,
     {
 			mobileAck.cmdID = 0x06;
       mobileAck.ack   = static_cast<uint16_t>(ack.data);
-      vehiclePtr->mobileDevice->sendDataToMSDK(reinterpret_cast<uint8_t*>(&mobileAck),
+      vehiclePtr->getMobileDevice()->sendDataToMSDK(reinterpret_cast<uint8_t*>(&mobileAck),
                                       sizeof(mobileAck));
     }
   }
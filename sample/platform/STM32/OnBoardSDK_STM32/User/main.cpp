@@ -229,7 +229,7 @@ void *mainLoopTask(void *p){
           delay_nms(1000);
 
           // Run Mobile Communication sample
-          v->mobileDevice->setFromMSDKCallback(parseFromMobileCallback);
+          v->getMobileDevice()->setFromMSDKCallback(parseFromMobileCallback);
           DSTATUS(
               "Mobile callback registered. Trigger command mobile "
               "App.\r\n");
@@ -69,12 +69,21 @@ LinuxSetup::setupEnvironment(int argc, char** argv)
       .func = OsdkUser_Console,
   };
 
+#ifdef OSDK_UART_EPOLL
+  static T_OsdkHalUartHandler halUartHandler = {
+      .UartInit = OsdkLinux_UartEpollInit,
+      .UartWriteData = OsdkLinux_UartSendData,
+      .UartReadData = OsdkLinux_UartEpollReadData,
+      .UartClose = OsdkLinux_UartEpollClose,
+  };
+#else
   static T_OsdkHalUartHandler halUartHandler = {
       .UartInit = OsdkLinux_UartInit,
       .UartWriteData = OsdkLinux_UartSendData,
       .UartReadData = OsdkLinux_UartReadData,
       .UartClose = OsdkLinux_UartClose,
   };
+#endif
 
 #ifdef ADVANCED_SENSING
   static T_OsdkHalUSBBulkHandler halUSBBulkHandler = {
@@ -27,6 +27,14 @@
 /* Includes ------------------------------------------------------------------*/
 #include "osdkhal_linux.h"
 #include "errno.h"
+#include <linux/serial.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <time.h>
 
 #ifdef OSDK_HOTPLUG
 #include "pthread.h"
@@ -185,6 +193,409 @@ E_OsdkStat OsdkLinux_UartInit(const char *port, const int baudrate,
   return OsdkStat;
 }
 
+/* Epoll uart ----------------------------------------------------------------*/
+#define OSDK_LINUX_UART_CTX_NUM     4
+#define OSDK_LINUX_UART_RING_SIZE   8192 /* power of two */
+#define OSDK_LINUX_UART_READ_MAX    1024 /* per read call, as the polling read */
+#ifndef OSDK_LINUX_UART_EPOLL_WAIT_MS
+#define OSDK_LINUX_UART_EPOLL_WAIT_MS 20
+#endif
+
+/* T_HalObj only carries the fd and is shared with the prebuilt core, so the
+ * per-port state lives here, looked up by fd. One reader thread per port. */
+typedef struct {
+  int fd;
+  int epollFd;
+  int eventFd;
+  int closing;
+  int readers;
+  int closer; /* OsdkLinux_UartEpollClose is still waiting on the readers */
+  uint32_t head; /* free running write index, reader thread only */
+  uint32_t tail; /* free running read index, reader thread only */
+  T_OsdkLinuxUartStats stats;
+  uint8_t ring[OSDK_LINUX_UART_RING_SIZE];
+} T_UartEpollCtx;
+
+static T_UartEpollCtx *s_uartEpollCtx[OSDK_LINUX_UART_CTX_NUM];
+static pthread_mutex_t s_uartEpollMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t OsdkLinux_UartNowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Index of the highest set bit plus one, capped to the histogram size */
+static int OsdkLinux_UartHistIndex(uint64_t value, int num) {
+  int i = 0;
+  while (value && i < num - 1) {
+    value >>= 1;
+    i++;
+  }
+  return i;
+}
+
+/* Call with s_uartEpollMutex held */
+static T_UartEpollCtx *OsdkLinux_UartEpollFind(int fd) {
+  int i;
+  for (i = 0; i < OSDK_LINUX_UART_CTX_NUM; i++) {
+    if (s_uartEpollCtx[i] && s_uartEpollCtx[i]->fd == fd) {
+      return s_uartEpollCtx[i];
+    }
+  }
+  return NULL;
+}
+
+/* Call with s_uartEpollMutex held */
+static T_UartEpollCtx *OsdkLinux_UartEpollCreate(int fd) {
+  struct epoll_event ev;
+  T_UartEpollCtx *ctx;
+  int slot;
+
+  for (slot = 0; slot < OSDK_LINUX_UART_CTX_NUM; slot++) {
+    if (!s_uartEpollCtx[slot]) break;
+  }
+  if (slot == OSDK_LINUX_UART_CTX_NUM) {
+    return NULL;
+  }
+
+  ctx = calloc(1, sizeof(T_UartEpollCtx));
+  if (!ctx) {
+    return NULL;
+  }
+  ctx->fd = fd;
+  ctx->epollFd = epoll_create1(EPOLL_CLOEXEC);
+  ctx->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (ctx->epollFd < 0 || ctx->eventFd < 0) {
+    goto fail;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = ctx->eventFd;
+  if (epoll_ctl(ctx->epollFd, EPOLL_CTL_ADD, ctx->eventFd, &ev) < 0) {
+    goto fail;
+  }
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+  if (epoll_ctl(ctx->epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    goto fail;
+  }
+
+  /* Reads only happen after a wake-up, they must never block */
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  s_uartEpollCtx[slot] = ctx;
+  return ctx;
+
+fail:
+  if (ctx->epollFd >= 0) close(ctx->epollFd);
+  if (ctx->eventFd >= 0) close(ctx->eventFd);
+  free(ctx);
+  return NULL;
+}
+
+/* Call with s_uartEpollMutex held, once ctx is out of s_uartEpollCtx and
+ * nobody uses it any more */
+static void OsdkLinux_UartEpollFree(T_UartEpollCtx *ctx) {
+  close(ctx->epollFd);
+  close(ctx->eventFd);
+  free(ctx);
+}
+
+/* Drain the tty into the free part of the ring with one readv */
+static ssize_t OsdkLinux_UartEpollFill(T_UartEpollCtx *ctx) {
+  struct iovec iov[2];
+  uint32_t freeLen = OSDK_LINUX_UART_RING_SIZE - (ctx->head - ctx->tail);
+  uint32_t pos = ctx->head & (OSDK_LINUX_UART_RING_SIZE - 1);
+  uint32_t first = OSDK_LINUX_UART_RING_SIZE - pos;
+  ssize_t readLen;
+
+  if (freeLen == 0) {
+    errno = EAGAIN;
+    return -1;
+  }
+  if (first > freeLen) first = freeLen;
+  iov[0].iov_base = ctx->ring + pos;
+  iov[0].iov_len = first;
+  iov[1].iov_base = ctx->ring;
+  iov[1].iov_len = freeLen - first;
+
+  readLen = readv(ctx->fd, iov, iov[1].iov_len ? 2 : 1);
+  if (readLen > 0) {
+    ctx->head += readLen;
+  }
+  return readLen;
+}
+
+/**
+ * @brief Set or clear ASYNC_LOW_LATENCY on the serial driver, so received
+ * bytes are pushed to the tty layer without the driver's batching delay.
+ * @param obj: pointer to the hal object, which including uart interface parameters.
+ * @param enable: non-zero to enable.
+ * @return OSDK_STAT_SYS_ERR if the driver does not support it (ptys, some
+ * USB adapters), which is harmless.
+ */
+E_OsdkStat OsdkLinux_UartSetLowLatency(const T_HalObj *obj, int enable) {
+  struct serial_struct serial;
+
+  if ((obj == NULL) || (obj->uartObject.fd == -1)) {
+    return OSDK_STAT_ERR;
+  }
+  if (ioctl(obj->uartObject.fd, TIOCGSERIAL, &serial) < 0) {
+    return OSDK_STAT_SYS_ERR;
+  }
+  if (enable) {
+    serial.flags |= ASYNC_LOW_LATENCY;
+  } else {
+    serial.flags &= ~ASYNC_LOW_LATENCY;
+  }
+  if (ioctl(obj->uartObject.fd, TIOCSSERIAL, &serial) < 0) {
+    return OSDK_STAT_SYS_ERR;
+  }
+  return OSDK_STAT_OK;
+}
+
+/**
+ * @brief Uart interface init function of the epoll variant.
+ * @param port: uart interface port.
+ * @param baudrate:  uart interface baudrate.
+ * @param obj: pointer to the hal object, which is used to store uart interface parameters.
+ * @return an enum that represents a status of OSDK
+ */
+E_OsdkStat OsdkLinux_UartEpollInit(const char *port, const int baudrate,
+                                   T_HalObj *obj) {
+  E_OsdkStat OsdkStat = OsdkLinux_UartInit(port, baudrate, obj);
+  if (OsdkStat != OSDK_STAT_OK) {
+    return OsdkStat;
+  }
+
+  /* Best effort, the wake-up still works without it */
+  OsdkLinux_UartSetLowLatency(obj, 1);
+
+  pthread_mutex_lock(&s_uartEpollMutex);
+  if (!OsdkLinux_UartEpollFind(obj->uartObject.fd) &&
+      !OsdkLinux_UartEpollCreate(obj->uartObject.fd)) {
+    OsdkStat = OSDK_STAT_ERR_ALLOC;
+  }
+  pthread_mutex_unlock(&s_uartEpollMutex);
+
+  if (OsdkStat != OSDK_STAT_OK) {
+    OsdkLinux_UartClose(obj);
+  }
+  return OsdkStat;
+}
+
+/**
+ * @brief Uart interface read function of the epoll variant. Returns buffered
+ * data at once, otherwise waits up to OSDK_LINUX_UART_EPOLL_WAIT_MS for data
+ * or OsdkLinux_UartEpollClose.
+ * @param obj: pointer to the hal object, which including uart interface parameters.
+ * @param pBuf:  pointer to the buffer which is used to store receive data.
+ * @param bufLen:  receive data length, 0 after a timeout.
+ * @return an enum that represents a status of OSDK
+ */
+E_OsdkStat OsdkLinux_UartEpollReadData(const T_HalObj *obj, uint8_t *pBuf,
+                                       uint32_t *bufLen) {
+  struct epoll_event ev[2];
+  T_UartEpollCtx *ctx;
+  uint64_t waitUs = 0;
+  ssize_t chunk[2];
+  int chunkNum = 0;
+  int waited = 0;
+  int wakeData = 0;
+  int wakeShutdown = 0;
+  int hangup = 0;
+  int overflow = 0;
+  int closing = 0;
+  uint32_t used;
+  uint32_t copyLen = 0;
+  int i;
+
+  if ((obj == NULL) || (obj->uartObject.fd == -1)) {
+    return OSDK_STAT_ERR;
+  }
+  *bufLen = 0;
+
+  pthread_mutex_lock(&s_uartEpollMutex);
+  ctx = OsdkLinux_UartEpollFind(obj->uartObject.fd);
+  if (!ctx) {
+    /* e.g. re-opened by the hotplug monitor */
+    ctx = OsdkLinux_UartEpollCreate(obj->uartObject.fd);
+  }
+  if (ctx) {
+    closing = ctx->closing;
+    if (!closing) ctx->readers++;
+  }
+  pthread_mutex_unlock(&s_uartEpollMutex);
+
+  if (!ctx) {
+    return OsdkLinux_UartReadData(obj, pBuf, bufLen);
+  }
+  if (closing) {
+    return OSDK_STAT_ERR;
+  }
+
+  if (ctx->head == ctx->tail) {
+    uint64_t start = OsdkLinux_UartNowUs();
+    int n = epoll_wait(ctx->epollFd, ev, 2, OSDK_LINUX_UART_EPOLL_WAIT_MS);
+    waitUs = OsdkLinux_UartNowUs() - start;
+    waited = 1;
+
+    for (i = 0; i < n; i++) {
+      if (ev[i].data.fd == ctx->eventFd) {
+        wakeShutdown = 1;
+        continue;
+      }
+      if (ev[i].events & (EPOLLHUP | EPOLLERR)) {
+        hangup = 1;
+      }
+      if (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        wakeData = 1;
+        /* A second read picks up what arrived during the first one or
+         * did not fit before the ring wrapped */
+        while (chunkNum < 2) {
+          ssize_t readLen = OsdkLinux_UartEpollFill(ctx);
+          if (readLen <= 0) {
+            if (readLen < 0 && errno == EAGAIN &&
+                ctx->head - ctx->tail == OSDK_LINUX_UART_RING_SIZE) {
+              overflow = 1;
+            }
+            break;
+          }
+          chunk[chunkNum++] = readLen;
+        }
+      }
+    }
+  }
+
+  used = ctx->head - ctx->tail;
+  if (used) {
+    uint32_t pos = ctx->tail & (OSDK_LINUX_UART_RING_SIZE - 1);
+    uint32_t first = OSDK_LINUX_UART_RING_SIZE - pos;
+
+    copyLen = used < OSDK_LINUX_UART_READ_MAX ? used : OSDK_LINUX_UART_READ_MAX;
+    if (first > copyLen) first = copyLen;
+    memcpy(pBuf, ctx->ring + pos, first);
+    memcpy(pBuf + first, ctx->ring, copyLen - first);
+    ctx->tail += copyLen;
+    *bufLen = copyLen;
+  }
+
+  pthread_mutex_lock(&s_uartEpollMutex);
+  ctx->readers--;
+  ctx->stats.readCalls++;
+  ctx->stats.readBytes += copyLen;
+  if (used > ctx->stats.ringHighWater) ctx->stats.ringHighWater = used;
+  if (overflow) ctx->stats.ringOverflow++;
+  for (i = 0; i < chunkNum; i++) {
+    ctx->stats.readSizeHist[OsdkLinux_UartHistIndex(
+        chunk[i] >> 1, OSDK_LINUX_UART_READ_HIST_NUM)]++;
+  }
+  if (waited) {
+    ctx->stats.waitHist[OsdkLinux_UartHistIndex(
+        waitUs, OSDK_LINUX_UART_WAIT_HIST_NUM)]++;
+    if (wakeShutdown) {
+      ctx->stats.wakeShutdown++;
+    } else if (wakeData) {
+      ctx->stats.wakeData++;
+    } else {
+      ctx->stats.wakeTimeout++;
+    }
+  }
+  /* Closed while reading, and the closer gave up waiting */
+  if (ctx->closing && !ctx->readers && !ctx->closer) {
+    OsdkLinux_UartEpollFree(ctx);
+  }
+  pthread_mutex_unlock(&s_uartEpollMutex);
+
+  if (hangup && !copyLen && !wakeShutdown) {
+    /* The device is gone, epoll would report it again at once */
+    usleep(OSDK_LINUX_UART_EPOLL_WAIT_MS * 1000);
+    return OSDK_STAT_ERR;
+  }
+  return OSDK_STAT_OK;
+}
+
+/**
+ * @brief Uart interface close function of the epoll variant. Wakes a reader
+ * blocked in OsdkLinux_UartEpollReadData before releasing the port.
+ * @param obj: pointer to the hal object, which including uart interface parameters.
+ * @return an enum that represents a status of OSDK
+ */
+E_OsdkStat OsdkLinux_UartEpollClose(T_HalObj *obj) {
+  T_UartEpollCtx *ctx;
+  uint64_t one = 1;
+  int readers = 0;
+  int i;
+
+  if ((obj == NULL) || (obj->uartObject.fd == -1)) {
+    return OSDK_STAT_ERR;
+  }
+
+  /* Unlinked at once, so a re-opened port with the same fd gets a fresh
+   * ctx. The ctx itself lives until its last user leaves. */
+  pthread_mutex_lock(&s_uartEpollMutex);
+  ctx = OsdkLinux_UartEpollFind(obj->uartObject.fd);
+  if (ctx) {
+    for (i = 0; i < OSDK_LINUX_UART_CTX_NUM; i++) {
+      if (s_uartEpollCtx[i] == ctx) s_uartEpollCtx[i] = NULL;
+    }
+    ctx->closing = 1;
+    ctx->closer = 1;
+    if (write(ctx->eventFd, &one, sizeof(one)) != sizeof(one)) {
+      perror("OsdkLinux_UartEpollClose");
+    }
+  }
+  pthread_mutex_unlock(&s_uartEpollMutex);
+
+  /* A reader leaves within one wait timeout at most, let it go before the
+   * port is closed */
+  for (i = 0; ctx && i < 100; i++) {
+    pthread_mutex_lock(&s_uartEpollMutex);
+    readers = ctx->readers;
+    pthread_mutex_unlock(&s_uartEpollMutex);
+    if (!readers) break;
+    usleep(10000);
+  }
+
+  if (ctx) {
+    pthread_mutex_lock(&s_uartEpollMutex);
+    ctx->closer = 0;
+    /* Otherwise the last reader frees it */
+    if (!ctx->readers) {
+      OsdkLinux_UartEpollFree(ctx);
+    }
+    pthread_mutex_unlock(&s_uartEpollMutex);
+  }
+
+  return OsdkLinux_UartClose(obj);
+}
+
+/**
+ * @brief Copy the counters of the epoll read path.
+ * @param obj: pointer to the hal object, which including uart interface parameters.
+ * @param stats: receives the counters.
+ * @return OSDK_STAT_ERR_NOT_FOUND if the port is not read through epoll.
+ */
+E_OsdkStat OsdkLinux_UartGetStats(const T_HalObj *obj,
+                                  T_OsdkLinuxUartStats *stats) {
+  T_UartEpollCtx *ctx;
+
+  if ((obj == NULL) || (obj->uartObject.fd == -1) || (stats == NULL)) {
+    return OSDK_STAT_ERR_PARAM;
+  }
+
+  pthread_mutex_lock(&s_uartEpollMutex);
+  ctx = OsdkLinux_UartEpollFind(obj->uartObject.fd);
+  if (ctx) {
+    *stats = ctx->stats;
+  }
+  pthread_mutex_unlock(&s_uartEpollMutex);
+
+  return ctx ? OSDK_STAT_OK : OSDK_STAT_ERR_NOT_FOUND;
+}
+
 #ifdef ADVANCED_SENSING
 
 /**
@@ -52,8 +52,24 @@ extern "C" {
 #endif
 
 /* Exported constants --------------------------------------------------------*/
+#define OSDK_LINUX_UART_READ_HIST_NUM   14 /* [2^i, 2^(i+1)) bytes, last is >= 8K */
+#define OSDK_LINUX_UART_WAIT_HIST_NUM   20 /* [2^(i-1), 2^i) us, last is >= 262ms */
 
 /* Exported types ------------------------------------------------------------*/
+/**
+ * @brief Counters of the epoll uart read path, see OsdkLinux_UartGetStats.
+ */
+typedef struct {
+  uint64_t readCalls;     /* OsdkLinux_UartEpollReadData calls */
+  uint64_t readBytes;     /* bytes handed to the caller */
+  uint64_t wakeData;      /* waits ended by received data */
+  uint64_t wakeTimeout;   /* waits ended by the timeout */
+  uint64_t wakeShutdown;  /* waits ended by OsdkLinux_UartEpollClose */
+  uint64_t ringOverflow;  /* reads deferred because the ring was full */
+  uint32_t ringHighWater; /* most bytes buffered at once */
+  uint32_t readSizeHist[OSDK_LINUX_UART_READ_HIST_NUM]; /* bytes per tty read */
+  uint32_t waitHist[OSDK_LINUX_UART_WAIT_HIST_NUM];     /* time spent waiting */
+} T_OsdkLinuxUartStats;
 
 /* Exported functions --------------------------------------------------------*/
 
@@ -62,6 +78,15 @@ E_OsdkStat OsdkLinux_UartReadData(const T_HalObj *obj, uint8_t *pBuf, uint32_t *
 E_OsdkStat OsdkLinux_UartInit(const char *port, const int baudrate, T_HalObj *obj);
 E_OsdkStat OsdkLinux_UartClose(T_HalObj *obj);
 
+/* Event driven variant: the read blocks in epoll until data, a timeout or
+ * close, and drains the tty into a ring buffer in large chunks. Build with
+ * OSDK_UART_EPOLL to register it instead of the polling functions above. */
+E_OsdkStat OsdkLinux_UartEpollInit(const char *port, const int baudrate, T_HalObj *obj);
+E_OsdkStat OsdkLinux_UartEpollReadData(const T_HalObj *obj, uint8_t *pBuf, uint32_t *bufLen);
+E_OsdkStat OsdkLinux_UartEpollClose(T_HalObj *obj);
+E_OsdkStat OsdkLinux_UartSetLowLatency(const T_HalObj *obj, int enable);
+E_OsdkStat OsdkLinux_UartGetStats(const T_HalObj *obj, T_OsdkLinuxUartStats *stats);
+
 #ifdef ADVANCED_SENSING
 E_OsdkStat OsdkLinux_USBBulkInit(uint16_t pid, uint16_t vid, uint16_t num, uint16_t epIn,
                                  uint16_t epOut, T_HalObj *obj);
@@ -47,7 +47,7 @@ pwmOutputBlockingApiDemo(Vehicle* vehicle)
 
   // Setup the channel 4
   std::cout << "Configuring channel\n";
-  vehicle->mfio->config(MFIO::MODE_PWM_OUT, MFIO::CHANNEL_3, initOnTimeUs,
+  vehicle->getMFIO()->config(MFIO::MODE_PWM_OUT, MFIO::CHANNEL_3, initOnTimeUs,
                         pwmFreq, responseTimeout);
   std::cout << "Channel 4 configured to output 50Hz PWM with 50% duty cycle.\n";
   sleep(5);
@@ -56,18 +56,18 @@ pwmOutputBlockingApiDemo(Vehicle* vehicle)
 
   std::cout << "Setting 30% duty cycle\n";
   initOnTimeUs = 6000; // us, 30% duty cycle
-  vehicle->mfio->setValue(MFIO::CHANNEL_3, initOnTimeUs, responseTimeout);
+  vehicle->getMFIO()->setValue(MFIO::CHANNEL_3, initOnTimeUs, responseTimeout);
   sleep(5);
 
   std::cout << "Setting 70% duty cycle\n";
   initOnTimeUs = 14000; // us, 70% duty cycle
-  vehicle->mfio->setValue(MFIO::CHANNEL_3, initOnTimeUs, responseTimeout);
+  vehicle->getMFIO()->setValue(MFIO::CHANNEL_3, initOnTimeUs, responseTimeout);
   sleep(5);
 
   std::cout << "Turning off the PWM signal\n";
   uint32_t digitalValue = 0;
   uint16_t digitalFreq  = 0;
-  vehicle->mfio->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, digitalValue,
+  vehicle->getMFIO()->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, digitalValue,
                         digitalFreq, responseTimeout);
   return true;
 }
@@ -84,7 +84,7 @@ pwmOutputNonBlockingApiDemo(Vehicle* vehicle)
 
   // Setup the channe4
   std::cout << "Configuring channel\n";
-  vehicle->mfio->config(MFIO::MODE_PWM_OUT, MFIO::CHANNEL_3, initOnTimeUs,
+  vehicle->getMFIO()->config(MFIO::MODE_PWM_OUT, MFIO::CHANNEL_3, initOnTimeUs,
                         pwmFreq);
   std::cout << "Channel 4 configured to output 50Hz PWM with 50% duty cycle.\n";
   sleep(5);
@@ -93,18 +93,18 @@ pwmOutputNonBlockingApiDemo(Vehicle* vehicle)
 
   std::cout << "Setting 30% duty cycle\n";
   initOnTimeUs = 6000; // us, 30% duty cycle
-  vehicle->mfio->setValue(MFIO::CHANNEL_3, initOnTimeUs);
+  vehicle->getMFIO()->setValue(MFIO::CHANNEL_3, initOnTimeUs);
   sleep(5);
 
   std::cout << "Setting 70% duty cycle\n";
   initOnTimeUs = 14000; // us, 70% duty cycle
-  vehicle->mfio->setValue(MFIO::CHANNEL_3, initOnTimeUs);
+  vehicle->getMFIO()->setValue(MFIO::CHANNEL_3, initOnTimeUs);
   sleep(5);
 
   std::cout << "Turning off the PWM signal\n";
   uint32_t digitalValue = 0;
   uint16_t digitalFreq  = 0;
-  vehicle->mfio->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, digitalValue,
+  vehicle->getMFIO()->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, digitalValue,
                         digitalFreq);
   return true;
 }
@@ -121,7 +121,7 @@ gpioLoopbackBlockingApiDemo(Vehicle* vehicle)
 
   // Setup the channel 4
   std::cout << "Configuring channel\n";
-  vehicle->mfio->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, initHL, pwmFreq,
+  vehicle->getMFIO()->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, initHL, pwmFreq,
                         responseTimeout);
   std::cout << "Channel 4 configured to GPO.\n";
   sleep(5);
@@ -130,17 +130,17 @@ gpioLoopbackBlockingApiDemo(Vehicle* vehicle)
 
   std::cout << "Setting to high\n";
   initHL = 1; // high
-  vehicle->mfio->setValue(MFIO::CHANNEL_3, initHL, responseTimeout);
+  vehicle->getMFIO()->setValue(MFIO::CHANNEL_3, initHL, responseTimeout);
   sleep(1);
 
   std::cout << "config channel 5 to GPI\n";
   uint32_t digitalValue = 1; // not used... Does not matter for GPI
   uint16_t digitalFreq  = 0; //  not used....Does not matter for GPIO
-  vehicle->mfio->config(MFIO::MODE_GPIO_IN, MFIO::CHANNEL_4, digitalValue,
+  vehicle->getMFIO()->config(MFIO::MODE_GPIO_IN, MFIO::CHANNEL_4, digitalValue,
                         digitalFreq, responseTimeout);
 
   ACK::MFIOGet ack;
-  ack = vehicle->mfio->getValue(MFIO::CHANNEL_4, responseTimeout);
+  ack = vehicle->getMFIO()->getValue(MFIO::CHANNEL_4, responseTimeout);
 
   std::cout << "\n GPI status:" << ack.ack.data << std::endl;
   std::cout << "\n GPI value:" << ack.value << std::endl;
@@ -157,7 +157,7 @@ gpioLoopbackNonBlockingApiDemo(Vehicle* vehicle)
 
   // Setup the channel
   std::cout << "Configuring channel\n";
-  vehicle->mfio->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, initHL, pwmFreq);
+  vehicle->getMFIO()->config(MFIO::MODE_GPIO_OUT, MFIO::CHANNEL_3, initHL, pwmFreq);
   std::cout << "Channel configured to GPO low.\n";
   sleep(5);
 
@@ -165,16 +165,16 @@ gpioLoopbackNonBlockingApiDemo(Vehicle* vehicle)
 
   std::cout << "Setting to high\n";
   initHL = 1; // us, 30% duty cycle
-  vehicle->mfio->setValue(MFIO::CHANNEL_3, initHL);
+  vehicle->getMFIO()->setValue(MFIO::CHANNEL_3, initHL);
   sleep(1);
 
   std::cout << "config channel 5 to GPI\n";
   uint32_t digitalValue = 0; // not used... Does not matter for GPI
   uint16_t digitalFreq  = 0; // not used....Does not matter for GPIO
-  vehicle->mfio->config(MFIO::MODE_GPIO_IN, MFIO::CHANNEL_4, digitalValue,
+  vehicle->getMFIO()->config(MFIO::MODE_GPIO_IN, MFIO::CHANNEL_4, digitalValue,
                         digitalFreq);
 
-  vehicle->mfio->getValue(MFIO::CHANNEL_4, getGpiCallBack);
+  vehicle->getMFIO()->getValue(MFIO::CHANNEL_4, getGpiCallBack);
   sleep(5);
   return true;
 }
@@ -208,12 +208,12 @@ adcBlockingApiDemo(Vehicle* vehicle)
 
   // Setup the channel 5
   std::cout << "Configuring channel\n";
-  vehicle->mfio->config(MFIO::MODE_ADC, MFIO::CHANNEL_4, initOnTimeUs, pwmFreq,
+  vehicle->getMFIO()->config(MFIO::MODE_ADC, MFIO::CHANNEL_4, initOnTimeUs, pwmFreq,
                         responseTimeout);
   std::cout << "Channel 5 configured to ADC input.\n";
 
   ACK::MFIOGet ack;
-  ack = vehicle->mfio->getValue(MFIO::CHANNEL_4, responseTimeout);
+  ack = vehicle->getMFIO()->getValue(MFIO::CHANNEL_4, responseTimeout);
 
   std::cout << "ADC status:" << ack.ack.data << std::endl;
   std::cout << "ADC value:" << ack.value << std::endl;
@@ -230,10 +230,10 @@ adcNonBlockingApiDemo(Vehicle* vehicle)
 
   // Setup the channel
   std::cout << "Configuring channel\n";
-  vehicle->mfio->config(MFIO::MODE_ADC, MFIO::CHANNEL_4, initOnTimeUs, pwmFreq);
+  vehicle->getMFIO()->config(MFIO::MODE_ADC, MFIO::CHANNEL_4, initOnTimeUs, pwmFreq);
   std::cout << "Channel 5 configured to ADC input\n";
 
-  vehicle->mfio->getValue(MFIO::CHANNEL_4, getAdcCallBack);
+  vehicle->getMFIO()->getValue(MFIO::CHANNEL_4, getAdcCallBack);
 
   sleep(5);
   return true;
@@ -159,14 +159,14 @@ parseFromMobileCallback2(Vehicle* vehicle, RecvContainer recvFrame,
 void
 setFromMSDKCallback(Vehicle* vehicle, LinuxSetup* linuxEnvironment)
 {
-  vehicle->mobileDevice->setFromMSDKCallback(parseFromMobileCallback,
+  vehicle->getMobileDevice()->setFromMSDKCallback(parseFromMobileCallback,
                                              linuxEnvironment);
 }
 
 void
 sendDataToMSDK(Vehicle* vehicle, uint8_t* data, uint8_t len)
 {
-  vehicle->mobileDevice->sendDataToMSDK(data, len);
+  vehicle->getMobileDevice()->sendDataToMSDK(data, len);
 }
 
 bool
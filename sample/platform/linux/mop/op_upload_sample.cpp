@@ -231,7 +231,7 @@ static void* MopClientTask(void *arg)
   Vehicle *vehicle = (Vehicle *)arg;
 
   /*! main psdk device init */
-  ErrorCode::ErrorCodeType ret = vehicle->psdkManager->initPSDKModule(
+  ErrorCode::ErrorCodeType ret = vehicle->getPSDKManager()->initPSDKModule(
       PAYLOAD_INDEX_0, "Main_psdk_device");
   if (ret != ErrorCode::SysCommonErr::Success) {
     DERROR("Init PSDK module Main_psdk_device failed.");
@@ -240,7 +240,7 @@ static void* MopClientTask(void *arg)
 
   /*! get the mop client */
   MopClient *mopClient = NULL;
-  ret = vehicle->psdkManager->getMopClient(PAYLOAD_INDEX_0, mopClient);
+  ret = vehicle->getPSDKManager()->getMopClient(PAYLOAD_INDEX_0, mopClient);
   if (ret != ErrorCode::SysCommonErr::Success) {
     DERROR("Get MOP client object for_psdk_device failed.");
     ErrorCode::printErrorCodeMsg(ret);
@@ -0,0 +1,227 @@
+/*! @file telemetry-contention/main.cpp
+ *  @version 4.1.0
+ *  @date Oct 2026
+ *
+ *  @brief
+ *  Contention benchmark of DataSubscription::getValue.
+ *  Feeds subscription frames to a package the way the receive thread does,
+ *  while reader threads poll topics, once with the message mutex and once
+ *  with lock-free reading, and prints the latency percentiles of both.
+ *  No vehicle is needed.
+ *
+ *  @Copyright (c) 2026 DJI
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <dji_platform.hpp>
+#include <dji_subscription.hpp>
+#include "osdkosal_linux.h"
+
+using namespace DJI::OSDK;
+using namespace DJI::OSDK::Telemetry;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int PACKAGE_ID = 0;
+//! Rate of the frames, the receive thread of an M300 sees up to 400 Hz
+static const int WRITER_HZ = 400;
+static TopicName topics[] = { TOPIC_QUATERNION, TOPIC_VELOCITY, TOPIC_GPS_FUSED,
+                              TOPIC_ACCELERATION_GROUND };
+static const int TOPIC_NUM = sizeof(topics) / sizeof(topics[0]);
+
+//! Samples kept per thread, the readers go on without recording after that
+static const size_t MAX_SAMPLES = 4000000;
+
+static std::atomic<bool> running(false);
+
+static E_OsdkStat
+consoleOut(const uint8_t* data, uint16_t dataLen)
+{
+  printf("%.*s", (int)dataLen, (const char*)data);
+  return OSDK_STAT_OK;
+}
+
+static void
+registerPlatform()
+{
+  static T_OsdkLoggerConsole console = {
+    .consoleLevel = OSDK_LOGGER_CONSOLE_LOG_LEVEL_ERROR,
+    .func         = consoleOut,
+  };
+  static T_OsdkOsalHandler osalHandler = {
+    .TaskCreate         = OsdkLinux_TaskCreate,
+    .TaskDestroy        = OsdkLinux_TaskDestroy,
+    .TaskSleepMs        = OsdkLinux_TaskSleepMs,
+    .MutexCreate        = OsdkLinux_MutexCreate,
+    .MutexDestroy       = OsdkLinux_MutexDestroy,
+    .MutexLock          = OsdkLinux_MutexLock,
+    .MutexUnlock        = OsdkLinux_MutexUnlock,
+    .SemaphoreCreate    = OsdkLinux_SemaphoreCreate,
+    .SemaphoreDestroy   = OsdkLinux_SemaphoreDestroy,
+    .SemaphoreWait      = OsdkLinux_SemaphoreWait,
+    .SemaphoreTimedWait = OsdkLinux_SemaphoreTimedWait,
+    .SemaphorePost      = OsdkLinux_SemaphorePost,
+    .GetTimeMs          = OsdkLinux_GetTimeMs,
+#ifdef OS_DEBUG
+    .GetTimeUs = OsdkLinux_GetTimeUs,
+#endif
+    .Malloc = OsdkLinux_Malloc,
+    .Free   = OsdkLinux_Free,
+  };
+
+  if (!DJI_REG_LOGGER_CONSOLE(&console) || !DJI_REG_OSAL_HANDLER(&osalHandler))
+  {
+    fprintf(stderr, "Platform register failed\n");
+    exit(1);
+  }
+}
+
+static uint32_t
+nsSince(Clock::time_point start)
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           Clock::now() - start)
+    .count();
+}
+
+static void
+writerLoop(DataSubscription* sub, std::vector<uint32_t>* lat)
+{
+  uint8_t       frame[256];
+  RecvFrameView view;
+  memset(&view, 0, sizeof(view));
+  view.payload    = frame;
+  view.payloadLen = 1;
+  for (int i = 0; i < TOPIC_NUM; i++)
+  {
+    view.payloadLen += TopicDataBase[topics[i]].size;
+  }
+  frame[0] = PACKAGE_ID;
+
+  Clock::time_point next = Clock::now();
+  for (uint8_t n = 0; running; n++)
+  {
+    memset(frame + 1, n, view.payloadLen - 1);
+    Clock::time_point start = Clock::now();
+    DataSubscription::decodeViewCallback(NULL, view, sub);
+    lat->push_back(nsSince(start));
+
+    next += std::chrono::microseconds(1000000 / WRITER_HZ);
+    std::this_thread::sleep_until(next);
+  }
+}
+
+template <TopicName topic>
+static void
+readerLoop(DataSubscription* sub, std::vector<uint32_t>* lat)
+{
+  while (running)
+  {
+    Clock::time_point start = Clock::now();
+    typename TypeMap<topic>::type value = sub->getValue<topic>();
+    uint32_t ns = nsSince(start);
+    if (lat->size() < MAX_SAMPLES)
+    {
+      lat->push_back(ns);
+    }
+    (void)value;
+  }
+}
+
+static void
+report(const char* name, std::vector<uint32_t>& lat)
+{
+  if (lat.empty())
+  {
+    printf("  %-8s no samples\n", name);
+    return;
+  }
+  std::sort(lat.begin(), lat.end());
+  size_t n = lat.size();
+  printf("  %-8s %9zu calls  p50 %6u  p99 %7u  p99.9 %8u  max %9u ns\n", name,
+         n, lat[n / 2], lat[n * 99 / 100], lat[n * 999 / 1000], lat[n - 1]);
+}
+
+static void
+runOnce(DataSubscription* sub, bool lockFree, int seconds)
+{
+  std::vector<uint32_t> writerLat, quatLat, velLat, gpsLat;
+  writerLat.reserve(WRITER_HZ * seconds + 16);
+  quatLat.reserve(MAX_SAMPLES);
+  velLat.reserve(MAX_SAMPLES);
+  gpsLat.reserve(MAX_SAMPLES);
+
+  sub->setLockFreeRead(lockFree);
+  running = true;
+  std::thread writer(writerLoop, sub, &writerLat);
+  std::thread quat(readerLoop<TOPIC_QUATERNION>, sub, &quatLat);
+  std::thread vel(readerLoop<TOPIC_VELOCITY>, sub, &velLat);
+  std::thread gps(readerLoop<TOPIC_GPS_FUSED>, sub, &gpsLat);
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  running = false;
+  writer.join();
+  quat.join();
+  vel.join();
+  gps.join();
+
+  printf("%s:\n", lockFree ? "Lock-free read" : "Mutex read");
+  report("writer", writerLat);
+  report("quat", quatLat);
+  report("velocity", velLat);
+  report("gps", gpsLat);
+}
+
+int
+main(int argc, char** argv)
+{
+  int seconds = (argc > 1) ? atoi(argv[1]) : 3;
+  if (seconds <= 0)
+  {
+    seconds = 3;
+  }
+
+  registerPlatform();
+
+  DataSubscription* sub = new DataSubscription(NULL);
+  // The frames come at WRITER_HZ anyway, the rate only has to be valid
+  if (!sub->addPackageOffline(PACKAGE_ID, TOPIC_NUM, topics, false, 50))
+  {
+    fprintf(stderr, "Set up the package failed\n");
+    return 1;
+  }
+
+  printf("%d s per run, frames at %d Hz, readers polling without pause\n",
+         seconds, WRITER_HZ);
+  runOnce(sub, false, seconds);
+  runOnce(sub, true, seconds);
+
+  sub->removePackageOffline(PACKAGE_ID);
+  delete sub;
+  return 0;
+}